@@ -0,0 +1,151 @@
+/**
+ * @file AllocationCounter.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a test hook which counts the heap allocations made by each
+ *      thread.
+ */
+
+#include "AllocationCounter.h"
+
+#ifdef COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <errno.h>
+#include <stddef.h>
+
+/**
+ * These are the allocation functions of the C library, which the counting versions pass the calls on to.
+ */
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void *pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+}
+
+/*
+ * These are the file scoped counts of allocations.  The per thread count is plain thread local data, so counting never
+ * allocates or locks.
+ */
+static thread_local uint64_t threadAllocations = 0;
+static std::atomic<uint64_t> totalAllocations(0);
+
+/**
+ * This function will count an allocation.
+ */
+static inline void countAllocation() {
+	threadAllocations++;
+	totalAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * These are the counting versions of the allocation functions.  operator new is built on malloc, so it is counted too.
+ */
+extern "C" {
+void* malloc(size_t size) {
+	countAllocation();
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+	countAllocation();
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void *pointer, size_t size) {
+	countAllocation();
+	return __libc_realloc(pointer, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+	countAllocation();
+	return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+	countAllocation();
+	return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **pointer, size_t alignment, size_t size) {
+	countAllocation();
+	void *result = __libc_memalign(alignment, size);
+	if (result == NULL) {
+		return ENOMEM;
+	}
+	*pointer = result;
+	return 0;
+}
+}
+
+/**
+ * This method will determine if the allocations are being counted.
+ * @return The return will be true, as the counting is compiled in.
+ */
+bool AllocationCounter::isEnabled() {
+	return true;
+}
+
+/**
+ * This method will obtain the number of heap allocations made by the calling thread.
+ * @return The return will be the number of allocations since the thread started.
+ */
+uint64_t AllocationCounter::getThreadAllocations() {
+	return threadAllocations;
+}
+
+/**
+ * This method will obtain the number of heap allocations made by every thread.
+ * @return The return will be the number of allocations since the program started.
+ */
+uint64_t AllocationCounter::getTotalAllocations() {
+	return totalAllocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+/**
+ * This method will determine if the allocations are being counted.
+ * @return The return will be false, as the counting is not compiled in.
+ */
+bool AllocationCounter::isEnabled() {
+	return false;
+}
+
+/**
+ * This method will obtain the number of heap allocations made by the calling thread.
+ * @return The return will be 0, as the counting is not compiled in.
+ */
+uint64_t AllocationCounter::getThreadAllocations() {
+	return 0;
+}
+
+/**
+ * This method will obtain the number of heap allocations made by every thread.
+ * @return The return will be 0, as the counting is not compiled in.
+ */
+uint64_t AllocationCounter::getTotalAllocations() {
+	return 0;
+}
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file AllocationCounter.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a test hook which counts the heap allocations made by each
+ *      thread, so that the tasks can show that they do not allocate once they have
+ *      reached a steady state.  It is only compiled in when COUNT_ALLOCATIONS is
+ *      defined, in which case malloc and its relatives (and so new) are replaced
+ *      by versions which count each call before passing it to the C library.
+ *      Otherwise, the counts are always 0 and cost nothing.
+ */
+
+#ifndef ALLOCATIONCOUNTER_H_
+#define ALLOCATIONCOUNTER_H_
+
+#include <stdint.h>
+
+class AllocationCounter {
+public:
+	/**
+	 * This method will determine if the allocations are being counted.
+	 * @return The return will be true if the counting is compiled in.
+	 */
+	static bool isEnabled();
+
+	/**
+	 * This method will obtain the number of heap allocations made by the calling thread.
+	 * @return The return will be the number of allocations since the thread started.
+	 */
+	static uint64_t getThreadAllocations();
+
+	/**
+	 * This method will obtain the number of heap allocations made by every thread.
+	 * @return The return will be the number of allocations since the program started.
+	 */
+	static uint64_t getTotalAllocations();
+};
+
+#endif /* ALLOCATIONCOUNTER_H_ */
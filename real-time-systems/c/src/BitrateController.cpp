@@ -0,0 +1,290 @@
+/**
+ * @file BitrateController.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a periodic task which fits the image stream to the link,
+ *      using the reports which the receiver sends back.
+ */
+
+#include "BitrateController.h"
+#include "Logger.h"
+
+#include <stdio.h>
+#include <algorithm>
+
+/**
+ * This function will obtain the number of microseconds from one time to another.
+ * @param end This is the later time.
+ * @param start This is the earlier time.
+ * @return The return will be the number of microseconds between the times.
+ */
+static int64_t microsecondsBetween(const struct timespec &end, const struct timespec &start) {
+	return ((int64_t) (end.tv_sec - start.tv_sec) * 1000000LL) + ((end.tv_nsec - start.tv_nsec) / 1000);
+}
+
+/**
+ * This is the constructor for the class.
+ * @param threadName This is the name of the thread in a human readable format.
+ * @param period This is the period for the task, given in microseconds.
+ * @param imageCapturer This is the image stream which is controlled.
+ * @param width This is the width of the image stream in pixels.
+ * @param height This is the height of the image stream in pixels.
+ */
+BitrateController::BitrateController(std::string threadName, uint32_t period, ImageCapturer *imageCapturer, int width, int height) :
+		PeriodicTask(threadName, period), capturer(imageCapturer), transmitter(imageCapturer->getTransmitter()), baseWidth(width), baseHeight(
+				height), qualitySteps(0), resolutionSteps(0), rateSteps(0), maximumRate(0), decreaseLoss(0.10), increaseLoss(0.02), maximumJitter(
+				30000), stepUpHoldOff(5), pacing(false), targetRate(0), previousReports(0), previousBytes(0), previousFrames(0), previousDatagrams(
+				0), headroomPeriods(0), stepCount(0) {
+	basePeriod = imageCapturer->getTaskPeriod();
+	baseQuality = transmitter->getJpegQuality();
+	previousSampleTime.tv_sec = 0;
+	previousSampleTime.tv_nsec = 0;
+}
+
+/**
+ * This is the destructor for the class.  The stream is returned to its base settings.
+ */
+BitrateController::~BitrateController() {
+	if ((qualitySteps > 0) || (resolutionSteps > 0) || (rateSteps > 0)) {
+		qualitySteps = 0;
+		resolutionSteps = 0;
+		rateSteps = 0;
+		applySteps();
+	}
+}
+
+/**
+ * This method will set the limits of the controller.  It must be called before the controller is started.
+ * @param maximumRate This is the highest rate the stream may be sent at in kilobits per second, or 0 if there is no limit.
+ * @param decreaseLoss This is the fraction of datagrams lost, from 0 to 1, above which the target is cut.
+ * @param increaseLoss This is the fraction of datagrams lost below which the target may grow.
+ * @param maximumJitter This is the jitter in microseconds above which the target is cut.
+ * @param stepUpHoldOff This is the number of consecutive periods in which the stream must be predicted to fit the target
+ * a step up before it is stepped up.
+ */
+void BitrateController::setLimits(uint32_t maximumRate, double decreaseLoss, double increaseLoss, uint32_t maximumJitter, uint32_t stepUpHoldOff) {
+	this->maximumRate = maximumRate;
+	this->decreaseLoss = decreaseLoss;
+	this->increaseLoss = increaseLoss;
+	this->maximumJitter = maximumJitter;
+	this->stepUpHoldOff = stepUpHoldOff;
+}
+
+/**
+ * This method will pace the datagrams of the stream at the target rate.  It must be called before the controller is
+ * started.
+ * @param enable This is true to pace the datagrams, or false to leave the pacing alone.
+ */
+void BitrateController::setPacing(bool enable) {
+	pacing = enable;
+}
+
+/**
+ * This is the task method.  It reads the last report of the receiver and steps the stream down or up.  The algorithm is
+ * as follows:
+ */
+void BitrateController::taskMethod() {
+	/**
+	 * 1.0 Measure the rate the stream was sent at since the last period.  The first period is only sampled.
+	 */
+	struct timespec now;
+	getClock()->getTime(now);
+	int64_t window = (previousSampleTime.tv_sec == 0) ? 0 : microsecondsBetween(now, previousSampleTime);
+	previousSampleTime = now;
+	uint64_t reports = transmitter->getReportsReceived();
+	uint64_t bytes = transmitter->getBytesSent();
+	uint64_t frames = transmitter->getFramesSent();
+	uint64_t datagrams = transmitter->getDatagramsSent();
+	uint64_t newReports = reports - previousReports;
+	uint64_t bytesSent = bytes - previousBytes;
+	uint64_t framesSent = frames - previousFrames;
+	uint64_t datagramsSent = datagrams - previousDatagrams;
+	previousReports = reports;
+	previousBytes = bytes;
+	previousFrames = frames;
+	previousDatagrams = datagrams;
+
+	/**
+	 * 1.1 Keep the stream as it is until the receiver reports.  A bit per millisecond is a kilobit per second.
+	 */
+	if ((window <= 0) || (newReports == 0)) {
+		return;
+	}
+	double sendRate = (bytesSent * 8.0) / (window / 1000.0);
+
+	/**
+	 * 2.0 Set the target.  If the receiver lost too many datagrams, the link is full, so the target is cut below what the
+	 * receiver got.  If the jitter is too high, a queue is building up, so the target is cut to a little below what the
+	 * receiver got.  If the link is clean, the target grows slowly, but never far beyond the rate the stream is sent at.
+	 */
+	double loss = transmitter->getReportedLoss();
+	uint32_t jitter = transmitter->getReportedJitter();
+	double receiveRate = transmitter->getReportedReceiveRate();
+	double target = (targetRate == 0) ? std::max(sendRate, 1.0) : targetRate.load();
+	char reason[160];
+	if (loss > decreaseLoss) {
+		target = receiveRate * (1.0 - (0.5 * loss));
+		snprintf(reason, sizeof(reason), "%.1f%% of the datagrams lost at %.0f kbps", loss * 100.0, receiveRate);
+	} else if (jitter > maximumJitter) {
+		target = receiveRate * 0.85;
+		snprintf(reason, sizeof(reason), "%u us of jitter at %.0f kbps", jitter, receiveRate);
+	} else {
+		if (loss < increaseLoss) {
+			target = std::min(target * 1.05, std::max(sendRate * 1.5, target));
+		}
+		snprintf(reason, sizeof(reason), "%.1f%% of the datagrams lost and %u us of jitter", loss * 100.0, jitter);
+	}
+	if (maximumRate > 0) {
+		target = std::min(target, (double) maximumRate);
+	}
+	target = std::max(target, 64.0);
+	targetRate = (uint32_t) target;
+
+	/**
+	 * 3.0 Step the stream down if it is sent faster than the target.  Step it up once a step up is predicted to fit the
+	 * target for long enough.
+	 */
+	char description[240];
+	if (sendRate > target) {
+		snprintf(description, sizeof(description), "sent at %.0f kbps with a target of %.0f kbps, %s", sendRate, target, reason);
+		stepDown(description);
+		headroomPeriods = 0;
+	} else {
+		double ratio = getStepUpRatio();
+		if ((ratio > 0.0) && (sendRate * ratio < target)) {
+			headroomPeriods++;
+		} else {
+			headroomPeriods = 0;
+		}
+		if (headroomPeriods >= stepUpHoldOff) {
+			snprintf(description, sizeof(description), "predicted at %.0f kbps with a target of %.0f kbps, %s", sendRate * ratio, target, reason);
+			stepUp(description);
+			headroomPeriods = 0;
+		}
+	}
+
+	/**
+	 * 4.0 Pace the datagrams at the target rate, but not so slowly that a frame can not be sent within its period.
+	 */
+	if (pacing && (datagramsSent > 0) && (framesSent > 0)) {
+		double interval = ((bytesSent * 8.0) / datagramsSent) / target * 1000.0;
+		double longestInterval = (0.8 * capturer->getTaskPeriod()) / ((double) datagramsSent / framesSent);
+		transmitter->setDatagramInterval((uint32_t) std::min(interval, longestInterval));
+	}
+}
+
+/**
+ * This method will take the stream one step down.  The JPEG quality is lowered first, then the resolution, and then the
+ * frame rate.
+ * @param reason This is a human readable description of why the stream is stepped down.
+ * @return The return will be true if the stream was stepped down.
+ */
+bool BitrateController::stepDown(const std::string &reason) {
+	if ((transmitter->getEncoding() == ENCODING_JPEG) && (baseQuality - ((qualitySteps + 1) * QUALITY_STEP) >= MINIMUM_QUALITY)) {
+		qualitySteps++;
+	} else if (resolutionSteps < MAXIMUM_RESOLUTION_STEPS) {
+		resolutionSteps++;
+	} else if (rateSteps < MAXIMUM_RATE_STEPS) {
+		rateSteps++;
+	} else {
+		return false;
+	}
+	applySteps();
+	Logger::log(LOG_WARNING, "%s: Stepped %s down to quality %d, %d%% of the resolution and 1/%d of the frame rate: %s.", myName.c_str(),
+			transmitter->getName().c_str(), baseQuality - (qualitySteps * QUALITY_STEP), 100 - (25 * resolutionSteps), 1 << rateSteps,
+			reason.c_str());
+	return true;
+}
+
+/**
+ * This method will take the stream one step up.  The frame rate is restored first, then the resolution, and then the
+ * JPEG quality.
+ * @param reason This is a human readable description of why the stream is stepped up.
+ * @return The return will be true if the stream was stepped up.
+ */
+bool BitrateController::stepUp(const std::string &reason) {
+	if (rateSteps > 0) {
+		rateSteps--;
+	} else if (resolutionSteps > 0) {
+		resolutionSteps--;
+	} else if (qualitySteps > 0) {
+		qualitySteps--;
+	} else {
+		return false;
+	}
+	applySteps();
+	Logger::log(LOG_INFO, "%s: Stepped %s up to quality %d, %d%% of the resolution and 1/%d of the frame rate: %s.", myName.c_str(),
+			transmitter->getName().c_str(), baseQuality - (qualitySteps * QUALITY_STEP), 100 - (25 * resolutionSteps), 1 << rateSteps,
+			reason.c_str());
+	return true;
+}
+
+/**
+ * This method will predict how much the rate of the stream grows if it is taken one step up.  The rate follows the
+ * frame rate and the number of pixels.  A step of JPEG quality is taken to add a quarter.
+ * @return The return will be the ratio of the rate one step up to the current rate, or 0 if the stream is at the base
+ * settings.
+ */
+double BitrateController::getStepUpRatio() {
+	if (rateSteps > 0) {
+		return 2.0;
+	} else if (resolutionSteps > 0) {
+		double scale = (double) (5 - resolutionSteps) / (4 - resolutionSteps);
+		return scale * scale;
+	} else if (qualitySteps > 0) {
+		return 1.25;
+	}
+	return 0.0;
+}
+
+/**
+ * This method will apply the current steps to the stream.  A reduced resolution is kept even, so that every pixel
+ * format can be sent.
+ */
+void BitrateController::applySteps() {
+	if (transmitter->getEncoding() == ENCODING_JPEG) {
+		transmitter->setEncoding(ENCODING_JPEG, baseQuality - (qualitySteps * QUALITY_STEP));
+	}
+	if (resolutionSteps == 0) {
+		capturer->setResolution(baseWidth, baseHeight);
+	} else {
+		capturer->setResolution(((baseWidth * (4 - resolutionSteps)) / 4) & ~1, ((baseHeight * (4 - resolutionSteps)) / 4) & ~1);
+	}
+	capturer->setTaskPeriod(basePeriod << rateSteps);
+	stepCount++;
+}
+
+/**
+ * This method will obtain the rate the stream is fitted to.
+ * @return The return will be the rate in kilobits per second, or 0 if no report has arrived.
+ */
+uint32_t BitrateController::getTargetRate() {
+	return targetRate;
+}
+
+/**
+ * This method will obtain the number of steps taken, up or down.
+ * @return The return will be the number of steps.
+ */
+uint32_t BitrateController::getStepCount() {
+	return stepCount;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file BitrateController.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a periodic task which fits the image stream to the link,
+ *      using the reports which the receiver sends back.  Each period, it sets a
+ *      target rate: it is cut to what the receiver got when the receiver loses
+ *      too many datagrams or the jitter shows a queue building up, and it grows
+ *      slowly while the link is clean.  The stream is then stepped down or up
+ *      to fit the target, one step per period.  Going down, the JPEG quality is
+ *      lowered first, then the resolution, and then the frame rate.  Going up,
+ *      they are restored in the opposite order, once the stream is predicted
+ *      to fit for a number of periods.  The datagrams can also be paced at the
+ *      target rate.  Every step is logged with what caused it.
+ *
+ *      The stream keeps its settings if the receiver stops reporting.  The
+ *      frame rate is changed through the period of the image stream, so the
+ *      controller should not be combined with an overload manager which
+ *      changes the same task.
+ */
+
+#ifndef BITRATECONTROLLER_H_
+#define BITRATECONTROLLER_H_
+
+#include "PeriodicTask.h"
+#include "ImageCapturer.h"
+#include "ImageTransmitter.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <time.h>
+
+class BitrateController: public PeriodicTask {
+public:
+	/**
+	 * These are the limits of the steps.  The quality is lowered in steps of QUALITY_STEP down to MINIMUM_QUALITY, the
+	 * resolution in quarters of the base resolution down to a half, and the frame rate by halves down to a quarter.
+	 */
+	static const int QUALITY_STEP = 15;
+	static const int MINIMUM_QUALITY = 20;
+	static const int MAXIMUM_RESOLUTION_STEPS = 2;
+	static const int MAXIMUM_RATE_STEPS = 2;
+
+private:
+	/**
+	 * These are the image stream which is controlled and its transmitter.
+	 */
+	ImageCapturer *capturer;
+	ImageTransmitter *transmitter;
+
+	/**
+	 * These are the settings of the stream before it was stepped down: the resolution, the period in microseconds, and
+	 * the JPEG quality.
+	 */
+	int baseWidth;
+	int baseHeight;
+	uint32_t basePeriod;
+	int baseQuality;
+
+	/**
+	 * These are the number of steps the stream has been taken down in JPEG quality, resolution and frame rate.
+	 */
+	int qualitySteps;
+	int resolutionSteps;
+	int rateSteps;
+
+	/**
+	 * This is the highest rate the stream may be sent at in kilobits per second, or 0 if there is no limit.
+	 */
+	uint32_t maximumRate;
+
+	/**
+	 * These are the fraction of datagrams lost, from 0 to 1, above which the target is cut and below which it may grow,
+	 * and the jitter in microseconds above which the target is cut.
+	 */
+	double decreaseLoss;
+	double increaseLoss;
+	uint32_t maximumJitter;
+
+	/**
+	 * This is the number of consecutive periods in which the stream must be predicted to fit the target a step up before
+	 * it is stepped up.
+	 */
+	uint32_t stepUpHoldOff;
+
+	/**
+	 * This variable will determine whether or not the datagrams are paced at the target rate.
+	 */
+	bool pacing;
+
+	/**
+	 * This is the rate the stream is fitted to in kilobits per second.  It is 0 until the first report arrives.
+	 */
+	std::atomic<uint32_t> targetRate;
+
+	/**
+	 * These are the statistics of the transmitter at the last period, and the time of the last period.  The time is 0
+	 * before the first period.
+	 */
+	uint64_t previousReports;
+	uint64_t previousBytes;
+	uint64_t previousFrames;
+	uint64_t previousDatagrams;
+	struct timespec previousSampleTime;
+
+	/**
+	 * This is the number of consecutive periods in which the stream has been predicted to fit the target a step up.
+	 */
+	uint32_t headroomPeriods;
+
+	/**
+	 * This is the number of steps taken, up or down.
+	 */
+	std::atomic<uint32_t> stepCount;
+
+	/**
+	 * This method will take the stream one step down, if it is not already at the lowest step.
+	 * @param reason This is a human readable description of why the stream is stepped down.
+	 * @return The return will be true if the stream was stepped down.
+	 */
+	bool stepDown(const std::string &reason);
+
+	/**
+	 * This method will take the stream one step up, if it is not already at the base settings.
+	 * @param reason This is a human readable description of why the stream is stepped up.
+	 * @return The return will be true if the stream was stepped up.
+	 */
+	bool stepUp(const std::string &reason);
+
+	/**
+	 * This method will predict how much the rate of the stream grows if it is taken one step up.
+	 * @return The return will be the ratio of the rate one step up to the current rate, or 0 if the stream is at the base
+	 * settings.
+	 */
+	double getStepUpRatio();
+
+	/**
+	 * This method will apply the current steps to the stream.
+	 */
+	void applySteps();
+
+public:
+	/**
+	 * This is the constructor for the class.  The current settings of the stream are taken as its base settings.
+	 * @param threadName This is the name of the thread in a human readable format.
+	 * @param period This is the period for the task, given in microseconds.  It should be about the interval of the
+	 * receiver's reports.
+	 * @param imageCapturer This is the image stream which is controlled.
+	 * @param width This is the width of the image stream in pixels.
+	 * @param height This is the height of the image stream in pixels.
+	 */
+	BitrateController(std::string threadName, uint32_t period, ImageCapturer *imageCapturer, int width, int height);
+
+	/**
+	 * This is the destructor for the class.  The stream is returned to its base settings.
+	 */
+	virtual ~BitrateController();
+
+	/**
+	 * This method will set the limits of the controller.  It must be called before the controller is started.
+	 * @param maximumRate This is the highest rate the stream may be sent at in kilobits per second, or 0 if there is no
+	 * limit.
+	 * @param decreaseLoss This is the fraction of datagrams lost, from 0 to 1, above which the target is cut.
+	 * @param increaseLoss This is the fraction of datagrams lost below which the target may grow.
+	 * @param maximumJitter This is the jitter in microseconds above which the target is cut.
+	 * @param stepUpHoldOff This is the number of consecutive periods in which the stream must be predicted to fit the
+	 * target a step up before it is stepped up.
+	 */
+	void setLimits(uint32_t maximumRate, double decreaseLoss, double increaseLoss, uint32_t maximumJitter, uint32_t stepUpHoldOff);
+
+	/**
+	 * This method will pace the datagrams of the stream at the target rate.  It must be called before the controller is
+	 * started.
+	 * @param enable This is true to pace the datagrams, or false to leave the pacing alone.
+	 */
+	void setPacing(bool enable);
+
+	/**
+	 * This is the task method.  It reads the last report of the receiver and steps the stream down or up.
+	 */
+	virtual void taskMethod();
+
+	/**
+	 * This method will obtain the rate the stream is fitted to.
+	 * @return The return will be the rate in kilobits per second, or 0 if no report has arrived.
+	 */
+	uint32_t getTargetRate();
+
+	/**
+	 * This method will obtain the number of steps taken, up or down.
+	 * @return The return will be the number of steps.
+	 */
+	uint32_t getStepCount();
+};
+
+#endif /* BITRATECONTROLLER_H_ */
@@ -1,4 +1,6 @@
 #include "Camera.h"
+#include "TraceBuffer.h"
+#include "Logger.h"
 #include <chrono>
 
 #define FPS (30)
@@ -10,31 +12,47 @@
  * @param threadName This is the name of the thread that is to be used to run the image capture.
  */
 Camera::Camera(int width, int height, std::string threadName, uint32_t period) :
-		PeriodicTask(threadName, period) {
+		Camera(width, height, threadName, period, new VideoCapture(0)) {
+}
 
-	/**
-	 * 1.0 Start by instantiating a VideoCapture object which will grab the images from the camera.
-	 */
-	capture = new VideoCapture(0);
+/**
+ * Construct a new instance of the camera class which captures from the given video capture.
+ * @param width This is the width of the natively captured images.
+ * @param height This is the height of the natively captured images.
+ * @param threadName This is the name of the thread that is to be used to run the image capture.
+ * @param period This is the period for the periodic task.
+ * @param videoCapture This is the video capture, which the camera deletes.  It may be NULL.
+ */
+Camera::Camera(int width, int height, std::string threadName, uint32_t period, VideoCapture *videoCapture) :
+		PeriodicTask(threadName, period), mtx(threadName + " frame") {
+	frameWidth = width;
+	frameHeight = height;
 
 	/**
-	 * 2.0 Next, set the width, height, and frames per second parameters of the capture.
+	 * 1.0 Start with the VideoCapture object which will grab the images from the camera.
 	 */
-	capture->set(CV_CAP_PROP_FRAME_WIDTH, width);
-	capture->set(CV_CAP_PROP_FRAME_HEIGHT, height);
-	capture->set(CV_CAP_PROP_FPS, FPS);
+	capture = videoCapture;
 
 	/**
-	 * 3.0 Instantiate a new matrix that will hold the last frame.
+	 * 2.0 Instantiate a new matrix that will hold the last frame.
 	 */
 	lastFrame = new Mat();
 
-	/**
-	 * 4.0 Check to see that the capture is opened.  If if isn't, print out a failure method and exit the program with an error code.
-	 */
-	if (!capture->isOpened()) {
-		cout << "Failed to connect to the camera." << endl;
-		exit(-1);
+	if (capture != NULL) {
+		/**
+		 * 3.0 Next, set the width, height, and frames per second parameters of the capture.
+		 */
+		capture->set(cv::CAP_PROP_FRAME_WIDTH, width);
+		capture->set(cv::CAP_PROP_FRAME_HEIGHT, height);
+		capture->set(cv::CAP_PROP_FPS, FPS);
+
+		/**
+		 * 4.0 Check to see that the capture is opened.  If if isn't, print out a failure method and exit the program with an error code.
+		 */
+		if (!capture->isOpened()) {
+			cout << "Failed to connect to the camera." << endl;
+			exit(-1);
+		}
 	}
 }
 
@@ -45,13 +63,18 @@ Camera::~Camera() {
 	/**
 	 * 1.0 Release the camera.
 	 */
-	capture->release();
+	if (capture != NULL) {
+		capture->release();
+	}
 
 	/**
 	 * 2.0 Delete all allocated objects.
 	 */
 	delete lastFrame;
 	delete capture;
+	if (framePool != NULL) {
+		framePool->release(frameBuffer);
+	}
 }
 
 /**
@@ -65,10 +88,15 @@ void Camera::taskMethod() {
 	mtx.lock();
 
 	/**
-	 * 2.0 Read the next image in.
+	 * 2.0 Read the next image in, recording the capture in the trace buffer.
 	 */
-	capture->grab();
-	capture->retrieve(*lastFrame);
+	frameCount++;
+	TraceBuffer::record(TRACE_BEGIN, STAGE_CAPTURE, frameCount, 0);
+	if (captureFrame(*lastFrame) == false) {
+		LOG_RATE_LIMITED(1, LOG_WARNING, "%s: Failed to capture frame %u from the camera.", myName.c_str(), frameCount);
+	}
+	lastFrameId = frameCount;
+	TraceBuffer::record(TRACE_END, STAGE_CAPTURE, frameCount, lastFrame->rows * lastFrame->cols * lastFrame->channels());
 
 	/**
 	 * 3.0 Unlock the mutex.
@@ -77,37 +105,99 @@ void Camera::taskMethod() {
 
 }
 
+/**
+ * This method will capture the next frame by grabbing it from the video capture.
+ * @param frame This is the matrix which the frame is captured into.
+ * @return The return will be true if a frame was captured or false otherwise.
+ */
+bool Camera::captureFrame(Mat &frame) {
+	return (capture != NULL) && capture->grab() && capture->retrieve(frame);
+}
+
 /**
  * This method will return the next picture from the camera, following the algorithms described here:
  * @return The return will be a matrix of the picture that was last grabbed from the camera.  If the last frame is empty, the return will be an empty matrix.
  */
 Mat Camera::takePicture() {
+	uint32_t frameId;
+	return takePicture(frameId);
+}
+
+/**
+ * This method will return the next picture from the camera, along with the id of the frame.
+ * @param frameId This is set to the id of the frame which was returned.
+ * @return The return will be a matrix of the picture that was last grabbed from the camera.  If the last frame is empty, the return will be an empty matrix.
+ */
+Mat Camera::takePicture(uint32_t &frameId) {
+	Mat newMat = Mat();
+	takePicture(newMat, frameId);
+	return newMat;
+}
+
+/**
+ * This method will copy the next picture from the camera into the given matrix.  If the matrix already has the size and
+ * type of the picture, its memory is reused, so no memory is allocated.
+ * @param destination This is the matrix which the picture is copied into.
+ * @param frameId This is set to the id of the frame which was copied.
+ * @return The return will be true if a picture was copied or false if no picture has been captured yet.
+ */
+bool Camera::takePicture(Mat &destination, uint32_t &frameId) {
+	bool copied = false;
+	frameId = 0;
 	/**
-	 * 1.0 Create an empty matrix object.
+	 * 1.0 Lock the mutex protecting the last frame, so that the frame and its id are read together.
 	 */
-	Mat newMat = Mat();
+	mtx.lock();
+
 	/**
-	 * 2.0 If the last frame is not empty.
+	 * 1.1 If a frame has been captured and the last frame is not empty, copy it into the destination.  A frame held in a
+	 * pool buffer is never empty, so the frame id shows whether anything has been captured into it.
 	 */
-	if (!lastFrame->empty()) {
-		/**
-		 * 2.1 Lock the mutex protecting the last frame.
-		 */
-		mtx.lock();
+	if ((lastFrameId != 0) && (!lastFrame->empty())) {
+		lastFrame->copyTo(destination);
+		frameId = lastFrameId;
+		copied = true;
+	}
 
-		/**
-		 * 2.2 Copy the last frame to the return value.
-		 */
-		lastFrame->copyTo(newMat);
+	/**
+	 * 1.2 Unlock the mutex.
+	 */
+	mtx.unlock();
+	return copied;
+}
 
-		/**
-		 * 2.3 Unlock the mutex.
-		 */
+/**
+ * This method will hold the last frame in a buffer from the given pool, so that capturing never allocates.  It must be
+ * called before the camera is started.
+ * @param pool This is the pool.
+ */
+void Camera::setFramePool(FramePool *pool) {
+	if ((size_t) (frameWidth * frameHeight * 3) > pool->getBufferSize()) {
+		Logger::log(LOG_WARNING, "%s: The buffers of %s are too small for %dx%d frames.", myName.c_str(), pool->getName().c_str(),
+				frameWidth, frameHeight);
+		return;
+	}
+	uint8_t *buffer = pool->acquire();
+	if (buffer != NULL) {
+		mtx.lock();
+		*lastFrame = Mat(frameHeight, frameWidth, CV_8UC3, buffer);
+		if (framePool != NULL) {
+			framePool->release(frameBuffer);
+		}
+		framePool = pool;
+		frameBuffer = buffer;
 		mtx.unlock();
 	}
-	/**
-	 * 3.0 Return the matrix object.
-	 */
-	return newMat;
+}
+
+/**
+ * These methods will obtain the width and height of the natively captured images.
+ */
+int Camera::getWidth() {
+	return frameWidth;
+}
+
+int Camera::getHeight() {
+	return frameHeight;
 }
 
@@ -8,8 +8,9 @@
 #define CAMERA_H_
 
 #include "PeriodicTask.h"
+#include "RealTimeMutex.h"
+#include "FramePool.h"
 #include <opencv2/opencv.hpp>
-#include <mutex>
 
 using namespace std;
 using namespace cv;
@@ -27,9 +28,54 @@ private:
 	Mat *lastFrame;
 
 	/**
-	 * This is a mutex within the camera class that prevents race conditions as the images are manipulated.
+	 * This is a mutex within the camera class that prevents race conditions as the images are manipulated.  It uses priority
+	 * inheritance, as the camera and the tasks taking pictures run at different priorities.
 	 */
-	std::mutex mtx;
+	RealTimeMutex mtx;
+
+	/**
+	 * This is a count of the frames which have been captured.  It identifies the frame held in lastFrame.
+	 */
+	uint32_t frameCount = 0;
+
+	/**
+	 * This is the id of the frame which is held in lastFrame.
+	 */
+	uint32_t lastFrameId = 0;
+
+	/**
+	 * These are the width and height of the natively captured images.
+	 */
+	int frameWidth;
+	int frameHeight;
+
+	/**
+	 * This is the pool which the last frame is held in, and the buffer taken from it.  They are NULL if the last frame is
+	 * allocated from the heap.
+	 */
+	FramePool *framePool = NULL;
+	uint8_t *frameBuffer = NULL;
+
+protected:
+	/**
+	 * Construct a new instance of the camera class which captures from the given video capture.
+	 * @param width This is the width of the natively captured images.
+	 * @param height This is the height of the natively captured images.
+	 * @param threadName This is the name of the thread that is to be used to run the image capture.
+	 * @param period This is the period for the periodic task.
+	 * @param videoCapture This is the video capture, which the camera deletes.  It may be NULL for a derived class which
+	 * overrides captureFrame, such as one which generates its frames.
+	 */
+	Camera(int width, int height, std::string threadName, uint32_t period, VideoCapture *videoCapture);
+
+	/**
+	 * This method will capture the next frame.  It is called with the mutex protecting the last frame held.
+	 * @param frame This is the matrix which the frame is captured into.  If it is held in a pool buffer, it has the size and
+	 * type of the natively captured images, and the frame must be written into it in place.
+	 * @return The return will be true if a frame was captured or false otherwise.
+	 */
+	virtual bool captureFrame(Mat &frame);
+
 public:
 	/**
 	 * Construct a new instance of the camera class.
@@ -55,6 +101,36 @@ public:
 	 * @return The return will be a matrix of the picture that was last grabbed from the camera.
 	 */
 	Mat takePicture();
+
+	/**
+	 * This method will return the next picture from the camera, along with the id of the frame.
+	 * @param frameId This is set to the id of the frame which was returned.
+	 * @return The return will be a matrix of the picture that was last grabbed from the camera.
+	 */
+	Mat takePicture(uint32_t &frameId);
+
+	/**
+	 * This method will copy the next picture from the camera into the given matrix.  If the matrix already has the size
+	 * and type of the picture, its memory is reused, so no memory is allocated.
+	 * @param destination This is the matrix which the picture is copied into.
+	 * @param frameId This is set to the id of the frame which was copied.
+	 * @return The return will be true if a picture was copied or false if no picture has been captured yet.
+	 */
+	bool takePicture(Mat &destination, uint32_t &frameId);
+
+	/**
+	 * This method will hold the last frame in a buffer from the given pool, so that capturing never allocates.  It must
+	 * be called before the camera is started.  If the pool's buffers are too small, or it is exhausted, the last frame
+	 * stays on the heap.
+	 * @param pool This is the pool.
+	 */
+	void setFramePool(FramePool *pool);
+
+	/**
+	 * These methods will obtain the width and height of the natively captured images.
+	 */
+	int getWidth();
+	int getHeight();
 };
 #endif /* CAMERA_H_ */
 
@@ -0,0 +1,120 @@
+/**
+ * @file ControlProtocol.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This file defines the binary protocol of the control socket.  Each command
+ *      is a single ControlMessage datagram sent to the Unix domain datagram socket
+ *      of the streamer.  The streamer answers each command with a ControlMessage
+ *      holding the same command and sequence number, the status, and the values
+ *      which are now in effect.  All integers are in network byte order.
+ */
+
+#ifndef CONTROLPROTOCOL_H_
+#define CONTROLPROTOCOL_H_
+
+#include <stdint.h>
+
+/**
+ * This is the magic number which starts every control message ("RTSC").
+ */
+#define CONTROL_MAGIC 0x52545343
+
+/**
+ * This is the default path of the control socket.
+ */
+#define CONTROL_DEFAULT_PATH "/tmp/PiImageStreamer.control"
+
+/**
+ * This is the maximum length of the target name, including the terminating null.
+ */
+#define CONTROL_TARGET_SIZE 32
+
+/**
+ * This enumeration defines the commands.
+ */
+enum ControlCommand {
+	CONTROL_PRINT_THREADS = 1, /**< Print the thread diagnostics on the console of the streamer. */
+	CONTROL_RESET_STATISTICS = 2, /**< Reset the diagnostics of all threads and locks. */
+	CONTROL_PRINT_ANALYSIS = 3, /**< Print the schedulability analysis on the console of the streamer. */
+	CONTROL_TOGGLE_TRACE = 4, /**< Turn tracing on or off.  Argument 0 of the reply is 1 if tracing is now on. */
+	CONTROL_QUIT = 5, /**< Shut the streamer down. */
+	CONTROL_SET_PERIOD = 16, /**< Set the period of the target task to argument 0 microseconds. */
+	CONTROL_SET_PRIORITY = 17, /**< Set the priority of the target task to argument 0. */
+	CONTROL_SET_RESOLUTION = 18, /**< Set the transmitted width and height of the target stream task to arguments 0 and 1. */
+	CONTROL_SET_LINES_PER_DATAGRAM = 19, /**< Set the number of lines in each datagram of the target stream to argument 0. */
+	CONTROL_SET_PACING = 20, /**< Set the gap between the datagrams of the target stream to argument 0 microseconds (0 is unpaced). */
+	CONTROL_RELEASE_NOW = 21, /**< Release the target task immediately rather than at the end of its period. */
+	CONTROL_SET_ENCODING = 22, /**< Set the encoding of the target stream to argument 0 (a StreamEncoding) at JPEG quality argument 1 (0 keeps the quality). */
+	CONTROL_REQUEST_KEYFRAME = 23, /**< Send the next frame of the target stream as a keyframe, if it is sent as tile deltas. */
+	CONTROL_SET_PIXEL_FORMAT = 24, /**< Send the raw rows of the target stream in pixel format argument 0 (a StreamPixelFormat). */
+	CONTROL_SET_FEC = 25, /**< Protect the target stream with argument 1 parity datagrams for each argument 0 data datagrams (0 turns the error correction off). */
+	CONTROL_SET_RETRANSMISSION = 26 /**< Send lost datagrams of the target stream again while their frame is less than argument 0 milliseconds old (0 turns retransmission off). */
+};
+
+/**
+ * This enumeration defines the status of a reply.
+ */
+enum ControlStatus {
+	CONTROL_OK = 0, /**< The command was applied. */
+	CONTROL_UNKNOWN_COMMAND = 1, /**< The command is not known. */
+	CONTROL_UNKNOWN_TARGET = 2, /**< No task or stream has the target name. */
+	CONTROL_INVALID_ARGUMENT = 3, /**< An argument is out of range. */
+	CONTROL_REFUSED = 4 /**< The command was valid, but was refused (for example, by schedulability admission control). */
+};
+
+/**
+ * This structure is a control message, either a command or its reply.  It is 48 bytes.
+ */
+struct ControlMessage {
+	/**
+	 * This is the magic number, CONTROL_MAGIC.
+	 */
+	uint32_t magic;
+
+	/**
+	 * This is the command (a ControlCommand).
+	 */
+	uint8_t command;
+
+	/**
+	 * This is the status of a reply (a ControlStatus).  It is 0 in a command.
+	 */
+	uint8_t status;
+
+	/**
+	 * This is a sequence number chosen by the client, which is copied into the reply.
+	 */
+	uint16_t sequence;
+
+	/**
+	 * These are the arguments of the command, or the values in effect in the reply.
+	 */
+	int32_t arguments[2];
+
+	/**
+	 * This is the name of the task or stream which the command applies to, null terminated.  An empty name applies a
+	 * stream command to every stream.
+	 */
+	char target[CONTROL_TARGET_SIZE];
+} __attribute__((packed));
+
+#endif /* CONTROLPROTOCOL_H_ */
@@ -0,0 +1,395 @@
+/**
+ * @file ControlServer.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is the control plane of the streamer.
+ */
+
+#include "ControlServer.h"
+#include "PeriodicTask.h"
+#include "ImageCapturer.h"
+#include "ImageTransmitter.h"
+#include "SchedulabilityAnalyzer.h"
+#include "RealTimeMutex.h"
+#include "TraceBuffer.h"
+#include "Logger.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+/**
+ * This is the constructor for the class.
+ * @param path This is the path of the control socket.
+ * @param threadName This is the name of the thread in a human readable format.
+ */
+ControlServer::ControlServer(std::string path, std::string threadName) :
+		RunnableClass(threadName) {
+	socketPath = path;
+}
+
+/**
+ * This is the destructor for the class.  It will close and remove the socket.
+ */
+ControlServer::~ControlServer() {
+	if (controlSocket >= 0) {
+		close(controlSocket);
+		unlink(socketPath.c_str());
+	}
+}
+
+/**
+ * This is the run method.  It will receive and carry out commands until the server is stopped.
+ */
+void ControlServer::run() {
+	struct sockaddr_un address;
+
+	/**
+	 * 1.0 Create the socket, replacing any socket left behind by an earlier run.
+	 */
+	controlSocket = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (controlSocket < 0) {
+		Logger::log(LOG_ERROR, "%s: Cannot create the socket (%s).", myName.c_str(), strerror(errno));
+		requestQuit();
+		return;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+	unlink(socketPath.c_str());
+	if (bind(controlSocket, (struct sockaddr *) &address, sizeof(address)) != 0) {
+		Logger::log(LOG_ERROR, "%s: Cannot bind to %s (%s).", myName.c_str(), socketPath.c_str(), strerror(errno));
+		close(controlSocket);
+		controlSocket = -1;
+		requestQuit();
+		return;
+	}
+	Logger::log(LOG_INFO, "%s: Listening for commands on %s.", myName.c_str(), socketPath.c_str());
+
+	/**
+	 * 2.0 Receive commands until stopped.  The wait is limited so that a stop is noticed.
+	 */
+	while (keepGoing) {
+		struct pollfd waiting;
+		waiting.fd = controlSocket;
+		waiting.events = POLLIN;
+		if (poll(&waiting, 1, 250) <= 0) {
+			continue;
+		}
+
+		ControlMessage message;
+		struct sockaddr_un sender;
+		socklen_t senderLength = sizeof(sender);
+		ssize_t length = recvfrom(controlSocket, &message, sizeof(message), 0, (struct sockaddr *) &sender, &senderLength);
+
+		/**
+		 * 2.1 Ignore anything which is not a control message.
+		 */
+		if ((length != sizeof(message)) || (ntohl(message.magic) != CONTROL_MAGIC)) {
+			continue;
+		}
+
+		/**
+		 * 2.2 Carry out the command, and reply if the client has an address to reply to.
+		 */
+		execute(message);
+		if (senderLength > sizeof(sa_family_t)) {
+			sendto(controlSocket, &message, sizeof(message), 0, (struct sockaddr *) &sender, senderLength);
+		}
+	}
+
+	requestQuit();
+}
+
+/**
+ * This method will find the running thread with the given name.
+ * @param name This is the name of the thread.
+ * @return The return will be the thread, or NULL if there is none.
+ */
+RunnableClass* ControlServer::findThread(const std::string &name) {
+	for (RunnableClass *rc : RunnableClass::getRunningThreads()) {
+		if (rc->getName() == name) {
+			return rc;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * This method will carry out a command, filling in the status and values of the reply.
+ * @param message This is the command.  It is changed into the reply.
+ */
+void ControlServer::execute(ControlMessage &message) {
+	int32_t first = (int32_t) ntohl(message.arguments[0]);
+	int32_t second = (int32_t) ntohl(message.arguments[1]);
+	message.target[CONTROL_TARGET_SIZE - 1] = '\0';
+	std::string target(message.target);
+	ControlStatus status = CONTROL_OK;
+	bool found = false;
+
+	switch (message.command) {
+	case CONTROL_PRINT_THREADS:
+		RunnableClass::printThreads();
+		break;
+
+	case CONTROL_RESET_STATISTICS:
+		RunnableClass::resetAllThreadInformation();
+		break;
+
+	case CONTROL_PRINT_ANALYSIS:
+		SchedulabilityAnalyzer::printAnalysis();
+		break;
+
+	case CONTROL_TOGGLE_TRACE:
+		if (tracingAvailable) {
+			TraceBuffer::setEnabled(!TraceBuffer::isEnabled());
+		} else {
+			status = CONTROL_REFUSED;
+		}
+		first = TraceBuffer::isEnabled() ? 1 : 0;
+		break;
+
+	case CONTROL_QUIT:
+		requestQuit();
+		break;
+
+	case CONTROL_SET_PERIOD: {
+		/**
+		 * The task is woken up, so the period takes effect immediately rather than at the end of the task's current
+		 * period.  It may be refused by admission control.
+		 */
+		PeriodicTask *task = dynamic_cast<PeriodicTask*>(findThread(target));
+		if (task == NULL) {
+			status = CONTROL_UNKNOWN_TARGET;
+		} else if (first < 100) {
+			status = CONTROL_INVALID_ARGUMENT;
+		} else {
+			task->setTaskPeriod((uint32_t) first);
+			if (task->getTaskPeriod() != (uint32_t) first) {
+				status = CONTROL_REFUSED;
+			}
+			first = task->getTaskPeriod();
+		}
+		break;
+	}
+
+	case CONTROL_RELEASE_NOW: {
+		PeriodicTask *task = dynamic_cast<PeriodicTask*>(findThread(target));
+		if (task == NULL) {
+			status = CONTROL_UNKNOWN_TARGET;
+		} else {
+			task->releaseNow();
+		}
+		break;
+	}
+
+	case CONTROL_SET_PRIORITY: {
+		RunnableClass *thread = findThread(target);
+		if (thread == NULL) {
+			status = CONTROL_UNKNOWN_TARGET;
+		} else if ((first < 0) || (first > 99)) {
+			status = CONTROL_INVALID_ARGUMENT;
+		} else {
+			thread->setPriority(first);
+			first = thread->getPriority();
+		}
+		break;
+	}
+
+	case CONTROL_SET_RESOLUTION:
+		/**
+		 * The new size is applied by each stream task at the start of its next frame.  A stream whose frame pool buffers
+		 * can not hold the size refuses it.
+		 */
+		if ((first <= 0) || (second <= 0) || (first > 4096) || (second > 4096)) {
+			status = CONTROL_INVALID_ARGUMENT;
+			break;
+		}
+		for (RunnableClass *rc : RunnableClass::getRunningThreads()) {
+			ImageCapturer *capturer = dynamic_cast<ImageCapturer*>(rc);
+			if ((capturer != NULL) && (target.empty() || (capturer->getName() == target))) {
+				if (capturer->setResolution(first, second) == false) {
+					status = CONTROL_REFUSED;
+				}
+				found = true;
+			}
+		}
+		if (found == false) {
+			status = CONTROL_UNKNOWN_TARGET;
+		}
+		break;
+
+	case CONTROL_SET_LINES_PER_DATAGRAM:
+	case CONTROL_SET_PACING:
+		/**
+		 * The stream settings are picked up by each transmitter at the start of its next image.
+		 */
+		if (first < ((message.command == CONTROL_SET_PACING) ? 0 : 1)) {
+			status = CONTROL_INVALID_ARGUMENT;
+			break;
+		}
+		for (ImageTransmitter *transmitter : ImageTransmitter::getAllTransmitters()) {
+			if (target.empty() || (transmitter->getName() == target)) {
+				if (message.command == CONTROL_SET_PACING) {
+					transmitter->setDatagramInterval((uint32_t) first);
+				} else {
+					transmitter->setLinesPerDatagram(first);
+				}
+				found = true;
+			}
+		}
+		if (found == false) {
+			status = CONTROL_UNKNOWN_TARGET;
+		}
+		break;
+
+	case CONTROL_SET_ENCODING: {
+		/**
+		 * The JPEG and delta encodings are refused by a stream which was started without their encoder.  A quality of 0 keeps the
+		 * quality of each stream.
+		 */
+		int32_t encoding = first;
+		int32_t requestedQuality = second;
+		if ((encoding < ENCODING_RAW) || (encoding > ENCODING_LOSSLESS)) {
+			status = CONTROL_INVALID_ARGUMENT;
+			break;
+		}
+		for (ImageTransmitter *transmitter : ImageTransmitter::getAllTransmitters()) {
+			if (target.empty() || (transmitter->getName() == target)) {
+				int quality = (requestedQuality == 0) ? transmitter->getJpegQuality() : requestedQuality;
+				if (transmitter->setEncoding((StreamEncoding) encoding, quality) == false) {
+					status = ((quality < 1) || (quality > 100)) ? CONTROL_INVALID_ARGUMENT : CONTROL_REFUSED;
+				}
+				first = transmitter->getEncoding();
+				second = transmitter->getJpegQuality();
+				found = true;
+			}
+		}
+		if (found == false) {
+			status = CONTROL_UNKNOWN_TARGET;
+		}
+		break;
+	}
+
+	case CONTROL_SET_PIXEL_FORMAT:
+		if (PixelFormatConverter::isValid(first) == false) {
+			status = CONTROL_INVALID_ARGUMENT;
+			break;
+		}
+		for (ImageTransmitter *transmitter : ImageTransmitter::getAllTransmitters()) {
+			if (target.empty() || (transmitter->getName() == target)) {
+				transmitter->setPixelFormat(first);
+				found = true;
+			}
+		}
+		if (found == false) {
+			status = CONTROL_UNKNOWN_TARGET;
+		}
+		break;
+
+	case CONTROL_SET_FEC:
+		for (ImageTransmitter *transmitter : ImageTransmitter::getAllTransmitters()) {
+			if ((transmitter->getFecEncoder() != NULL) && (target.empty() || (transmitter->getName() == target))) {
+				if (transmitter->setFec(first, second) == false) {
+					status = CONTROL_INVALID_ARGUMENT;
+				}
+				found = true;
+			}
+		}
+		if (found == false) {
+			status = CONTROL_UNKNOWN_TARGET;
+		}
+		break;
+
+	case CONTROL_SET_RETRANSMISSION:
+		if (first < 0) {
+			status = CONTROL_INVALID_ARGUMENT;
+			break;
+		}
+		for (ImageTransmitter *transmitter : ImageTransmitter::getAllTransmitters()) {
+			if ((transmitter->getTransmitHistory() != NULL) && (target.empty() || (transmitter->getName() == target))) {
+				transmitter->setRetransmitBudget(first);
+				found = true;
+			}
+		}
+		if (found == false) {
+			status = CONTROL_UNKNOWN_TARGET;
+		}
+		break;
+
+	case CONTROL_REQUEST_KEYFRAME:
+		for (ImageTransmitter *transmitter : ImageTransmitter::getAllTransmitters()) {
+			if ((transmitter->getTileEncoder() != NULL) && (target.empty() || (transmitter->getName() == target))) {
+				transmitter->getTileEncoder()->requestKeyframe();
+				found = true;
+			}
+		}
+		if (found == false) {
+			status = CONTROL_UNKNOWN_TARGET;
+		}
+		break;
+
+	default:
+		status = CONTROL_UNKNOWN_COMMAND;
+		break;
+	}
+
+	/**
+	 * Fill in the reply.
+	 */
+	message.status = status;
+	message.arguments[0] = htonl((uint32_t) first);
+	message.arguments[1] = htonl((uint32_t) second);
+	if (status != CONTROL_OK) {
+		Logger::log(LOG_WARNING, "%s: Command %d for \"%s\" failed with status %d.", myName.c_str(), message.command,
+				target.c_str(), status);
+	}
+}
+
+/**
+ * This method will determine whether or not tracing can be turned on.
+ * @param available This is true if a trace drainer is running.
+ */
+void ControlServer::setTracingAvailable(bool available) {
+	tracingAvailable = available;
+}
+
+/**
+ * This method will set the quit flag and wake up any thread waiting for it.
+ */
+void ControlServer::requestQuit() {
+	std::lock_guard<std::mutex> guard(quitMutex);
+	quitRequested = true;
+	quitCondition.notify_all();
+}
+
+/**
+ * This method will block until a quit command is received or the server stops.
+ */
+void ControlServer::waitForQuit() {
+	std::unique_lock<std::mutex> lock(quitMutex);
+	quitCondition.wait(lock, [this] {return quitRequested;});
+}
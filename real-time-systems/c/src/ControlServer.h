@@ -0,0 +1,116 @@
+/**
+ * @file ControlServer.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is the control plane of the streamer.  It listens on a Unix domain
+ *      datagram socket for the binary commands defined in ControlProtocol.h, and
+ *      retunes the tasks and streams while they run: task periods and priorities,
+ *      the transmitted resolution, the datagram size and the datagram pacing.  The
+ *      changes are handed to the tasks, which apply them at their next frame
+ *      boundary, so the camera never has to be stopped.  It should run at the
+ *      default (non real time) priority.
+ */
+
+#ifndef CONTROLSERVER_H_
+#define CONTROLSERVER_H_
+
+#include "RunnableClass.h"
+#include "ControlProtocol.h"
+
+#include <string>
+#include <mutex>
+#include <condition_variable>
+
+class ControlServer: public RunnableClass {
+private:
+	/**
+	 * This is the path of the control socket.
+	 */
+	std::string socketPath;
+
+	/**
+	 * This is the control socket.
+	 */
+	int controlSocket = -1;
+
+	/**
+	 * This variable will determine whether or not tracing can be turned on, which requires a trace drainer.
+	 */
+	bool tracingAvailable = false;
+
+	/**
+	 * This variable is set when the streamer is to shut down, either due to a quit command or because the server stopped.
+	 * It is protected by the mutex, and the condition variable is signaled when it is set.
+	 */
+	bool quitRequested = false;
+	std::mutex quitMutex;
+	std::condition_variable quitCondition;
+
+	/**
+	 * This method will set the quit flag and wake up any thread waiting for it.
+	 */
+	void requestQuit();
+
+	/**
+	 * This method will carry out a command, filling in the status and values of the reply.
+	 * @param message This is the command.  It is changed into the reply.
+	 */
+	void execute(ControlMessage &message);
+
+	/**
+	 * This method will find the running thread with the given name.
+	 * @param name This is the name of the thread.
+	 * @return The return will be the thread, or NULL if there is none.
+	 */
+	static RunnableClass* findThread(const std::string &name);
+
+public:
+	/**
+	 * This is the constructor for the class.
+	 * @param path This is the path of the control socket.
+	 * @param threadName This is the name of the thread in a human readable format.
+	 */
+	ControlServer(std::string path, std::string threadName);
+
+	/**
+	 * This is the destructor for the class.  It will close and remove the socket.
+	 */
+	virtual ~ControlServer();
+
+	/**
+	 * This is the run method.  It will receive and carry out commands until the server is stopped.
+	 */
+	void run();
+
+	/**
+	 * This method will determine whether or not tracing can be turned on.
+	 * @param available This is true if a trace drainer is running.
+	 */
+	void setTracingAvailable(bool available);
+
+	/**
+	 * This method will block until a quit command is received or the server stops.
+	 */
+	void waitForQuit();
+};
+
+#endif /* CONTROLSERVER_H_ */
@@ -0,0 +1,83 @@
+/**
+ * @file ExecutionTimeModel.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class models the execution time of a task for simulation.
+ */
+
+#include "ExecutionTimeModel.h"
+
+/**
+ * This is the constructor for the class.
+ * @param distribution This is the distribution of the execution time.
+ * @param firstParameter This is the first parameter of the distribution, in microseconds.
+ * @param secondParameter This is the second parameter of the distribution, in microseconds.
+ * @param seed This is the seed of the random number generator.
+ */
+ExecutionTimeModel::ExecutionTimeModel(Distribution distribution, uint32_t firstParameter, uint32_t secondParameter, uint32_t seed) :
+		generator(seed) {
+	this->distribution = distribution;
+	this->firstParameter = firstParameter;
+	this->secondParameter = secondParameter;
+	overrunProbability = 0.0;
+	overrunTime = 0;
+}
+
+/**
+ * This method will set the chance of an overrun.
+ * @param probability This is the probability, from 0 to 1, that an execution overruns.
+ * @param extraTime This is the CPU time which an overrun adds, in microseconds.
+ */
+void ExecutionTimeModel::setOverrun(double probability, uint32_t extraTime) {
+	overrunProbability = probability;
+	overrunTime = extraTime;
+}
+
+/**
+ * This method will draw the execution time of the next execution.
+ * @return The return will be the execution time in microseconds.
+ */
+uint32_t ExecutionTimeModel::nextExecutionTime() {
+	double executionTime = firstParameter;
+
+	/**
+	 * 1.0 Draw from the distribution.
+	 */
+	if (distribution == DISTRIBUTION_UNIFORM) {
+		std::uniform_real_distribution<double> uniform(firstParameter, secondParameter);
+		executionTime = uniform(generator);
+	} else if (distribution == DISTRIBUTION_NORMAL) {
+		std::normal_distribution<double> normal(firstParameter, secondParameter);
+		executionTime = normal(generator);
+	}
+
+	/**
+	 * 2.0 Add an overrun, if this execution overruns.
+	 */
+	if (overrunProbability > 0.0) {
+		std::uniform_real_distribution<double> chance(0.0, 1.0);
+		if (chance(generator) < overrunProbability) {
+			executionTime += overrunTime;
+		}
+	}
+	return (executionTime > 0.0) ? (uint32_t) executionTime : 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file ExecutionTimeModel.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class models the execution time of a task for simulation.  Each call
+ *      draws the CPU time of the next execution from a distribution (constant,
+ *      uniform or normal), with an optional chance of an overrun.  The draws come
+ *      from a seeded generator, so a simulation is repeatable.
+ */
+
+#ifndef EXECUTIONTIMEMODEL_H_
+#define EXECUTIONTIMEMODEL_H_
+
+#include <random>
+#include <stdint.h>
+
+class ExecutionTimeModel {
+public:
+	/**
+	 * This enumeration defines the distributions of the execution time.
+	 */
+	enum Distribution {
+		DISTRIBUTION_CONSTANT, /**< Every execution takes the first parameter. */
+		DISTRIBUTION_UNIFORM, /**< Executions are uniformly distributed between the first and the second parameter. */
+		DISTRIBUTION_NORMAL /**< Executions are normally distributed, with the first parameter as the mean and the second as the standard deviation. */
+	};
+
+private:
+	/**
+	 * This is the distribution of the execution time.
+	 */
+	Distribution distribution;
+
+	/**
+	 * These are the parameters of the distribution, in microseconds.
+	 */
+	uint32_t firstParameter;
+	uint32_t secondParameter;
+
+	/**
+	 * This is the probability, from 0 to 1, that an execution overruns, and the CPU time which an overrun adds, in microseconds.
+	 */
+	double overrunProbability;
+	uint32_t overrunTime;
+
+	/**
+	 * This is the random number generator.
+	 */
+	std::mt19937 generator;
+
+public:
+	/**
+	 * This is the constructor for the class.
+	 * @param distribution This is the distribution of the execution time.
+	 * @param firstParameter This is the first parameter of the distribution, in microseconds.
+	 * @param secondParameter This is the second parameter of the distribution, in microseconds.  It is not used by the
+	 * constant distribution.
+	 * @param seed This is the seed of the random number generator.
+	 */
+	ExecutionTimeModel(Distribution distribution, uint32_t firstParameter, uint32_t secondParameter, uint32_t seed);
+
+	/**
+	 * This method will set the chance of an overrun.
+	 * @param probability This is the probability, from 0 to 1, that an execution overruns.
+	 * @param extraTime This is the CPU time which an overrun adds, in microseconds.
+	 */
+	void setOverrun(double probability, uint32_t extraTime);
+
+	/**
+	 * This method will draw the execution time of the next execution.
+	 * @return The return will be the execution time in microseconds.
+	 */
+	uint32_t nextExecutionTime();
+};
+
+#endif /* EXECUTIONTIMEMODEL_H_ */
@@ -0,0 +1,289 @@
+/**
+ * @file FecCodec.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class holds the arithmetic of the forward error correction of the
+ *      stream.
+ */
+
+#include "FecCodec.h"
+
+#include <string.h>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * This is the polynomial which GF(256) is built from, x^8 + x^4 + x^3 + x^2 + 1, without its top bit.
+ */
+#define FIELD_POLYNOMIAL 0x1D
+
+/**
+ * This structure holds the tables of the field: the logarithms and the powers of its generator, 2, and the Cauchy
+ * coefficients of the parity blocks.
+ */
+struct FieldTables {
+	uint8_t logarithm[256];
+	uint8_t power[512];
+	uint8_t coefficients[FecCodec::MAXIMUM_PARITY_COUNT][FecCodec::MAXIMUM_DATA_COUNT];
+
+	/**
+	 * This is the constructor for the tables.
+	 */
+	FieldTables() {
+		/**
+		 * 1.0 Build the powers of the generator, twice over so that the sum of two logarithms needs no modulo.
+		 */
+		int value = 1;
+		for (int exponent = 0; exponent < 255; exponent++) {
+			power[exponent] = value;
+			power[exponent + 255] = value;
+			logarithm[value] = exponent;
+			value <<= 1;
+			if (value & 0x100) {
+				value ^= 0x100 | FIELD_POLYNOMIAL;
+			}
+		}
+		power[510] = power[511] = 0;
+		logarithm[0] = 0;
+
+		/**
+		 * 2.0 Build the Cauchy matrix 1 / (x + y) from the distinct elements x = parity index and y = the number of parity
+		 * blocks + data index, and divide each column by its first element, so that the first row is all ones.  Scaling a
+		 * column keeps every square submatrix invertible.
+		 */
+		for (int dataIndex = 0; dataIndex < FecCodec::MAXIMUM_DATA_COUNT; dataIndex++) {
+			uint8_t y = FecCodec::MAXIMUM_PARITY_COUNT + dataIndex;
+			uint8_t scale = y;
+			for (int parityIndex = 0; parityIndex < FecCodec::MAXIMUM_PARITY_COUNT; parityIndex++) {
+				uint8_t sum = parityIndex ^ y;
+				coefficients[parityIndex][dataIndex] = power[logarithm[scale] + 255 - logarithm[sum]];
+			}
+		}
+	}
+};
+
+/**
+ * This method will obtain the tables of the field, which are built on first use.
+ * @return The return will be the tables.
+ */
+static const FieldTables& getTables() {
+	static const FieldTables tables;
+	return tables;
+}
+
+/**
+ * This method will multiply two elements of GF(256).
+ * @param a This is the first element.
+ * @param b This is the second element.
+ * @return The return will be the product.
+ */
+uint8_t FecCodec::multiply(uint8_t a, uint8_t b) {
+	const FieldTables &tables = getTables();
+	if ((a == 0) || (b == 0)) {
+		return 0;
+	}
+	return tables.power[tables.logarithm[a] + tables.logarithm[b]];
+}
+
+/**
+ * This method will obtain the coefficient which a data block is multiplied by in a parity block.
+ * @param parityIndex This is the index of the parity block, from 0 to MAXIMUM_PARITY_COUNT - 1.
+ * @param dataIndex This is the index of the data block, from 0 to MAXIMUM_DATA_COUNT - 1.
+ * @return The return will be the coefficient.
+ */
+uint8_t FecCodec::getCoefficient(int parityIndex, int dataIndex) {
+	return getTables().coefficients[parityIndex][dataIndex];
+}
+
+/**
+ * This method will XOR one region into another.
+ * @param destination This is the region which is changed.
+ * @param source This is the region which is added to it.
+ * @param length This is the length of the regions in bytes.
+ */
+void FecCodec::addRegion(uint8_t *destination, const uint8_t *source, size_t length) {
+	size_t index = 0;
+#if defined(__SSE2__)
+	for (; index + 16 <= length; index += 16) {
+		__m128i sum = _mm_xor_si128(_mm_loadu_si128((const __m128i*) (destination + index)), _mm_loadu_si128((const __m128i*) (source + index)));
+		_mm_storeu_si128((__m128i*) (destination + index), sum);
+	}
+#elif defined(__ARM_NEON)
+	for (; index + 16 <= length; index += 16) {
+		vst1q_u8(destination + index, veorq_u8(vld1q_u8(destination + index), vld1q_u8(source + index)));
+	}
+#endif
+	for (; index < length; index++) {
+		destination[index] ^= source[index];
+	}
+}
+
+/**
+ * This method will multiply a region by a constant and XOR it into another.
+ * @param destination This is the region which is changed.
+ * @param source This is the region which is multiplied and added to it.
+ * @param coefficient This is the constant.
+ * @param length This is the length of the regions in bytes.
+ */
+void FecCodec::multiplyAddRegion(uint8_t *destination, const uint8_t *source, uint8_t coefficient, size_t length) {
+	if (coefficient == 0) {
+		return;
+	} else if (coefficient == 1) {
+		addRegion(destination, source, length);
+		return;
+	}
+	const FieldTables &tables = getTables();
+	size_t index = 0;
+#if defined(__SSSE3__) || defined(__ARM_NEON)
+	/**
+	 * The product of a byte is the XOR of the products of its two nibbles, each of which is looked up in 16 entries.
+	 */
+	uint8_t low[16];
+	uint8_t high[16];
+	for (int nibble = 0; nibble < 16; nibble++) {
+		low[nibble] = multiply(coefficient, nibble);
+		high[nibble] = multiply(coefficient, nibble << 4);
+	}
+#endif
+#if defined(__SSSE3__)
+	const __m128i lowTable = _mm_loadu_si128((const __m128i*) low);
+	const __m128i highTable = _mm_loadu_si128((const __m128i*) high);
+	const __m128i mask = _mm_set1_epi8(0x0F);
+	for (; index + 16 <= length; index += 16) {
+		__m128i bytes = _mm_loadu_si128((const __m128i*) (source + index));
+		__m128i product = _mm_xor_si128(_mm_shuffle_epi8(lowTable, _mm_and_si128(bytes, mask)),
+				_mm_shuffle_epi8(highTable, _mm_and_si128(_mm_srli_epi16(bytes, 4), mask)));
+		_mm_storeu_si128((__m128i*) (destination + index), _mm_xor_si128(_mm_loadu_si128((const __m128i*) (destination + index)), product));
+	}
+#elif defined(__SSE2__)
+	/**
+	 * Without a byte shuffle, the region is doubled once per bit of the coefficient, and added where the bit is set.
+	 */
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i polynomial = _mm_set1_epi8(FIELD_POLYNOMIAL);
+	for (; index + 16 <= length; index += 16) {
+		__m128i bytes = _mm_loadu_si128((const __m128i*) (source + index));
+		__m128i product = zero;
+		for (uint8_t bits = coefficient;; bits >>= 1) {
+			if (bits & 1) {
+				product = _mm_xor_si128(product, bytes);
+			}
+			if (bits == 1) {
+				break;
+			}
+			__m128i overflow = _mm_and_si128(_mm_cmplt_epi8(bytes, zero), polynomial);
+			bytes = _mm_xor_si128(_mm_add_epi8(bytes, bytes), overflow);
+		}
+		_mm_storeu_si128((__m128i*) (destination + index), _mm_xor_si128(_mm_loadu_si128((const __m128i*) (destination + index)), product));
+	}
+#elif defined(__ARM_NEON)
+	uint8x8x2_t lowTable = { { vld1_u8(low), vld1_u8(low + 8) } };
+	uint8x8x2_t highTable = { { vld1_u8(high), vld1_u8(high + 8) } };
+	const uint8x16_t mask = vdupq_n_u8(0x0F);
+	for (; index + 16 <= length; index += 16) {
+		uint8x16_t bytes = vld1q_u8(source + index);
+		uint8x16_t lowNibbles = vandq_u8(bytes, mask);
+		uint8x16_t highNibbles = vshrq_n_u8(bytes, 4);
+		uint8x16_t product = vcombine_u8(veor_u8(vtbl2_u8(lowTable, vget_low_u8(lowNibbles)), vtbl2_u8(highTable, vget_low_u8(highNibbles))),
+				veor_u8(vtbl2_u8(lowTable, vget_high_u8(lowNibbles)), vtbl2_u8(highTable, vget_high_u8(highNibbles))));
+		vst1q_u8(destination + index, veorq_u8(vld1q_u8(destination + index), product));
+	}
+#endif
+	uint8_t logCoefficient = tables.logarithm[coefficient];
+	for (; index < length; index++) {
+		if (source[index] != 0) {
+			destination[index] ^= tables.power[logCoefficient + tables.logarithm[source[index]]];
+		}
+	}
+}
+
+/**
+ * This method will invert a square matrix over GF(256), in place, by Gauss-Jordan elimination.
+ * @param matrix This is the matrix, row by row.
+ * @param size This is the number of rows and columns, at most MAXIMUM_PARITY_COUNT.
+ * @return The return will be true if the matrix was inverted, or false if it is singular.
+ */
+bool FecCodec::invert(uint8_t *matrix, int size) {
+	const FieldTables &tables = getTables();
+	uint8_t work[MAXIMUM_PARITY_COUNT][2 * MAXIMUM_PARITY_COUNT];
+	if ((size < 1) || (size > MAXIMUM_PARITY_COUNT)) {
+		return false;
+	}
+
+	/**
+	 * 1.0 Place the identity to the right of the matrix.
+	 */
+	for (int row = 0; row < size; row++) {
+		memcpy(work[row], matrix + (row * size), size);
+		memset(work[row] + size, 0, size);
+		work[row][size + row] = 1;
+	}
+
+	for (int column = 0; column < size; column++) {
+		/**
+		 * 2.0 Find a row with a non zero pivot, swap it into place and scale it so the pivot is 1.
+		 */
+		int pivot = column;
+		while ((pivot < size) && (work[pivot][column] == 0)) {
+			pivot++;
+		}
+		if (pivot == size) {
+			return false;
+		}
+		if (pivot != column) {
+			uint8_t swap[2 * MAXIMUM_PARITY_COUNT];
+			memcpy(swap, work[pivot], 2 * size);
+			memcpy(work[pivot], work[column], 2 * size);
+			memcpy(work[column], swap, 2 * size);
+		}
+		uint8_t scale = tables.power[255 - tables.logarithm[work[column][column]]];
+		for (int index = 0; index < 2 * size; index++) {
+			work[column][index] = multiply(work[column][index], scale);
+		}
+
+		/**
+		 * 3.0 Clear the column from every other row.
+		 */
+		for (int row = 0; row < size; row++) {
+			uint8_t factor = work[row][column];
+			if ((row != column) && (factor != 0)) {
+				for (int index = 0; index < 2 * size; index++) {
+					work[row][index] ^= multiply(factor, work[column][index]);
+				}
+			}
+		}
+	}
+
+	/**
+	 * 4.0 The inverse is now to the right of the identity.
+	 */
+	for (int row = 0; row < size; row++) {
+		memcpy(matrix + (row * size), work[row] + size, size);
+	}
+	return true;
+}
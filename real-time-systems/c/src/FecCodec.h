@@ -0,0 +1,93 @@
+/**
+ * @file FecCodec.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class holds the arithmetic of the forward error correction of the
+ *      stream, which is a systematic Reed-Solomon code over GF(256) built from a
+ *      Cauchy matrix.  The matrix is scaled so that its first row is all ones,
+ *      so a group with one parity datagram is protected by plain XOR, and any
+ *      dataCount of a group's data and parity blocks rebuild the rest.
+ *
+ *      The work is in two region kernels, XOR and multiply-accumulate by a
+ *      constant.  Multiplication uses 16 entry tables of the products of each
+ *      nibble, looked up with PSHUFB on SSSE3 and VTBL on NEON.  Plain SSE2 has no
+ *      byte shuffle, so it multiplies by doubling and adding, eight steps at most.
+ */
+
+#ifndef FECCODEC_H_
+#define FECCODEC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+class FecCodec {
+public:
+	/**
+	 * These are the largest numbers of data and of parity blocks in a group.
+	 */
+	static const int MAXIMUM_DATA_COUNT = 64;
+	static const int MAXIMUM_PARITY_COUNT = 16;
+
+	/**
+	 * This method will multiply two elements of GF(256).
+	 * @param a This is the first element.
+	 * @param b This is the second element.
+	 * @return The return will be the product.
+	 */
+	static uint8_t multiply(uint8_t a, uint8_t b);
+
+	/**
+	 * This method will obtain the coefficient which a data block is multiplied by in a parity block.  The coefficients
+	 * do not depend on the size of the group, and those of the first parity block are all 1.
+	 * @param parityIndex This is the index of the parity block, from 0 to MAXIMUM_PARITY_COUNT - 1.
+	 * @param dataIndex This is the index of the data block, from 0 to MAXIMUM_DATA_COUNT - 1.
+	 * @return The return will be the coefficient.
+	 */
+	static uint8_t getCoefficient(int parityIndex, int dataIndex);
+
+	/**
+	 * This method will XOR one region into another.
+	 * @param destination This is the region which is changed.
+	 * @param source This is the region which is added to it.
+	 * @param length This is the length of the regions in bytes.
+	 */
+	static void addRegion(uint8_t *destination, const uint8_t *source, size_t length);
+
+	/**
+	 * This method will multiply a region by a constant and XOR it into another.
+	 * @param destination This is the region which is changed.
+	 * @param source This is the region which is multiplied and added to it.
+	 * @param coefficient This is the constant.
+	 * @param length This is the length of the regions in bytes.
+	 */
+	static void multiplyAddRegion(uint8_t *destination, const uint8_t *source, uint8_t coefficient, size_t length);
+
+	/**
+	 * This method will invert a square matrix over GF(256), in place.
+	 * @param matrix This is the matrix, row by row.
+	 * @param size This is the number of rows and columns, at most MAXIMUM_PARITY_COUNT.
+	 * @return The return will be true if the matrix was inverted, or false if it is singular.
+	 */
+	static bool invert(uint8_t *matrix, int size);
+};
+
+#endif /* FECCODEC_H_ */
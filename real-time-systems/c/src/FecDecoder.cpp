@@ -0,0 +1,254 @@
+/**
+ * @file FecDecoder.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class undoes the forward error correction of a stream at the
+ *      receiver.
+ */
+
+#include "FecDecoder.h"
+
+#include <arpa/inet.h>
+#include <string.h>
+
+/**
+ * This is the constructor for the class.
+ * @param maximumGroups This is the number of groups which are kept while they are incomplete.
+ */
+FecDecoder::FecDecoder(int maximumGroups) :
+		maximumGroups(maximumGroups), abandonedBefore(0), recoveredCount(0), lostCount(0) {
+}
+
+/**
+ * This is the destructor for the class.
+ */
+FecDecoder::~FecDecoder() {
+}
+
+/**
+ * This method will take in a received datagram.
+ * @param datagram This is the datagram.
+ * @param length This is the length of the datagram in bytes.
+ * @param innerLength This is filled in with the length of the datagram which is returned.
+ * @return The return will be the datagram without its forward error correction, or NULL if there is nothing for the
+ * receiver in it.
+ */
+const uint8_t* FecDecoder::receive(const uint8_t *datagram, size_t length, size_t &innerLength) {
+	/**
+	 * 1.0 Datagrams which are not protected pass through.
+	 */
+	const StreamFecHeader *header = (const StreamFecHeader*) datagram;
+	if ((length < sizeof(StreamFecHeader)) || (ntohl(header->magic) != STREAM_FEC_MAGIC)) {
+		innerLength = length;
+		return datagram;
+	}
+	int dataCount = header->dataCount;
+	int parityCount = header->parityCount;
+	if ((header->version != STREAM_VERSION) || (dataCount < 1) || (dataCount > FecCodec::MAXIMUM_DATA_COUNT) || (parityCount < 1)
+			|| (parityCount > FecCodec::MAXIMUM_PARITY_COUNT) || (header->index >= dataCount + parityCount)) {
+		return NULL;
+	}
+
+	/**
+	 * 2.0 Find the group, and give up on those which are too old to be completed.  The data of a group which has
+	 * already been given up on is still handed back, but not kept.
+	 */
+	const uint8_t *payload = datagram + sizeof(StreamFecHeader);
+	size_t payloadLength = length - sizeof(StreamFecHeader);
+	bool isParity = (header->index >= dataCount);
+	uint32_t groupId = ntohl(header->groupId);
+	auto found = groups.find(groupId);
+	if (found == groups.end()) {
+		while ((groupId >= abandonedBefore) && ((int) groups.size() >= maximumGroups)) {
+			auto oldest = groups.begin();
+			abandon(oldest->second);
+			abandonedBefore = oldest->first + 1;
+			groups.erase(oldest);
+		}
+		if (groupId < abandonedBefore) {
+			innerLength = payloadLength;
+			return isParity ? NULL : payload;
+		}
+		found = groups.emplace(groupId, Group()).first;
+	}
+	Group &group = found->second;
+
+	/**
+	 * 3.0 Keep the block, unless it has already been received or rebuilt.  The data block is the length followed by
+	 * the datagram, as it was protected.
+	 */
+	int slot = isParity ? FecCodec::MAXIMUM_DATA_COUNT + (header->index - dataCount) : header->index;
+	if ((group.complete) || (group.blocks[slot].empty() == false)) {
+		return NULL;
+	}
+	if (isParity) {
+		group.dataCount = dataCount;
+		group.parityCount = parityCount;
+		group.blocks[slot].assign(payload, payload + payloadLength);
+	} else {
+		if (dataCount > group.maximumDataCount) {
+			group.maximumDataCount = dataCount;
+		}
+		group.blocks[slot].resize(payloadLength + 2);
+		group.blocks[slot][0] = payloadLength >> 8;
+		group.blocks[slot][1] = payloadLength & 0xFF;
+		memcpy(&group.blocks[slot][2], payload, payloadLength);
+	}
+
+	/**
+	 * 4.0 Rebuild what was lost, if the group can be completed now.
+	 */
+	recover(group);
+	if (isParity) {
+		return NULL;
+	}
+	innerLength = payloadLength;
+	return payload;
+}
+
+/**
+ * This method will rebuild the lost data datagrams of a group, if enough of it has been received.
+ * @param group This is the group.
+ */
+void FecDecoder::recover(Group &group) {
+	/**
+	 * 1.0 The size of the group is only known once a parity block has arrived.  List the lost data blocks, and the
+	 * parity blocks which can stand in for them.
+	 */
+	if ((group.dataCount == 0) || group.complete) {
+		return;
+	}
+	int lost[FecCodec::MAXIMUM_PARITY_COUNT];
+	int lostBlocks = 0;
+	int parityRows[FecCodec::MAXIMUM_PARITY_COUNT];
+	int parityRowCount = 0;
+	for (int index = 0; index < group.parityCount; index++) {
+		if (group.blocks[FecCodec::MAXIMUM_DATA_COUNT + index].empty() == false) {
+			parityRows[parityRowCount++] = index;
+		}
+	}
+	for (int index = 0; index < group.dataCount; index++) {
+		if (group.blocks[index].empty()) {
+			if (lostBlocks == parityRowCount) {
+				return;
+			}
+			lost[lostBlocks++] = index;
+		}
+	}
+	group.complete = true;
+	if (lostBlocks == 0) {
+		return;
+	}
+
+	/**
+	 * 2.0 Take the received data out of one parity block per lost block, which leaves the lost blocks multiplied by
+	 * their coefficients.
+	 */
+	size_t blockLength = group.blocks[FecCodec::MAXIMUM_DATA_COUNT + parityRows[0]].size();
+	std::vector<uint8_t> syndromes[FecCodec::MAXIMUM_PARITY_COUNT];
+	uint8_t matrix[FecCodec::MAXIMUM_PARITY_COUNT * FecCodec::MAXIMUM_PARITY_COUNT];
+	for (int row = 0; row < lostBlocks; row++) {
+		int parityIndex = parityRows[row];
+		syndromes[row] = group.blocks[FecCodec::MAXIMUM_DATA_COUNT + parityIndex];
+		syndromes[row].resize(blockLength, 0);
+		for (int index = 0; index < group.dataCount; index++) {
+			const std::vector<uint8_t> &block = group.blocks[index];
+			if ((block.empty() == false) && (block.size() <= blockLength)) {
+				FecCodec::multiplyAddRegion(syndromes[row].data(), block.data(), FecCodec::getCoefficient(parityIndex, index), block.size());
+			}
+		}
+		for (int column = 0; column < lostBlocks; column++) {
+			matrix[(row * lostBlocks) + column] = FecCodec::getCoefficient(parityIndex, lost[column]);
+		}
+	}
+
+	/**
+	 * 3.0 Solve for the lost blocks, and queue the datagrams they hold.
+	 */
+	if (FecCodec::invert(matrix, lostBlocks) == false) {
+		abandon(group);
+		return;
+	}
+	for (int column = 0; column < lostBlocks; column++) {
+		std::vector<uint8_t> &block = group.blocks[lost[column]];
+		block.assign(blockLength, 0);
+		for (int row = 0; row < lostBlocks; row++) {
+			FecCodec::multiplyAddRegion(block.data(), syndromes[row].data(), matrix[(column * lostBlocks) + row], blockLength);
+		}
+		size_t datagramLength = ((size_t) block[0] << 8) | block[1];
+		if (datagramLength + 2 <= blockLength) {
+			recovered.push_back(std::vector<uint8_t>(block.begin() + 2, block.begin() + 2 + datagramLength));
+			recoveredCount++;
+		} else {
+			lostCount++;
+		}
+	}
+}
+
+/**
+ * This method will give up on a group, counting its lost data datagrams.  If no parity block arrived, the size of the
+ * group is not known, and the data blocks after the last one received are not counted.
+ * @param group This is the group.
+ */
+void FecDecoder::abandon(Group &group) {
+	if (group.complete) {
+		return;
+	}
+	int dataCount = group.dataCount;
+	if (dataCount == 0) {
+		for (int index = 0; index < group.maximumDataCount; index++) {
+			if (group.blocks[index].empty() == false) {
+				dataCount = index + 1;
+			}
+		}
+	}
+	for (int index = 0; index < dataCount; index++) {
+		if (group.blocks[index].empty()) {
+			lostCount++;
+		}
+	}
+	group.complete = true;
+}
+
+/**
+ * This method will take the oldest datagram which has been rebuilt.
+ * @param datagram This is filled in with the datagram.
+ * @return The return will be true if a datagram was taken, or false if there are none.
+ */
+bool FecDecoder::takeRecovered(std::vector<uint8_t> &datagram) {
+	if (recovered.empty()) {
+		return false;
+	}
+	datagram.swap(recovered.front());
+	recovered.pop_front();
+	return true;
+}
+
+/**
+ * These methods obtain the statistics of the decoder: the data datagrams rebuilt, and those which were lost for good.
+ */
+uint64_t FecDecoder::getRecoveredCount() {
+	return recoveredCount;
+}
+uint64_t FecDecoder::getLostCount() {
+	return lostCount;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file FecDecoder.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class undoes the forward error correction of a stream at the
+ *      receiver.  Data datagrams are handed straight back without their header,
+ *      and kept until their group is complete.  Once a group has lost no more
+ *      data datagrams than it has received parity datagrams, the lost ones are
+ *      rebuilt and queued for the receiver to take.  Datagrams which are not
+ *      protected pass through unchanged.  It is meant for receivers, and
+ *      allocates as groups arrive.
+ */
+
+#ifndef FECDECODER_H_
+#define FECDECODER_H_
+
+#include "FecCodec.h"
+#include "StreamProtocol.h"
+
+#include <list>
+#include <map>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+class FecDecoder {
+private:
+	/**
+	 * This structure holds the blocks of a group which have been received.
+	 */
+	struct Group {
+		/**
+		 * These are the number of data datagrams in the group, which is 0 until a parity datagram tells it, and the
+		 * number of parity datagrams.
+		 */
+		int dataCount = 0;
+		int parityCount = 0;
+
+		/**
+		 * This is the largest number of data datagrams which the group can hold, from the headers of its data datagrams.
+		 */
+		int maximumDataCount = 0;
+
+		/**
+		 * This is true once every data datagram of the group has been received or rebuilt.
+		 */
+		bool complete = false;
+
+		/**
+		 * These are the protected blocks, the data blocks followed by the parity blocks.  A block which has not been
+		 * received is empty.
+		 */
+		std::vector<uint8_t> blocks[FecCodec::MAXIMUM_DATA_COUNT + FecCodec::MAXIMUM_PARITY_COUNT];
+	};
+
+	/**
+	 * These are the groups which are being received, by their count.
+	 */
+	std::map<uint32_t, Group> groups;
+
+	/**
+	 * This is the number of groups which are kept.  Older groups are given up on.
+	 */
+	int maximumGroups;
+
+	/**
+	 * This is the count of the oldest group which is still kept.  Every older group has been given up on.
+	 */
+	uint32_t abandonedBefore;
+
+	/**
+	 * These are the datagrams which have been rebuilt and not yet taken.
+	 */
+	std::list<std::vector<uint8_t>> recovered;
+
+	/**
+	 * These are the statistics of the decoder: the data datagrams rebuilt, and those which were lost for good.
+	 */
+	uint64_t recoveredCount;
+	uint64_t lostCount;
+
+	/**
+	 * This method will rebuild the lost data datagrams of a group, if enough of it has been received.
+	 * @param group This is the group.
+	 */
+	void recover(Group &group);
+
+	/**
+	 * This method will give up on a group, counting its lost data datagrams.
+	 * @param group This is the group.
+	 */
+	void abandon(Group &group);
+
+public:
+	/**
+	 * This is the constructor for the class.
+	 * @param maximumGroups This is the number of groups which are kept while they are incomplete.
+	 */
+	FecDecoder(int maximumGroups);
+
+	/**
+	 * This is the destructor for the class.
+	 */
+	virtual ~FecDecoder();
+
+	/**
+	 * This method will take in a received datagram.
+	 * @param datagram This is the datagram.
+	 * @param length This is the length of the datagram in bytes.
+	 * @param innerLength This is filled in with the length of the datagram which is returned.
+	 * @return The return will be the datagram without its forward error correction, or NULL if there is nothing for the
+	 * receiver in it, as it is a parity datagram, a duplicate, or malformed.
+	 */
+	const uint8_t* receive(const uint8_t *datagram, size_t length, size_t &innerLength);
+
+	/**
+	 * This method will take the oldest datagram which has been rebuilt.
+	 * @param datagram This is filled in with the datagram.
+	 * @return The return will be true if a datagram was taken, or false if there are none.
+	 */
+	bool takeRecovered(std::vector<uint8_t> &datagram);
+
+	/**
+	 * These methods obtain the statistics of the decoder: the data datagrams rebuilt, and those which were lost for good.
+	 */
+	uint64_t getRecoveredCount();
+	uint64_t getLostCount();
+};
+
+#endif /* FECDECODER_H_ */
@@ -0,0 +1,194 @@
+/**
+ * @file FecEncoder.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class protects the datagrams of a stream with forward error
+ *      correction.
+ */
+
+#include "FecEncoder.h"
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * This is the constructor for the class.
+ * @param dataCount This is the number of data datagrams in a group, from 1 to FecCodec::MAXIMUM_DATA_COUNT.
+ * @param parityCount This is the number of parity datagrams for each group, from 1 to FecCodec::MAXIMUM_PARITY_COUNT.
+ */
+FecEncoder::FecEncoder(int dataCount, int parityCount) :
+		groupId(0), groupSize(0), blockLength(0), groupsClosed(0) {
+	maximumParityCount = (parityCount < 1) ? 1 : ((parityCount > FecCodec::MAXIMUM_PARITY_COUNT) ? FecCodec::MAXIMUM_PARITY_COUNT : parityCount);
+	this->dataCount = 1;
+	this->parityCount = 1;
+	configure(dataCount, maximumParityCount);
+
+	/**
+	 * The parity buffers hold the largest parity datagram, and start out as zeros, which is the parity of nothing.
+	 */
+	for (int index = 0; index < FecCodec::MAXIMUM_PARITY_COUNT; index++) {
+		parity[index] = NULL;
+		void *buffer = NULL;
+		if ((index < maximumParityCount) && (posix_memalign(&buffer, 64, STREAM_MAX_DATAGRAM_SIZE) == 0)) {
+			parity[index] = (uint8_t*) buffer;
+			memset(parity[index], 0, STREAM_MAX_DATAGRAM_SIZE);
+		}
+	}
+}
+
+/**
+ * This is the destructor for the class.
+ */
+FecEncoder::~FecEncoder() {
+	for (int index = 0; index < FecCodec::MAXIMUM_PARITY_COUNT; index++) {
+		free(parity[index]);
+	}
+}
+
+/**
+ * This method will change the size of the groups.  It must only be called when no group is open.
+ * @param dataCount This is the number of data datagrams in a group.
+ * @param parityCount This is the number of parity datagrams for each group.
+ * @return The return will be true if the group size was changed, or false if it is out of range.
+ */
+bool FecEncoder::configure(int dataCount, int parityCount) {
+	if ((dataCount < 1) || (dataCount > FecCodec::MAXIMUM_DATA_COUNT) || (parityCount < 1) || (parityCount > maximumParityCount)) {
+		return false;
+	}
+	this->dataCount = dataCount;
+	this->parityCount = parityCount;
+	return true;
+}
+
+/**
+ * This method will add a datagram to the open group, opening a new group if there is none.
+ * @param datagram This is the datagram, which must be at most MAXIMUM_DATAGRAM_SIZE bytes.
+ * @param length This is the length of the datagram in bytes.
+ * @param header This is filled in with the header which is to be sent ahead of the datagram.
+ * @return The return will be true if the group is now full, and is to be closed.
+ */
+bool FecEncoder::addDatagram(const uint8_t *datagram, size_t length, StreamFecHeader &header) {
+	/**
+	 * 1.0 If this opens a group, clear the parity blocks of the last group, which have been sent by now.
+	 */
+	if (groupSize == 0) {
+		for (int index = 0; index < maximumParityCount; index++) {
+			memset(parity[index] + sizeof(StreamFecHeader), 0, blockLength);
+		}
+		blockLength = 0;
+	}
+
+	/**
+	 * 2.0 Fill in the header of the data datagram.
+	 */
+	header.magic = htonl(STREAM_FEC_MAGIC);
+	header.version = STREAM_VERSION;
+	header.index = groupSize;
+	header.dataCount = dataCount;
+	header.parityCount = parityCount;
+	header.groupId = htonl(groupId);
+
+	/**
+	 * 3.0 The protected block is the length of the datagram followed by the datagram.  Each parity block adds its multiple
+	 * of it, and the bytes beyond the block are zero, so they are left alone.
+	 */
+	uint8_t lengthBytes[2] = { (uint8_t) (length >> 8), (uint8_t) length };
+	for (int index = 0; index < parityCount; index++) {
+		uint8_t coefficient = FecCodec::getCoefficient(index, groupSize);
+		uint8_t *block = parity[index] + sizeof(StreamFecHeader);
+		FecCodec::multiplyAddRegion(block, lengthBytes, coefficient, 2);
+		FecCodec::multiplyAddRegion(block + 2, datagram, coefficient, length);
+	}
+	if (length + 2 > blockLength) {
+		blockLength = length + 2;
+	}
+	groupSize++;
+	return groupSize == dataCount;
+}
+
+/**
+ * This method will close the open group, filling in the headers of its parity datagrams.
+ * @return The return will be the number of parity datagrams to send, which is 0 if no group is open.
+ */
+int FecEncoder::closeGroup() {
+	if (groupSize == 0) {
+		return 0;
+	}
+	for (int index = 0; index < parityCount; index++) {
+		StreamFecHeader *header = (StreamFecHeader*) parity[index];
+		header->magic = htonl(STREAM_FEC_MAGIC);
+		header->version = STREAM_VERSION;
+		header->index = groupSize + index;
+		header->dataCount = groupSize;
+		header->parityCount = parityCount;
+		header->groupId = htonl(groupId);
+	}
+	groupsClosed.fetch_add(1, std::memory_order_relaxed);
+	groupId++;
+	groupSize = 0;
+	return parityCount;
+}
+
+/**
+ * This method will obtain a parity datagram of the group which was just closed.  It stays valid until a datagram is
+ * added to the next group.
+ * @param index This is the index of the parity datagram.
+ * @param length This is filled in with the length of the datagram in bytes.
+ * @return The return will be the datagram.
+ */
+const uint8_t* FecEncoder::getParityDatagram(int index, size_t &length) {
+	length = sizeof(StreamFecHeader) + blockLength;
+	return parity[index];
+}
+
+/**
+ * This method will discard the open group without sending its parity, such as when a frame is abandoned.  The group
+ * keeps its count, so that a receiver never mixes its datagrams with those of the next group.
+ */
+void FecEncoder::discardGroup() {
+	if (groupSize > 0) {
+		groupId++;
+		groupSize = 0;
+	}
+}
+
+/**
+ * These methods obtain the size of the groups, and the most parity datagrams which can be configured.
+ */
+int FecEncoder::getDataCount() {
+	return dataCount;
+}
+int FecEncoder::getParityCount() {
+	return parityCount;
+}
+int FecEncoder::getMaximumParityCount() {
+	return maximumParityCount;
+}
+
+/**
+ * This method will obtain the number of groups which have been closed.
+ * @return The return will be the number of groups.
+ */
+uint64_t FecEncoder::getGroupsClosed() {
+	return groupsClosed.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,145 @@
+/**
+ * @file FecEncoder.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class protects the datagrams of a stream with forward error
+ *      correction.  The datagrams are taken in groups, and each one is added
+ *      into the parity blocks of its group as it is sent, so the datagrams are
+ *      never copied or held.  When the group is full, or the frame ends, the
+ *      group is closed and its parity datagrams are ready to send.  All of the
+ *      memory is allocated when the encoder is constructed.
+ */
+
+#ifndef FECENCODER_H_
+#define FECENCODER_H_
+
+#include "FecCodec.h"
+#include "StreamProtocol.h"
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+class FecEncoder {
+private:
+	/**
+	 * These are the number of data datagrams in a full group, and the number of parity datagrams sent for each group.
+	 */
+	int dataCount;
+	int parityCount;
+
+	/**
+	 * This is the largest number of parity datagrams a group can be given, which is the number of parity buffers.
+	 */
+	int maximumParityCount;
+
+	/**
+	 * These are the parity datagrams of the open group, each a StreamFecHeader followed by the parity block.
+	 */
+	uint8_t *parity[FecCodec::MAXIMUM_PARITY_COUNT];
+
+	/**
+	 * These are the count of the open group, the number of datagrams added to it, and the length of its longest
+	 * protected block.
+	 */
+	uint32_t groupId;
+	int groupSize;
+	size_t blockLength;
+
+	/**
+	 * This is the number of groups which have been closed.  It may be read by any thread.
+	 */
+	std::atomic<uint64_t> groupsClosed;
+
+public:
+	/**
+	 * This is the largest datagram which can be protected.
+	 */
+	static const size_t MAXIMUM_DATAGRAM_SIZE = STREAM_MAX_DATAGRAM_SIZE - STREAM_FEC_OVERHEAD;
+
+	/**
+	 * This is the constructor for the class.
+	 * @param dataCount This is the number of data datagrams in a group, from 1 to FecCodec::MAXIMUM_DATA_COUNT.
+	 * @param parityCount This is the number of parity datagrams for each group, from 1 to FecCodec::MAXIMUM_PARITY_COUNT.
+	 * It is also the most which can be configured later.
+	 */
+	FecEncoder(int dataCount, int parityCount);
+
+	/**
+	 * This is the destructor for the class.
+	 */
+	virtual ~FecEncoder();
+
+	/**
+	 * This method will change the size of the groups.  It must only be called when no group is open.
+	 * @param dataCount This is the number of data datagrams in a group.
+	 * @param parityCount This is the number of parity datagrams for each group, at most the number given when the
+	 * encoder was constructed.
+	 * @return The return will be true if the group size was changed, or false if it is out of range.
+	 */
+	bool configure(int dataCount, int parityCount);
+
+	/**
+	 * This method will add a datagram to the open group, opening a new group if there is none.
+	 * @param datagram This is the datagram, which must be at most MAXIMUM_DATAGRAM_SIZE bytes.
+	 * @param length This is the length of the datagram in bytes.
+	 * @param header This is filled in with the header which is to be sent ahead of the datagram.
+	 * @return The return will be true if the group is now full, and is to be closed.
+	 */
+	bool addDatagram(const uint8_t *datagram, size_t length, StreamFecHeader &header);
+
+	/**
+	 * This method will close the open group, filling in the headers of its parity datagrams.
+	 * @return The return will be the number of parity datagrams to send, which is 0 if no group is open.
+	 */
+	int closeGroup();
+
+	/**
+	 * This method will obtain a parity datagram of the group which was just closed.  It stays valid until a datagram
+	 * is added to the next group.
+	 * @param index This is the index of the parity datagram.
+	 * @param length This is filled in with the length of the datagram in bytes.
+	 * @return The return will be the datagram.
+	 */
+	const uint8_t* getParityDatagram(int index, size_t &length);
+
+	/**
+	 * This method will discard the open group without sending its parity, such as when a frame is abandoned.  The
+	 * group keeps its count, so that a receiver never mixes its datagrams with those of the next group.
+	 */
+	void discardGroup();
+
+	/**
+	 * These methods obtain the size of the groups, and the most parity datagrams which can be configured.
+	 */
+	int getDataCount();
+	int getParityCount();
+	int getMaximumParityCount();
+
+	/**
+	 * This method will obtain the number of groups which have been closed.
+	 * @return The return will be the number of groups.
+	 */
+	uint64_t getGroupsClosed();
+};
+
+#endif /* FECENCODER_H_ */
@@ -0,0 +1,54 @@
+/**
+ * @file FeedbackReceiver.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a task which acts on the feedback for an image stream as
+ *      soon as it arrives.
+ */
+
+#include "FeedbackReceiver.h"
+
+/**
+ * This is the constructor for the class.
+ * @param transmitter This is the image stream whose feedback is acted on.  It is not owned by the task.
+ * @param threadName This is the name of the thread in a human readable format.
+ */
+FeedbackReceiver::FeedbackReceiver(ImageTransmitter *transmitter, std::string threadName) :
+		RunnableClass(threadName) {
+	this->transmitter = transmitter;
+}
+
+/**
+ * This is the destructor for the class.
+ */
+FeedbackReceiver::~FeedbackReceiver() {
+}
+
+/**
+ * This is the run method.  It will act on the feedback as it arrives until the task is stopped.  The wait is limited so
+ * that a stop is noticed.
+ */
+void FeedbackReceiver::run() {
+	while (keepGoing) {
+		transmitter->serviceFeedback(100);
+	}
+}
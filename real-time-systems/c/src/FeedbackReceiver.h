@@ -0,0 +1,67 @@
+/**
+ * @file FeedbackReceiver.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a task which acts on the feedback which the receivers send
+ *      back for an image stream as soon as it arrives.  It waits on the socket of
+ *      the stream, so that the datagrams which a receiver asks for again are sent
+ *      within about a round trip, rather than when the next image is streamed.  It
+ *      should run below the image stream, which it shares the history of the
+ *      stream with under a priority inheritance lock.
+ */
+
+#ifndef FEEDBACKRECEIVER_H_
+#define FEEDBACKRECEIVER_H_
+
+#include "RunnableClass.h"
+#include "ImageTransmitter.h"
+
+#include <string>
+
+class FeedbackReceiver: public RunnableClass {
+private:
+	/**
+	 * This is the image stream whose feedback is acted on.  For a simulcast, it is the first stream, whose socket the
+	 * others share.
+	 */
+	ImageTransmitter *transmitter;
+
+public:
+	/**
+	 * This is the constructor for the class.
+	 * @param transmitter This is the image stream whose feedback is acted on.  It is not owned by the task.
+	 * @param threadName This is the name of the thread in a human readable format.
+	 */
+	FeedbackReceiver(ImageTransmitter *transmitter, std::string threadName);
+
+	/**
+	 * This is the destructor for the class.
+	 */
+	virtual ~FeedbackReceiver();
+
+	/**
+	 * This is the run method.  It will act on the feedback as it arrives until the task is stopped.
+	 */
+	void run();
+};
+
+#endif /* FEEDBACKRECEIVER_H_ */
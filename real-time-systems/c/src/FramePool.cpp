@@ -0,0 +1,231 @@
+/**
+ * @file FramePool.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a fixed capacity pool of frame buffers, which is allocated
+ *      once at startup.
+ */
+
+#include "FramePool.h"
+#include "Logger.h"
+
+#include <sys/mman.h>
+#include <string.h>
+#include <errno.h>
+
+/*
+ * This is a file scoped variable which holds a list of all of the frame pools.
+ */
+std::list<FramePool*> FramePool::allPools;
+
+/**
+ * This is the size of a cache line, to which every buffer is aligned.
+ */
+static const size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * This is the size of a huge page.  The mapping is rounded up to it when huge pages are used.
+ */
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/**
+ * This is the constructor for the class.  It maps and touches the memory for all of the buffers.
+ * @param name This is the human readable name of the pool.
+ * @param size This is the size of each buffer in bytes.
+ * @param count This is the number of buffers.
+ * @param useHugePages This is true to back the buffers with huge pages, if the system has them available.
+ */
+FramePool::FramePool(std::string name, size_t size, uint32_t count, bool useHugePages) :
+		freeHead(0), available(0), exhaustedCount(0) {
+	poolName = name;
+	bufferSize = size;
+	bufferStride = (size + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+	bufferCount = count;
+	hugePages = false;
+	memory = NULL;
+	mappedSize = bufferStride * count;
+
+	/**
+	 * 1.0 Map the buffers, from huge pages if they were requested and are available, otherwise from normal pages.  A
+	 * mapping is page aligned, and so every buffer is cache line aligned.
+	 */
+	if (useHugePages) {
+		size_t hugeSize = (mappedSize + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+		void *mapping = mmap(NULL, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (mapping != MAP_FAILED) {
+			memory = (uint8_t*) mapping;
+			mappedSize = hugeSize;
+			hugePages = true;
+		} else {
+			Logger::log(LOG_WARNING, "%s: Huge pages are not available (%s).  Using normal pages.", poolName.c_str(), strerror(errno));
+		}
+	}
+	if (memory == NULL) {
+		void *mapping = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mapping == MAP_FAILED) {
+			Logger::log(LOG_ERROR, "%s: Cannot map %lu bytes for the frame buffers (%s).", poolName.c_str(), (unsigned long) mappedSize,
+					strerror(errno));
+			mappedSize = 0;
+			bufferCount = 0;
+		} else {
+			memory = (uint8_t*) mapping;
+
+			/**
+			 * Ask for transparent huge pages, if huge pages were wanted but could not be reserved.
+			 */
+			if (useHugePages) {
+				madvise(memory, mappedSize, MADV_HUGEPAGE);
+			}
+		}
+	}
+
+	/**
+	 * 2.0 Touch every page, so that the buffers never fault once streaming starts.
+	 */
+	if (memory != NULL) {
+		memset(memory, 0, mappedSize);
+	}
+
+	/**
+	 * 3.0 Link every buffer into the stack of free buffers.
+	 */
+	nextFree = new std::atomic<uint32_t>[(bufferCount > 0) ? bufferCount : 1];
+	for (uint32_t index = 0; index < bufferCount; index++) {
+		nextFree[index].store(index + 1, std::memory_order_relaxed);
+	}
+	freeHead = 0;
+	available = bufferCount;
+
+	allPools.push_back(this);
+}
+
+/**
+ * This is the destructor for the class.  The buffers must all have been released.
+ */
+FramePool::~FramePool() {
+	allPools.remove(this);
+	if (available != bufferCount) {
+		Logger::log(LOG_WARNING, "%s: %u buffers were not released.", poolName.c_str(), bufferCount - available);
+	}
+	if (memory != NULL) {
+		munmap(memory, mappedSize);
+	}
+	delete[] nextFree;
+}
+
+/**
+ * This method will take a buffer from the pool.
+ * @return The return will be the buffer, or NULL if the pool is exhausted.
+ */
+uint8_t* FramePool::acquire() {
+	uint64_t head = freeHead.load(std::memory_order_acquire);
+	for (;;) {
+		uint32_t index = (uint32_t) head;
+		if (index >= bufferCount) {
+			exhaustedCount.fetch_add(1, std::memory_order_relaxed);
+			return NULL;
+		}
+
+		/**
+		 * Pop the buffer, changing the tag so that a concurrent pop and push of the same buffer makes this attempt fail.
+		 */
+		uint64_t newHead = (((head >> 32) + 1) << 32) | nextFree[index].load(std::memory_order_relaxed);
+		if (freeHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire)) {
+			available.fetch_sub(1, std::memory_order_relaxed);
+			return memory + (index * bufferStride);
+		}
+	}
+}
+
+/**
+ * This method will return a buffer to the pool.
+ * @param buffer This is the buffer, which must have been acquired from this pool.  NULL is ignored.
+ */
+void FramePool::release(uint8_t *buffer) {
+	if ((buffer == NULL) || (buffer < memory) || (buffer >= memory + (bufferCount * bufferStride))) {
+		return;
+	}
+	uint32_t index = (uint32_t) ((buffer - memory) / bufferStride);
+	uint64_t head = freeHead.load(std::memory_order_relaxed);
+	uint64_t newHead;
+	do {
+		nextFree[index].store((uint32_t) head, std::memory_order_relaxed);
+		newHead = (((head >> 32) + 1) << 32) | index;
+	} while (freeHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed) == false);
+	available.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the size of each buffer.
+ * @return The return will be the size of each buffer in bytes.
+ */
+size_t FramePool::getBufferSize() {
+	return bufferSize;
+}
+
+/**
+ * This method will obtain the number of buffers in the pool.
+ * @return The return will be the number of buffers.
+ */
+uint32_t FramePool::getBufferCount() {
+	return bufferCount;
+}
+
+/**
+ * This method will obtain the number of buffers which are free.
+ * @return The return will be the number of free buffers.
+ */
+uint32_t FramePool::getAvailable() {
+	return available.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the number of times a buffer was requested when none was free.
+ * @return The return will be the number of times the pool was exhausted.
+ */
+uint64_t FramePool::getExhaustedCount() {
+	return exhaustedCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will determine if the pool is backed by huge pages.
+ * @return The return will be true if the pool is backed by huge pages.
+ */
+bool FramePool::isUsingHugePages() {
+	return hugePages;
+}
+
+/**
+ * This method will obtain the name of the pool.
+ * @return The return will be the name of the pool.
+ */
+std::string FramePool::getName() {
+	return poolName;
+}
+
+/**
+ * This method will obtain the list of all of the frame pools.
+ * @return The return will be a reference to the list of frame pools.
+ */
+const std::list<FramePool*>& FramePool::getAllPools() {
+	return allPools;
+}
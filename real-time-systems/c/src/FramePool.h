@@ -0,0 +1,168 @@
+/**
+ * @file FramePool.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a fixed capacity pool of frame buffers, which is allocated
+ *      once at startup so that the stages of the pipeline never allocate frames
+ *      from the heap while streaming.  The buffers are cache line aligned and are
+ *      carved from a single mapping, which can be backed by huge pages to save TLB
+ *      misses on large frames.  The whole mapping is touched when it is created,
+ *      so the buffers never page fault later.  Acquiring and releasing a buffer is
+ *      lock free and may be done from any thread.
+ */
+
+#ifndef FRAMEPOOL_H_
+#define FRAMEPOOL_H_
+
+#include <atomic>
+#include <list>
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+class FramePool {
+private:
+	/**
+	 * This is a list of all of the frame pools, for the metrics.
+	 */
+	static std::list<FramePool*> allPools;
+
+	/**
+	 * This is the human readable name of the pool.
+	 */
+	std::string poolName;
+
+	/**
+	 * This is the start of the mapping which holds the buffers, and its size in bytes.
+	 */
+	uint8_t *memory;
+	size_t mappedSize;
+
+	/**
+	 * This is true if the mapping is backed by huge pages.
+	 */
+	bool hugePages;
+
+	/**
+	 * This is the usable size of each buffer, and the distance between buffers, which is rounded up to a cache line.
+	 */
+	size_t bufferSize;
+	size_t bufferStride;
+
+	/**
+	 * This is the number of buffers in the pool.
+	 */
+	uint32_t bufferCount;
+
+	/**
+	 * This is the index of the next free buffer after each buffer, which links the free buffers into a stack.
+	 */
+	std::atomic<uint32_t> *nextFree;
+
+	/**
+	 * This is the top of the stack of free buffers.  The lower 32 bits are the index of the buffer, or bufferCount if none
+	 * are free, and the upper 32 bits are a tag which changes on every update, so that a buffer which is released and
+	 * acquired again during an update is detected.
+	 */
+	std::atomic<uint64_t> freeHead;
+
+	/**
+	 * This is the number of buffers which are free.
+	 */
+	std::atomic<uint32_t> available;
+
+	/**
+	 * This is the number of times a buffer was requested when none was free.
+	 */
+	std::atomic<uint64_t> exhaustedCount;
+
+public:
+	/**
+	 * This is the constructor for the class.  It maps and touches the memory for all of the buffers.
+	 * @param name This is the human readable name of the pool.
+	 * @param size This is the size of each buffer in bytes.
+	 * @param count This is the number of buffers.
+	 * @param useHugePages This is true to back the buffers with huge pages, if the system has them available.
+	 */
+	FramePool(std::string name, size_t size, uint32_t count, bool useHugePages);
+
+	/**
+	 * This is the destructor for the class.  The buffers must all have been released.
+	 */
+	virtual ~FramePool();
+
+	/**
+	 * This method will take a buffer from the pool.
+	 * @return The return will be the buffer, or NULL if the pool is exhausted.
+	 */
+	uint8_t* acquire();
+
+	/**
+	 * This method will return a buffer to the pool.
+	 * @param buffer This is the buffer, which must have been acquired from this pool.  NULL is ignored.
+	 */
+	void release(uint8_t *buffer);
+
+	/**
+	 * This method will obtain the size of each buffer.
+	 * @return The return will be the size of each buffer in bytes.
+	 */
+	size_t getBufferSize();
+
+	/**
+	 * This method will obtain the number of buffers in the pool.
+	 * @return The return will be the number of buffers.
+	 */
+	uint32_t getBufferCount();
+
+	/**
+	 * This method will obtain the number of buffers which are free.
+	 * @return The return will be the number of free buffers.
+	 */
+	uint32_t getAvailable();
+
+	/**
+	 * This method will obtain the number of times a buffer was requested when none was free.
+	 * @return The return will be the number of times the pool was exhausted.
+	 */
+	uint64_t getExhaustedCount();
+
+	/**
+	 * This method will determine if the pool is backed by huge pages.
+	 * @return The return will be true if the pool is backed by huge pages.
+	 */
+	bool isUsingHugePages();
+
+	/**
+	 * This method will obtain the name of the pool.
+	 * @return The return will be the name of the pool.
+	 */
+	std::string getName();
+
+	/**
+	 * This method will obtain the list of all of the frame pools.
+	 * @return The return will be a reference to the list of frame pools.
+	 */
+	static const std::list<FramePool*>& getAllPools();
+};
+
+#endif /* FRAMEPOOL_H_ */
@@ -1,7 +1,7 @@
 #include "ImageCapturer.h"
-#include <chrono>
+#include "TraceBuffer.h"
+#include "Logger.h"
 
-using namespace std::chrono;
 using namespace std;
 
 /**
@@ -15,86 +15,210 @@ using namespace std;
  */
 ImageCapturer::ImageCapturer(Camera *referencedCamera, ImageTransmitter *trans,
 		int width, int height, std::string threadName, uint32_t period) :
-		PeriodicTask(threadName, period) {
+		PeriodicTask(threadName, period), size(width, height), pendingResolution(0) {
 	myCamera = referencedCamera;
 	myTrans = trans;
 	imageWidth = width;
 	imageHeight = height;
-	size = new Size(width, height);
 }
 
 /**
  * This is the destructor.
  */
 ImageCapturer::~ImageCapturer() {
-	delete size;
+	capturedFrame.release();
+	transmitFrame.release();
+	for (SimulcastLevel &level : simulcastLevels) {
+		level.frame.release();
+	}
+	if (framePool != NULL) {
+		framePool->release(captureBuffer);
+		framePool->release(transmitBuffer);
+		for (SimulcastLevel &level : simulcastLevels) {
+			framePool->release(level.buffer);
+		}
+	}
 }
 
 /**
  * This is the virtual task  method. It will execute the given code that is to be executed by this class. It will execute once each task period. The algorithm is as follows:
  */
 void ImageCapturer::taskMethod() {
+	uint32_t frameId = 0;
+
+	/**
+	 * 0.0 If a new size has been requested, apply it now, between frames.
+	 */
+	uint64_t resolution = pendingResolution.exchange(0);
+	if (resolution != 0) {
+		imageWidth = (int) (resolution >> 32);
+		imageHeight = (int) (resolution & 0xFFFFFFFF);
+		size = Size(imageWidth, imageHeight);
+		bindFrame(transmitFrame, transmitBuffer, imageWidth, imageHeight);
+	}
+
 	/**
-	 * 1.0 Obtain the time since the epoch from the system clock in ms.
+	 * 1.0 Record the start of the grab in the trace buffer.  The frame id is not known until the picture is taken.
 	 */
-	milliseconds start = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
+	TraceBuffer::record(TRACE_BEGIN, STAGE_GRAB, 0, 0);
 
 	/**
-	 *2.0 Take the picture from the camera.
+	 *2.0 Take the picture from the camera, into the captured frame.  The camera's frame id links this frame to its capture in the trace.
 	 */
-	Mat image = myCamera->takePicture();
+	bool captured = myCamera->takePicture(capturedFrame, frameId) && (!capturedFrame.empty());
+	Mat &image = capturedFrame;
+	TraceBuffer::record(TRACE_END, STAGE_GRAB, frameId, captured ? image.rows * image.cols * image.channels() : 0);
 
 	/**
 	 * 3.0 If the image is not empty,
 	 */
-	if (!image.empty()) {
+	if (captured) {
 		/**
-		 * 3.1 Obtain the time since the epoch from the system clock in ms.
+		 * 3.1 Record the start of the resize in the trace buffer.
 		 */
-		milliseconds start2 = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
+		TraceBuffer::record(TRACE_BEGIN, STAGE_RESIZE, frameId, 0);
 
 		/**
 		 * 3.2 Resize the image according to the desired size, if a resize needs to occur.
 		 */
-		Mat dst;
+		Mat *dst = &transmitFrame;
 		if (image.cols != imageWidth || image.rows != imageHeight) {
 			/**
-			 * 3.2.1 Resize the image as is applicable.
+			 * 3.2.1 Resize the image as is applicable, into the transmitted frame.
 			 */
-			resize(image, dst, *size);
+			resize(image, transmitFrame, size);
 		} else {
 			/**
-			 * 3.3.1 The image does not need to be resized but instead simply needs to be copied.
+			 * 3.3.1 The image does not need to be resized, so it is transmitted straight from the captured frame.
 			 */
-			image.copyTo(dst);
+			dst = &image;
 		}
 
 		/**
-		 * 3.4 Obtain the time since the epoch from the system clock in ms.
+		 * 3.4 Record the end of the resize and the start of the transmission in the trace buffer.
 		 */
-		milliseconds start3 = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
+		uint32_t bytes = dst->rows * dst->cols * dst->channels();
+		TraceBuffer::record(TRACE_END, STAGE_RESIZE, frameId, bytes);
+		TraceBuffer::record(TRACE_BEGIN, STAGE_TRANSMIT, frameId, 0);
 
 		/**
 		 * 3.5 Stream the image to the remote device.
 		 */
-		myTrans->streamImage(&dst);
+		myTrans->streamImage(dst);
 
 		/**
-		 * 3.6 Obtain the time since the epoch from the system clock in ms.
+		 * 3.6 Record the end of the transmission in the trace buffer.
 		 */
-		milliseconds end = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
-		milliseconds delta = start2 - start;
+		TraceBuffer::record(TRACE_END, STAGE_TRANSMIT, frameId, bytes);
 
 		/**
-		 * 3.7 Print out to the console in ms the amount of time it took to grab the picture, resize the picture, and transmit the picture in ms.
+		 * 3.7 Send each level of the simulcast, resized from the level before it, so that each resize only reads the
+		 * pixels of a frame which is already small.  The levels are traced as stages of their own, so that the flow of
+		 * the frame ends at the transmit of the full resolution.
 		 */
-		cout << "Grab picture:\t" << (delta.count()) << "\t";
-		delta = start3 - start2;
-		cout << "Resize:\t" << (delta.count()) << "\t";
-		delta = end - start3;
-		cout << "Transmit:\t" << (delta.count()) << "\t";
-		milliseconds delayTime = std::chrono::milliseconds(getTaskPeriod() / 1000) - (end - start);
-		cout << "Delaying:\t" << delayTime.count() << "\n";
+		for (SimulcastLevel &level : simulcastLevels) {
+			TraceBuffer::record(TRACE_BEGIN, STAGE_SIMULCAST_RESIZE, frameId, 0);
+			resize(*dst, level.frame, level.size, 0, 0, INTER_AREA);
+			dst = &level.frame;
+			bytes = dst->rows * dst->cols * dst->channels();
+			TraceBuffer::record(TRACE_END, STAGE_SIMULCAST_RESIZE, frameId, bytes);
+			TraceBuffer::record(TRACE_BEGIN, STAGE_SIMULCAST_TRANSMIT, frameId, 0);
+			level.transmitter->streamImage(dst);
+			TraceBuffer::record(TRACE_END, STAGE_SIMULCAST_TRANSMIT, frameId, bytes);
+		}
 	}
 }
 
+/**
+ * This method will change the size of the image that is transmitted.  It may be called from any thread.  The new size
+ * takes effect at the start of the next frame.  A size which does not fit the buffers of the frame pool is refused, so
+ * that the stream never falls back to allocating its frames from the heap.
+ * @param width This is the width of the image that is to be sent in pixels.
+ * @param height This is the height of the image that is to be sent in pixels.
+ * @return The return will be true if the change was requested, or false if the size was refused.
+ */
+bool ImageCapturer::setResolution(int width, int height) {
+	if ((width <= 0) || (height <= 0)) {
+		return false;
+	}
+	if ((framePool != NULL) && ((size_t) width * height * 3 > framePool->getBufferSize())) {
+		return false;
+	}
+	pendingResolution.store(((uint64_t) width << 32) | (uint32_t) height);
+	return true;
+}
+
+/**
+ * This method will obtain the image transmitter which sends the images of this task.
+ * @return The return will be the image transmitter.
+ */
+ImageTransmitter* ImageCapturer::getTransmitter() {
+	return myTrans;
+}
+
+/**
+ * This method will add a smaller resolution of the frames to the simulcast.  Each frame is resized from the level before
+ * it, or from the transmitted frame for the first level, and sent by the given transmitter, which becomes a stream of
+ * the simulcast of this task's transmitter.  It must be called before the task is started, from the largest level to
+ * the smallest.
+ * @param trans This is the transmitter which is to send the level.
+ * @param width This is the width of the level in pixels.
+ * @param height This is the height of the level in pixels.
+ * @return The return will be true if the level was added, or false if the size is not sensible or the transmitter can
+ * not be a stream of the simulcast.
+ */
+bool ImageCapturer::addSimulcastLevel(ImageTransmitter *trans, int width, int height) {
+	if ((width <= 0) || (height <= 0) || (myTrans->addSimulcastStream(trans) == false)) {
+		return false;
+	}
+	SimulcastLevel level;
+	level.transmitter = trans;
+	level.size = Size(width, height);
+	level.buffer = NULL;
+	if (framePool != NULL) {
+		level.buffer = framePool->acquire();
+		bindFrame(level.frame, level.buffer, width, height);
+	} else {
+		level.frame.create(height, width, CV_8UC3);
+	}
+	simulcastLevels.push_back(level);
+	return true;
+}
+
+/**
+ * This method will hold the captured and the transmitted frames, and the frame of each level of the simulcast, in buffers
+ * from the given pool, so that streaming never allocates.  It must be called before the task is started.  The levels
+ * which are added afterwards are held in buffers from the pool as they are added.
+ * @param pool This is the pool.
+ */
+void ImageCapturer::setFramePool(FramePool *pool) {
+	framePool = pool;
+	captureBuffer = pool->acquire();
+	transmitBuffer = pool->acquire();
+	bindFrame(capturedFrame, captureBuffer, myCamera->getWidth(), myCamera->getHeight());
+	bindFrame(transmitFrame, transmitBuffer, imageWidth, imageHeight);
+	for (SimulcastLevel &level : simulcastLevels) {
+		level.buffer = pool->acquire();
+		bindFrame(level.frame, level.buffer, level.size.width, level.size.height);
+	}
+}
+
+/**
+ * This method will place a frame in a pool buffer, if the buffer is large enough, or otherwise leave it to be allocated
+ * from the heap when it is first written.
+ * @param frame This is the frame.
+ * @param buffer This is the pool buffer, or NULL if there is none.
+ * @param width This is the width of the frame in pixels.
+ * @param height This is the height of the frame in pixels.
+ */
+void ImageCapturer::bindFrame(Mat &frame, uint8_t *buffer, int width, int height) {
+	if ((buffer != NULL) && ((size_t) (width * height * 3) <= framePool->getBufferSize())) {
+		frame = Mat(height, width, CV_8UC3, buffer);
+	} else {
+		frame = Mat();
+		if (framePool != NULL) {
+			Logger::log(LOG_WARNING, "%s: No buffer of %s fits a %dx%d frame.  The frame is allocated from the heap.", myName.c_str(),
+					framePool->getName().c_str(), width, height);
+		}
+	}
+}
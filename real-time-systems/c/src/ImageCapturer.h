@@ -1,6 +1,7 @@
 /*
  * ImageCapturer.h
  * This class is responsible for capturing an image from the camera and getting it ready to be transmitted to another device.
+ * In a simulcast, it also sends smaller resolutions of each frame, each resized from the one before it.
  */
 
 #ifndef IMAGECAPTURER_H_
@@ -9,6 +10,10 @@
 #include "PeriodicTask.h"
 #include "Camera.h"
 #include "ImageTransmitter.h"
+#include "FramePool.h"
+
+#include <atomic>
+#include <vector>
 
 class ImageCapturer: public PeriodicTask {
 private:
@@ -33,9 +38,59 @@ private:
 	int imageHeight;
 
 	/**
-	 * This is the size of the image that is to be transmitted. It is an openCV Size type.
+	 * This is the size of the image that is to be transmitted. It is an openCV Size type, held by value so that changing
+	 * it never allocates.
+	 */
+	Size size;
+
+	/**
+	 * This is a requested change of the transmitted size, with the width in the upper 32 bits and the height in the lower
+	 * 32 bits.  It is 0 if no change has been requested.  The change is applied at the start of the next frame.
+	 */
+	std::atomic<uint64_t> pendingResolution;
+
+	/**
+	 * This is the pool which the frames are held in, and the buffers taken from it for the captured and the transmitted
+	 * frame.  They are NULL if the frames are allocated from the heap.
+	 */
+	FramePool *framePool = NULL;
+	uint8_t *captureBuffer = NULL;
+	uint8_t *transmitBuffer = NULL;
+
+	/**
+	 * These are the captured frame and the resized frame which is transmitted.  They are kept from one frame to the next,
+	 * so that their memory is reused.
+	 */
+	Mat capturedFrame;
+	Mat transmitFrame;
+
+	/**
+	 * This structure is a level of the simulcast: the transmitter which sends it, its size, and the frame it is resized
+	 * into, which is kept from one frame to the next, with the pool buffer which holds it (or NULL if it is allocated from
+	 * the heap).
+	 */
+	struct SimulcastLevel {
+		ImageTransmitter *transmitter;
+		Size size;
+		Mat frame;
+		uint8_t *buffer;
+	};
+
+	/**
+	 * These are the levels of the simulcast, from the largest to the smallest.
+	 */
+	std::vector<SimulcastLevel> simulcastLevels;
+
+	/**
+	 * This method will place a frame in a pool buffer, if the buffer is large enough, or otherwise leave it to be
+	 * allocated from the heap when it is first written.
+	 * @param frame This is the frame.
+	 * @param buffer This is the pool buffer, or NULL if there is none.
+	 * @param width This is the width of the frame in pixels.
+	 * @param height This is the height of the frame in pixels.
 	 */
-	Size *size;
+	void bindFrame(Mat &frame, uint8_t *buffer, int width, int height);
+
 public:
 
 	/**
@@ -58,5 +113,41 @@ public:
 	 * This is the taskMethod that will run.
 	 */
 	virtual void taskMethod();
+
+	/**
+	 * This method will change the size of the image that is transmitted.  It may be called from any thread.  The new size
+	 * takes effect at the start of the next frame.  A size which does not fit the buffers of the frame pool is refused,
+	 * so that the stream never falls back to allocating its frames from the heap.
+	 * @param width This is the width of the image that is to be sent in pixels.
+	 * @param height This is the height of the image that is to be sent in pixels.
+	 * @return The return will be true if the change was requested, or false if the size was refused.
+	 */
+	bool setResolution(int width, int height);
+
+	/**
+	 * This method will obtain the image transmitter which sends the images of this task.
+	 * @return The return will be the image transmitter.
+	 */
+	ImageTransmitter* getTransmitter();
+
+	/**
+	 * This method will add a smaller resolution of the frames to the simulcast.  Each frame is resized from the level
+	 * before it, or from the transmitted frame for the first level, and sent by the given transmitter, which becomes a
+	 * stream of the simulcast of this task's transmitter.  It must be called before the task is started, from the
+	 * largest level to the smallest.
+	 * @param trans This is the transmitter which is to send the level.
+	 * @param width This is the width of the level in pixels.
+	 * @param height This is the height of the level in pixels.
+	 * @return The return will be true if the level was added, or false if the size is not sensible or the transmitter
+	 * can not be a stream of the simulcast.
+	 */
+	bool addSimulcastLevel(ImageTransmitter *trans, int width, int height);
+
+	/**
+	 * This method will hold the captured and the transmitted frames, and the frame of each level of the simulcast, in
+	 * buffers from the given pool, so that streaming never allocates.  It must be called before the task is started.
+	 * @param pool This is the pool.
+	 */
+	void setFramePool(FramePool *pool);
 };
 #endif /* IMAGECAPTURER_H_ */
@@ -21,7 +21,11 @@
  * the grant of any rights to this Software.
  *
  * @section DESCRIPTION
- *      This class will transmit an image to a remote device.  The image will be transmitted as a set of UDP datagrams.
+ *      This class will transmit an image to a remote device.  The image will be transmitted as a set of UDP datagrams,
+ *      either as raw rows or as JPEG slices which can each be decoded on their own.  Each datagram is built once and
+ *      sent to every destination of the stream, which may be unicast hosts or a multicast group, in one system call.
+ *      Several transmitters may share one socket as the streams of a simulcast, each sending one resolution of the
+ *      frames under its own stream id.
  */
 
 #include "ImageTransmitter.h"
@@ -33,8 +37,40 @@
 #include <unistd.h>
 #include <stdint.h>
 #include "time_util.h"
+#include "Logger.h"
 #include <string.h>
+#include <errno.h>
+#include <time.h>
 #include <iostream>
+#include <stdlib.h>
+#include <poll.h>
+#include <algorithm>
+#include <mutex>
+
+/*
+ * This is a file scoped variable which holds a list of all of the transmitters.
+ */
+std::list<ImageTransmitter*> ImageTransmitter::allTransmitters;
+
+/**
+ * This is the size of the datagram buffer.  It holds the largest UDP datagram, plus the 4 bytes which are sent beyond it.
+ */
+#define SEND_BUFFER_SIZE (65536)
+
+/**
+ * This is the time, in nanoseconds, for which nothing is sent to a destination after a send to it failed.
+ */
+#define DESTINATION_SUSPEND_TIME (1000000000ULL)
+
+/**
+ * This function will obtain the CLOCK_MONOTONIC time.
+ * @return The return will be the time in nanoseconds.
+ */
+static uint64_t getMonotonicTime() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t) now.tv_sec * 1000000000ULL) + now.tv_nsec;
+}
 
 /**
  * This will instantiate a new instance of this class. It will copy the machine name into a heap allocated string and update the port.
@@ -42,16 +78,34 @@
  * @param port This is the udp port number that the machine is to connect to.
  * @param linesPerUDPDatagram This is the number of lines that are to be sent in each UDP datagram.
  */
-ImageTransmitter::ImageTransmitter(char *machineName, int port,	int linesPerUDPDatagram) {
+ImageTransmitter::ImageTransmitter(char *machineName, int port,	int linesPerUDPDatagram) :
+		feedbackLock(std::string("Feedback ") + ((machineName != NULL) ? machineName : "") + ":" + std::to_string(port)), socketLock(&feedbackLock), requestedLinesPerDatagram(linesPerUDPDatagram), datagramInterval(0), requestedEncoding(ENCODING_RAW), requestedQuality(75), requestedPixelFormat(STREAM_PIXEL_BGR24), requestedFecDataCount(0), requestedFecParityCount(1), requestedRetransmitBudget(0), framesSent(0), datagramsSent(0), bytesSent(0), sendErrors(0), parityDatagramsSent(0),
+		nacksReceived(0), datagramsRetransmitted(0), retransmissionsExpired(0), retransmissionsSuppressed(0), roundTripTime(0), reportsReceived(0), reportedLossFraction(0), reportedJitter(0),
+		reportedReceiveRate(0) {
 	destinationMachineName = machineName;
 	myPort = port;
 	this->linesPerUDPDatagram = linesPerUDPDatagram;
+	memset(&messages, 0, sizeof(messages));
+	memset(&simulcastHeader, 0, sizeof(simulcastHeader));
+	addDestination(machineName, port);
+
+	/**
+	 * Allocate the datagram buffer now, rather than for each image.  It holds the largest datagram that is ever sent.
+	 */
+	void *buffer = NULL;
+	if (posix_memalign(&buffer, 64, SEND_BUFFER_SIZE) == 0) {
+		sendBuffer = (uint8_t*) buffer;
+	}
+	allTransmitters.push_back(this);
 }
 
 /**
  * This is the destructor. It will free all allocated memory.
  */
 ImageTransmitter::~ImageTransmitter() {
+	allTransmitters.remove(this);
+	closeSocket();
+	free(sendBuffer);
 
 }
 
@@ -65,91 +119,118 @@ int ImageTransmitter::streamImage(Mat* image) {
 	 * 1.0 If the image and destination machine are not null,
 	 */
 
-	if ((image != NULL) && (destinationMachineName != NULL)) {
-		struct sockaddr_in serv_addr;
-		struct hostent *server;
+	if ((image != NULL) && (destinationMachineName != NULL) && (sendBuffer != NULL)) {
 		/**
 		 * 1.1 Increment the image count.
 		 */
 		imageCount++;
 
-
 		/**
-		 * 1.2 Initialize the socket sockfd to be a DGRAM.
+		 * 1.2 Open the socket and look up the destination, if this has not already been done.  They are kept from one
+		 * image to the next.
 		 */
-		if ((sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
-			perror("cannot create socket\n");
-			return (-1);
+		if (openSocket() == false) {
+			return -1;
 		}
 
-
 		/**
-		 * 1.3 If there is an error with 1b, abort with an error message and return -1.
+		 * 1.2.1 Act on any feedback from the receiver which has not been acted on already, and send a keyframe if the
+		 * stream has just switched to deltas.
 		 */
-		if (sockfd < 0) {
-			perror("ERROR opening socket");
-			return -1;
+		{
+			std::lock_guard<RealTimeMutex> guard(*socketLock);
+			readFeedback();
+		}
+		int encoding = requestedEncoding.load(std::memory_order_relaxed);
+		if ((encoding == ENCODING_DELTA) && (lastEncoding != ENCODING_DELTA) && (tileEncoder != NULL)) {
+			tileEncoder->requestKeyframe();
 		}
+		lastEncoding = encoding;
 
 		/**
-		 * 1.4 Get the host by name and set up a server instance.
+		 * 1.2.2 Pick up any change of the forward error correction.  A group left open by an abandoned image is dropped,
+		 * as its parity can no longer be sent.
 		 */
-
-		server = gethostbyname(destinationMachineName);
+		int fecDataCount = requestedFecDataCount.load(std::memory_order_relaxed);
+		fecActive = (fecEncoder != NULL) && (fecDataCount > 0);
+		if (fecEncoder != NULL) {
+			fecEncoder->discardGroup();
+			if (fecActive) {
+				fecEncoder->configure(fecDataCount, requestedFecParityCount.load(std::memory_order_relaxed));
+			}
+		}
 
 		/**
-		 * 1.5 If the server is NULL, print out an error and return -1.
+		 * 1.2.3 Pick up any change of the retransmission, and start keeping the datagrams of the image if it is on.  The
+		 * number of datagrams in the image before is sent with each datagram, so that the receiver can tell when the
+		 * last datagrams of that image were lost.
 		 */
-
-		if (server == NULL) {
-			perror("ERROR, no such host\n");
-			return -1;;
+		uint32_t retransmitBudget = requestedRetransmitBudget.load(std::memory_order_relaxed);
+		{
+			std::lock_guard<RealTimeMutex> guard(*socketLock);
+			previousDatagramCount = retransmitActive ? history->getDatagramCount() : 0;
+			retransmitActive = (history != NULL) && (retransmitBudget > 0);
+			if (retransmitActive) {
+				history->beginFrame(imageCount, getMonotonicTime());
+			}
 		}
 
 		/**
-		 * 1.6 Set up the rest of the UDP parameters.
-		 * */
-		// Zero out the structure.
-		bzero((char *) &serv_addr, sizeof(serv_addr));
-		serv_addr.sin_family = AF_INET;
-		// Now copy the appropriate data over.
-		memcpy((char *) &serv_addr.sin_addr.s_addr, (char *) server->h_addr, server->h_length);
-
-
-		/**
-		 * 1.7 Set the port for the system.
+		 * 1.2.4 If the stream is encoded as JPEG slices, tile deltas or lossless rows, send those instead of the raw rows.
+		 * Raw rows in a smaller pixel format are sent in their own datagrams.
 		 */
-		serv_addr.sin_port = htons(myPort);
-
+		int pixelFormat = requestedPixelFormat.load(std::memory_order_relaxed);
+		if ((encoding == ENCODING_JPEG) && (jpegEncoder != NULL)) {
+			return finishFrame(streamSlices(image));
+		} else if ((encoding == ENCODING_DELTA) && (tileEncoder != NULL)) {
+			return finishFrame(streamTiles(image));
+		} else if (encoding == ENCODING_LOSSLESS) {
+			return finishFrame(streamLosslessRows(image));
+		} else if (pixelFormat != STREAM_PIXEL_BGR24) {
+			return finishFrame(streamPixelRows(image, (StreamPixelFormat) pixelFormat));
+		}
 
 		/**
-		 * 1.8 Obtain the image rows, columns, message size, and required buffer allocation size (which is ((3 * columns + 24) * linesPerUDPDatagram) + 4).
+		 * 1.3 Obtain the image rows, columns, message size, and required buffer allocation size (which is ((3 * columns + 24) * linesPerUDPDatagram) + 4).
 		 */
 		int imageRows = image->size().height;
 		int imageCols = image->size().width;
 		int msgSize = ((3 * imageCols) + 24);
+
+		/**
+		 * 1.3.1 Pick up any change of the datagram size, between images.  A datagram, which is sent with 4 bytes beyond the
+		 * buffer size, can not be larger than the UDP maximum of 65507 bytes, less the overhead of any error correction.
+		 */
+		int capacity = (int) getDatagramCapacity();
+		linesPerUDPDatagram = requestedLinesPerDatagram.load(std::memory_order_relaxed);
+		if ((msgSize * linesPerUDPDatagram) + 8 > capacity) {
+			linesPerUDPDatagram = (capacity - 8) / msgSize;
+		}
+		if (linesPerUDPDatagram < 1) {
+			linesPerUDPDatagram = 1;
+		}
 		int reqBufferAllocSize = ((msgSize) * linesPerUDPDatagram) + 4;
 
 		/**
-		 * 1.9 Allocate a buffer of message size length on the heap.
+		 * 1.4 Build the datagrams in the preallocated buffer.
 		 */
-		void *msgToSend = malloc(reqBufferAllocSize);
+		void *msgToSend = sendBuffer;
 
 		/**
-		 * 1.10 Obtain the current timestamp in ms using the time_util library.
+		 * 1.5 Obtain the current timestamp in ms using the time_util library.
 		 */
 
 		int time = current_timestamp();
 
 		/**
-		 * 1.11 Declare a pointer to a 32 bit integer that has the same address as the start of the buffer.
+		 * 1.6 Declare a pointer to a 32 bit integer that has the same address as the start of the buffer.
 		 * The, set the first 32 bits of the buffer to be the network copnverted endianess of the linesPerUDPDatagram variable.
 		 */
 		((uint32_t*) msgToSend)[0] = htonl(linesPerUDPDatagram);
 
 
 		/**
-		 * 1.12 Declare a variable that will keep track of the index into the image (i.e. which row is being packed right now),
+		 * 1.7 Declare a variable that will keep track of the index into the image (i.e. which row is being packed right now),
 		 * as well as another variable which counts how many rows have been packed into the given UDP datagram.
 		 */
 		int index = 0;
@@ -158,20 +239,27 @@ int ImageTransmitter::streamImage(Mat* image) {
 
 		int bytesPerImageCol = 3;
 
+		/**
+		 * 1.7.1 Obtain the pacing for this image.  The first datagram is sent immediately.
+		 */
+		uint32_t interval = datagramInterval.load(std::memory_order_relaxed);
+		struct timespec nextSendTime;
+		clock_gettime(CLOCK_MONOTONIC, &nextSendTime);
+
 
 
 		/**
-		 * 1.11 Iterate (using index) so longas the index is less than rows in the image.
+		 * 1.8 Iterate (using index) so longas the index is less than rows in the image.
 		 */
 
 		while (index < rows) {
 			/**
-			 * 1.11.1 Using a for loop, place up to linesPerUDPDatagram within the UDP message.  However, also make certain that we do not pack rows which do not exist into the UDP datagram.
+			 * 1.8.1 Using a for loop, place up to linesPerUDPDatagram within the UDP message.  However, also make certain that we do not pack rows which do not exist into the UDP datagram.
 			 * To do this, in addition to the udpLineNumber being less than linesPerUDPDatagram, the conditional on the for loop should also check to make sure that rowsPacked < rows (i.e. the number of rows that has been packed for transmission is less than the number of rows overall.
 			 */
 			for (int udpLineNumber = 0; (udpLineNumber < linesPerUDPDatagram) && (rowsPacked < rows); udpLineNumber++) {
 				/**
-				 * 1.11.1.1 Starting after the initial 4 bytes of the udp, which contains the linesPerUDPDatagram attribute, create the portion of the message which has the following:
+				 * 1.8.1.1 Starting after the initial 4 bytes of the udp, which contains the linesPerUDPDatagram attribute, create the portion of the message which has the following:
 				 * Integer 0: The start time for the transmission
 				 * Integer 1: The current timestamp for the current portion of the image
 				 * Integer 2: The count of the image.
@@ -200,42 +288,1254 @@ int ImageTransmitter::streamImage(Mat* image) {
 
 				memcpy(&((uint32_t*) msgToSend)[(udpLineNumber * ((6 + (imageCols * bytesPerImageCol / 4)))) + 7], image->ptr(rowsPacked), imageCols * 3);
 				/**
-				 * 1.11.1.2 Increment the rows packed variable to indicate that another row has been packed.
+				 * 1.8.1.2 Increment the rows packed variable to indicate that another row has been packed.
 				 */
 				rowsPacked++;
 
 			}
 			/**
-			 * 1.11.2 Send to message to the destination.
+			 * 1.8.2 Send to message to the destination.
 			 */
 			// Note: The 1024 shouldn't be a magic number like this.  It is done like this to show you that the message length to send is the 1024 of the message plus the 4 bytes of the length up front.
 			//DO WE NEED THE PLUS QUATRO
 
-			int lres = sendto(sockfd, msgToSend, (reqBufferAllocSize + 4), 0, (struct sockaddr*) & serv_addr, sizeof(serv_addr));
+			waitForSendTime(nextSendTime, interval);
+
+			int lres = sendDatagram((const uint8_t*) msgToSend, (reqBufferAllocSize + 4));
 			if (lres < 0) {
-				printf("%d c %d ", lres, errno);
-				perror("Transmit:");
-				exit(-1);
+				/**
+				 * The rest of the image is abandoned, but the next image is tried, with a new socket, as the error may be temporary.
+				 */
+				sendErrors.fetch_add(1, std::memory_order_relaxed);
+				LOG_RATE_LIMITED(1, LOG_ERROR, "Transmit: Sending image %d failed (%s).", imageCount, strerror(errno));
+				closeSocket();
+				return -1;
 			}
 
-
 			/**
-			 * 1.11.3 Increment the index to account the lines that were sent.
+			 * 1.8.3 Increment the index to account the lines that were sent.
 			 */
 			index += linesPerUDPDatagram;
 
 		}
 
+		framesSent.fetch_add(1, std::memory_order_relaxed);
+		return finishFrame(0);
+	}
+	return 0;
+}
+
+/**
+ * This method will send a datagram of an image to the destinations.  If retransmission is on, the datagram is numbered
+ * with a StreamSequenceHeader and kept in the history.  If forward error correction is on, the datagram is sent behind
+ * its StreamFecHeader, and the parity of its group is sent once the group is full.
+ * @param datagram This is the datagram.
+ * @param length This is the length of the datagram in bytes.
+ * @return The return will be the number of bytes sent, or -1 if there is a failure.
+ */
+int ImageTransmitter::sendDatagram(const uint8_t *datagram, size_t length) {
+	/**
+	 * 1.0 If retransmission is on, copy the datagram into the history behind its sequence header, and send it from
+	 * there.  It is copied under the lock of the socket, as the datagram it overwrites may be being sent again.  A
+	 * datagram which can not be kept is sent without a sequence header, and can not be retransmitted.
+	 */
+	if (retransmitActive) {
+		std::lock_guard<RealTimeMutex> guard(*socketLock);
+		uint16_t index = 0;
+		uint8_t *kept = history->append(sizeof(StreamSequenceHeader) + length, index);
+		if (kept != NULL) {
+			StreamSequenceHeader *header = (StreamSequenceHeader*) kept;
+			header->magic = htonl(STREAM_SEQUENCE_MAGIC);
+			header->version = STREAM_VERSION;
+			header->flags = 0;
+			header->datagramIndex = htons(index);
+			header->frameId = htonl(imageCount);
+			header->previousDatagramCount = htons(previousDatagramCount);
+			header->reserved = 0;
+			memcpy(kept + sizeof(StreamSequenceHeader), datagram, length);
+			datagram = kept;
+			length += sizeof(StreamSequenceHeader);
+		}
+	}
+
+	/**
+	 * 1.1 A datagram which is too long to be protected, such as a JPEG slice of an encoder sized before the error
+	 * correction was turned on, is sent as is.  The receiver passes it through.
+	 */
+	struct iovec parts[2];
+	if ((fecActive == false) || (length > FecEncoder::MAXIMUM_DATAGRAM_SIZE)) {
+		parts[0].iov_base = (void*) datagram;
+		parts[0].iov_len = length;
+		int lres = sendToDestinations(parts, 1);
+		if (lres >= 0) {
+			datagramsSent.fetch_add(1, std::memory_order_relaxed);
+			bytesSent.fetch_add(lres, std::memory_order_relaxed);
+		}
+		return lres;
+	}
+
+	/**
+	 * 2.0 Add the datagram to the parity of its group, and send it behind its header, without copying it.
+	 */
+	StreamFecHeader header;
+	bool groupFull = fecEncoder->addDatagram(datagram, length, header);
+	parts[0].iov_base = &header;
+	parts[0].iov_len = sizeof(header);
+	parts[1].iov_base = (void*) datagram;
+	parts[1].iov_len = length;
+	int lres = sendToDestinations(parts, 2);
+	if (lres < 0) {
+		return lres;
+	}
+	datagramsSent.fetch_add(1, std::memory_order_relaxed);
+	bytesSent.fetch_add(lres, std::memory_order_relaxed);
+
+	/**
+	 * 3.0 If the group is full, send its parity straight away.
+	 */
+	if (groupFull && (sendParity() < 0)) {
+		return -1;
+	}
+	return lres;
+}
+
+/**
+ * This method will send a datagram to every destination which is not suspended.  The messages all point at the same
+ * parts, so the datagram is never copied, and they are sent with sendmmsg.  A message which fails stops the call, so
+ * the rest are sent with another.  A destination which fails while others succeed is suspended for a while, so that a
+ * peer which is gone can not hold up the others.  If every destination fails, the fault is taken to be the socket's.
+ * @param parts These are the parts which the datagram is gathered from.
+ * @param partCount This is the number of parts.
+ * @return The return will be the number of bytes in the datagram, or -1 if it could not be sent to any destination.
+ */
+int ImageTransmitter::sendToDestinations(struct iovec *parts, int partCount) {
+	/**
+	 * 1.0 If the stream is part of a simulcast, send the datagram behind its simulcast header.
+	 */
+	struct iovec gathered[4];
+	if (simulcast && (partCount < 4)) {
+		gathered[0].iov_base = &simulcastHeader;
+		gathered[0].iov_len = sizeof(simulcastHeader);
+		memcpy(&gathered[1], parts, partCount * sizeof(struct iovec));
+		parts = gathered;
+		partCount++;
+	}
+
+	/**
+	 * 1.1 Build a message for each destination which was found and is not suspended.
+	 */
+	int destinationIndex[MAXIMUM_DESTINATIONS];
+	int messageCount = 0;
+	uint64_t now = 0;
+	for (int index = 0; index < destinationCount; index++) {
+		StreamDestination &destination = destinations[index];
+		if (destination.resolved == false) {
+			continue;
+		}
+		uint64_t suspendedUntil = destination.suspendedUntil.load(std::memory_order_relaxed);
+		if (suspendedUntil != 0) {
+			if (now == 0) {
+				now = getMonotonicTime();
+			}
+			if (now < suspendedUntil) {
+				continue;
+			}
+			destination.suspendedUntil.store(0, std::memory_order_relaxed);
+		}
+		struct msghdr &message = messages[messageCount].msg_hdr;
+		message.msg_name = &destination.address;
+		message.msg_namelen = sizeof(destination.address);
+		message.msg_iov = parts;
+		message.msg_iovlen = partCount;
+		message.msg_control = NULL;
+		message.msg_controllen = 0;
+		message.msg_flags = 0;
+		destinationIndex[messageCount++] = index;
+	}
+
+	/**
+	 * 2.0 Send the messages, skipping over any which fail.
+	 */
+	int failed[MAXIMUM_DESTINATIONS];
+	int failedCount = 0;
+	int sentCount = 0;
+	int error = EDESTADDRREQ;
+	int start = 0;
+	while (start < messageCount) {
+		int result = sendmmsg(sockfd, &messages[start], messageCount - start, 0);
+		if (result > 0) {
+			for (int message = start; message < start + result; message++) {
+				StreamDestination &destination = destinations[destinationIndex[message]];
+				destination.datagramsSent.fetch_add(1, std::memory_order_relaxed);
+				destination.bytesSent.fetch_add(messages[message].msg_len, std::memory_order_relaxed);
+			}
+			sentCount += result;
+			start += result;
+		} else {
+			error = errno;
+			destinations[destinationIndex[start]].sendErrors.fetch_add(1, std::memory_order_relaxed);
+			failed[failedCount++] = destinationIndex[start];
+			start++;
+		}
+	}
+
+	/**
+	 * 3.0 If the datagram reached any destination, suspend the ones which failed.
+	 */
+	if (sentCount == 0) {
+		errno = error;
+		return -1;
+	}
+	for (int index = 0; index < failedCount; index++) {
+		StreamDestination &destination = destinations[failed[index]];
+		destination.suspendedUntil.store(getMonotonicTime() + DESTINATION_SUSPEND_TIME, std::memory_order_relaxed);
+		LOG_RATE_LIMITED(1, LOG_WARNING, "Transmit: Sending to %s:%d failed (%s).  It is suspended for a second.",
+				destination.machineName, destination.port, strerror(error));
+	}
+	size_t length = 0;
+	for (int part = 0; part < partCount; part++) {
+		length += parts[part].iov_len;
+	}
+	return (int) length;
+}
+
+/**
+ * This method will determine if an address is the address of one of the destinations.
+ * @param address This is the address.
+ * @return The return will be true if a destination is on the host of the address, or false otherwise.
+ */
+bool ImageTransmitter::isDestination(const struct sockaddr_in &address) {
+	for (int index = 0; index < destinationCount; index++) {
+		if (destinations[index].resolved && (destinations[index].address.sin_addr.s_addr == address.sin_addr.s_addr)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * This method will close the open group of forward error correction, and send its parity datagrams.
+ * @return The return will be 0 if successful or -1 if there is a failure.
+ */
+int ImageTransmitter::sendParity() {
+	int parityCount = fecEncoder->closeGroup();
+	for (int index = 0; index < parityCount; index++) {
+		size_t length = 0;
+		struct iovec part;
+		part.iov_base = (void*) fecEncoder->getParityDatagram(index, length);
+		part.iov_len = length;
+		int lres = sendToDestinations(&part, 1);
+		if (lres < 0) {
+			return -1;
+		}
+		datagramsSent.fetch_add(1, std::memory_order_relaxed);
+		bytesSent.fetch_add(lres, std::memory_order_relaxed);
+		parityDatagramsSent.fetch_add(1, std::memory_order_relaxed);
+	}
+	return 0;
+}
+
+/**
+ * This method will end an image.  If it was sent, the parity of its last group of datagrams is sent, as groups never
+ * span images.
+ * @param result This is the result of sending the image.
+ * @return The return will be the result, or -1 if the parity could not be sent.
+ */
+int ImageTransmitter::finishFrame(int result) {
+	if ((result == 0) && fecActive && (sendParity() < 0)) {
+		sendErrors.fetch_add(1, std::memory_order_relaxed);
+		LOG_RATE_LIMITED(1, LOG_ERROR, "Transmit: Sending the parity of image %d failed (%s).", imageCount, strerror(errno));
+		closeSocket();
+		return -1;
+	}
+	return result;
+}
+
+/**
+ * This method will obtain the largest datagram which an image can be sent in.  It is smaller when forward error
+ * correction or retransmission is on, or the stream is part of a simulcast, to leave room for their headers.
+ * @return The return will be the size in bytes.
+ */
+size_t ImageTransmitter::getDatagramCapacity() {
+	size_t capacity = fecActive ? FecEncoder::MAXIMUM_DATAGRAM_SIZE : STREAM_MAX_DATAGRAM_SIZE;
+	capacity -= simulcast ? sizeof(StreamSimulcastHeader) : 0;
+	return retransmitActive ? (capacity - sizeof(StreamSequenceHeader)) : capacity;
+}
+
+/**
+ * This method will stream the image as JPEG slices, one per datagram.
+ * @param image This is the image that is to be sent.
+ * @return The return will be 0 if successful or -1 if there is a failure.
+ */
+int ImageTransmitter::streamSlices(Mat *image) {
+	/**
+	 * 1.0 Encode the slices of the image, in parallel, into the datagrams of the encoder.
+	 */
+	int quality = requestedQuality.load(std::memory_order_relaxed);
+	int slices = jpegEncoder->encode(*image, imageCount, current_timestamp(), quality);
+	if (slices == 0) {
+		sendErrors.fetch_add(1, std::memory_order_relaxed);
+		LOG_RATE_LIMITED(1, LOG_ERROR, "Transmit: Image %d (%dx%d) could not be encoded.", imageCount, image->cols, image->rows);
+		return -1;
+	}
+
+	/**
+	 * 2.0 Send the slices in order, paced like the raw rows.  A dropped slice is skipped, and only its rows are lost.
+	 */
+	uint32_t interval = datagramInterval.load(std::memory_order_relaxed);
+	struct timespec nextSendTime;
+	clock_gettime(CLOCK_MONOTONIC, &nextSendTime);
+	for (int slice = 0; slice < slices; slice++) {
+		size_t length = 0;
+		const uint8_t *datagram = jpegEncoder->getDatagram(slice, length);
+		if (length == 0) {
+			continue;
+		}
+		waitForSendTime(nextSendTime, interval);
+
+		int lres = sendDatagram(datagram, length);
+		if (lres < 0) {
+			/**
+			 * The rest of the image is abandoned, but the next image is tried, with a new socket, as the error may be temporary.
+			 */
+			sendErrors.fetch_add(1, std::memory_order_relaxed);
+			LOG_RATE_LIMITED(1, LOG_ERROR, "Transmit: Sending slice %d of image %d failed (%s).", slice, imageCount, strerror(errno));
+			closeSocket();
+			return -1;
+		}
+	}
+	framesSent.fetch_add(1, std::memory_order_relaxed);
+	return 0;
+}
+
+/**
+ * This method will stream the tiles of the image which have changed since they were last sent.
+ * @param image This is the image that is to be sent.
+ * @return The return will be 0 if successful or -1 if there is a failure.
+ */
+int ImageTransmitter::streamTiles(Mat *image) {
+	/**
+	 * 1.0 Find the tiles which have changed.
+	 */
+	int datagrams = tileEncoder->encode(*image, imageCount, current_timestamp(), getDatagramCapacity());
+	if (datagrams == 0) {
+		sendErrors.fetch_add(1, std::memory_order_relaxed);
+		LOG_RATE_LIMITED(1, LOG_ERROR, "Transmit: Image %d (%dx%d) could not be encoded.", imageCount, image->cols, image->rows);
+		return -1;
+	}
+
+	/**
+	 * 2.0 Build each datagram of tiles in the send buffer and send it, paced like the raw rows.
+	 */
+	uint32_t interval = datagramInterval.load(std::memory_order_relaxed);
+	struct timespec nextSendTime;
+	clock_gettime(CLOCK_MONOTONIC, &nextSendTime);
+	for (int datagram = 0; datagram < datagrams; datagram++) {
+		size_t length = tileEncoder->buildDatagram(datagram, sendBuffer);
+		waitForSendTime(nextSendTime, interval);
+
+		int lres = sendDatagram(sendBuffer, length);
+		if (lres < 0) {
+			/**
+			 * The tiles which were not sent are already in the reference, so the next frame has to be a keyframe.
+			 */
+			sendErrors.fetch_add(1, std::memory_order_relaxed);
+			LOG_RATE_LIMITED(1, LOG_ERROR, "Transmit: Sending tiles of image %d failed (%s).", imageCount, strerror(errno));
+			tileEncoder->requestKeyframe();
+			closeSocket();
+			return -1;
+		}
+	}
+	framesSent.fetch_add(1, std::memory_order_relaxed);
+	return 0;
+}
+
+/**
+ * This method will stream the image as groups of rows compressed without loss, one group per datagram.
+ * @param image This is the image that is to be sent.
+ * @return The return will be 0 if successful or -1 if there is a failure.
+ */
+int ImageTransmitter::streamLosslessRows(Mat *image) {
+	if ((image->channels() != 3) || (image->rows > 65535) || (image->cols > 65535)
+			|| (LosslessRowCodec::getWorstCaseRowSize(image->cols) > getDatagramCapacity() - sizeof(StreamRowHeader))) {
+		sendErrors.fetch_add(1, std::memory_order_relaxed);
+		LOG_RATE_LIMITED(1, LOG_ERROR, "Transmit: Image %d (%dx%d) can not be sent without loss.", imageCount, image->cols, image->rows);
+		return -1;
+	}
+	uint32_t time = current_timestamp();
+	uint32_t interval = datagramInterval.load(std::memory_order_relaxed);
+	struct timespec nextSendTime;
+	clock_gettime(CLOCK_MONOTONIC, &nextSendTime);
+
+	int row = 0;
+	while (row < image->rows) {
 		/**
-		 * 1.12	Free the message that was allocated on the heap.
+		 * 1.0 Compress as many rows as fit into the send buffer, behind the header.
 		 */
-		free(msgToSend);
+		size_t payloadSize = 0;
+		int rows = rowCodec.encodeRows(*image, row, sendBuffer + sizeof(StreamRowHeader), getDatagramCapacity() - sizeof(StreamRowHeader),
+				payloadSize);
 
 		/**
-		 * 1.13 Close the socket down.
+		 * 2.0 Fill in the header.
 		 */
-		close(sockfd);
+		StreamRowHeader *header = (StreamRowHeader*) sendBuffer;
+		header->magic = htonl(STREAM_MAGIC);
+		header->version = STREAM_VERSION;
+		header->payloadType = STREAM_PAYLOAD_LOSSLESS_ROWS;
+		header->pixelFormat = STREAM_PIXEL_BGR24;
+		header->reserved = 0;
+		header->firstRow = htons(row);
+		header->rowCount = htons(rows);
+		header->frameWidth = htons(image->cols);
+		header->frameHeight = htons(image->rows);
+		header->frameId = htonl(imageCount);
+		header->timestamp = htonl(time);
+		header->payloadSize = htonl(payloadSize);
+		header->rawSize = htonl(rows * image->cols * 3);
+
+		/**
+		 * 3.0 Send the datagram, paced like the raw rows.
+		 */
+		waitForSendTime(nextSendTime, interval);
+		int lres = sendDatagram(sendBuffer, sizeof(StreamRowHeader) + payloadSize);
+		if (lres < 0) {
+			/**
+			 * The rest of the image is abandoned, but the next image is tried, with a new socket, as the error may be temporary.
+			 */
+			sendErrors.fetch_add(1, std::memory_order_relaxed);
+			LOG_RATE_LIMITED(1, LOG_ERROR, "Transmit: Sending rows %d of image %d failed (%s).", row, imageCount, strerror(errno));
+			closeSocket();
+			return -1;
+		}
+		row += rows;
+	}
+	framesSent.fetch_add(1, std::memory_order_relaxed);
+	return 0;
+}
+
+/**
+ * This method will stream the image as rows converted to a smaller pixel format, with a StreamRowHeader on each datagram.
+ * @param image This is the image that is to be sent.
+ * @param format This is the pixel format.
+ * @return The return will be 0 if successful or -1 if there is a failure.
+ */
+int ImageTransmitter::streamPixelRows(Mat *image, StreamPixelFormat format) {
+	/**
+	 * 1.0 Work out the rows per datagram.  The requested lines per datagram are kept to, unless they do not fit, and
+	 * rounded down to the rows which the pixel format packs together.
+	 */
+	int rowMultiple = PixelFormatConverter::getRowMultiple(format);
+	size_t capacity = getDatagramCapacity() - sizeof(StreamRowHeader);
+	size_t multipleSize = PixelFormatConverter::getPackedSize(format, image->cols, rowMultiple);
+	int fit = (multipleSize > 0) ? (int) (capacity / multipleSize) * rowMultiple : 0;
+	int lines = std::min(requestedLinesPerDatagram.load(std::memory_order_relaxed), fit);
+	lines = std::max(lines - (lines % rowMultiple), rowMultiple);
+	if ((image->channels() != 3) || (image->rows > 65535) || (image->cols > 65535) || (fit < rowMultiple)) {
+		sendErrors.fetch_add(1, std::memory_order_relaxed);
+		LOG_RATE_LIMITED(1, LOG_ERROR, "Transmit: Image %d (%dx%d) can not be sent in pixel format %d.", imageCount, image->cols,
+				image->rows, format);
+		return -1;
+	}
+	uint32_t time = current_timestamp();
+	uint32_t interval = datagramInterval.load(std::memory_order_relaxed);
+	struct timespec nextSendTime;
+	clock_gettime(CLOCK_MONOTONIC, &nextSendTime);
+
+	for (int row = 0; row < image->rows; row += lines) {
+		/**
+		 * 2.0 Convert the rows straight into the send buffer, behind the header.
+		 */
+		int rows = std::min(lines, image->rows - row);
+		size_t payloadSize = PixelFormatConverter::packRows(*image, row, rows, format, sendBuffer + sizeof(StreamRowHeader));
 
+		/**
+		 * 3.0 Fill in the header.
+		 */
+		StreamRowHeader *header = (StreamRowHeader*) sendBuffer;
+		header->magic = htonl(STREAM_MAGIC);
+		header->version = STREAM_VERSION;
+		header->payloadType = STREAM_PAYLOAD_PIXEL_ROWS;
+		header->pixelFormat = format;
+		header->reserved = 0;
+		header->firstRow = htons(row);
+		header->rowCount = htons(rows);
+		header->frameWidth = htons(image->cols);
+		header->frameHeight = htons(image->rows);
+		header->frameId = htonl(imageCount);
+		header->timestamp = htonl(time);
+		header->payloadSize = htonl(payloadSize);
+		header->rawSize = htonl(payloadSize);
+
+		/**
+		 * 4.0 Send the datagram, paced like the raw rows.
+		 */
+		waitForSendTime(nextSendTime, interval);
+		int lres = sendDatagram(sendBuffer, sizeof(StreamRowHeader) + payloadSize);
+		if (lres < 0) {
+			/**
+			 * The rest of the image is abandoned, but the next image is tried, with a new socket, as the error may be temporary.
+			 */
+			sendErrors.fetch_add(1, std::memory_order_relaxed);
+			LOG_RATE_LIMITED(1, LOG_ERROR, "Transmit: Sending rows %d of image %d failed (%s).", row, imageCount, strerror(errno));
+			closeSocket();
+			return -1;
+		}
 	}
+	framesSent.fetch_add(1, std::memory_order_relaxed);
 	return 0;
 }
+
+/**
+ * This method will wait for feedback from the receivers to arrive on the socket, and act on it straight away, so that a
+ * lost datagram is sent again within about a round trip, rather than when the next image is streamed.  The socket is
+ * waited on without the lock, so that the transmitting thread is never held up by the wait, and it is only read if it
+ * has not been closed in the meantime.
+ * @param timeout This is the longest time to wait in milliseconds.
+ * @return The return will be true if feedback arrived, or false if the wait timed out or the socket is not open.
+ */
+bool ImageTransmitter::serviceFeedback(int timeout) {
+	if (socketOwner != NULL) {
+		return socketOwner->serviceFeedback(timeout);
+	}
+
+	/**
+	 * 1.0 Wait for the socket to become readable.  A socket which is not open is skipped by poll, which then only waits,
+	 * for no longer than 10 ms, so that the socket is picked up soon after it is opened.
+	 */
+	struct pollfd waiting;
+	{
+		std::lock_guard<RealTimeMutex> guard(*socketLock);
+		waiting.fd = sockfd;
+	}
+	waiting.events = POLLIN;
+	waiting.revents = 0;
+	if ((poll(&waiting, 1, (waiting.fd < 0) ? std::min(timeout, 10) : timeout) <= 0) || (waiting.fd < 0)) {
+		return false;
+	}
+
+	/**
+	 * 2.0 Act on the feedback, unless the socket was closed while it was waited on.
+	 */
+	std::lock_guard<RealTimeMutex> guard(*socketLock);
+	if (sockfd != waiting.fd) {
+		return false;
+	}
+	readFeedback();
+	return true;
+}
+
+/**
+ * This method will read the feedback which the receiver has sent back on the socket, without waiting, and pass it to the
+ * stream it is for.  The streams of a simulcast share the socket, so any of them may read the feedback of the others.
+ * The lock of the socket must be held.
+ */
+void ImageTransmitter::readFeedback() {
+	union {
+		StreamFeedback feedback;
+		StreamNack nack;
+		StreamReceiverReport report;
+	} message;
+	struct sockaddr_in sender;
+	socklen_t senderLength = sizeof(sender);
+	ssize_t received;
+	while ((received = recvfrom(sockfd, &message, sizeof(message), MSG_DONTWAIT, (struct sockaddr*) &sender, &senderLength)) >= 0) {
+		senderLength = sizeof(sender);
+		if ((received < (ssize_t) sizeof(StreamFeedback)) || (ntohl(message.feedback.magic) != STREAM_FEEDBACK_MAGIC)
+				|| (message.feedback.version != STREAM_VERSION)) {
+			continue;
+		}
+		ImageTransmitter *stream = findStream(message.feedback.streamId);
+		if (stream != NULL) {
+			stream->handleFeedback((const uint8_t*) &message, received, sender);
+		}
+	}
+}
+
+/**
+ * This method will act on a feedback message from a receiver.  A message which is not from a destination machine is
+ * ignored, unless the stream is sent to a multicast group, whose receivers are not known.  The address of such a
+ * receiver may be forged, so the datagrams it asks for again are sent to the groups, where they would have gone anyway,
+ * and the stream can not be turned on another host.
+ * @param message This is the message, which starts with a StreamFeedback.
+ * @param length This is the length of the message in bytes.
+ * @param sender This is the address which the message came from.
+ */
+void ImageTransmitter::handleFeedback(const uint8_t *message, size_t length, const struct sockaddr_in &sender) {
+	const StreamFeedback &feedback = *(const StreamFeedback*) message;
+	bool fromDestination = isDestination(sender);
+	if ((multicast == false) && (fromDestination == false)) {
+		return;
+	}
+	if ((feedback.type == STREAM_FEEDBACK_KEYFRAME) && (tileEncoder != NULL)) {
+		tileEncoder->requestKeyframe();
+	} else if ((feedback.type == STREAM_FEEDBACK_NACK) && (length == sizeof(StreamNack))) {
+		const StreamNack &nack = *(const StreamNack*) message;
+		nacksReceived.fetch_add(1, std::memory_order_relaxed);
+
+		/**
+		 * The receiver asks for the lost datagrams of a frame when the next frame starts to arrive, so the time since the
+		 * next frame was started measures the round trip, within which a datagram is not sent again twice.
+		 */
+		uint64_t now = getMonotonicTime();
+		uint64_t nextStartTime = 0;
+		if ((history != NULL) && history->getStartTime(ntohl(feedback.frameId) + 1, nextStartTime) && (now > nextStartTime)) {
+			uint32_t sample = (uint32_t) std::max((now - nextStartTime) / 1000, (uint64_t) 1);
+			uint32_t smoothed = roundTripTime.load(std::memory_order_relaxed);
+			roundTripTime.store((smoothed == 0) ? sample : (smoothed - (smoothed / 8) + (sample / 8)), std::memory_order_relaxed);
+		}
+		for (int bit = 0; bit < STREAM_NACK_BITS; bit++) {
+			if (ntohl(nack.bitmap[bit / 32]) & (1u << (bit % 32))) {
+				retransmit(ntohl(feedback.frameId), ntohs(nack.firstIndex) + bit, fromDestination ? &sender : NULL);
+			}
+		}
+	} else if ((feedback.type == STREAM_FEEDBACK_REPORT) && (length == sizeof(StreamReceiverReport))) {
+		const StreamReceiverReport &report = *(const StreamReceiverReport*) message;
+		reportedLossFraction.store(ntohs(report.lossFraction), std::memory_order_relaxed);
+		reportedJitter.store(ntohl(report.jitter), std::memory_order_relaxed);
+		reportedReceiveRate.store(ntohl(report.receiveRate), std::memory_order_relaxed);
+		reportsReceived.fetch_add(1, std::memory_order_release);
+	}
+}
+
+/**
+ * This method will find the stream of the simulcast which this stream belongs to with the given stream id.
+ * @param streamId This is the stream id.
+ * @return The return will be the stream, or NULL if there is no such stream.
+ */
+ImageTransmitter* ImageTransmitter::findStream(int streamId) {
+	ImageTransmitter *first = (socketOwner != NULL) ? socketOwner : this;
+	if (streamId == 0) {
+		return first;
+	}
+	return (streamId <= (int) first->simulcastStreams.size()) ? first->simulcastStreams[streamId - 1] : NULL;
+}
+
+/**
+ * This method will send a datagram again which the receiver lost, if it is still kept and its image is still within
+ * the latency budget.  It is sent straight away, without forward error correction, and only to the receiver which
+ * lost it, or to the multicast groups if the receiver is not known.  The lock of the socket must be held, so that the
+ * datagram is not overwritten while it is sent.
+ * @param frameId This is the count of the image.
+ * @param index This is the index of the datagram within the image.
+ * @param receiver This is the address of the receiver which lost the datagram, or NULL to send it to the multicast
+ * groups of the stream.
+ */
+void ImageTransmitter::retransmit(uint32_t frameId, int index, const struct sockaddr_in *receiver) {
+	/**
+	 * 1.0 Find the datagram.  Once retransmission is turned off, the history is no longer kept up to date.
+	 */
+	size_t length = 0;
+	uint64_t startTime = 0;
+	uint64_t retransmitTime = 0;
+	uint8_t *datagram = NULL;
+	if ((history != NULL) && retransmitActive && (index < TransmitHistory::MAXIMUM_DATAGRAMS_PER_FRAME)) {
+		datagram = history->find(frameId, (uint16_t) index, length, startTime, retransmitTime);
+	}
+
+	/**
+	 * 2.0 Check that it is not too late for the datagram to be of use.
+	 */
+	uint64_t now = getMonotonicTime();
+	uint64_t budget = (uint64_t) requestedRetransmitBudget.load(std::memory_order_relaxed) * 1000000ULL;
+	if ((datagram == NULL) || (now - startTime > budget)) {
+		retransmissionsExpired.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	/**
+	 * 2.1 Send a datagram again at most once a round trip.  A request which arrives sooner is a duplicate, and answering
+	 * it would only add to the load of a link which is already losing datagrams.  Until the round trip has been
+	 * measured, a datagram is sent again only once.
+	 */
+	uint64_t roundTrip = (uint64_t) roundTripTime.load(std::memory_order_relaxed) * 1000ULL;
+	if ((retransmitTime != 0) && (now - retransmitTime < ((roundTrip > 0) ? roundTrip : budget))) {
+		retransmissionsSuppressed.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	/**
+	 * 3.0 Send the datagram again behind a copy of its sequence header which marks it as retransmitted.  The datagram
+	 * itself is not changed, as the transmitting thread may be sending it.
+	 */
+	StreamSequenceHeader header = *(const StreamSequenceHeader*) datagram;
+	header.flags |= STREAM_FLAG_RETRANSMITTED;
+	struct iovec parts[3];
+	int partCount = 0;
+	if (simulcast) {
+		parts[partCount].iov_base = &simulcastHeader;
+		parts[partCount++].iov_len = sizeof(simulcastHeader);
+	}
+	parts[partCount].iov_base = &header;
+	parts[partCount++].iov_len = sizeof(header);
+	parts[partCount].iov_base = datagram + sizeof(header);
+	parts[partCount++].iov_len = length - sizeof(header);
+	struct msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_namelen = sizeof(struct sockaddr_in);
+	message.msg_iov = parts;
+	message.msg_iovlen = partCount;
+	int lres = -1;
+	if (receiver != NULL) {
+		message.msg_name = (void*) receiver;
+		lres = sendmsg(sockfd, &message, 0);
+	} else {
+		for (int destination = 0; destination < destinationCount; destination++) {
+			if (destinations[destination].resolved && IN_MULTICAST(ntohl(destinations[destination].address.sin_addr.s_addr))) {
+				message.msg_name = &destinations[destination].address;
+				lres = std::max(lres, (int) sendmsg(sockfd, &message, 0));
+			}
+		}
+	}
+	if (lres >= 0) {
+		history->markRetransmitted(frameId, (uint16_t) index, now);
+		datagramsSent.fetch_add(1, std::memory_order_relaxed);
+		bytesSent.fetch_add(lres, std::memory_order_relaxed);
+		datagramsRetransmitted.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+/**
+ * This method will wait until the send time of the next datagram of an image, and then work out the send time of the
+ * one after it.  Absolute times keep the pacing from drifting.
+ * @param nextSendTime This is the CLOCK_MONOTONIC send time of the next datagram.  It is advanced by the interval.
+ * @param interval This is the time between datagrams in microseconds.  If it is 0, the method returns at once.
+ */
+void ImageTransmitter::waitForSendTime(struct timespec &nextSendTime, uint32_t interval) {
+	if (interval > 0) {
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &nextSendTime, NULL);
+		nextSendTime.tv_nsec += interval * 1000L;
+		while (nextSendTime.tv_nsec >= 1000000000L) {
+			nextSendTime.tv_nsec -= 1000000000L;
+			nextSendTime.tv_sec++;
+		}
+	}
+}
+
+/**
+ * This method will open the socket and look up the destinations, if that has not already been done.  A destination
+ * which can not be found is skipped until the socket is opened again.  A stream of a simulcast sends on the socket of
+ * the first stream, and looks its destinations up again whenever that socket has been opened again.
+ * @return The return will be true if the socket is open or false if it could not be opened.
+ */
+bool ImageTransmitter::openSocket() {
+	if (socketOwner != NULL) {
+		/**
+		 * 1.0 Take the socket of the first stream of the simulcast, opening it if need be.
+		 */
+		if (socketOwner->openSocket() == false) {
+			closeSocket();
+			return false;
+		}
+		if ((sockfd >= 0) && (socketOpenCount == socketOwner->socketOpenCount)) {
+			return true;
+		}
+	} else if (sockfd >= 0) {
+		return true;
+	}
+
+	/**
+	 * 1.1 The socket and the destinations are set up under the lock of the socket, as the feedback is read from the one
+	 * and checked against the other.
+	 */
+	int resolvedCount = 0;
+	{
+		std::lock_guard<RealTimeMutex> guard(*socketLock);
+		if (socketOwner != NULL) {
+			sockfd = socketOwner->sockfd;
+			socketOpenCount = socketOwner->socketOpenCount;
+		} else if ((sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+			/**
+			 * 1.2 Otherwise, initialize the socket sockfd to be a DGRAM.
+			 */
+			sendErrors.fetch_add(1, std::memory_order_relaxed);
+			LOG_RATE_LIMITED(1, LOG_ERROR, "Transmit: Cannot create the socket (%s).", strerror(errno));
+			sockfd = -1;
+			return false;
+		} else {
+			socketOpenCount++;
+		}
+
+		/**
+		 * 2.0 Get each destination host by name, and set up the rest of its UDP parameters, and the port.  If there is no
+		 * such host, print out an error.
+		 */
+		multicast = false;
+		for (int index = 0; index < destinationCount; index++) {
+			StreamDestination &destination = destinations[index];
+			struct hostent *server = gethostbyname(destination.machineName);
+			destination.resolved = (server != NULL);
+			destination.suspendedUntil.store(0, std::memory_order_relaxed);
+			if (server == NULL) {
+				destination.sendErrors.fetch_add(1, std::memory_order_relaxed);
+				LOG_RATE_LIMITED(1, LOG_ERROR, "Transmit: No such host %s.", destination.machineName);
+				continue;
+			}
+			memset(&destination.address, 0, sizeof(destination.address));
+			destination.address.sin_family = AF_INET;
+			memcpy(&destination.address.sin_addr.s_addr, server->h_addr, server->h_length);
+			destination.address.sin_port = htons(destination.port);
+			multicast = multicast || IN_MULTICAST(ntohl(destination.address.sin_addr.s_addr));
+			resolvedCount++;
+		}
+	}
+
+	/**
+	 * 3.0 If no destination was found, try again with the next image.
+	 */
+	if (resolvedCount == 0) {
+		sendErrors.fetch_add(1, std::memory_order_relaxed);
+		closeSocket();
+		return false;
+	}
+
+	/**
+	 * 4.0 If a destination is a multicast group, limit how far its datagrams travel, and loop them back, so that a
+	 * receiver on this machine gets them too.
+	 */
+	if (multicast) {
+		unsigned char ttl = (unsigned char) multicastTtl;
+		unsigned char loop = 1;
+		setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+		setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+	}
+	return true;
+}
+
+/**
+ * This method will close the socket.  A stream of a simulcast only lets go of the socket of the first stream, which
+ * stays open for it.  The socket is closed under its lock, so that the feedback is never read from a closed socket.
+ */
+void ImageTransmitter::closeSocket() {
+	std::lock_guard<RealTimeMutex> guard(*socketLock);
+	if ((socketOwner == NULL) && (sockfd >= 0)) {
+		close(sockfd);
+	}
+	sockfd = -1;
+}
+
+/**
+ * This method will obtain the name of the stream, which is the destination machine and port, followed by the stream id
+ * for a stream of a simulcast other than the first.
+ * @return The return will be the name of the stream.
+ */
+std::string ImageTransmitter::getName() {
+	std::string name = std::string((destinationMachineName != NULL) ? destinationMachineName : "") + ":" + std::to_string(myPort);
+	return (simulcastHeader.streamId > 0) ? (name + "/" + std::to_string(simulcastHeader.streamId)) : name;
+}
+
+/**
+ * This method will make another transmitter a stream of the simulcast which this one is the first stream of.  It sends
+ * on the socket of this transmitter, with the next stream id, and the feedback for it which arrives on the socket is
+ * passed on to it.  It must be called before the streams are started, and the streams must all be streamed from the
+ * same thread.  This transmitter must outlive the stream.
+ * @param stream This is the transmitter which is to be a stream of the simulcast.
+ * @return The return will be true if it was added, or false if it already belongs to a simulcast or there are too many
+ * streams.
+ */
+bool ImageTransmitter::addSimulcastStream(ImageTransmitter *stream) {
+	if ((stream == NULL) || (stream == this) || (socketOwner != NULL) || stream->simulcast || (simulcastStreams.size() >= 254)) {
+		return false;
+	}
+	simulcastStreams.push_back(stream);
+	stream->socketOwner = this;
+	stream->socketLock = socketLock;
+
+	/**
+	 * Every stream carries the number of streams in its header, so all of the headers are brought up to date.
+	 */
+	uint8_t streamCount = (uint8_t) (simulcastStreams.size() + 1);
+	for (ImageTransmitter *member : { this, stream }) {
+		member->simulcast = true;
+		member->simulcastHeader.magic = htonl(STREAM_SIMULCAST_MAGIC);
+		member->simulcastHeader.version = STREAM_VERSION;
+		member->simulcastHeader.reserved = 0;
+	}
+	stream->simulcastHeader.streamId = streamCount - 1;
+	simulcastHeader.streamCount = streamCount;
+	for (ImageTransmitter *member : simulcastStreams) {
+		member->simulcastHeader.streamCount = streamCount;
+	}
+	return true;
+}
+
+/**
+ * This method will obtain the stream id of the stream within its simulcast.
+ * @return The return will be the stream id, which is 0 for the first stream or a stream which is not a simulcast.
+ */
+int ImageTransmitter::getStreamId() {
+	return simulcastHeader.streamId;
+}
+
+/**
+ * This method will add a destination which the stream is sent to as well, either a unicast host or a multicast group.
+ * It must be called before the stream is started.
+ * @param machineName This is the name of the machine or the multicast group.  It is not copied.
+ * @param port This is the udp port number which the datagrams are sent to.
+ * @return The return will be true if the destination was added, or false if the stream has as many destinations as it
+ * can have.
+ */
+bool ImageTransmitter::addDestination(char *machineName, int port) {
+	if ((machineName == NULL) || (destinationCount >= MAXIMUM_DESTINATIONS)) {
+		return false;
+	}
+	StreamDestination &destination = destinations[destinationCount++];
+	destination.machineName = machineName;
+	destination.port = port;
+	memset(&destination.address, 0, sizeof(destination.address));
+	return true;
+}
+
+/**
+ * This method will set the number of hops which the datagrams sent to a multicast group may travel.  It must be called
+ * before the stream is started.
+ * @param ttl This is the number of hops, from 1 to 255.
+ */
+void ImageTransmitter::setMulticastTtl(int ttl) {
+	if ((ttl >= 1) && (ttl <= 255)) {
+		multicastTtl = ttl;
+	}
+}
+
+/**
+ * This method will obtain the number of destinations of the stream.
+ * @return The return will be the number of destinations.
+ */
+int ImageTransmitter::getDestinationCount() {
+	return destinationCount;
+}
+
+/**
+ * This method will obtain the name of a destination, which is the machine and port.
+ * @param index This is the index of the destination.
+ * @return The return will be the name of the destination.
+ */
+std::string ImageTransmitter::getDestinationName(int index) {
+	return std::string(destinations[index].machineName) + ":" + std::to_string(destinations[index].port);
+}
+
+/**
+ * This method will obtain the number of datagrams sent to a destination.
+ * @param index This is the index of the destination.
+ * @return The return will be the number of datagrams.
+ */
+uint64_t ImageTransmitter::getDestinationDatagramsSent(int index) {
+	return destinations[index].datagramsSent.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the number of bytes sent to a destination.
+ * @param index This is the index of the destination.
+ * @return The return will be the number of bytes.
+ */
+uint64_t ImageTransmitter::getDestinationBytesSent(int index) {
+	return destinations[index].bytesSent.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the number of datagrams which could not be sent to a destination, and the times it could not
+ * be found.
+ * @param index This is the index of the destination.
+ * @return The return will be the number of errors.
+ */
+uint64_t ImageTransmitter::getDestinationSendErrors(int index) {
+	return destinations[index].sendErrors.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will determine if nothing is being sent to a destination because a send to it failed.
+ * @param index This is the index of the destination.
+ * @return The return will be true if the destination is suspended or false otherwise.
+ */
+bool ImageTransmitter::isDestinationSuspended(int index) {
+	uint64_t suspendedUntil = destinations[index].suspendedUntil.load(std::memory_order_relaxed);
+	return (suspendedUntil != 0) && (getMonotonicTime() < suspendedUntil);
+}
+
+/**
+ * This method will change the number of lines in each UDP datagram.  It may be called from any thread, and takes effect
+ * at the start of the next image.
+ * @param lines This is the number of lines per datagram.  It must be at least 1.
+ */
+void ImageTransmitter::setLinesPerDatagram(int lines) {
+	if (lines >= 1) {
+		requestedLinesPerDatagram.store(lines, std::memory_order_relaxed);
+	}
+}
+
+/**
+ * This method will obtain the number of lines in each UDP datagram.
+ * @return The return will be the number of lines per datagram.
+ */
+int ImageTransmitter::getLinesPerDatagram() {
+	return requestedLinesPerDatagram.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will set the pacing of the datagrams.  It takes effect at the start of the next image.
+ * @param interval This is the time between datagrams in microseconds, or 0 to send them as fast as possible.
+ */
+void ImageTransmitter::setDatagramInterval(uint32_t interval) {
+	datagramInterval.store(interval, std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the pacing of the datagrams.
+ * @return The return will be the time between datagrams in microseconds.
+ */
+uint32_t ImageTransmitter::getDatagramInterval() {
+	return datagramInterval.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will give the stream an encoder for JPEG slices.  It must be called before the first image is streamed.
+ * @param encoder This is the encoder.  It is not owned by the transmitter.
+ */
+void ImageTransmitter::setJpegEncoder(JpegSliceEncoder *encoder) {
+	jpegEncoder = encoder;
+}
+
+/**
+ * This method will obtain the encoder for JPEG slices.
+ * @return The return will be the encoder, or NULL if the stream has none.
+ */
+JpegSliceEncoder* ImageTransmitter::getJpegEncoder() {
+	return jpegEncoder;
+}
+
+/**
+ * This method will give the stream an encoder for tile deltas.  It must be called before the first image is streamed.
+ * @param encoder This is the encoder.  It is not owned by the transmitter.
+ */
+void ImageTransmitter::setTileEncoder(TileDeltaEncoder *encoder) {
+	tileEncoder = encoder;
+}
+
+/**
+ * This method will obtain the encoder for tile deltas.
+ * @return The return will be the encoder, or NULL if the stream has none.
+ */
+TileDeltaEncoder* ImageTransmitter::getTileEncoder() {
+	return tileEncoder;
+}
+
+/**
+ * This method will set the encoder which the datagrams are protected with, and turn forward error correction on at its
+ * group size.  It must be called before the stream is started.
+ * @param encoder This is the encoder.
+ */
+void ImageTransmitter::setFecEncoder(FecEncoder *encoder) {
+	fecEncoder = encoder;
+	requestedFecParityCount.store(encoder->getParityCount(), std::memory_order_relaxed);
+	requestedFecDataCount.store(encoder->getDataCount(), std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the encoder which the datagrams are protected with.
+ * @return The return will be the encoder, or NULL if there is none.
+ */
+FecEncoder* ImageTransmitter::getFecEncoder() {
+	return fecEncoder;
+}
+
+/**
+ * This method will change the forward error correction of the stream.
+ * @param dataCount This is the number of data datagrams in a group, or 0 to turn the error correction off.
+ * @param parityCount This is the number of parity datagrams for each group.  It is ignored if the error correction is
+ * turned off.
+ * @return The return will be true if the error correction was changed, or false if there is no encoder or the group
+ * size is out of range.
+ */
+bool ImageTransmitter::setFec(int dataCount, int parityCount) {
+	if ((fecEncoder == NULL) || (dataCount < 0) || (dataCount > FecCodec::MAXIMUM_DATA_COUNT)) {
+		return false;
+	}
+	if (dataCount > 0) {
+		if ((parityCount < 1) || (parityCount > fecEncoder->getMaximumParityCount())) {
+			return false;
+		}
+		requestedFecParityCount.store(parityCount, std::memory_order_relaxed);
+	}
+	requestedFecDataCount.store(dataCount, std::memory_order_relaxed);
+	return true;
+}
+
+/**
+ * These methods obtain the forward error correction which has been requested: the number of data datagrams in a group,
+ * which is 0 if it is off, and the number of parity datagrams for each group.
+ */
+int ImageTransmitter::getFecDataCount() {
+	return (fecEncoder != NULL) ? requestedFecDataCount.load(std::memory_order_relaxed) : 0;
+}
+int ImageTransmitter::getFecParityCount() {
+	return requestedFecParityCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will set the history which the datagrams are kept in for retransmission.  It must be called before the
+ * stream is started.
+ * @param transmitHistory This is the history.
+ */
+void ImageTransmitter::setTransmitHistory(TransmitHistory *transmitHistory) {
+	history = transmitHistory;
+}
+
+/**
+ * This method will obtain the history which the datagrams are kept in for retransmission.
+ * @return The return will be the history, or NULL if there is none.
+ */
+TransmitHistory* ImageTransmitter::getTransmitHistory() {
+	return history;
+}
+
+/**
+ * This method will change the latency budget of the retransmission.  A lost datagram is only sent again if its image
+ * started less than the budget ago.
+ * @param budget This is the budget in milliseconds, or 0 to turn retransmission off.
+ * @return The return will be true if the budget was changed, or false if there is no history.
+ */
+bool ImageTransmitter::setRetransmitBudget(uint32_t budget) {
+	if (history == NULL) {
+		return false;
+	}
+	requestedRetransmitBudget.store(budget, std::memory_order_relaxed);
+	return true;
+}
+
+/**
+ * This method will obtain the latency budget of the retransmission.
+ * @return The return will be the budget in milliseconds, or 0 if retransmission is off.
+ */
+uint32_t ImageTransmitter::getRetransmitBudget() {
+	return (history != NULL) ? requestedRetransmitBudget.load(std::memory_order_relaxed) : 0;
+}
+
+/**
+ * This method will obtain the codec which the rows are compressed with in the lossless encoding.
+ * @return The return will be the codec.
+ */
+LosslessRowCodec& ImageTransmitter::getRowCodec() {
+	return rowCodec;
+}
+
+/**
+ * This method will change the encoding of the stream.  It takes effect at the start of the next image.
+ * @param encoding This is the encoding.
+ * @param quality This is the JPEG quality, from 1 to 100.
+ * @return The return will be true if the encoding was changed, or false if it can not be used.
+ */
+bool ImageTransmitter::setEncoding(StreamEncoding encoding, int quality) {
+	if ((quality < 1) || (quality > 100) || ((encoding == ENCODING_JPEG) && (jpegEncoder == NULL))
+			|| ((encoding == ENCODING_DELTA) && (tileEncoder == NULL))) {
+		return false;
+	}
+	requestedQuality.store(quality, std::memory_order_relaxed);
+	requestedEncoding.store(encoding, std::memory_order_relaxed);
+	return true;
+}
+
+/**
+ * This method will obtain the encoding of the stream.
+ * @return The return will be the encoding.
+ */
+StreamEncoding ImageTransmitter::getEncoding() {
+	return (StreamEncoding) requestedEncoding.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the JPEG quality of the stream.
+ * @return The return will be the quality, from 1 to 100.
+ */
+int ImageTransmitter::getJpegQuality() {
+	return requestedQuality.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will change the pixel format which the raw rows are sent in.
+ * @param format This is the pixel format (a StreamPixelFormat).
+ * @return The return will be true if the pixel format was changed, or false if it is not a pixel format.
+ */
+bool ImageTransmitter::setPixelFormat(int format) {
+	if (PixelFormatConverter::isValid(format) == false) {
+		return false;
+	}
+	requestedPixelFormat.store(format, std::memory_order_relaxed);
+	return true;
+}
+
+/**
+ * This method will obtain the pixel format which the raw rows are sent in.
+ * @return The return will be the pixel format.
+ */
+StreamPixelFormat ImageTransmitter::getPixelFormat() {
+	return (StreamPixelFormat) requestedPixelFormat.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the list of all of the transmitters.
+ * @return The return will be a reference to the list of transmitters.
+ */
+const std::list<ImageTransmitter*>& ImageTransmitter::getAllTransmitters() {
+	return allTransmitters;
+}
+
+/**
+ * These methods obtain the statistics of the stream.
+ */
+uint64_t ImageTransmitter::getFramesSent() {
+	return framesSent.load(std::memory_order_relaxed);
+}
+
+uint64_t ImageTransmitter::getDatagramsSent() {
+	return datagramsSent.load(std::memory_order_relaxed);
+}
+
+uint64_t ImageTransmitter::getBytesSent() {
+	return bytesSent.load(std::memory_order_relaxed);
+}
+
+uint64_t ImageTransmitter::getSendErrors() {
+	return sendErrors.load(std::memory_order_relaxed);
+}
+
+uint64_t ImageTransmitter::getParityDatagramsSent() {
+	return parityDatagramsSent.load(std::memory_order_relaxed);
+}
+
+uint64_t ImageTransmitter::getNacksReceived() {
+	return nacksReceived.load(std::memory_order_relaxed);
+}
+
+uint64_t ImageTransmitter::getDatagramsRetransmitted() {
+	return datagramsRetransmitted.load(std::memory_order_relaxed);
+}
+
+uint64_t ImageTransmitter::getRetransmissionsExpired() {
+	return retransmissionsExpired.load(std::memory_order_relaxed);
+}
+uint64_t ImageTransmitter::getRetransmissionsSuppressed() {
+	return retransmissionsSuppressed.load(std::memory_order_relaxed);
+}
+uint32_t ImageTransmitter::getRoundTripTime() {
+	return roundTripTime.load(std::memory_order_relaxed);
+}
+
+/**
+ * These methods obtain the last report from the receiver: the number of reports received, the fraction of the
+ * datagrams lost on the link, from 0 to 1, the jitter in microseconds, and the receive rate in kilobits per second.
+ */
+uint64_t ImageTransmitter::getReportsReceived() {
+	return reportsReceived.load(std::memory_order_acquire);
+}
+
+double ImageTransmitter::getReportedLoss() {
+	return reportedLossFraction.load(std::memory_order_relaxed) / 65536.0;
+}
+
+uint32_t ImageTransmitter::getReportedJitter() {
+	return reportedJitter.load(std::memory_order_relaxed);
+}
+
+uint32_t ImageTransmitter::getReportedReceiveRate() {
+	return reportedReceiveRate.load(std::memory_order_relaxed);
+}
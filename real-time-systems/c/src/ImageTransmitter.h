@@ -21,26 +21,166 @@
  * the grant of any rights to this Software.
  *
  * @section DESCRIPTION
- *      This class will transmit an image to a remote device.  The image will be transmitted as a set of UDP datagrams.
+ *      This class will transmit an image to a remote device.  The image will be transmitted as a set of UDP datagrams,
+ *      either as raw rows or as JPEG slices which can each be decoded on their own.  Each datagram is built once and
+ *      sent to every destination of the stream, which may be unicast hosts or a multicast group, in one system call.
+ *      Several transmitters may share one socket as the streams of a simulcast, each sending one resolution of the
+ *      frames under its own stream id.
  */
 
 #ifndef IMAGETRANSMITTER_H_
 #define IMAGETRANSMITTER_H_
 
+#include "JpegSliceEncoder.h"
+#include "TileDeltaEncoder.h"
+#include "LosslessRowCodec.h"
+#include "PixelFormatConverter.h"
+#include "FecEncoder.h"
+#include "TransmitHistory.h"
+#include "RealTimeMutex.h"
+
 #include <opencv2/opencv.hpp>
+#include <atomic>
+#include <list>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
 
 using namespace cv;
 
+/**
+ * This enumeration defines how the images of a stream are encoded.
+ */
+enum StreamEncoding {
+	ENCODING_RAW = 0, /**< Each datagram holds a number of raw BGR rows. */
+	ENCODING_JPEG = 1, /**< Each datagram holds a StreamSliceHeader and a slice of the image, encoded as a JPEG. */
+	ENCODING_DELTA = 2, /**< Each datagram holds a StreamTileHeader and the tiles of the image which have changed. */
+	ENCODING_LOSSLESS = 3 /**< Each datagram holds a StreamRowHeader and a group of rows compressed without loss. */
+};
+
+/**
+ * This structure is one of the destinations which a stream is sent to, and its statistics.
+ */
+struct StreamDestination {
+	/**
+	 * This is the name of the destination machine, or the multicast group, and the port it is sent to.
+	 */
+	char *machineName = NULL;
+	int port = 0;
+
+	/**
+	 * This is the address of the destination, which is looked up when the socket is opened, and whether it was found.
+	 */
+	struct sockaddr_in address;
+	bool resolved = false;
+
+	/**
+	 * This is the CLOCK_MONOTONIC time, in nanoseconds, until which nothing is sent to the destination because a send to
+	 * it failed.  It is 0 if the destination is not suspended.  It is updated by the transmitting thread and may be read
+	 * by any thread.
+	 */
+	std::atomic<uint64_t> suspendedUntil { 0 };
+
+	/**
+	 * These are the statistics of the destination.  They are updated by the transmitting thread and may be read by any thread.
+	 */
+	std::atomic<uint64_t> datagramsSent { 0 };
+	std::atomic<uint64_t> bytesSent { 0 };
+	std::atomic<uint64_t> sendErrors { 0 };
+};
+
 class ImageTransmitter {
+public:
+	/**
+	 * This is the largest number of destinations which a stream can be sent to.
+	 */
+	static const int MAXIMUM_DESTINATIONS = 16;
+
 private:
 	/**
 	 * This is the default port that is to be used for the UDP transmission.
 	 */
 	int myPort = 6000;
 	/**
-	 * This is the socket fd that is to be used.
+	 * This is the socket fd that is to be used.  It is opened for the first image and kept open, and is -1 while it is closed.
 	 */
-	int sockfd = 0;
+	int sockfd = -1;
+
+	/**
+	 * This is the lock which the socket, the destinations and the history are shared under, between the transmitting
+	 * thread and the thread which acts on the feedback.  The streams of a simulcast all use the lock of the first stream,
+	 * whose socket they share.
+	 */
+	RealTimeMutex feedbackLock;
+	RealTimeMutex *socketLock;
+
+	/**
+	 * These are the destinations of the stream and the number of them.  The first is the destination machine which the
+	 * transmitter was constructed for.
+	 */
+	StreamDestination destinations[MAXIMUM_DESTINATIONS];
+	int destinationCount = 0;
+
+	/**
+	 * These are the messages which a datagram is sent to the destinations with, one per destination.  They are kept
+	 * here so that they are not built on the stack for each datagram.
+	 */
+	struct mmsghdr messages[MAXIMUM_DESTINATIONS];
+
+	/**
+	 * This variable will determine whether or not one of the destinations is a multicast group.  The feedback is then
+	 * taken from any receiver, as the members of the group are not known, but the datagrams which such a receiver asks
+	 * for again are sent to the groups, never to the address which the feedback came from.
+	 */
+	bool multicast = false;
+
+	/**
+	 * This is the number of hops which the datagrams sent to a multicast group may travel.
+	 */
+	int multicastTtl = 1;
+
+	/**
+	 * This is the number of times the socket has been opened.  In a stream of a simulcast, it is the count of the first
+	 * stream's socket which the destinations were last looked up for.
+	 */
+	uint32_t socketOpenCount = 0;
+
+	/**
+	 * This is the first stream of the simulcast which this stream sends on the socket of, or NULL if this stream has its
+	 * own socket.
+	 */
+	ImageTransmitter *socketOwner = NULL;
+
+	/**
+	 * These are the other streams of the simulcast, in the order of their stream ids, if this is the first stream.
+	 */
+	std::vector<ImageTransmitter*> simulcastStreams;
+
+	/**
+	 * This is the header which each datagram is sent behind, and whether or not the stream is part of a simulcast.
+	 */
+	StreamSimulcastHeader simulcastHeader;
+	bool simulcast = false;
+
+	/**
+	 * This is the buffer which each datagram is built in.  It is allocated once, large enough for the largest datagram,
+	 * and aligned to a cache line.
+	 */
+	uint8_t *sendBuffer = NULL;
+
+	/**
+	 * This method will open the socket and look up the destinations, if that has not already been done.
+	 * @return The return will be true if the socket is open or false if it could not be opened.
+	 */
+	bool openSocket();
+
+	/**
+	 * This method will close the socket.  A stream of a simulcast only lets go of the socket of the first stream, which
+	 * stays open for it.
+	 */
+	void closeSocket();
 	/**
 	 * This is a c style string representing the destination machine's name.
 	 */
@@ -55,6 +195,233 @@ private:
 	 */
 	int linesPerUDPDatagram=1;
 
+	/**
+	 * This is the number of lines per UDP datagram which has been requested.  It is copied into linesPerUDPDatagram at
+	 * the start of each image, so a change never splits an image.
+	 */
+	std::atomic<int> requestedLinesPerDatagram;
+
+	/**
+	 * This is the time, in microseconds, between the datagrams of an image.  0 means the datagrams are sent as fast as possible.
+	 */
+	std::atomic<uint32_t> datagramInterval;
+
+	/**
+	 * This is the encoder which the JPEG slices are encoded with.  It is NULL if the stream can only be sent raw.
+	 */
+	JpegSliceEncoder *jpegEncoder = NULL;
+
+	/**
+	 * This is the encoder which the tile deltas are encoded with.  It is NULL if the stream can not be sent as deltas.
+	 */
+	TileDeltaEncoder *tileEncoder = NULL;
+
+	/**
+	 * This is the codec which the rows are compressed with in the lossless encoding.  It is always available.
+	 */
+	LosslessRowCodec rowCodec;
+
+	/**
+	 * This is the encoding which the last image was sent with.  A keyframe is sent when the stream switches to deltas.
+	 */
+	int lastEncoding = ENCODING_RAW;
+
+	/**
+	 * These are the encoding and the JPEG quality which have been requested.  They are picked up at the start of each image.
+	 */
+	std::atomic<int> requestedEncoding;
+	std::atomic<int> requestedQuality;
+
+	/**
+	 * This is the pixel format which the raw rows are sent in (a StreamPixelFormat).  It is picked up at the start of each image.
+	 */
+	std::atomic<int> requestedPixelFormat;
+
+	/**
+	 * This is the encoder which the datagrams are protected with.  It is NULL if the stream has no forward error correction.
+	 */
+	FecEncoder *fecEncoder = NULL;
+
+	/**
+	 * These are the number of data datagrams in a group of forward error correction, which is 0 if it is off, and the
+	 * number of parity datagrams for each group, which have been requested.  They are picked up at the start of each image.
+	 */
+	std::atomic<int> requestedFecDataCount;
+	std::atomic<int> requestedFecParityCount;
+
+	/**
+	 * This variable will determine whether or not the datagrams of the current image are protected.
+	 */
+	bool fecActive = false;
+
+	/**
+	 * This is the history which the datagrams are kept in for retransmission.  It is NULL if the stream can not be
+	 * retransmitted.
+	 */
+	TransmitHistory *history = NULL;
+
+	/**
+	 * This is the latency budget of the retransmission in milliseconds, which is 0 if it is off.  It is picked up at the
+	 * start of each image.
+	 */
+	std::atomic<uint32_t> requestedRetransmitBudget;
+
+	/**
+	 * This variable will determine whether or not the datagrams of the current image are kept for retransmission.
+	 */
+	bool retransmitActive = false;
+
+	/**
+	 * This is the number of datagrams which the image before the current one was sent in, if it was kept.
+	 */
+	uint16_t previousDatagramCount = 0;
+
+	/**
+	 * This method will wait until the send time of the next datagram of an image, and then work out the send time of
+	 * the one after it.
+	 * @param nextSendTime This is the CLOCK_MONOTONIC send time of the next datagram.  It is advanced by the interval.
+	 * @param interval This is the time between datagrams in microseconds.  If it is 0, the method returns at once.
+	 */
+	void waitForSendTime(struct timespec &nextSendTime, uint32_t interval);
+
+	/**
+	 * This method will stream the image as JPEG slices, one per datagram.
+	 * @param image This is the image that is to be sent.
+	 * @return The return will be 0 if successful or -1 if there is a failure.
+	 */
+	int streamSlices(Mat *image);
+
+	/**
+	 * This method will stream the tiles of the image which have changed since they were last sent.
+	 * @param image This is the image that is to be sent.
+	 * @return The return will be 0 if successful or -1 if there is a failure.
+	 */
+	int streamTiles(Mat *image);
+
+	/**
+	 * This method will stream the image as groups of rows compressed without loss, one group per datagram.
+	 * @param image This is the image that is to be sent.
+	 * @return The return will be 0 if successful or -1 if there is a failure.
+	 */
+	int streamLosslessRows(Mat *image);
+
+	/**
+	 * This method will stream the image as rows converted to a smaller pixel format, with a StreamRowHeader on each datagram.
+	 * @param image This is the image that is to be sent.
+	 * @param format This is the pixel format.
+	 * @return The return will be 0 if successful or -1 if there is a failure.
+	 */
+	int streamPixelRows(Mat *image, StreamPixelFormat format);
+
+	/**
+	 * This method will send a datagram of an image to the destination.  If forward error correction is on, the datagram
+	 * is sent behind its StreamFecHeader, and the parity of its group is sent once the group is full.
+	 * @param datagram This is the datagram.
+	 * @param length This is the length of the datagram in bytes.
+	 * @return The return will be the number of bytes sent, or -1 if there is a failure.
+	 */
+	int sendDatagram(const uint8_t *datagram, size_t length);
+
+	/**
+	 * This method will send a datagram to every destination which is not suspended, with as few system calls as
+	 * possible.  A destination which fails while others succeed is suspended for a while, so that it can not hold up
+	 * the rest of the stream.
+	 * @param parts These are the parts which the datagram is gathered from.
+	 * @param partCount This is the number of parts.
+	 * @return The return will be the number of bytes in the datagram, or -1 if it could not be sent to any destination.
+	 */
+	int sendToDestinations(struct iovec *parts, int partCount);
+
+	/**
+	 * This method will determine if an address is the address of one of the destinations.
+	 * @param address This is the address.
+	 * @return The return will be true if a destination is on the host of the address, or false otherwise.
+	 */
+	bool isDestination(const struct sockaddr_in &address);
+
+	/**
+	 * This method will close the open group of forward error correction, and send its parity datagrams.
+	 * @return The return will be 0 if successful or -1 if there is a failure.
+	 */
+	int sendParity();
+
+	/**
+	 * This method will end an image.  If it was sent, the parity of its last group of datagrams is sent.
+	 * @param result This is the result of sending the image.
+	 * @return The return will be the result, or -1 if the parity could not be sent.
+	 */
+	int finishFrame(int result);
+
+	/**
+	 * This method will obtain the largest datagram which an image can be sent in.
+	 * @return The return will be the size in bytes.
+	 */
+	size_t getDatagramCapacity();
+
+	/**
+	 * This method will read the feedback which the receiver has sent back on the socket, without waiting, and pass it
+	 * to the stream it is for.  The lock of the socket must be held.
+	 */
+	void readFeedback();
+
+	/**
+	 * This method will act on a feedback message from a receiver.
+	 * @param message This is the message, which starts with a StreamFeedback.
+	 * @param length This is the length of the message in bytes.
+	 * @param sender This is the address which the message came from.
+	 */
+	void handleFeedback(const uint8_t *message, size_t length, const struct sockaddr_in &sender);
+
+	/**
+	 * This method will find the stream of the simulcast which this stream belongs to with the given stream id.
+	 * @param streamId This is the stream id.
+	 * @return The return will be the stream, or NULL if there is no such stream.
+	 */
+	ImageTransmitter* findStream(int streamId);
+
+	/**
+	 * This method will send a datagram again which the receiver lost, if it is still kept and its image is still within
+	 * the latency budget.  The lock of the socket must be held.
+	 * @param frameId This is the count of the image.
+	 * @param index This is the index of the datagram within the image.
+	 * @param receiver This is the address of the receiver which lost the datagram, or NULL to send it to the multicast
+	 * groups of the stream.
+	 */
+	void retransmit(uint32_t frameId, int index, const struct sockaddr_in *receiver);
+
+	/**
+	 * This is a list of all of the transmitters which have been instantiated.
+	 */
+	static std::list<ImageTransmitter*> allTransmitters;
+
+	/**
+	 * These are the statistics of the stream.  They are updated by the transmitting thread and may be read by any thread.
+	 */
+	std::atomic<uint64_t> framesSent;
+	std::atomic<uint64_t> datagramsSent;
+	std::atomic<uint64_t> bytesSent;
+	std::atomic<uint64_t> sendErrors;
+	std::atomic<uint64_t> parityDatagramsSent;
+	std::atomic<uint64_t> nacksReceived;
+	std::atomic<uint64_t> datagramsRetransmitted;
+	std::atomic<uint64_t> retransmissionsExpired;
+	std::atomic<uint64_t> retransmissionsSuppressed;
+
+	/**
+	 * This is the round trip to the receiver in microseconds, smoothed over the NACKs, or 0 until it has been measured.
+	 * A datagram is not sent again more than once a round trip.
+	 */
+	std::atomic<uint32_t> roundTripTime;
+
+	/**
+	 * These are the number of reports received from the receiver, and the contents of the last one.  They are updated by
+	 * the transmitting thread and may be read by any thread.
+	 */
+	std::atomic<uint64_t> reportsReceived;
+	std::atomic<uint32_t> reportedLossFraction;
+	std::atomic<uint32_t> reportedJitter;
+	std::atomic<uint32_t> reportedReceiveRate;
+
 public:
 	/**
 	 * This will instantiate a new instance of this class. It will copy the machine name into a heap allocated string and update the port.
@@ -76,6 +443,269 @@ public:
 	 */
 	int streamImage(Mat* image);
 
+	/**
+	 * This method will wait for feedback from the receivers to arrive on the socket, and act on it straight away, so that
+	 * a lost datagram is sent again without waiting for the next image to be streamed.  It is called over and over by a
+	 * thread other than the transmitting thread.  The feedback of the streams of a simulcast is read through the first
+	 * stream.
+	 * @param timeout This is the longest time to wait in milliseconds.
+	 * @return The return will be true if feedback arrived, or false if the wait timed out or the socket is not open.
+	 */
+	bool serviceFeedback(int timeout);
+
+	/**
+	 * This method will obtain the name of the stream, which is the destination machine and port, followed by the stream
+	 * id for a stream of a simulcast other than the first.
+	 * @return The return will be the name of the stream.
+	 */
+	std::string getName();
+
+	/**
+	 * This method will add a destination which the stream is sent to as well, either a unicast host or a multicast
+	 * group.  It must be called before the stream is started.
+	 * @param machineName This is the name of the machine or the multicast group.  It is not copied.
+	 * @param port This is the udp port number which the datagrams are sent to.
+	 * @return The return will be true if the destination was added, or false if the stream has as many destinations as
+	 * it can have.
+	 */
+	bool addDestination(char *machineName, int port);
+
+	/**
+	 * This method will make another transmitter a stream of the simulcast which this one is the first stream of.  It
+	 * sends on the socket of this transmitter, with the next stream id, and the feedback for it which arrives on the
+	 * socket is passed on to it.  It must be called before the streams are started, and the streams must all be
+	 * streamed from the same thread.  This transmitter must outlive the stream.
+	 * @param stream This is the transmitter which is to be a stream of the simulcast.
+	 * @return The return will be true if it was added, or false if it already belongs to a simulcast or there are too
+	 * many streams.
+	 */
+	bool addSimulcastStream(ImageTransmitter *stream);
+
+	/**
+	 * This method will obtain the stream id of the stream within its simulcast.
+	 * @return The return will be the stream id, which is 0 for the first stream or a stream which is not a simulcast.
+	 */
+	int getStreamId();
+
+	/**
+	 * This method will set the number of hops which the datagrams sent to a multicast group may travel.  It must be
+	 * called before the stream is started.
+	 * @param ttl This is the number of hops, from 1 to 255.
+	 */
+	void setMulticastTtl(int ttl);
+
+	/**
+	 * This method will obtain the number of destinations of the stream.
+	 * @return The return will be the number of destinations.
+	 */
+	int getDestinationCount();
+
+	/**
+	 * This method will obtain the name of a destination, which is the machine and port.
+	 * @param index This is the index of the destination.
+	 * @return The return will be the name of the destination.
+	 */
+	std::string getDestinationName(int index);
+
+	/**
+	 * These methods obtain the statistics of a destination.  A datagram is counted once for each destination it is sent
+	 * to, whereas the statistics of the stream count it once.  A destination is suspended while nothing is sent to it
+	 * because a send to it failed.
+	 * @param index This is the index of the destination.
+	 */
+	uint64_t getDestinationDatagramsSent(int index);
+	uint64_t getDestinationBytesSent(int index);
+	uint64_t getDestinationSendErrors(int index);
+	bool isDestinationSuspended(int index);
+
+	/**
+	 * This method will change the number of lines in each UDP datagram.  It may be called from any thread, and takes effect
+	 * at the start of the next image.
+	 * @param lines This is the number of lines per datagram.  It must be at least 1.
+	 */
+	void setLinesPerDatagram(int lines);
+
+	/**
+	 * This method will obtain the number of lines in each UDP datagram.
+	 * @return The return will be the number of lines per datagram.
+	 */
+	int getLinesPerDatagram();
+
+	/**
+	 * This method will set the pacing of the datagrams.  Spreading the datagrams of an image out avoids overflowing the
+	 * buffers of the network and the receiver.  It takes effect at the start of the next image.
+	 * @param interval This is the time between datagrams in microseconds, or 0 to send them as fast as possible.
+	 */
+	void setDatagramInterval(uint32_t interval);
+
+	/**
+	 * This method will obtain the pacing of the datagrams.
+	 * @return The return will be the time between datagrams in microseconds.
+	 */
+	uint32_t getDatagramInterval();
+
+	/**
+	 * This method will give the stream an encoder for JPEG slices, which allows it to be switched to the JPEG encoding.
+	 * It must be called before the first image is streamed.
+	 * @param encoder This is the encoder.  It is not owned by the transmitter.
+	 */
+	void setJpegEncoder(JpegSliceEncoder *encoder);
+
+	/**
+	 * This method will obtain the encoder for JPEG slices.
+	 * @return The return will be the encoder, or NULL if the stream has none.
+	 */
+	JpegSliceEncoder* getJpegEncoder();
+
+	/**
+	 * This method will give the stream an encoder for tile deltas, which allows it to be switched to the delta encoding.
+	 * It must be called before the first image is streamed.
+	 * @param encoder This is the encoder.  It is not owned by the transmitter.
+	 */
+	void setTileEncoder(TileDeltaEncoder *encoder);
+
+	/**
+	 * This method will obtain the encoder for tile deltas.
+	 * @return The return will be the encoder, or NULL if the stream has none.
+	 */
+	TileDeltaEncoder* getTileEncoder();
+
+	/**
+	 * This method will obtain the codec which the rows are compressed with in the lossless encoding.
+	 * @return The return will be the codec.
+	 */
+	LosslessRowCodec& getRowCodec();
+
+	/**
+	 * This method will change the encoding of the stream.  It may be called from any thread, and takes effect at the
+	 * start of the next image.
+	 * @param encoding This is the encoding.
+	 * @param quality This is the JPEG quality, from 1 to 100.  It is kept for later if the encoding is raw.
+	 * @return The return will be true if the encoding was changed, or false if the quality is out of range or the
+	 * encoding was requested without its encoder.
+	 */
+	bool setEncoding(StreamEncoding encoding, int quality);
+
+	/**
+	 * This method will obtain the encoding of the stream.
+	 * @return The return will be the encoding.
+	 */
+	StreamEncoding getEncoding();
+
+	/**
+	 * This method will obtain the JPEG quality of the stream.
+	 * @return The return will be the quality, from 1 to 100.
+	 */
+	int getJpegQuality();
+
+	/**
+	 * This method will change the pixel format which the raw rows are sent in.  Rows in BGR24 are sent in the original
+	 * raw datagrams, and rows in the other formats in pixel row datagrams.  The compressed encodings are always sent from
+	 * BGR.  It may be called from any thread, and takes effect at the start of the next image.
+	 * @param format This is the pixel format (a StreamPixelFormat).
+	 * @return The return will be true if the pixel format was changed, or false if it is not a pixel format.
+	 */
+	bool setPixelFormat(int format);
+
+	/**
+	 * This method will obtain the pixel format which the raw rows are sent in.
+	 * @return The return will be the pixel format.
+	 */
+	StreamPixelFormat getPixelFormat();
+
+	/**
+	 * This method will set the encoder which the datagrams are protected with, and turn forward error correction on at
+	 * its group size.  It must be called before the stream is started.
+	 * @param encoder This is the encoder.  It is not owned by the transmitter.
+	 */
+	void setFecEncoder(FecEncoder *encoder);
+
+	/**
+	 * This method will obtain the encoder which the datagrams are protected with.
+	 * @return The return will be the encoder, or NULL if there is none.
+	 */
+	FecEncoder* getFecEncoder();
+
+	/**
+	 * This method will change the forward error correction of the stream.  It may be called from any thread, and takes
+	 * effect at the start of the next image.
+	 * @param dataCount This is the number of data datagrams in a group, or 0 to turn the error correction off.
+	 * @param parityCount This is the number of parity datagrams for each group.
+	 * @return The return will be true if the error correction was changed, or false if there is no encoder or the group
+	 * size is out of range.
+	 */
+	bool setFec(int dataCount, int parityCount);
+
+	/**
+	 * These methods obtain the forward error correction which has been requested: the number of data datagrams in a
+	 * group, which is 0 if it is off, and the number of parity datagrams for each group.
+	 */
+	int getFecDataCount();
+	int getFecParityCount();
+
+	/**
+	 * This method will set the history which the datagrams are kept in for retransmission.  It must be called before
+	 * the stream is started.
+	 * @param transmitHistory This is the history.  It is not owned by the transmitter.
+	 */
+	void setTransmitHistory(TransmitHistory *transmitHistory);
+
+	/**
+	 * This method will obtain the history which the datagrams are kept in for retransmission.
+	 * @return The return will be the history, or NULL if there is none.
+	 */
+	TransmitHistory* getTransmitHistory();
+
+	/**
+	 * This method will change the latency budget of the retransmission.  A lost datagram is only sent again if its
+	 * image started less than the budget ago.  It may be called from any thread, and takes effect at the start of the
+	 * next image.
+	 * @param budget This is the budget in milliseconds, or 0 to turn retransmission off.
+	 * @return The return will be true if the budget was changed, or false if there is no history.
+	 */
+	bool setRetransmitBudget(uint32_t budget);
+
+	/**
+	 * This method will obtain the latency budget of the retransmission.
+	 * @return The return will be the budget in milliseconds, or 0 if retransmission is off.
+	 */
+	uint32_t getRetransmitBudget();
+
+	/**
+	 * This method will obtain the list of all of the transmitters.
+	 * @return The return will be a reference to the list of transmitters.
+	 */
+	static const std::list<ImageTransmitter*>& getAllTransmitters();
+
+	/**
+	 * These methods obtain the statistics of the stream.  Frames are only counted once all of their datagrams have been sent.
+	 */
+	uint64_t getFramesSent();
+	uint64_t getDatagramsSent();
+	uint64_t getBytesSent();
+	uint64_t getSendErrors();
+	uint64_t getParityDatagramsSent();
+	uint64_t getNacksReceived();
+	uint64_t getDatagramsRetransmitted();
+	uint64_t getRetransmissionsExpired();
+	uint64_t getRetransmissionsSuppressed();
+
+	/**
+	 * This method will obtain the round trip to the receiver, as measured from its NACKs.
+	 * @return The return will be the round trip in microseconds, or 0 if it has not been measured.
+	 */
+	uint32_t getRoundTripTime();
+
+	/**
+	 * These methods obtain the last report from the receiver: the number of reports received, the fraction of the
+	 * datagrams lost on the link, from 0 to 1, the jitter in microseconds, and the receive rate in kilobits per second.
+	 * The contents are only meaningful once a report has been received.
+	 */
+	uint64_t getReportsReceived();
+	double getReportedLoss();
+	uint32_t getReportedJitter();
+	uint32_t getReportedReceiveRate();
+
 };
 
 #endif /* IMAGETRANSMITTER_H_ */
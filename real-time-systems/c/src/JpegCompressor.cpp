@@ -0,0 +1,310 @@
+/**
+ * @file JpegCompressor.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class compresses a band of rows of an image into a baseline JPEG in a
+ *      caller supplied buffer.
+ */
+
+#include "JpegCompressor.h"
+#include "Logger.h"
+
+#include <string.h>
+
+/**
+ * This is the libjpeg callback for a fatal error.  It will log the error and return to the start of the band.
+ * @param info This is the compressor.
+ */
+void JpegCompressor::errorExit(j_common_ptr info) {
+	ErrorManager *errors = (ErrorManager*) info->err;
+	char message[JMSG_LENGTH_MAX];
+	(*info->err->format_message)(info, message);
+	LOG_RATE_LIMITED(1, LOG_ERROR, "JPEG: %s.", message);
+	longjmp(errors->exitPoint, 1);
+}
+
+/**
+ * This is the libjpeg callback for a warning or trace message.  They are not of interest, and are dropped rather than
+ * written to stderr from a real time thread.
+ * @param info This is the compressor.
+ */
+void JpegCompressor::outputMessage(j_common_ptr info) {
+}
+
+/**
+ * This is the libjpeg callback which starts a band.  It will point the compressor at the caller's buffer.
+ * @param info This is the compressor.
+ */
+void JpegCompressor::initDestination(j_compress_ptr info) {
+	JpegCompressor *self = (JpegCompressor*) info->client_data;
+	self->destination.next_output_byte = self->output;
+	self->destination.free_in_buffer = self->outputCapacity;
+	self->overflowed = false;
+}
+
+/**
+ * This is the libjpeg callback for a full buffer.  The band no longer fits, so the rest of it is written to the overflow
+ * buffer and thrown away.  Suspending would leave the compressor unable to finish the band.
+ * @param info This is the compressor.
+ * @return The return will be TRUE, as there is always more room.
+ */
+boolean JpegCompressor::emptyOutputBuffer(j_compress_ptr info) {
+	JpegCompressor *self = (JpegCompressor*) info->client_data;
+	self->overflowed = true;
+	self->destination.next_output_byte = self->overflowBuffer;
+	self->destination.free_in_buffer = sizeof(self->overflowBuffer);
+	return TRUE;
+}
+
+/**
+ * This is the libjpeg callback which ends a band.  The size of the band is worked out by compress.
+ * @param info This is the compressor.
+ */
+void JpegCompressor::termDestination(j_compress_ptr info) {
+}
+
+/**
+ * This method will carve working storage for the current band from the band memory.
+ * @param size This is the number of bytes which are needed.
+ * @return The return will be the storage, or NULL if the band memory is full.
+ */
+void* JpegCompressor::allocateBandMemory(size_t size) {
+	size_t alignedSize = (size + BAND_MEMORY_ALIGNMENT - 1) & ~(BAND_MEMORY_ALIGNMENT - 1);
+	uintptr_t base = (uintptr_t) bandMemory.data();
+	uintptr_t start = (base + bandMemoryUsed + BAND_MEMORY_ALIGNMENT - 1) & ~(uintptr_t) (BAND_MEMORY_ALIGNMENT - 1);
+
+	/**
+	 * The storage is counted whether or not it fits, so that the band memory can grow to fit the whole band.
+	 */
+	bandMemoryNeeded += alignedSize + BAND_MEMORY_ALIGNMENT;
+	if ((bandMemory.empty()) || (start + alignedSize > base + bandMemory.size())) {
+		return NULL;
+	}
+	bandMemoryUsed = (start + alignedSize) - base;
+	return (void*) start;
+}
+
+/**
+ * This is the libjpeg callback which allocates a small object.
+ * @param info This is the compressor.
+ * @param poolId This is the pool which the object belongs to.
+ * @param size This is the size of the object in bytes.
+ * @return The return will be the object.
+ */
+void* JpegCompressor::allocateSmall(j_common_ptr info, int poolId, size_t size) {
+	JpegCompressor *self = (JpegCompressor*) info->client_data;
+	void *object = (poolId == JPOOL_IMAGE) ? self->allocateBandMemory(size) : NULL;
+	return (object != NULL) ? object : self->libraryMemory.alloc_small(info, poolId, size);
+}
+
+/**
+ * This is the libjpeg callback which allocates a large object.
+ * @param info This is the compressor.
+ * @param poolId This is the pool which the object belongs to.
+ * @param size This is the size of the object in bytes.
+ * @return The return will be the object.
+ */
+void* JpegCompressor::allocateLarge(j_common_ptr info, int poolId, size_t size) {
+	JpegCompressor *self = (JpegCompressor*) info->client_data;
+	void *object = (poolId == JPOOL_IMAGE) ? self->allocateBandMemory(size) : NULL;
+	return (object != NULL) ? object : self->libraryMemory.alloc_large(info, poolId, size);
+}
+
+/**
+ * This is the libjpeg callback which allocates a two dimensional array of samples.  Each row is aligned and padded, as
+ * libjpeg-turbo's own arrays are.
+ * @param info This is the compressor.
+ * @param poolId This is the pool which the array belongs to.
+ * @param samplesPerRow This is the number of samples in each row.
+ * @param rows This is the number of rows.
+ * @return The return will be the array of row pointers.
+ */
+JSAMPARRAY JpegCompressor::allocateSampleArray(j_common_ptr info, int poolId, JDIMENSION samplesPerRow, JDIMENSION rows) {
+	JpegCompressor *self = (JpegCompressor*) info->client_data;
+	size_t rowSize = ((size_t) samplesPerRow * sizeof(JSAMPLE) + BAND_MEMORY_ALIGNMENT - 1) & ~(BAND_MEMORY_ALIGNMENT - 1);
+	JSAMPARRAY array = NULL;
+	uint8_t *samples = NULL;
+	if (poolId == JPOOL_IMAGE) {
+		array = (JSAMPARRAY) self->allocateBandMemory(rows * sizeof(JSAMPROW));
+		samples = (uint8_t*) self->allocateBandMemory(rows * rowSize);
+	}
+	if ((array == NULL) || (samples == NULL)) {
+		return self->libraryMemory.alloc_sarray(info, poolId, samplesPerRow, rows);
+	}
+	for (JDIMENSION row = 0; row < rows; row++) {
+		array[row] = (JSAMPROW) (samples + (row * rowSize));
+	}
+	return array;
+}
+
+/**
+ * This is the libjpeg callback which allocates a two dimensional array of coefficient blocks.
+ * @param info This is the compressor.
+ * @param poolId This is the pool which the array belongs to.
+ * @param blocksPerRow This is the number of blocks in each row.
+ * @param rows This is the number of rows.
+ * @return The return will be the array of row pointers.
+ */
+JBLOCKARRAY JpegCompressor::allocateBlockArray(j_common_ptr info, int poolId, JDIMENSION blocksPerRow, JDIMENSION rows) {
+	JpegCompressor *self = (JpegCompressor*) info->client_data;
+	size_t rowSize = (size_t) blocksPerRow * sizeof(JBLOCK);
+	JBLOCKARRAY array = NULL;
+	uint8_t *blocks = NULL;
+	if (poolId == JPOOL_IMAGE) {
+		array = (JBLOCKARRAY) self->allocateBandMemory(rows * sizeof(JBLOCKROW));
+		blocks = (uint8_t*) self->allocateBandMemory(rows * rowSize);
+	}
+	if ((array == NULL) || (blocks == NULL)) {
+		return self->libraryMemory.alloc_barray(info, poolId, blocksPerRow, rows);
+	}
+	for (JDIMENSION row = 0; row < rows; row++) {
+		array[row] = (JBLOCKROW) (blocks + (row * rowSize));
+	}
+	return array;
+}
+
+/**
+ * This is the libjpeg callback which frees a pool.  Freeing the image pool at the end of a band releases the band memory,
+ * which grows first if the band did not fit in it.
+ * @param info This is the compressor.
+ * @param poolId This is the pool.
+ */
+void JpegCompressor::freePool(j_common_ptr info, int poolId) {
+	JpegCompressor *self = (JpegCompressor*) info->client_data;
+	if (poolId == JPOOL_IMAGE) {
+		if (self->bandMemoryNeeded > self->bandMemory.size()) {
+			self->bandMemory.resize(self->bandMemoryNeeded);
+		}
+		self->bandMemoryUsed = 0;
+		self->bandMemoryNeeded = 0;
+	}
+	self->libraryMemory.free_pool(info, poolId);
+}
+
+/**
+ * This is the constructor for the class.  It will set up the libjpeg compressor.
+ */
+JpegCompressor::JpegCompressor() {
+	memset(&compressor, 0, sizeof(compressor));
+	compressor.err = jpeg_std_error(&errorManager.manager);
+	errorManager.manager.error_exit = errorExit;
+	errorManager.manager.output_message = outputMessage;
+	jpeg_create_compress(&compressor);
+	compressor.client_data = this;
+
+	destination.init_destination = initDestination;
+	destination.empty_output_buffer = emptyOutputBuffer;
+	destination.term_destination = termDestination;
+	compressor.dest = &destination;
+
+	/**
+	 * The image size is set for each band, but the color space and the defaults are set once.  libjpeg-turbo reads the
+	 * BGR rows of OpenCV directly; plain libjpeg is given RGB rows.
+	 */
+	compressor.input_components = 3;
+#ifdef JCS_EXTENSIONS
+	compressor.in_color_space = JCS_EXT_BGR;
+#else
+	compressor.in_color_space = JCS_RGB;
+#endif
+	jpeg_set_defaults(&compressor);
+	compressor.dct_method = JDCT_IFAST;
+
+	/**
+	 * Carve the working storage of each band from the band memory, keeping libjpeg's memory manager for everything else.
+	 */
+	libraryMemory = *compressor.mem;
+	compressor.mem->alloc_small = allocateSmall;
+	compressor.mem->alloc_large = allocateLarge;
+	compressor.mem->alloc_sarray = allocateSampleArray;
+	compressor.mem->alloc_barray = allocateBlockArray;
+	compressor.mem->free_pool = freePool;
+}
+
+/**
+ * This is the destructor for the class.
+ */
+JpegCompressor::~JpegCompressor() {
+	jpeg_destroy_compress(&compressor);
+}
+
+/**
+ * This method will compress a band of rows of an 8 bit, 3 channel BGR image into a JPEG which can be decoded on its own.
+ * @param image This is the image.
+ * @param firstRow This is the first row of the band.
+ * @param rowCount This is the number of rows in the band.
+ * @param quality This is the JPEG quality, from 1 to 100.
+ * @param buffer This is the buffer which the JPEG is written to.
+ * @param capacity This is the size of the buffer in bytes.
+ * @return The return will be the size of the JPEG in bytes, or 0 if it did not fit the buffer or could not be compressed.
+ */
+size_t JpegCompressor::compress(const Mat &image, int firstRow, int rowCount, int quality, uint8_t *buffer, size_t capacity) {
+	if ((image.channels() != 3) || (rowCount <= 0) || (firstRow + rowCount > image.rows)) {
+		return 0;
+	}
+	output = buffer;
+	outputCapacity = capacity;
+
+	/**
+	 * 1.0 A fatal libjpeg error returns here.  The compressor is reset so that it can be used for the next band.
+	 */
+	if (setjmp(errorManager.exitPoint) != 0) {
+		jpeg_abort_compress(&compressor);
+		return 0;
+	}
+
+	/**
+	 * 2.0 Set the size and quality of the band, and start it.
+	 */
+	compressor.image_width = image.cols;
+	compressor.image_height = rowCount;
+	jpeg_set_quality(&compressor, quality, TRUE);
+	jpeg_start_compress(&compressor, TRUE);
+
+	/**
+	 * 3.0 Compress the rows straight from the image.
+	 */
+#ifndef JCS_EXTENSIONS
+	rowBuffer.resize(image.cols * 3);
+#endif
+	for (int row = firstRow; row < firstRow + rowCount; row++) {
+		JSAMPROW rowPointer = (JSAMPROW) image.ptr(row);
+#ifndef JCS_EXTENSIONS
+		for (int column = 0; column < image.cols * 3; column += 3) {
+			rowBuffer[column] = rowPointer[column + 2];
+			rowBuffer[column + 1] = rowPointer[column + 1];
+			rowBuffer[column + 2] = rowPointer[column];
+		}
+		rowPointer = rowBuffer.data();
+#endif
+		jpeg_write_scanlines(&compressor, &rowPointer, 1);
+	}
+	jpeg_finish_compress(&compressor);
+
+	/**
+	 * 4.0 A band which overflowed is reported as not fitting, rather than sent truncated.
+	 */
+	if (overflowed) {
+		return 0;
+	}
+	return capacity - destination.free_in_buffer;
+}
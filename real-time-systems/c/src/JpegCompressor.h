@@ -0,0 +1,171 @@
+/**
+ * @file JpegCompressor.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class compresses a band of rows of an image into a baseline JPEG in a
+ *      caller supplied buffer.  The libjpeg compressor, its error handler and its
+ *      destination are set up once and reused for every band, and the output is
+ *      written straight into the buffer, so compressing never copies the result.
+ *      A band which does not fit the buffer is reported rather than truncated.
+ *      The working storage which libjpeg needs for each band is carved from
+ *      memory which is kept between bands, so compressing does not allocate once
+ *      the memory has grown to fit the largest band.
+ */
+
+#ifndef JPEGCOMPRESSOR_H_
+#define JPEGCOMPRESSOR_H_
+
+#include <opencv2/opencv.hpp>
+#include <stdio.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <vector>
+#include <jpeglib.h>
+
+using namespace cv;
+
+class JpegCompressor {
+private:
+	/**
+	 * This is the libjpeg error handler, extended with the point that a fatal error returns to, so that an error ends
+	 * the band rather than the program.
+	 */
+	struct ErrorManager {
+		struct jpeg_error_mgr manager;
+		jmp_buf exitPoint;
+	};
+
+	/**
+	 * This is the libjpeg compressor.  It is created once and reused for every band.
+	 */
+	struct jpeg_compress_struct compressor;
+
+	/**
+	 * This is the error handler of the compressor.
+	 */
+	ErrorManager errorManager;
+
+	/**
+	 * This is the destination of the compressor, which writes into the caller's buffer.
+	 */
+	struct jpeg_destination_mgr destination;
+
+	/**
+	 * These are the caller's buffer and its size for the band being compressed.
+	 */
+	uint8_t *output = NULL;
+	size_t outputCapacity = 0;
+
+	/**
+	 * This variable will determine whether or not the band has overflowed the caller's buffer.
+	 */
+	bool overflowed = false;
+
+	/**
+	 * This is where the rest of a band which has overflowed the caller's buffer is written, and thrown away.
+	 */
+	uint8_t overflowBuffer[4096];
+
+	/**
+	 * This is a row converted from BGR to RGB, which is only needed when libjpeg can not read BGR directly.
+	 */
+	std::vector<uint8_t> rowBuffer;
+
+	/**
+	 * This is the alignment of the working storage carved from the band memory, which is enough for the SIMD code of
+	 * libjpeg-turbo.
+	 */
+	static const size_t BAND_MEMORY_ALIGNMENT = 64;
+
+	/**
+	 * This is the memory which the working storage of a band (libjpeg's image pool) is carved from.  libjpeg would
+	 * otherwise allocate and free it for every band.
+	 */
+	std::vector<uint8_t> bandMemory;
+
+	/**
+	 * This is the number of bytes of the band memory which are in use.
+	 */
+	size_t bandMemoryUsed = 0;
+
+	/**
+	 * This is the number of bytes which the working storage of the current band needs.  If it is more than the band memory
+	 * holds, the rest is allocated by libjpeg, and the band memory grows to fit it once the band is complete.
+	 */
+	size_t bandMemoryNeeded = 0;
+
+	/**
+	 * These are the methods of libjpeg's own memory manager, which are used for everything but the working storage of a band.
+	 */
+	struct jpeg_memory_mgr libraryMemory;
+
+	/**
+	 * This method will carve working storage for the current band from the band memory.
+	 * @param size This is the number of bytes which are needed.
+	 * @return The return will be the storage, or NULL if the band memory is full.
+	 */
+	void* allocateBandMemory(size_t size);
+
+	/**
+	 * These are the libjpeg callbacks of the memory manager.  The image pool is carved from the band memory, and everything
+	 * else is passed on to libjpeg.
+	 */
+	static void* allocateSmall(j_common_ptr info, int poolId, size_t size);
+	static void* allocateLarge(j_common_ptr info, int poolId, size_t size);
+	static JSAMPARRAY allocateSampleArray(j_common_ptr info, int poolId, JDIMENSION samplesPerRow, JDIMENSION rows);
+	static JBLOCKARRAY allocateBlockArray(j_common_ptr info, int poolId, JDIMENSION blocksPerRow, JDIMENSION rows);
+	static void freePool(j_common_ptr info, int poolId);
+
+	/**
+	 * These are the libjpeg callbacks of the error handler and the destination.
+	 */
+	static void errorExit(j_common_ptr info);
+	static void outputMessage(j_common_ptr info);
+	static void initDestination(j_compress_ptr info);
+	static boolean emptyOutputBuffer(j_compress_ptr info);
+	static void termDestination(j_compress_ptr info);
+
+public:
+	/**
+	 * This is the constructor for the class.  It will set up the libjpeg compressor.
+	 */
+	JpegCompressor();
+
+	/**
+	 * This is the destructor for the class.
+	 */
+	virtual ~JpegCompressor();
+
+	/**
+	 * This method will compress a band of rows of an 8 bit, 3 channel BGR image into a JPEG which can be decoded on its own.
+	 * @param image This is the image.
+	 * @param firstRow This is the first row of the band.
+	 * @param rowCount This is the number of rows in the band.
+	 * @param quality This is the JPEG quality, from 1 to 100.
+	 * @param buffer This is the buffer which the JPEG is written to.
+	 * @param capacity This is the size of the buffer in bytes.
+	 * @return The return will be the size of the JPEG in bytes, or 0 if it did not fit the buffer or could not be compressed.
+	 */
+	size_t compress(const Mat &image, int firstRow, int rowCount, int quality, uint8_t *buffer, size_t capacity);
+};
+
+#endif /* JPEGCOMPRESSOR_H_ */
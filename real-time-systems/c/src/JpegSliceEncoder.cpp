@@ -0,0 +1,302 @@
+/**
+ * @file JpegSliceEncoder.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class encodes each frame of the compressed stream as a set of
+ *      horizontal slices, each a JPEG which can be decoded on its own and which
+ *      fits one datagram.
+ */
+
+#include "JpegSliceEncoder.h"
+#include "TraceBuffer.h"
+#include "Logger.h"
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+/**
+ * This method will round a number of rows down to a multiple of the slice row multiple.
+ * @param rows This is the number of rows.
+ * @return The return will be the rounded number of rows.
+ */
+static int roundDownRows(int rows) {
+	return (rows / JpegSliceEncoder::SLICE_ROW_MULTIPLE) * JpegSliceEncoder::SLICE_ROW_MULTIPLE;
+}
+
+/**
+ * This method will round a number of rows up to a multiple of the slice row multiple.
+ * @param rows This is the number of rows.
+ * @return The return will be the rounded number of rows.
+ */
+static int roundUpRows(int rows) {
+	return roundDownRows(rows + JpegSliceEncoder::SLICE_ROW_MULTIPLE - 1);
+}
+
+/**
+ * This is the constructor for the class.  All of the buffers are allocated here.
+ * @param name This is the name of the encoder.  The worker threads are named after it.
+ * @param lanes This is the number of slices which are encoded at the same time, normally the number of cores.
+ * @param maximumRows This is the height of the tallest frame which is expected.
+ * @param maximumDatagramSize This is the largest datagram which is sent, including the header.
+ */
+JpegSliceEncoder::JpegSliceEncoder(std::string name, int lanes, int maximumRows, size_t maximumDatagramSize) :
+		slicesEncoded(0), slicesDropped(0), qualityReductions(0), currentRowsPerSlice(SLICE_ROW_MULTIPLE) {
+	myName = name;
+	pool = new WorkerPool(name, lanes);
+	for (int lane = 0; lane < pool->getLaneCount(); lane++) {
+		compressors.push_back(new JpegCompressor());
+	}
+
+	/**
+	 * The datagrams are a cache line apart, so that two lanes never write to the same line.  There is one for every
+	 * slice of the tallest frame, at the smallest slice height.
+	 */
+	datagramSize = std::min(std::max(maximumDatagramSize, sizeof(StreamSliceHeader) + 1024), (size_t) STREAM_MAX_DATAGRAM_SIZE);
+	datagramStride = (datagramSize + 63) & ~((size_t) 63);
+	maximumSlices = std::max(1, roundUpRows(maximumRows) / SLICE_ROW_MULTIPLE);
+	datagramLengths.resize(maximumSlices, 0);
+	sliceQualities.resize(maximumSlices, 0);
+	rowsPerSlice = SLICE_ROW_MULTIPLE;
+
+	void *buffer = NULL;
+	if (posix_memalign(&buffer, 64, datagramStride * maximumSlices) == 0) {
+		datagrams = (uint8_t*) buffer;
+	} else {
+		Logger::log(LOG_ERROR, "%s: Cannot allocate the datagrams of %d slices.", myName.c_str(), maximumSlices);
+	}
+}
+
+/**
+ * This is the destructor for the class.  The encoder must have been stopped.
+ */
+JpegSliceEncoder::~JpegSliceEncoder() {
+	delete pool;
+	for (JpegCompressor *compressor : compressors) {
+		delete compressor;
+	}
+	free(datagrams);
+}
+
+/**
+ * This method will start the worker threads of the encoder.
+ * @param priority This is the priority of the workers, which should be that of the task which encodes the frames.
+ */
+void JpegSliceEncoder::start(int priority) {
+	pool->start(priority);
+}
+
+/**
+ * This method will stop the worker threads of the encoder and wait for them to end.
+ */
+void JpegSliceEncoder::stop() {
+	pool->stop();
+}
+
+/**
+ * This method will encode a frame into slices.  The datagrams remain valid until the next frame is encoded.
+ * @param frame This is the frame, an 8 bit, 3 channel BGR image.
+ * @param id This is the count of the frame.
+ * @param time This is the time at which the transmission of the frame started, in milliseconds.
+ * @param jpegQuality This is the JPEG quality, from 1 to 100.
+ * @return The return will be the number of slices, or 0 if the frame could not be encoded.
+ */
+int JpegSliceEncoder::encode(const Mat &frame, uint32_t id, uint32_t time, int jpegQuality) {
+	/**
+	 * 1.0 The frame must fit the 16 bit sizes of the header.
+	 */
+	if ((datagrams == NULL) || (frame.channels() != 3) || (frame.rows <= 0) || (frame.cols <= 0) || (frame.rows > 65535)
+			|| (frame.cols > 65535)) {
+		return 0;
+	}
+
+	/**
+	 * 2.0 Work out the slices.  A frame taller than expected is given taller slices, so that they still fit the buffer.
+	 */
+	image = &frame;
+	frameId = id;
+	timestamp = time;
+	quality = std::min(std::max(jpegQuality, 1), 100);
+	sliceRows = std::max(rowsPerSlice, roundUpRows((frame.rows + maximumSlices - 1) / maximumSlices));
+	sliceCount = (frame.rows + sliceRows - 1) / sliceRows;
+
+	/**
+	 * 3.0 Encode the slices in parallel, and adapt the slice height for the next frame.
+	 */
+	pool->run(*this);
+	adaptSliceHeight();
+	return sliceCount;
+}
+
+/**
+ * This method will carry out one lane of the encoding of a frame.  Lane n encodes slices n, n + laneCount, and so on.
+ * @param lane This is the lane.
+ * @param laneCount This is the number of lanes.
+ */
+void JpegSliceEncoder::runLane(int lane, int laneCount) {
+	for (int slice = lane; slice < sliceCount; slice += laneCount) {
+		encodeSlice(*compressors[lane], slice);
+	}
+}
+
+/**
+ * This method will encode one slice of the current frame into its datagram.
+ * @param compressor This is the compressor of the lane.
+ * @param slice This is the index of the slice.
+ */
+void JpegSliceEncoder::encodeSlice(JpegCompressor &compressor, int slice) {
+	TraceBuffer::record(TRACE_BEGIN, STAGE_ENCODE, frameId, 0);
+	uint8_t *datagram = datagrams + (slice * datagramStride);
+	int firstRow = slice * sliceRows;
+	int rowCount = std::min(sliceRows, image->rows - firstRow);
+
+	/**
+	 * 1.0 Encode the slice behind the header.  If it does not fit, halve the quality until it does.
+	 */
+	int sliceQuality = quality;
+	size_t payloadSize = compressor.compress(*image, firstRow, rowCount, sliceQuality, datagram + sizeof(StreamSliceHeader),
+			datagramSize - sizeof(StreamSliceHeader));
+	while ((payloadSize == 0) && (sliceQuality > MINIMUM_QUALITY)) {
+		sliceQuality = std::max(sliceQuality / 2, (int) MINIMUM_QUALITY);
+		qualityReductions.fetch_add(1, std::memory_order_relaxed);
+		payloadSize = compressor.compress(*image, firstRow, rowCount, sliceQuality, datagram + sizeof(StreamSliceHeader),
+				datagramSize - sizeof(StreamSliceHeader));
+	}
+
+	/**
+	 * 2.0 Fill in the header.
+	 */
+	StreamSliceHeader *header = (StreamSliceHeader*) datagram;
+	header->magic = htonl(STREAM_MAGIC);
+	header->version = STREAM_VERSION;
+	header->payloadType = STREAM_PAYLOAD_JPEG;
+	header->sliceIndex = htons(slice);
+	header->sliceCount = htons(sliceCount);
+	header->firstRow = htons(firstRow);
+	header->rowCount = htons(rowCount);
+	header->frameWidth = htons(image->cols);
+	header->frameHeight = htons(image->rows);
+	header->quality = htons(sliceQuality);
+	header->frameId = htonl(frameId);
+	header->timestamp = htonl(timestamp);
+	header->payloadSize = htonl(payloadSize);
+
+	/**
+	 * 3.0 A slice which does not fit even at the lowest quality is dropped, and only its rows of the frame are lost.
+	 */
+	if (payloadSize == 0) {
+		slicesDropped.fetch_add(1, std::memory_order_relaxed);
+		LOG_RATE_LIMITED(1, LOG_WARNING, "%s: Slice %d of frame %u does not fit a datagram and is dropped.", myName.c_str(),
+				slice, frameId);
+		datagramLengths[slice] = 0;
+	} else {
+		slicesEncoded.fetch_add(1, std::memory_order_relaxed);
+		datagramLengths[slice] = sizeof(StreamSliceHeader) + payloadSize;
+	}
+	sliceQualities[slice] = sliceQuality;
+	TraceBuffer::record(TRACE_END, STAGE_ENCODE, frameId, payloadSize);
+}
+
+/**
+ * This method will adapt the height of the slices to the sizes of the slices of the frame which was just encoded.
+ */
+void JpegSliceEncoder::adaptSliceHeight() {
+	/**
+	 * 1.0 Find the largest number of bytes per row of any slice, and whether any slice had to be reduced.
+	 */
+	bool reduced = false;
+	size_t largestBytesPerRow = 0;
+	for (int slice = 0; slice < sliceCount; slice++) {
+		int rowCount = std::min(sliceRows, image->rows - (slice * sliceRows));
+		if ((datagramLengths[slice] == 0) || (sliceQualities[slice] < quality)) {
+			reduced = true;
+		} else {
+			size_t payloadSize = datagramLengths[slice] - sizeof(StreamSliceHeader);
+			largestBytesPerRow = std::max(largestBytesPerRow, (payloadSize + rowCount - 1) / rowCount);
+		}
+	}
+
+	/**
+	 * 2.0 If a slice was reduced, halve the height at once.  Otherwise, aim for slices which fill three quarters of a
+	 * datagram, which leaves room for the content to change, shrinking at once but growing only half way each frame.
+	 */
+	if (reduced) {
+		rowsPerSlice = std::max((int) SLICE_ROW_MULTIPLE, roundDownRows(sliceRows / 2));
+	} else if (largestBytesPerRow > 0) {
+		int target = roundDownRows((int) ((((datagramSize - sizeof(StreamSliceHeader)) * 3) / 4) / largestBytesPerRow));
+		if (target < sliceRows) {
+			rowsPerSlice = std::max((int) SLICE_ROW_MULTIPLE, target);
+		} else if (target > sliceRows) {
+			rowsPerSlice = sliceRows + std::max((int) SLICE_ROW_MULTIPLE, roundDownRows((target - sliceRows) / 2));
+		}
+	}
+
+	/**
+	 * 3.0 Never make fewer slices than lanes, so that every core has a slice to encode.
+	 */
+	int laneRows = roundUpRows((image->rows + pool->getLaneCount() - 1) / pool->getLaneCount());
+	rowsPerSlice = std::min(rowsPerSlice, std::max((int) SLICE_ROW_MULTIPLE, laneRows));
+	currentRowsPerSlice.store(rowsPerSlice, std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the datagram of a slice of the last frame which was encoded.
+ * @param slice This is the index of the slice.
+ * @param length This is filled in with the length of the datagram, or 0 if the slice was dropped.
+ * @return The return will be the datagram.
+ */
+const uint8_t* JpegSliceEncoder::getDatagram(int slice, size_t &length) {
+	if ((slice < 0) || (slice >= sliceCount)) {
+		length = 0;
+		return NULL;
+	}
+	length = datagramLengths[slice];
+	return datagrams + (slice * datagramStride);
+}
+
+/**
+ * This method will obtain the name of the encoder.
+ * @return The return will be the name of the encoder.
+ */
+std::string JpegSliceEncoder::getName() {
+	return myName;
+}
+
+/**
+ * These methods obtain the statistics of the encoder.
+ */
+uint64_t JpegSliceEncoder::getSlicesEncoded() {
+	return slicesEncoded.load(std::memory_order_relaxed);
+}
+
+uint64_t JpegSliceEncoder::getSlicesDropped() {
+	return slicesDropped.load(std::memory_order_relaxed);
+}
+
+uint64_t JpegSliceEncoder::getQualityReductions() {
+	return qualityReductions.load(std::memory_order_relaxed);
+}
+
+int JpegSliceEncoder::getRowsPerSlice() {
+	return currentRowsPerSlice.load(std::memory_order_relaxed);
+}
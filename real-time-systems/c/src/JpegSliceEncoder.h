@@ -0,0 +1,207 @@
+/**
+ * @file JpegSliceEncoder.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class encodes each frame of the compressed stream as a set of
+ *      horizontal slices, each a JPEG which can be decoded on its own and which
+ *      fits one datagram.  The slices are encoded in parallel, one lane of a
+ *      WorkerPool per core, each lane with its own reused JpegCompressor.  Every
+ *      slice is encoded straight into its own preallocated datagram, behind the
+ *      StreamSliceHeader, so the datagrams are sent without being copied.
+ *
+ *      The height of the slices adapts to the content: it grows while the slices
+ *      are well within a datagram, as each slice repeats the JPEG tables, but
+ *      never beyond one slice per lane, and shrinks when they are not.  A slice which still does not fit is encoded
+ *      again at a lower quality, and dropped only if that fails.
+ */
+
+#ifndef JPEGSLICEENCODER_H_
+#define JPEGSLICEENCODER_H_
+
+#include "ParallelJob.h"
+#include "WorkerPool.h"
+#include "JpegCompressor.h"
+#include "StreamProtocol.h"
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace cv;
+
+class JpegSliceEncoder: public ParallelJob {
+public:
+	/**
+	 * This is the number of rows which the height of a slice is a multiple of.  It is the height of a JPEG MCU with 4:2:0
+	 * chroma subsampling, so no slice but the last ends in a padded MCU.
+	 */
+	static const int SLICE_ROW_MULTIPLE = 16;
+
+	/**
+	 * This is the lowest quality a slice is reduced to when trying to fit it into a datagram.
+	 */
+	static const int MINIMUM_QUALITY = 10;
+
+private:
+	/**
+	 * This is the name of the encoder.
+	 */
+	std::string myName;
+
+	/**
+	 * This is the pool which encodes the slices in parallel.
+	 */
+	WorkerPool *pool;
+
+	/**
+	 * These are the compressors, one for each lane of the pool.
+	 */
+	std::vector<JpegCompressor*> compressors;
+
+	/**
+	 * These are the largest datagram which is sent, the distance between the datagrams in the buffer, and the largest
+	 * number of slices in a frame.
+	 */
+	size_t datagramSize;
+	size_t datagramStride;
+	int maximumSlices;
+
+	/**
+	 * This is the buffer which holds the datagram of every slice.
+	 */
+	uint8_t *datagrams = NULL;
+
+	/**
+	 * These are the length of the datagram of each slice of the current frame (0 if the slice was dropped) and the
+	 * quality it was encoded at.  Each is written only by the lane which encodes the slice.
+	 */
+	std::vector<size_t> datagramLengths;
+	std::vector<int> sliceQualities;
+
+	/**
+	 * This is the height of the slices of the next frame in rows.  It is only used by the thread which encodes the frames.
+	 */
+	int rowsPerSlice;
+
+	/**
+	 * These are the frame which is being encoded and its parameters.  They are set before the lanes run, and only read
+	 * by them.
+	 */
+	const Mat *image = NULL;
+	uint32_t frameId = 0;
+	uint32_t timestamp = 0;
+	int quality = 0;
+	int sliceRows = 0;
+	int sliceCount = 0;
+
+	/**
+	 * These are the statistics of the encoder.  They may be read by any thread.
+	 */
+	std::atomic<uint64_t> slicesEncoded;
+	std::atomic<uint64_t> slicesDropped;
+	std::atomic<uint64_t> qualityReductions;
+	std::atomic<int> currentRowsPerSlice;
+
+	/**
+	 * This method will encode one slice of the current frame into its datagram.
+	 * @param compressor This is the compressor of the lane.
+	 * @param slice This is the index of the slice.
+	 */
+	void encodeSlice(JpegCompressor &compressor, int slice);
+
+	/**
+	 * This method will adapt the height of the slices to the sizes of the slices of the frame which was just encoded.
+	 */
+	void adaptSliceHeight();
+
+public:
+	/**
+	 * This is the constructor for the class.  All of the buffers are allocated here.
+	 * @param name This is the name of the encoder.  The worker threads are named after it.
+	 * @param lanes This is the number of slices which are encoded at the same time, normally the number of cores.
+	 * @param maximumRows This is the height of the tallest frame which is expected.  A taller frame is still encoded,
+	 * with taller slices.
+	 * @param maximumDatagramSize This is the largest datagram which is sent, including the header.
+	 */
+	JpegSliceEncoder(std::string name, int lanes, int maximumRows, size_t maximumDatagramSize);
+
+	/**
+	 * This is the destructor for the class.  The encoder must have been stopped.
+	 */
+	virtual ~JpegSliceEncoder();
+
+	/**
+	 * This method will start the worker threads of the encoder.  Until they are started, the slices are encoded one
+	 * at a time by the calling thread.
+	 * @param priority This is the priority of the workers, which should be that of the task which encodes the frames.
+	 */
+	void start(int priority);
+
+	/**
+	 * This method will stop the worker threads of the encoder and wait for them to end.
+	 */
+	void stop();
+
+	/**
+	 * This method will encode a frame into slices.  The datagrams remain valid until the next frame is encoded.
+	 * @param frame This is the frame, an 8 bit, 3 channel BGR image.
+	 * @param id This is the count of the frame.
+	 * @param time This is the time at which the transmission of the frame started, in milliseconds.
+	 * @param jpegQuality This is the JPEG quality, from 1 to 100.
+	 * @return The return will be the number of slices, or 0 if the frame could not be encoded.
+	 */
+	int encode(const Mat &frame, uint32_t id, uint32_t time, int jpegQuality);
+
+	/**
+	 * This method will obtain the datagram of a slice of the last frame which was encoded.
+	 * @param slice This is the index of the slice.
+	 * @param length This is filled in with the length of the datagram, or 0 if the slice was dropped.
+	 * @return The return will be the datagram.
+	 */
+	const uint8_t* getDatagram(int slice, size_t &length);
+
+	/**
+	 * This method will carry out one lane of the encoding of a frame.  Lane n encodes slices n, n + laneCount, and so on.
+	 * @param lane This is the lane.
+	 * @param laneCount This is the number of lanes.
+	 */
+	virtual void runLane(int lane, int laneCount);
+
+	/**
+	 * This method will obtain the name of the encoder.
+	 * @return The return will be the name of the encoder.
+	 */
+	std::string getName();
+
+	/**
+	 * These methods obtain the statistics of the encoder: the number of slices encoded and dropped, the number of times
+	 * a slice was encoded again at a lower quality, and the current height of the slices.
+	 */
+	uint64_t getSlicesEncoded();
+	uint64_t getSlicesDropped();
+	uint64_t getQualityReductions();
+	int getRowsPerSlice();
+};
+
+#endif /* JPEGSLICEENCODER_H_ */
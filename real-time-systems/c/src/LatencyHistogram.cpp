@@ -0,0 +1,141 @@
+/**
+ * @file LatencyHistogram.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a lock free histogram of latencies, given in microseconds.
+ */
+
+#include "LatencyHistogram.h"
+
+/**
+ * This is the constructor for the class.  The histogram starts out empty.
+ */
+LatencyHistogram::LatencyHistogram() :
+		totalCount(0), totalSum(0) {
+	for (uint32_t index = 0; index < BUCKETS; index++) {
+		counts[index].store(0, std::memory_order_relaxed);
+	}
+}
+
+/**
+ * This method will obtain the bucket that the given value is counted in.  Values below 4 have a bucket each.  Above that,
+ * each power of two is split into four equal buckets.
+ * @param value This is the value in microseconds.
+ * @return The return will be the index of the bucket.
+ */
+uint32_t LatencyHistogram::bucketOf(uint64_t value) {
+	if (value < 4) {
+		return (uint32_t) value;
+	}
+	uint32_t exponent = 63 - __builtin_clzll(value);
+	uint32_t subBucket = (uint32_t) (value >> (exponent - 2)) & 3;
+	uint32_t bucket = 4 + ((exponent - 2) * 4) + subBucket;
+	return (bucket < BUCKETS) ? bucket : (BUCKETS - 1);
+}
+
+/**
+ * This method will obtain the largest value which is counted in the given bucket.
+ * @param bucket This is the index of the bucket.
+ * @return The return will be the upper bound of the bucket in microseconds.
+ */
+uint64_t LatencyHistogram::upperBoundOf(uint32_t bucket) {
+	if (bucket < 4) {
+		return bucket;
+	}
+	uint32_t exponent = ((bucket - 4) / 4) + 2;
+	uint64_t subBucket = (bucket - 4) % 4;
+	return ((4 + subBucket + 1) << (exponent - 2)) - 1;
+}
+
+/**
+ * This method will record a value.  It may be called from a real time thread.
+ * @param value This is the value in microseconds.
+ */
+void LatencyHistogram::record(uint64_t value) {
+	counts[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+	totalSum.fetch_add(value, std::memory_order_relaxed);
+	totalCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the given percentile of the recorded values.
+ * @param percentile This is the percentile, between 0 and 100.
+ * @return The return will be the upper bound of the bucket holding the percentile, or 0 if nothing has been recorded.
+ */
+uint64_t LatencyHistogram::getPercentile(double percentile) {
+	uint64_t snapshot[BUCKETS];
+	uint64_t count = 0;
+
+	/**
+	 * 1.0 Take a copy of the buckets, counting the values from the copy so that the rank always falls within it.
+	 */
+	for (uint32_t index = 0; index < BUCKETS; index++) {
+		snapshot[index] = counts[index].load(std::memory_order_relaxed);
+		count += snapshot[index];
+	}
+	if (count == 0) {
+		return 0;
+	}
+
+	/**
+	 * 2.0 Find the bucket which holds the value of the given rank.
+	 */
+	uint64_t rank = (uint64_t) ((percentile / 100.0) * count);
+	if (rank >= count) {
+		rank = count - 1;
+	}
+	uint64_t seen = 0;
+	for (uint32_t index = 0; index < BUCKETS; index++) {
+		seen += snapshot[index];
+		if (seen > rank) {
+			return upperBoundOf(index);
+		}
+	}
+	return upperBoundOf(BUCKETS - 1);
+}
+
+/**
+ * This method will obtain the number of values recorded.
+ * @return The return will be the number of values.
+ */
+uint64_t LatencyHistogram::getCount() {
+	return totalCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the sum of the values recorded.
+ * @return The return will be the sum in microseconds.
+ */
+uint64_t LatencyHistogram::getSum() {
+	return totalSum.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will empty the histogram.
+ */
+void LatencyHistogram::reset() {
+	for (uint32_t index = 0; index < BUCKETS; index++) {
+		counts[index].store(0, std::memory_order_relaxed);
+	}
+	totalCount.store(0, std::memory_order_relaxed);
+	totalSum.store(0, std::memory_order_relaxed);
+}
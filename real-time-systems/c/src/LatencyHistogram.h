@@ -0,0 +1,112 @@
+/**
+ * @file LatencyHistogram.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a lock free histogram of latencies, given in microseconds.  It
+ *      is used to report the percentiles of the wall times of the tasks.  The buckets
+ *      are logarithmic, with four linear sub-buckets for each power of two, so a
+ *      percentile is accurate to within 25% over the range from 1 microsecond to over
+ *      an hour.  Recording is a single relaxed atomic increment, so the owning thread
+ *      is never delayed by a reader.
+ */
+
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include <atomic>
+#include <stdint.h>
+
+class LatencyHistogram {
+public:
+	/**
+	 * This is the number of buckets.  Values beyond the last bucket are counted in the last bucket.
+	 */
+	static const uint32_t BUCKETS = 128;
+
+private:
+	/**
+	 * This is the count of values in each bucket.
+	 */
+	std::atomic<uint64_t> counts[BUCKETS];
+
+	/**
+	 * This is the total number of values recorded.
+	 */
+	std::atomic<uint64_t> totalCount;
+
+	/**
+	 * This is the sum of the values recorded, in microseconds.
+	 */
+	std::atomic<uint64_t> totalSum;
+
+	/**
+	 * This method will obtain the bucket that the given value is counted in.
+	 * @param value This is the value in microseconds.
+	 * @return The return will be the index of the bucket.
+	 */
+	static uint32_t bucketOf(uint64_t value);
+
+	/**
+	 * This method will obtain the largest value which is counted in the given bucket.
+	 * @param bucket This is the index of the bucket.
+	 * @return The return will be the upper bound of the bucket in microseconds.
+	 */
+	static uint64_t upperBoundOf(uint32_t bucket);
+
+public:
+	/**
+	 * This is the constructor for the class.  The histogram starts out empty.
+	 */
+	LatencyHistogram();
+
+	/**
+	 * This method will record a value.  It may be called from a real time thread.
+	 * @param value This is the value in microseconds.
+	 */
+	void record(uint64_t value);
+
+	/**
+	 * This method will obtain the given percentile of the recorded values.
+	 * @param percentile This is the percentile, between 0 and 100.
+	 * @return The return will be the upper bound of the bucket holding the percentile, or 0 if nothing has been recorded.
+	 */
+	uint64_t getPercentile(double percentile);
+
+	/**
+	 * This method will obtain the number of values recorded.
+	 * @return The return will be the number of values.
+	 */
+	uint64_t getCount();
+
+	/**
+	 * This method will obtain the sum of the values recorded.
+	 * @return The return will be the sum in microseconds.
+	 */
+	uint64_t getSum();
+
+	/**
+	 * This method will empty the histogram.
+	 */
+	void reset();
+};
+
+#endif /* LATENCYHISTOGRAM_H_ */
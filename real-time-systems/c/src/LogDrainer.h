@@ -0,0 +1,65 @@
+/**
+ * @file LogDrainer.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a periodic task which writes out the messages queued by the
+ *      Logger.  It should run at a low (non real time) priority, so that a slow
+ *      terminal or disk only ever delays this task.  While it exists, the Logger
+ *      queues messages rather than writing them synchronously.
+ */
+
+#ifndef LOGDRAINER_H_
+#define LOGDRAINER_H_
+
+#include "PeriodicTask.h"
+#include "Logger.h"
+
+#include <stdio.h>
+
+class LogDrainer: public PeriodicTask {
+private:
+	/**
+	 * This is the file that the messages are written to.
+	 */
+	FILE *output;
+
+public:
+	/**
+	 * This is the constructor for the class.  It will switch the Logger to queueing messages.
+	 * @param output This is the file that the messages are to be written to.
+	 * @param threadName This is the name of the thread in a human readable format.
+	 * @param period This is the period for the task, given in microseconds.
+	 */
+	LogDrainer(FILE *output, std::string threadName, uint32_t period);
+
+	/**
+	 * This is the destructor for the class.  It will write out any remaining messages and switch the Logger back to writing synchronously.
+	 */
+	virtual ~LogDrainer();
+
+	/**
+	 * This is the task method.  It will write every message which has been logged since the last period.
+	 */
+	virtual void taskMethod();
+};
+
+#endif /* LOGDRAINER_H_ */
@@ -0,0 +1,283 @@
+/**
+ * @file Logger.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is an asynchronous logger which is safe to use from the real time
+ *      threads.
+ */
+
+#include "Logger.h"
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/*
+ * These are the file scoped variables which hold the state of the logger.
+ */
+Logger::LogRecord Logger::records[Logger::CAPACITY];
+std::atomic<uint32_t> Logger::enqueuePosition(0);
+uint32_t Logger::dequeuePosition = 0;
+std::mutex Logger::drainMutex;
+std::atomic<uint64_t> Logger::dropped(0);
+uint64_t Logger::droppedReported = 0;
+std::atomic<uint64_t> Logger::suppressed(0);
+std::atomic<int> Logger::minimumLevel(LOG_INFO);
+std::atomic<bool> Logger::synchronous(true);
+bool Logger::initialized = Logger::initializeQueue();
+
+/*
+ * This is the thread id of the calling thread, which is looked up the first time the thread logs.
+ */
+static thread_local pid_t loggingThreadId = 0;
+
+/*
+ * These are the names of the levels, indexed by LogLevel.
+ */
+static const char *levelNames[] = { "DEBUG", "INFO", "WARNING", "ERROR" };
+
+/**
+ * This function will obtain the current monotonic time in nanoseconds.
+ * @return The return will be the current time in nanoseconds.
+ */
+static uint64_t monotonicNow() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+/**
+ * This method will determine whether or not a message may be logged now.
+ * @param suppressedCount This is set to the number of messages which were suppressed since the last allowed message.
+ * @return The return will be true if the message may be logged or false if it is to be suppressed.
+ */
+bool LogRateLimiter::allow(uint32_t &suppressedCount) {
+	uint64_t now = monotonicNow();
+	uint64_t start = windowStart.load(std::memory_order_relaxed);
+
+	/**
+	 * 1.0 If the window has expired, start a new one.  Only the thread which wins the exchange resets the count.
+	 */
+	if ((now - start >= 1000000000ULL) && windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+		windowCount.store(0, std::memory_order_relaxed);
+	}
+
+	/**
+	 * 2.0 Allow the message if the window has room for it, otherwise count it as suppressed.
+	 */
+	if (windowCount.fetch_add(1, std::memory_order_relaxed) < maximumPerSecond) {
+		suppressedCount = suppressed.exchange(0, std::memory_order_relaxed);
+		return true;
+	}
+	suppressed.fetch_add(1, std::memory_order_relaxed);
+	suppressedCount = 0;
+	return false;
+}
+
+/**
+ * This method will set up the sequences of the queue.  Slot i is free for the message at position i.
+ * @return The return will always be true.
+ */
+bool Logger::initializeQueue() {
+	for (uint32_t index = 0; index < CAPACITY; index++) {
+		records[index].sequence.store(index, std::memory_order_relaxed);
+	}
+	return true;
+}
+
+/**
+ * This method will log a message.  The message is formatted like printf.  It never blocks, unless the logger is synchronous.
+ * @param level This is the level of the message.
+ * @param format This is the printf style format of the message.
+ * @return The return will be true if the message was logged or false if it was filtered or dropped.
+ */
+bool Logger::log(LogLevel level, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	bool result = vlog(level, format, args);
+	va_end(args);
+	return result;
+}
+
+/**
+ * This method will log a message, like log, using a va_list for the arguments.
+ * @param level This is the level of the message.
+ * @param format This is the printf style format of the message.
+ * @param args These are the arguments of the message.
+ * @return The return will be true if the message was logged or false if it was filtered or dropped.
+ */
+bool Logger::vlog(LogLevel level, const char *format, va_list args) {
+	if (level < minimumLevel.load(std::memory_order_relaxed)) {
+		return false;
+	}
+	if (loggingThreadId == 0) {
+		loggingThreadId = syscall(SYS_gettid);
+	}
+
+	/**
+	 * 1.0 Without a drainer, format the message on the stack and write it out directly.
+	 */
+	if (synchronous.load(std::memory_order_relaxed)) {
+		char message[MESSAGE_SIZE];
+		vsnprintf(message, sizeof(message), format, args);
+		writeMessage(stdout, monotonicNow(), loggingThreadId, level, message);
+		return true;
+	}
+
+	/**
+	 * 2.0 Claim a slot.  The slot is free when its sequence equals the position.  If it is still one lap behind, the queue
+	 * is full and the message is dropped rather than waiting for the drainer.
+	 */
+	uint32_t position = enqueuePosition.load(std::memory_order_relaxed);
+	LogRecord *record;
+	for (;;) {
+		record = &records[position & (CAPACITY - 1)];
+		int32_t difference = (int32_t) (record->sequence.load(std::memory_order_acquire) - position);
+		if (difference == 0) {
+			if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (difference < 0) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		} else {
+			position = enqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * 3.0 Format the message directly into the slot, and then hand the slot to the drainer.
+	 */
+	record->timestamp = monotonicNow();
+	record->threadId = loggingThreadId;
+	record->level = level;
+	vsnprintf(record->message, MESSAGE_SIZE, format, args);
+	record->sequence.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+/**
+ * This method will log a message if the given rate limiter allows it.  If messages were suppressed since the last
+ * one, a message saying how many is logged as well.
+ * @param limiter This is the rate limiter of the call site.
+ * @param level This is the level of the message.
+ * @param format This is the printf style format of the message.
+ * @return The return will be true if the message was logged or false if it was suppressed, filtered, or dropped.
+ */
+bool Logger::logLimited(LogRateLimiter &limiter, LogLevel level, const char *format, ...) {
+	uint32_t suppressedCount;
+	if (limiter.allow(suppressedCount) == false) {
+		suppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	va_list args;
+	va_start(args, format);
+	bool result = vlog(level, format, args);
+	va_end(args);
+
+	if (suppressedCount > 0) {
+		log(level, "(%u similar messages suppressed)", suppressedCount);
+	}
+	return result;
+}
+
+/**
+ * This method will write a single message to the given file.
+ * @param output This is the file that the message is written to.
+ * @param timestamp This is the CLOCK_MONOTONIC time of the message in nanoseconds.
+ * @param threadId This is the thread id of the thread which logged the message.
+ * @param level This is the level of the message.
+ * @param message This is the text of the message.
+ */
+void Logger::writeMessage(FILE *output, uint64_t timestamp, pid_t threadId, LogLevel level, const char *message) {
+	fprintf(output, "[%lu.%06lu] %-7s %d: %s\n", (unsigned long) (timestamp / 1000000000ULL),
+			(unsigned long) ((timestamp % 1000000000ULL) / 1000), levelNames[level], (int) threadId, message);
+}
+
+/**
+ * This method will write every message in the queue to the given file.  It is called by the drainer.
+ * @param output This is the file that the messages are written to.
+ * @return The return will be the number of messages written.
+ */
+uint32_t Logger::drain(FILE *output) {
+	std::lock_guard<std::mutex> guard(drainMutex);
+	uint32_t written = 0;
+
+	/**
+	 * 1.0 Write out the messages in order, stopping at the first slot which has not been filled in yet.  Once written,
+	 * the slot is made free for the position one lap later.
+	 */
+	for (;;) {
+		LogRecord &record = records[dequeuePosition & (CAPACITY - 1)];
+		if (record.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+			break;
+		}
+		writeMessage(output, record.timestamp, record.threadId, record.level, record.message);
+		record.sequence.store(dequeuePosition + CAPACITY, std::memory_order_release);
+		dequeuePosition++;
+		written++;
+	}
+
+	/**
+	 * 2.0 Report any messages which were dropped since the last time.
+	 */
+	uint64_t droppedNow = dropped.load(std::memory_order_relaxed);
+	if (droppedNow != droppedReported) {
+		fprintf(output, "%lu log messages were dropped because the queue was full.\n", (unsigned long) (droppedNow - droppedReported));
+		droppedReported = droppedNow;
+	}
+
+	fflush(output);
+	return written;
+}
+
+/**
+ * This method will determine whether messages are written synchronously or queued for the drainer.
+ * @param enable This is true to write messages synchronously or false to queue them.
+ */
+void Logger::setSynchronous(bool enable) {
+	synchronous.store(enable, std::memory_order_relaxed);
+}
+
+/**
+ * This method will set the minimum level of the messages which are logged.
+ * @param level This is the minimum level.
+ */
+void Logger::setMinimumLevel(LogLevel level) {
+	minimumLevel.store(level, std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the number of messages which were dropped because the queue was full.
+ * @return The return will be the number of dropped messages.
+ */
+uint64_t Logger::getDroppedCount() {
+	return dropped.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the number of messages which were suppressed by the rate limiting.
+ * @return The return will be the number of suppressed messages.
+ */
+uint64_t Logger::getSuppressedCount() {
+	return suppressed.load(std::memory_order_relaxed);
+}
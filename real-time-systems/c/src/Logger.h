@@ -0,0 +1,259 @@
+/**
+ * @file Logger.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is an asynchronous logger which is safe to use from the real time
+ *      threads.  A thread which logs formats its message directly into a slot of a
+ *      fixed size, lock free, multiple producer / single consumer queue, and never
+ *      blocks on the terminal or a file.  The LogDrainer task empties the queue at a
+ *      low priority and writes the messages out.  If the queue is full, the message
+ *      is dropped and counted.  Messages from a call site which may repeat every
+ *      frame should use LOG_RATE_LIMITED, so that a persistent error can not flood
+ *      the queue.
+ *
+ *      Until a LogDrainer has been created (and after it is deleted), messages are
+ *      written synchronously, so that start up and shut down messages are not lost.
+ */
+
+#ifndef LOGGER_H_
+#define LOGGER_H_
+
+#include <atomic>
+#include <mutex>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+/**
+ * This enumeration defines the severity of a log message.
+ */
+enum LogLevel {
+	LOG_DEBUG = 0, /**< Detailed information which is normally not shown. */
+	LOG_INFO = 1, /**< Normal operational messages. */
+	LOG_WARNING = 2, /**< Something unexpected happened, but the program continues normally. */
+	LOG_ERROR = 3 /**< An operation failed. */
+};
+
+/**
+ * This class limits how many messages a single call site may log each second.  Instances are normally declared by the
+ * LOG_RATE_LIMITED macro, one per call site.
+ */
+class LogRateLimiter {
+private:
+	/**
+	 * This is the maximum number of messages which may be logged each second.
+	 */
+	const uint32_t maximumPerSecond;
+
+	/**
+	 * This is the time, in nanoseconds, at which the current one second window started.
+	 */
+	std::atomic<uint64_t> windowStart;
+
+	/**
+	 * This is the number of messages which have been attempted in the current window.
+	 */
+	std::atomic<uint32_t> windowCount;
+
+	/**
+	 * This is the number of messages which have been suppressed since the last message was allowed.
+	 */
+	std::atomic<uint32_t> suppressed;
+
+public:
+	/**
+	 * This is the constructor for the class.  It is constexpr, so that a static limiter is initialized without a guard.
+	 * @param maximumPerSecond This is the maximum number of messages which may be logged each second.
+	 */
+	constexpr LogRateLimiter(uint32_t maximumPerSecond) :
+			maximumPerSecond(maximumPerSecond), windowStart(0), windowCount(0), suppressed(0) {
+	}
+
+	/**
+	 * This method will determine whether or not a message may be logged now.
+	 * @param suppressedCount This is set to the number of messages which were suppressed since the last allowed message.
+	 * @return The return will be true if the message may be logged or false if it is to be suppressed.
+	 */
+	bool allow(uint32_t &suppressedCount);
+};
+
+/**
+ * This macro will log a message, allowing at most maximumPerSecond messages each second from this call site.
+ */
+#define LOG_RATE_LIMITED(maximumPerSecond, level, ...) \
+	do { \
+		static LogRateLimiter logRateLimiter(maximumPerSecond); \
+		Logger::logLimited(logRateLimiter, level, __VA_ARGS__); \
+	} while (0)
+
+class Logger {
+public:
+	/**
+	 * This is the number of messages which the queue can hold.  It must be a power of two.
+	 */
+	static const uint32_t CAPACITY = 256;
+
+	/**
+	 * This is the maximum length of a message, including the terminating null.  Longer messages are truncated.
+	 */
+	static const uint32_t MESSAGE_SIZE = 200;
+
+private:
+	/**
+	 * This structure is one slot of the queue.  The sequence tells the producers and the consumer whose turn it is to use the slot.
+	 */
+	struct LogRecord {
+		std::atomic<uint32_t> sequence;
+		uint64_t timestamp;
+		pid_t threadId;
+		LogLevel level;
+		char message[MESSAGE_SIZE];
+	};
+
+	/**
+	 * This is the queue of messages.
+	 */
+	static LogRecord records[CAPACITY];
+
+	/**
+	 * This is the position at which the next message will be added to the queue.  It is shared by all of the producers.
+	 */
+	alignas(64) static std::atomic<uint32_t> enqueuePosition;
+
+	/**
+	 * This is the position from which the next message will be removed.  It is only used while holding the drain mutex.
+	 */
+	static uint32_t dequeuePosition;
+
+	/**
+	 * This mutex makes certain that only one thread is draining the queue at a time.  It is never taken by a producer.
+	 */
+	static std::mutex drainMutex;
+
+	/**
+	 * This is the number of messages which were dropped because the queue was full.
+	 */
+	static std::atomic<uint64_t> dropped;
+
+	/**
+	 * This is the number of dropped messages which have already been reported in the output.
+	 */
+	static uint64_t droppedReported;
+
+	/**
+	 * This is the number of messages which were suppressed by the rate limiting.
+	 */
+	static std::atomic<uint64_t> suppressed;
+
+	/**
+	 * This is the minimum level of the messages which are logged.
+	 */
+	static std::atomic<int> minimumLevel;
+
+	/**
+	 * This variable will determine whether messages are written synchronously or queued for the drainer.
+	 */
+	static std::atomic<bool> synchronous;
+
+	/**
+	 * This variable is used to set up the sequences of the queue before main starts.
+	 */
+	static bool initialized;
+
+	/**
+	 * This method will set up the sequences of the queue.
+	 * @return The return will always be true.
+	 */
+	static bool initializeQueue();
+
+	/**
+	 * This method will write a single message to the given file.
+	 * @param output This is the file that the message is written to.
+	 * @param timestamp This is the CLOCK_MONOTONIC time of the message in nanoseconds.
+	 * @param threadId This is the thread id of the thread which logged the message.
+	 * @param level This is the level of the message.
+	 * @param message This is the text of the message.
+	 */
+	static void writeMessage(FILE *output, uint64_t timestamp, pid_t threadId, LogLevel level, const char *message);
+
+public:
+	/**
+	 * This method will log a message.  The message is formatted like printf.  It never blocks, unless the logger is synchronous.
+	 * @param level This is the level of the message.
+	 * @param format This is the printf style format of the message.
+	 * @return The return will be true if the message was logged or false if it was filtered or dropped.
+	 */
+	static bool log(LogLevel level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+	/**
+	 * This method will log a message, like log, using a va_list for the arguments.
+	 * @param level This is the level of the message.
+	 * @param format This is the printf style format of the message.
+	 * @param args These are the arguments of the message.
+	 * @return The return will be true if the message was logged or false if it was filtered or dropped.
+	 */
+	static bool vlog(LogLevel level, const char *format, va_list args);
+
+	/**
+	 * This method will log a message if the given rate limiter allows it.  If messages were suppressed since the last
+	 * one, a message saying how many is logged as well.
+	 * @param limiter This is the rate limiter of the call site.
+	 * @param level This is the level of the message.
+	 * @param format This is the printf style format of the message.
+	 * @return The return will be true if the message was logged or false if it was suppressed, filtered, or dropped.
+	 */
+	static bool logLimited(LogRateLimiter &limiter, LogLevel level, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+	/**
+	 * This method will write every message in the queue to the given file.  It is called by the drainer.
+	 * @param output This is the file that the messages are written to.
+	 * @return The return will be the number of messages written.
+	 */
+	static uint32_t drain(FILE *output);
+
+	/**
+	 * This method will determine whether messages are written synchronously or queued for the drainer.
+	 * @param enable This is true to write messages synchronously or false to queue them.
+	 */
+	static void setSynchronous(bool enable);
+
+	/**
+	 * This method will set the minimum level of the messages which are logged.
+	 * @param level This is the minimum level.
+	 */
+	static void setMinimumLevel(LogLevel level);
+
+	/**
+	 * This method will obtain the number of messages which were dropped because the queue was full.
+	 * @return The return will be the number of dropped messages.
+	 */
+	static uint64_t getDroppedCount();
+
+	/**
+	 * This method will obtain the number of messages which were suppressed by the rate limiting.
+	 * @return The return will be the number of suppressed messages.
+	 */
+	static uint64_t getSuppressedCount();
+};
+
+#endif /* LOGGER_H_ */
@@ -0,0 +1,418 @@
+/**
+ * @file LosslessRowCodec.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class compresses the rows of a BGR image without loss.
+ */
+
+#include "LosslessRowCodec.h"
+
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * This is the number of bytes in a block of residuals, which are packed at the same width.
+ */
+#define BLOCK_SIZE 16
+
+/**
+ * This is the distance from a byte to the same channel of the pixel to its left.
+ */
+#define PIXEL_SIZE 3
+
+/**
+ * This method will predict one byte of a row.
+ * @param row This is the row.
+ * @param above This is the row above it, or NULL if it is not used.
+ * @param index This is the index of the byte.
+ * @param filter This is the filter.
+ * @return The return will be the prediction.
+ */
+static inline uint8_t predict(const uint8_t *row, const uint8_t *above, int index, LosslessRowCodec::RowFilter filter) {
+	uint8_t left = (index >= PIXEL_SIZE) ? row[index - PIXEL_SIZE] : 0;
+	uint8_t up = (above != NULL) ? above[index] : 0;
+	switch (filter) {
+	case LosslessRowCodec::FILTER_LEFT:
+		return left;
+	case LosslessRowCodec::FILTER_UP:
+		return up;
+	case LosslessRowCodec::FILTER_AVERAGE:
+		return (uint8_t) ((left + up + 1) >> 1);
+	default:
+		return 0;
+	}
+}
+
+/**
+ * This method will map a residual onto an unsigned byte, so that small negative and positive residuals are both small.
+ * @param residual This is the residual, as a two's complement byte.
+ * @return The return will be the zigzag byte.
+ */
+static inline uint8_t toZigzag(uint8_t residual) {
+	return (uint8_t) ((residual << 1) ^ ((residual & 0x80) ? 0xFF : 0x00));
+}
+
+/**
+ * This method will map a zigzag byte back onto its residual.
+ * @param zigzag This is the zigzag byte.
+ * @return The return will be the residual, as a two's complement byte.
+ */
+static inline uint8_t fromZigzag(uint8_t zigzag) {
+	return (uint8_t) ((zigzag >> 1) ^ ((zigzag & 1) ? 0xFF : 0x00));
+}
+
+/**
+ * This is the constructor for the class.
+ */
+LosslessRowCodec::LosslessRowCodec() :
+		rawBytes(0), compressedBytes(0) {
+}
+
+/**
+ * This is the destructor for the class.
+ */
+LosslessRowCodec::~LosslessRowCodec() {
+}
+
+/**
+ * This method will obtain the largest size a compressed row can have: the filter byte, the widths, and every block at
+ * the full 8 bits.
+ * @param width This is the width of the row in pixels.
+ * @return The return will be the size in bytes.
+ */
+size_t LosslessRowCodec::getWorstCaseRowSize(int width) {
+	size_t blocks = ((width * PIXEL_SIZE) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	return 1 + ((blocks + 1) / 2) + (blocks * BLOCK_SIZE);
+}
+
+/**
+ * This method will filter a row into zigzag residuals.
+ * @param row This is the row.
+ * @param above This is the row above it, or NULL if it is not to be used.
+ * @param length This is the length of the row in bytes.
+ * @param filter This is the filter.
+ * @param output This is where the residuals are written.
+ * @return The return will be the sum of the residuals, which is the cost of the filter.
+ */
+uint32_t LosslessRowCodec::filterRow(const uint8_t *row, const uint8_t *above, int length, RowFilter filter, uint8_t *output) {
+	uint32_t cost = 0;
+	int index = 0;
+
+	/**
+	 * 1.0 The first block has no left neighbor for its first pixel, so it is always filtered one byte at a time.
+	 */
+	for (; (index < BLOCK_SIZE) && (index < length); index++) {
+		output[index] = toZigzag(row[index] - predict(row, above, index, filter));
+		cost += output[index];
+	}
+
+#if defined(__SSE2__)
+	/**
+	 * 2.0 Filter the rest of the row 16 bytes at a time.  The zigzag doubles each residual and inverts it if it was
+	 * negative, and PSADBW sums the results.
+	 */
+	__m128i zero = _mm_setzero_si128();
+	__m128i total = _mm_setzero_si128();
+	for (; index + BLOCK_SIZE <= length; index += BLOCK_SIZE) {
+		__m128i prediction;
+		switch (filter) {
+		case FILTER_LEFT:
+			prediction = _mm_loadu_si128((const __m128i*) (row + index - PIXEL_SIZE));
+			break;
+		case FILTER_UP:
+			prediction = _mm_loadu_si128((const __m128i*) (above + index));
+			break;
+		case FILTER_AVERAGE:
+			prediction = _mm_avg_epu8(_mm_loadu_si128((const __m128i*) (row + index - PIXEL_SIZE)),
+					_mm_loadu_si128((const __m128i*) (above + index)));
+			break;
+		default:
+			prediction = zero;
+			break;
+		}
+		__m128i residual = _mm_sub_epi8(_mm_loadu_si128((const __m128i*) (row + index)), prediction);
+		__m128i zigzag = _mm_xor_si128(_mm_add_epi8(residual, residual), _mm_cmpgt_epi8(zero, residual));
+		_mm_storeu_si128((__m128i*) (output + index), zigzag);
+		total = _mm_add_epi64(total, _mm_sad_epu8(zigzag, zero));
+	}
+	cost += (uint32_t) (_mm_cvtsi128_si32(total) + _mm_cvtsi128_si32(_mm_srli_si128(total, 8)));
+#elif defined(__ARM_NEON)
+	/**
+	 * 2.0 Filter the rest of the row 16 bytes at a time.  VRHADD is the rounded up average, and the pairwise additions
+	 * sum the results.
+	 */
+	uint32x4_t total = vdupq_n_u32(0);
+	for (; index + BLOCK_SIZE <= length; index += BLOCK_SIZE) {
+		uint8x16_t prediction;
+		switch (filter) {
+		case FILTER_LEFT:
+			prediction = vld1q_u8(row + index - PIXEL_SIZE);
+			break;
+		case FILTER_UP:
+			prediction = vld1q_u8(above + index);
+			break;
+		case FILTER_AVERAGE:
+			prediction = vrhaddq_u8(vld1q_u8(row + index - PIXEL_SIZE), vld1q_u8(above + index));
+			break;
+		default:
+			prediction = vdupq_n_u8(0);
+			break;
+		}
+		uint8x16_t residual = vsubq_u8(vld1q_u8(row + index), prediction);
+		uint8x16_t negative = vcltq_s8(vreinterpretq_s8_u8(residual), vdupq_n_s8(0));
+		uint8x16_t zigzag = veorq_u8(vaddq_u8(residual, residual), negative);
+		vst1q_u8(output + index, zigzag);
+		total = vpadalq_u16(total, vpaddlq_u8(zigzag));
+	}
+	uint64x2_t sum = vpaddlq_u32(total);
+	cost += (uint32_t) (vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+#endif
+
+	/**
+	 * 3.0 Filter the rest of the row one byte at a time, and pad the last block with zeros.
+	 */
+	for (; index < length; index++) {
+		output[index] = toZigzag(row[index] - predict(row, above, index, filter));
+		cost += output[index];
+	}
+	for (; (index % BLOCK_SIZE) != 0; index++) {
+		output[index] = 0;
+	}
+	return cost;
+}
+
+/**
+ * This method will bit pack the residuals of a row.
+ * @param filter This is the filter which the residuals were made with.
+ * @param residual This is the residuals, padded to a whole number of blocks.
+ * @param length This is the length of the row in bytes.
+ * @param output This is where the compressed row is written.
+ * @return The return will be the size of the compressed row in bytes.
+ */
+size_t LosslessRowCodec::packRow(RowFilter filter, const uint8_t *residual, int length, uint8_t *output) {
+	int blocks = (length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	uint8_t *widths = output + 1;
+	uint8_t *next = widths + ((blocks + 1) / 2);
+	output[0] = (uint8_t) filter;
+	memset(widths, 0, (blocks + 1) / 2);
+
+	for (int block = 0; block < blocks; block++) {
+		const uint8_t *values = residual + (block * BLOCK_SIZE);
+		uint32_t largest = 0;
+
+		/**
+		 * 1.0 Find the largest value of the block.  It has as many bits as the OR of the block.
+		 */
+#if defined(__SSE2__)
+		__m128i planes = _mm_loadu_si128((const __m128i*) values);
+		__m128i maximum = _mm_max_epu8(planes, _mm_srli_si128(planes, 8));
+		maximum = _mm_max_epu8(maximum, _mm_srli_si128(maximum, 4));
+		maximum = _mm_max_epu8(maximum, _mm_srli_si128(maximum, 2));
+		maximum = _mm_max_epu8(maximum, _mm_srli_si128(maximum, 1));
+		largest = (uint32_t) _mm_cvtsi128_si32(maximum) & 0xFF;
+#elif defined(__ARM_NEON)
+		uint8x16_t planes = vld1q_u8(values);
+		uint8x8_t maximum = vmax_u8(vget_low_u8(planes), vget_high_u8(planes));
+		maximum = vpmax_u8(maximum, maximum);
+		maximum = vpmax_u8(maximum, maximum);
+		maximum = vpmax_u8(maximum, maximum);
+		largest = vget_lane_u8(maximum, 0);
+#else
+		for (int index = 0; index < BLOCK_SIZE; index++) {
+			largest = std::max(largest, (uint32_t) values[index]);
+		}
+#endif
+		int width = (largest == 0) ? 0 : (32 - __builtin_clz(largest));
+		widths[block / 2] |= (uint8_t) (width << ((block % 2) * 4));
+
+		/**
+		 * 2.0 Write the bit planes of the block, lowest first.  Each plane is the low bit of every byte, gathered into 16 bits.
+		 */
+#if defined(__SSE2__)
+		for (int plane = 0; plane < width; plane++) {
+			int bits = _mm_movemask_epi8(_mm_slli_epi16(planes, 7));
+			next[0] = (uint8_t) bits;
+			next[1] = (uint8_t) (bits >> 8);
+			next += 2;
+			planes = _mm_srli_epi16(planes, 1);
+		}
+#elif defined(__ARM_NEON)
+		static const uint8_t weightValues[BLOCK_SIZE] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+		uint8x16_t weights = vld1q_u8(weightValues);
+		uint8x16_t one = vdupq_n_u8(1);
+		for (int plane = 0; plane < width; plane++) {
+			uint64x2_t bits = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vmulq_u8(vandq_u8(planes, one), weights))));
+			next[0] = (uint8_t) vgetq_lane_u64(bits, 0);
+			next[1] = (uint8_t) vgetq_lane_u64(bits, 1);
+			next += 2;
+			planes = vshrq_n_u8(planes, 1);
+		}
+#else
+		for (int plane = 0; plane < width; plane++) {
+			uint32_t bits = 0;
+			for (int index = 0; index < BLOCK_SIZE; index++) {
+				bits |= ((values[index] >> plane) & 1u) << index;
+			}
+			next[0] = (uint8_t) bits;
+			next[1] = (uint8_t) (bits >> 8);
+			next += 2;
+		}
+#endif
+	}
+	return next - output;
+}
+
+/**
+ * This method will compress as many rows of an image, starting at the given row, as are sure to fit in a buffer.
+ * @param image This is the image, an 8 bit, 3 channel BGR image.
+ * @param firstRow This is the first row to compress.
+ * @param output This is the buffer the rows are written to.
+ * @param capacity This is the size of the buffer in bytes.
+ * @param length This is filled in with the number of bytes written.
+ * @return The return will be the number of rows compressed, which is 0 if not even one row is sure to fit.
+ */
+int LosslessRowCodec::encodeRows(const Mat &image, int firstRow, uint8_t *output, size_t capacity, size_t &length) {
+	length = 0;
+	if ((image.channels() != 3) || (firstRow < 0) || (firstRow >= image.rows)) {
+		return 0;
+	}
+
+	/**
+	 * 1.0 Size the residual rows for this width.  They only grow, so this allocates for the first frame only.
+	 */
+	int rowLength = image.cols * PIXEL_SIZE;
+	size_t paddedLength = ((rowLength + BLOCK_SIZE - 1) / BLOCK_SIZE) * BLOCK_SIZE;
+	for (std::vector<uint8_t> &residual : residuals) {
+		if (residual.size() < paddedLength) {
+			residual.resize(paddedLength);
+		}
+	}
+
+	/**
+	 * 2.0 Compress rows while even the worst case of another one fits.  The first row can not use the row above it.
+	 */
+	size_t worstCase = getWorstCaseRowSize(image.cols);
+	int rows = 0;
+	while ((firstRow + rows < image.rows) && (length + worstCase <= capacity)) {
+		const uint8_t *row = image.ptr(firstRow + rows);
+		const uint8_t *above = (rows > 0) ? image.ptr(firstRow + rows - 1) : NULL;
+
+		/**
+		 * 2.1 Choose the filter with the smallest sum of residuals, which is a good estimate of the packed size.
+		 */
+		RowFilter best = FILTER_LEFT;
+		uint32_t bestCost = filterRow(row, NULL, rowLength, FILTER_LEFT, residuals[FILTER_LEFT].data());
+		if (above != NULL) {
+			for (RowFilter filter : { FILTER_UP, FILTER_AVERAGE }) {
+				uint32_t cost = filterRow(row, above, rowLength, filter, residuals[filter].data());
+				if (cost < bestCost) {
+					best = filter;
+					bestCost = cost;
+				}
+			}
+		}
+
+		/**
+		 * 2.2 Pack the residuals of the chosen filter.
+		 */
+		length += packRow(best, residuals[best].data(), rowLength, output + length);
+		rows++;
+	}
+	rawBytes.fetch_add((uint64_t) rows * rowLength, std::memory_order_relaxed);
+	compressedBytes.fetch_add(length, std::memory_order_relaxed);
+	return rows;
+}
+
+/**
+ * This method will decompress a group of rows.
+ * @param input This is the compressed rows.
+ * @param length This is the size of the compressed rows in bytes.
+ * @param width This is the width of the rows in pixels.
+ * @param rowCount This is the number of rows.
+ * @param output This is where the first row is written.
+ * @param stride This is the distance between the rows of the output in bytes.
+ * @return The return will be true if the rows were decompressed, or false if the input is malformed.
+ */
+bool LosslessRowCodec::decodeRows(const uint8_t *input, size_t length, int width, int rowCount, uint8_t *output, size_t stride) {
+	const uint8_t *end = input + length;
+	int rowLength = width * PIXEL_SIZE;
+	int blocks = (rowLength + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+	for (int rowIndex = 0; rowIndex < rowCount; rowIndex++) {
+		uint8_t *row = output + (rowIndex * stride);
+		const uint8_t *above = (rowIndex > 0) ? (row - stride) : NULL;
+
+		/**
+		 * 1.0 Read the filter and the widths.  A filter which needs the row above is not allowed on the first row.
+		 */
+		if (input + 1 + ((blocks + 1) / 2) > end) {
+			return false;
+		}
+		RowFilter filter = (RowFilter) input[0];
+		const uint8_t *widths = input + 1;
+		input = widths + ((blocks + 1) / 2);
+		if ((filter > FILTER_AVERAGE) || ((above == NULL) && ((filter == FILTER_UP) || (filter == FILTER_AVERAGE)))) {
+			return false;
+		}
+
+		/**
+		 * 2.0 Unpack each block's bit planes into the zigzag residuals, and then undo the zigzag and the prediction.
+		 * The prediction needs the bytes already decoded, so this is done one byte at a time.
+		 */
+		for (int block = 0; block < blocks; block++) {
+			int bitWidth = (widths[block / 2] >> ((block % 2) * 4)) & 0x0F;
+			if ((bitWidth > 8) || (input + (2 * bitWidth) > end)) {
+				return false;
+			}
+			uint8_t values[BLOCK_SIZE] = { 0 };
+			for (int plane = 0; plane < bitWidth; plane++) {
+				uint32_t bits = input[0] | (input[1] << 8);
+				input += 2;
+				for (int index = 0; index < BLOCK_SIZE; index++) {
+					values[index] |= (uint8_t) (((bits >> index) & 1u) << plane);
+				}
+			}
+			int first = block * BLOCK_SIZE;
+			for (int index = first; (index < first + BLOCK_SIZE) && (index < rowLength); index++) {
+				row[index] = (uint8_t) (fromZigzag(values[index - first]) + predict(row, above, index, filter));
+			}
+		}
+	}
+	return input == end;
+}
+
+/**
+ * These methods obtain the statistics of the codec.
+ */
+uint64_t LosslessRowCodec::getRawBytes() {
+	return rawBytes.load(std::memory_order_relaxed);
+}
+
+uint64_t LosslessRowCodec::getCompressedBytes() {
+	return compressedBytes.load(std::memory_order_relaxed);
+}
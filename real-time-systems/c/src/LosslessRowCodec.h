@@ -0,0 +1,148 @@
+/**
+ * @file LosslessRowCodec.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class compresses the rows of a BGR image without loss.  Each row is
+ *      first filtered: every byte is replaced by its difference from a prediction
+ *      made from the same channel of the pixel to the left, the pixel above, or
+ *      their average, choosing per row the filter with the smallest residuals.
+ *      The residuals are mapped to unsigned bytes (zigzag), and each block of 16
+ *      is bit packed at the width of its largest value, as bit planes.  Both
+ *      stages are written with SSE2 on x86 and NEON on ARM, 16 bytes at a time.
+ *
+ *      The rows are compressed in groups, one per datagram.  The first row of a
+ *      group is never predicted from the row above it, so every group can be
+ *      decoded on its own, and a lost datagram only loses its own rows.
+ *
+ *      A compressed row is a filter byte (a RowFilter), the 4 bit widths of its
+ *      blocks (two per byte, the even block in the low half), and then, for each
+ *      block, one 16 bit little endian word per bit plane, bit n of which is the
+ *      plane of the block's byte n.  The last block of a row is padded with zeros.
+ */
+
+#ifndef LOSSLESSROWCODEC_H_
+#define LOSSLESSROWCODEC_H_
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+using namespace cv;
+
+class LosslessRowCodec {
+public:
+	/**
+	 * This enumeration defines the filters which a row can be predicted with.
+	 */
+	enum RowFilter {
+		FILTER_NONE = 0, /**< Each byte is sent as is. */
+		FILTER_LEFT = 1, /**< Each byte is predicted by the same channel of the pixel to the left. */
+		FILTER_UP = 2, /**< Each byte is predicted by the same byte of the row above. */
+		FILTER_AVERAGE = 3 /**< Each byte is predicted by the average of the left and the up predictions, rounded up. */
+	};
+
+private:
+	/**
+	 * These are the zigzag residuals of the row being compressed under each filter.  They are padded with zeros to a
+	 * whole number of blocks.
+	 */
+	std::vector<uint8_t> residuals[4];
+
+	/**
+	 * These are the statistics of the codec: the bytes of rows before and after compression.  They may be read by any thread.
+	 */
+	std::atomic<uint64_t> rawBytes;
+	std::atomic<uint64_t> compressedBytes;
+
+	/**
+	 * This method will filter a row into zigzag residuals.
+	 * @param row This is the row.
+	 * @param above This is the row above it, or NULL if it is not to be used.
+	 * @param length This is the length of the row in bytes.
+	 * @param filter This is the filter.
+	 * @param output This is where the residuals are written.
+	 * @return The return will be the sum of the residuals, which is the cost of the filter.
+	 */
+	static uint32_t filterRow(const uint8_t *row, const uint8_t *above, int length, RowFilter filter, uint8_t *output);
+
+	/**
+	 * This method will bit pack the residuals of a row.
+	 * @param filter This is the filter which the residuals were made with.
+	 * @param residual This is the residuals, padded to a whole number of blocks.
+	 * @param length This is the length of the row in bytes.
+	 * @param output This is where the compressed row is written.
+	 * @return The return will be the size of the compressed row in bytes.
+	 */
+	static size_t packRow(RowFilter filter, const uint8_t *residual, int length, uint8_t *output);
+
+public:
+	/**
+	 * This is the constructor for the class.
+	 */
+	LosslessRowCodec();
+
+	/**
+	 * This is the destructor for the class.
+	 */
+	virtual ~LosslessRowCodec();
+
+	/**
+	 * This method will obtain the largest size a compressed row can have.
+	 * @param width This is the width of the row in pixels.
+	 * @return The return will be the size in bytes.
+	 */
+	static size_t getWorstCaseRowSize(int width);
+
+	/**
+	 * This method will compress as many rows of an image, starting at the given row, as are sure to fit in a buffer.
+	 * The rows only depend on each other, so they can be decoded on their own.
+	 * @param image This is the image, an 8 bit, 3 channel BGR image.
+	 * @param firstRow This is the first row to compress.
+	 * @param output This is the buffer the rows are written to.
+	 * @param capacity This is the size of the buffer in bytes.
+	 * @param length This is filled in with the number of bytes written.
+	 * @return The return will be the number of rows compressed, which is 0 if not even one row is sure to fit.
+	 */
+	int encodeRows(const Mat &image, int firstRow, uint8_t *output, size_t capacity, size_t &length);
+
+	/**
+	 * This method will decompress a group of rows.
+	 * @param input This is the compressed rows.
+	 * @param length This is the size of the compressed rows in bytes.
+	 * @param width This is the width of the rows in pixels.
+	 * @param rowCount This is the number of rows.
+	 * @param output This is where the first row is written.
+	 * @param stride This is the distance between the rows of the output in bytes.
+	 * @return The return will be true if the rows were decompressed, or false if the input is malformed.
+	 */
+	static bool decodeRows(const uint8_t *input, size_t length, int width, int rowCount, uint8_t *output, size_t stride);
+
+	/**
+	 * These methods obtain the statistics of the codec: the bytes of rows before and after compression.
+	 */
+	uint64_t getRawBytes();
+	uint64_t getCompressedBytes();
+};
+
+#endif /* LOSSLESSROWCODEC_H_ */
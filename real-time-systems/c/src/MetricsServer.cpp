@@ -0,0 +1,523 @@
+/**
+ * @file MetricsServer.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a small embedded HTTP server which exports the statistics in
+ *      the Prometheus text format.
+ */
+
+#include "MetricsServer.h"
+#include "PeriodicTask.h"
+#include "ImageTransmitter.h"
+#include "RealTimeMutex.h"
+#include "FramePool.h"
+#include "Logger.h"
+
+#include <sstream>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+/**
+ * This function will write the HELP and TYPE lines of a metric.
+ * @param out This is the stream that the metrics are written to.
+ * @param name This is the name of the metric.
+ * @param type This is the Prometheus type of the metric.
+ * @param help This is the description of the metric.
+ */
+static void writeHeader(std::ostringstream &out, const char *name, const char *type, const char *help) {
+	out << "# HELP " << name << " " << help << "\n";
+	out << "# TYPE " << name << " " << type << "\n";
+}
+
+/**
+ * This is the constructor for the class.
+ * @param port This is the TCP port that the server is to listen on.
+ * @param threadName This is the name of the thread in a human readable format.
+ */
+MetricsServer::MetricsServer(int port, std::string threadName) :
+		RunnableClass(threadName) {
+	myPort = port;
+}
+
+/**
+ * This is the destructor for the class.  It will close the socket.
+ */
+MetricsServer::~MetricsServer() {
+	if (listenSocket >= 0) {
+		close(listenSocket);
+	}
+}
+
+/**
+ * This is the run method.  It will accept connections and answer them until the server is stopped.
+ */
+void MetricsServer::run() {
+	struct sockaddr_in address;
+	int reuse = 1;
+
+	/**
+	 * 1.0 Create the socket and listen on the port.
+	 */
+	listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+	if (listenSocket < 0) {
+		Logger::log(LOG_ERROR, "%s: Cannot create the socket (%s).", myName.c_str(), strerror(errno));
+		return;
+	}
+	setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(myPort);
+	if ((bind(listenSocket, (struct sockaddr *) &address, sizeof(address)) != 0) || (listen(listenSocket, 4) != 0)) {
+		Logger::log(LOG_ERROR, "%s: Cannot listen on port %d (%s).", myName.c_str(), myPort, strerror(errno));
+		close(listenSocket);
+		listenSocket = -1;
+		return;
+	}
+	Logger::log(LOG_INFO, "%s: Serving metrics on port %d.", myName.c_str(), myPort);
+
+	/**
+	 * 2.0 Answer connections one at a time.  The wait is limited so that a stop is noticed.
+	 */
+	while (keepGoing) {
+		struct pollfd waiting;
+		waiting.fd = listenSocket;
+		waiting.events = POLLIN;
+		if (poll(&waiting, 1, 250) > 0) {
+			int connection = accept(listenSocket, NULL, NULL);
+			if (connection >= 0) {
+				serveRequest(connection);
+				close(connection);
+			}
+		}
+	}
+}
+
+/**
+ * This method will answer a single request on the given connection.
+ * @param connection This is the socket of the connection.
+ */
+void MetricsServer::serveRequest(int connection) {
+	char request[1024];
+	std::string response;
+
+	/**
+	 * 1.0 Read the request line.  A client which does not send a request promptly is dropped.
+	 */
+	struct timeval timeout = { 1, 0 };
+	setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	ssize_t length = recv(connection, request, sizeof(request) - 1, 0);
+	if (length <= 0) {
+		return;
+	}
+	request[length] = '\0';
+
+	/**
+	 * 2.0 Answer a request for the metrics (or the root) with the metrics, and anything else with not found.
+	 */
+	if ((strncmp(request, "GET /metrics", 12) == 0) || (strncmp(request, "GET / ", 6) == 0)) {
+		std::string body = buildMetrics();
+		response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+				+ std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+		requestsServed++;
+	} else {
+		response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+	}
+
+	/**
+	 * 3.0 Send the response.
+	 */
+	size_t sent = 0;
+	while (sent < response.size()) {
+		ssize_t result = send(connection, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+		if (result <= 0) {
+			break;
+		}
+		sent += result;
+	}
+}
+
+/**
+ * This method will build the metrics in the Prometheus text format.
+ * @return The return will be the text of the metrics.
+ */
+std::string MetricsServer::buildMetrics() {
+	std::ostringstream out;
+	std::list<PeriodicTask*> tasks;
+
+	/**
+	 * 1.0 Find the periodic tasks.
+	 */
+	for (RunnableClass *rc : RunnableClass::getRunningThreads()) {
+		PeriodicTask *task = dynamic_cast<PeriodicTask*>(rc);
+		if (task != NULL) {
+			tasks.push_back(task);
+		}
+	}
+
+	/**
+	 * 2.0 Write the statistics of the tasks, one metric family at a time as Prometheus requires.
+	 */
+	std::list<TaskStatistics> statistics;
+	for (PeriodicTask *task : tasks) {
+		statistics.push_back(TaskStatistics());
+		task->getStatistics(statistics.back());
+	}
+
+	writeHeader(out, "rts_task_period_microseconds", "gauge", "The period of the task.");
+	std::list<TaskStatistics>::iterator stats = statistics.begin();
+	for (PeriodicTask *task : tasks) {
+		out << "rts_task_period_microseconds{task=\"" << task->getName() << "\"} " << (stats++)->period << "\n";
+	}
+
+	writeHeader(out, "rts_task_priority", "gauge", "The priority of the task.");
+	for (PeriodicTask *task : tasks) {
+		out << "rts_task_priority{task=\"" << task->getName() << "\",policy=\"" << task->getSchedulingPolicyName() << "\"} "
+				<< task->getPriority() << "\n";
+	}
+
+	writeHeader(out, "rts_task_activations_total", "counter", "The number of times the task has been released.");
+	stats = statistics.begin();
+	for (PeriodicTask *task : tasks) {
+		out << "rts_task_activations_total{task=\"" << task->getName() << "\"} " << (stats++)->activations << "\n";
+	}
+
+	writeHeader(out, "rts_task_execution_time_microseconds", "gauge", "The CPU time of the last execution of the task.");
+	stats = statistics.begin();
+	for (PeriodicTask *task : tasks) {
+		out << "rts_task_execution_time_microseconds{task=\"" << task->getName() << "\"} " << (stats++)->lastExecutionTime << "\n";
+	}
+
+	writeHeader(out, "rts_task_wcet_microseconds", "gauge", "The worst case CPU time of the task.");
+	stats = statistics.begin();
+	for (PeriodicTask *task : tasks) {
+		out << "rts_task_wcet_microseconds{task=\"" << task->getName() << "\"} " << (stats++)->worstCaseExecutionTime << "\n";
+	}
+
+	writeHeader(out, "rts_task_worst_case_wall_time_microseconds", "gauge", "The worst case wall time of the task.");
+	stats = statistics.begin();
+	for (PeriodicTask *task : tasks) {
+		out << "rts_task_worst_case_wall_time_microseconds{task=\"" << task->getName() << "\"} " << (stats++)->worstCaseWallTime << "\n";
+	}
+
+	writeHeader(out, "rts_task_wall_time_microseconds", "summary", "The wall time of the task from the start of its execution to completion.");
+	for (PeriodicTask *task : tasks) {
+		LatencyHistogram &histogram = task->getWallTimeHistogram();
+		for (double quantile : { 0.5, 0.9, 0.99, 0.999 }) {
+			out << "rts_task_wall_time_microseconds{task=\"" << task->getName() << "\",quantile=\"" << quantile << "\"} "
+					<< histogram.getPercentile(quantile * 100.0) << "\n";
+		}
+		out << "rts_task_wall_time_microseconds_sum{task=\"" << task->getName() << "\"} " << histogram.getSum() << "\n";
+		out << "rts_task_wall_time_microseconds_count{task=\"" << task->getName() << "\"} " << histogram.getCount() << "\n";
+	}
+
+	writeHeader(out, "rts_task_worst_case_response_time_microseconds", "gauge", "The worst case time of the task from its release to its completion.");
+	stats = statistics.begin();
+	for (PeriodicTask *task : tasks) {
+		out << "rts_task_worst_case_response_time_microseconds{task=\"" << task->getName() << "\"} " << (stats++)->worstCaseResponseTime << "\n";
+	}
+
+	writeHeader(out, "rts_task_worst_case_release_jitter_microseconds", "gauge", "The worst case delay of the task from its release to the start of its execution.");
+	stats = statistics.begin();
+	for (PeriodicTask *task : tasks) {
+		out << "rts_task_worst_case_release_jitter_microseconds{task=\"" << task->getName() << "\"} " << (stats++)->worstCaseReleaseJitter << "\n";
+	}
+
+	writeHeader(out, "rts_task_deadline_misses_total", "counter", "The number of executions which did not complete within the period.");
+	stats = statistics.begin();
+	for (PeriodicTask *task : tasks) {
+		out << "rts_task_deadline_misses_total{task=\"" << task->getName() << "\"} " << (stats++)->deadlineMisses << "\n";
+	}
+
+	writeHeader(out, "rts_task_steady_state_allocations_total", "counter", "The number of heap allocations made by the task once it reached a steady state.");
+	stats = statistics.begin();
+	for (PeriodicTask *task : tasks) {
+		out << "rts_task_steady_state_allocations_total{task=\"" << task->getName() << "\"} " << (stats++)->steadyStateAllocations << "\n";
+	}
+
+	writeHeader(out, "rts_task_budget_overruns_total", "counter", "The number of executions which exceeded the execution budget.");
+	stats = statistics.begin();
+	for (PeriodicTask *task : tasks) {
+		out << "rts_task_budget_overruns_total{task=\"" << task->getName() << "\"} " << (stats++)->budgetOverruns << "\n";
+	}
+
+	writeHeader(out, "rts_task_throttled_total", "counter", "The number of SCHED_DEADLINE runtime overruns signalled by the kernel.");
+	for (PeriodicTask *task : tasks) {
+		out << "rts_task_throttled_total{task=\"" << task->getName() << "\"} " << task->getThrottleCount() << "\n";
+	}
+
+	writeHeader(out, "rts_task_worst_case_page_faults", "gauge", "The largest number of page faults the task took in one period.");
+	stats = statistics.begin();
+	for (PeriodicTask *task : tasks) {
+		out << "rts_task_worst_case_page_faults{task=\"" << task->getName() << "\"} " << (stats++)->worstCasePageFaults << "\n";
+	}
+
+	/**
+	 * 3.0 Write the statistics of the image streams.
+	 */
+	const std::list<ImageTransmitter*> &transmitters = ImageTransmitter::getAllTransmitters();
+	writeHeader(out, "rts_stream_frames_total", "counter", "The number of frames transmitted.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		out << "rts_stream_frames_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getFramesSent() << "\n";
+	}
+	writeHeader(out, "rts_stream_datagrams_total", "counter", "The number of datagrams transmitted.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		out << "rts_stream_datagrams_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getDatagramsSent() << "\n";
+	}
+	writeHeader(out, "rts_stream_bytes_total", "counter", "The number of bytes transmitted.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		out << "rts_stream_bytes_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getBytesSent() << "\n";
+	}
+	writeHeader(out, "rts_stream_errors_total", "counter", "The number of frames which could not be transmitted.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		out << "rts_stream_errors_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getSendErrors() << "\n";
+	}
+	writeHeader(out, "rts_stream_encoding", "gauge", "The encoding of the stream: 0 raw, 1 JPEG slices, 2 tile deltas, 3 lossless rows.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		out << "rts_stream_encoding{stream=\"" << transmitter->getName() << "\"} " << transmitter->getEncoding() << "\n";
+	}
+	writeHeader(out, "rts_stream_pixel_format", "gauge", "The pixel format of the raw rows: 0 BGR24, 1 Y8, 2 YUV420, 3 RGB565.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		out << "rts_stream_pixel_format{stream=\"" << transmitter->getName() << "\"} " << transmitter->getPixelFormat() << "\n";
+	}
+	writeHeader(out, "rts_stream_jpeg_quality", "gauge", "The JPEG quality of the stream, or 0 if it is not sent as JPEG slices.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		out << "rts_stream_jpeg_quality{stream=\"" << transmitter->getName() << "\"} "
+				<< ((transmitter->getEncoding() == ENCODING_JPEG) ? transmitter->getJpegQuality() : 0) << "\n";
+	}
+
+	/**
+	 * 3.1 Write the statistics of the JPEG slice encoders, for the streams which have one.
+	 */
+	writeHeader(out, "rts_stream_slices_dropped_total", "counter", "The number of JPEG slices which did not fit a datagram at any quality.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getJpegEncoder() != NULL) {
+			out << "rts_stream_slices_dropped_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getJpegEncoder()->getSlicesDropped() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_slice_quality_reductions_total", "counter", "The number of times a JPEG slice was encoded again at a lower quality to fit a datagram.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getJpegEncoder() != NULL) {
+			out << "rts_stream_slice_quality_reductions_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getJpegEncoder()->getQualityReductions() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_slice_rows", "gauge", "The height of the JPEG slices in rows.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getJpegEncoder() != NULL) {
+			out << "rts_stream_slice_rows{stream=\"" << transmitter->getName() << "\"} " << transmitter->getJpegEncoder()->getRowsPerSlice() << "\n";
+		}
+	}
+
+	writeHeader(out, "rts_stream_lossless_raw_bytes_total", "counter", "The number of bytes of rows compressed without loss, before compression.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		out << "rts_stream_lossless_raw_bytes_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getRowCodec().getRawBytes() << "\n";
+	}
+	writeHeader(out, "rts_stream_lossless_compressed_bytes_total", "counter", "The number of bytes of rows compressed without loss, after compression.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		out << "rts_stream_lossless_compressed_bytes_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getRowCodec().getCompressedBytes() << "\n";
+	}
+
+	/**
+	 * 3.2 Write the statistics of the tile delta encoders, for the streams which have one.
+	 */
+	writeHeader(out, "rts_stream_keyframes_total", "counter", "The number of keyframes sent as tile deltas.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getTileEncoder() != NULL) {
+			out << "rts_stream_keyframes_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getTileEncoder()->getKeyframes() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_tiles_compared_total", "counter", "The number of tiles compared with the version last sent.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getTileEncoder() != NULL) {
+			out << "rts_stream_tiles_compared_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getTileEncoder()->getTilesCompared() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_tiles_sent_total", "counter", "The number of tiles sent because they changed or were part of a keyframe.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getTileEncoder() != NULL) {
+			out << "rts_stream_tiles_sent_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getTileEncoder()->getTilesSent() << "\n";
+		}
+	}
+
+	/**
+	 * 3.3 Write the statistics of the forward error correction, for the streams which have it.
+	 */
+	writeHeader(out, "rts_stream_fec_data_datagrams", "gauge", "The number of data datagrams in a group of forward error correction, or 0 if it is off.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getFecEncoder() != NULL) {
+			out << "rts_stream_fec_data_datagrams{stream=\"" << transmitter->getName() << "\"} " << transmitter->getFecDataCount() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_fec_parity_datagrams", "gauge", "The number of parity datagrams for each group of forward error correction.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getFecEncoder() != NULL) {
+			out << "rts_stream_fec_parity_datagrams{stream=\"" << transmitter->getName() << "\"} " << transmitter->getFecParityCount() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_fec_groups_total", "counter", "The number of groups of forward error correction closed and sent with their parity.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getFecEncoder() != NULL) {
+			out << "rts_stream_fec_groups_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getFecEncoder()->getGroupsClosed() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_fec_parity_datagrams_total", "counter", "The number of parity datagrams sent, which are included in the datagrams sent.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		out << "rts_stream_fec_parity_datagrams_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getParityDatagramsSent() << "\n";
+	}
+
+	/**
+	 * 3.4 Write the statistics of the retransmission, for the streams which have a history.
+	 */
+	writeHeader(out, "rts_stream_retransmit_budget_milliseconds", "gauge", "The age up to which lost datagrams are sent again, or 0 if retransmission is off.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getTransmitHistory() != NULL) {
+			out << "rts_stream_retransmit_budget_milliseconds{stream=\"" << transmitter->getName() << "\"} " << transmitter->getRetransmitBudget() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_nacks_received_total", "counter", "The number of requests from the receiver to send lost datagrams again.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getTransmitHistory() != NULL) {
+			out << "rts_stream_nacks_received_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getNacksReceived() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_retransmitted_datagrams_total", "counter", "The number of datagrams sent again, which are included in the datagrams sent.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getTransmitHistory() != NULL) {
+			out << "rts_stream_retransmitted_datagrams_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getDatagramsRetransmitted() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_retransmissions_expired_total", "counter", "The number of lost datagrams which were not sent again, as they were too old or no longer kept.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getTransmitHistory() != NULL) {
+			out << "rts_stream_retransmissions_expired_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getRetransmissionsExpired() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_retransmissions_suppressed_total", "counter", "The number of requests for a datagram which were not answered, as it had been sent again less than a round trip before.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getTransmitHistory() != NULL) {
+			out << "rts_stream_retransmissions_suppressed_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getRetransmissionsSuppressed() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_round_trip_microseconds", "gauge", "The round trip to the receiver, as measured from its requests for lost datagrams.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if ((transmitter->getTransmitHistory() != NULL) && (transmitter->getRoundTripTime() > 0)) {
+			out << "rts_stream_round_trip_microseconds{stream=\"" << transmitter->getName() << "\"} " << transmitter->getRoundTripTime() << "\n";
+		}
+	}
+
+	/**
+	 * 3.5 Write the last report of the receiver, for the streams which have received one.
+	 */
+	writeHeader(out, "rts_stream_receiver_reports_total", "counter", "The number of reports received from the receiver.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		out << "rts_stream_receiver_reports_total{stream=\"" << transmitter->getName() << "\"} " << transmitter->getReportsReceived() << "\n";
+	}
+	writeHeader(out, "rts_stream_receiver_loss_ratio", "gauge", "The fraction of the datagrams which the receiver last reported lost on the link.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getReportsReceived() > 0) {
+			out << "rts_stream_receiver_loss_ratio{stream=\"" << transmitter->getName() << "\"} " << transmitter->getReportedLoss() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_receiver_jitter_microseconds", "gauge", "The interarrival jitter of the frames which the receiver last reported.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getReportsReceived() > 0) {
+			out << "rts_stream_receiver_jitter_microseconds{stream=\"" << transmitter->getName() << "\"} " << transmitter->getReportedJitter() << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_receiver_rate_kbps", "gauge", "The rate at which the receiver last reported receiving the stream.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		if (transmitter->getReportsReceived() > 0) {
+			out << "rts_stream_receiver_rate_kbps{stream=\"" << transmitter->getName() << "\"} " << transmitter->getReportedReceiveRate() << "\n";
+		}
+	}
+
+	/**
+	 * 3.6 Write the statistics of each destination of the streams.
+	 */
+	writeHeader(out, "rts_stream_destination_datagrams_total", "counter", "The number of datagrams transmitted to the destination.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		for (int index = 0; index < transmitter->getDestinationCount(); index++) {
+			out << "rts_stream_destination_datagrams_total{stream=\"" << transmitter->getName() << "\",destination=\"" << transmitter->getDestinationName(index) << "\"} "
+					<< transmitter->getDestinationDatagramsSent(index) << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_destination_bytes_total", "counter", "The number of bytes transmitted to the destination.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		for (int index = 0; index < transmitter->getDestinationCount(); index++) {
+			out << "rts_stream_destination_bytes_total{stream=\"" << transmitter->getName() << "\",destination=\"" << transmitter->getDestinationName(index) << "\"} "
+					<< transmitter->getDestinationBytesSent(index) << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_destination_errors_total", "counter", "The number of datagrams which could not be transmitted to the destination.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		for (int index = 0; index < transmitter->getDestinationCount(); index++) {
+			out << "rts_stream_destination_errors_total{stream=\"" << transmitter->getName() << "\",destination=\"" << transmitter->getDestinationName(index) << "\"} "
+					<< transmitter->getDestinationSendErrors(index) << "\n";
+		}
+	}
+	writeHeader(out, "rts_stream_destination_suspended", "gauge", "1 if nothing is transmitted to the destination because a transmission to it failed, or 0 otherwise.");
+	for (ImageTransmitter *transmitter : transmitters) {
+		for (int index = 0; index < transmitter->getDestinationCount(); index++) {
+			out << "rts_stream_destination_suspended{stream=\"" << transmitter->getName() << "\",destination=\"" << transmitter->getDestinationName(index) << "\"} "
+					<< transmitter->isDestinationSuspended(index) << "\n";
+		}
+	}
+
+	/**
+	 * 4.0 Write the statistics of the real time locks.
+	 */
+	writeHeader(out, "rts_lock_contentions_total", "counter", "The number of times the lock was already held when it was requested.");
+	for (RealTimeMutex *lock : RealTimeMutex::getAllLocks()) {
+		out << "rts_lock_contentions_total{lock=\"" << lock->getName() << "\"} " << lock->getContentions() << "\n";
+	}
+	writeHeader(out, "rts_lock_worst_case_wait_microseconds", "gauge", "The longest time a task waited for the lock.");
+	for (RealTimeMutex *lock : RealTimeMutex::getAllLocks()) {
+		out << "rts_lock_worst_case_wait_microseconds{lock=\"" << lock->getName() << "\"} " << (lock->getWorstCaseWaitTime() / 1000) << "\n";
+	}
+
+	/**
+	 * 5.0 Write the statistics of the frame pools.
+	 */
+	writeHeader(out, "rts_pool_buffers_available", "gauge", "The number of free buffers in the frame pool.");
+	for (FramePool *pool : FramePool::getAllPools()) {
+		out << "rts_pool_buffers_available{pool=\"" << pool->getName() << "\"} " << pool->getAvailable() << "\n";
+	}
+	writeHeader(out, "rts_pool_exhausted_total", "counter", "The number of times a buffer was requested from the frame pool when none was free.");
+	for (FramePool *pool : FramePool::getAllPools()) {
+		out << "rts_pool_exhausted_total{pool=\"" << pool->getName() << "\"} " << pool->getExhaustedCount() << "\n";
+	}
+
+	/**
+	 * 6.0 Write the statistics of the logger.
+	 */
+	writeHeader(out, "rts_log_dropped_total", "counter", "The number of log messages dropped because the queue was full.");
+	out << "rts_log_dropped_total " << Logger::getDroppedCount() << "\n";
+	writeHeader(out, "rts_log_suppressed_total", "counter", "The number of log messages suppressed by rate limiting.");
+	out << "rts_log_suppressed_total " << Logger::getSuppressedCount() << "\n";
+
+	return out.str();
+}
@@ -0,0 +1,88 @@
+/**
+ * @file MetricsServer.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a small embedded HTTP server which exports the statistics of
+ *      every periodic task, every image stream, every real time lock, and the logger
+ *      in the Prometheus text format, so that headless units can be monitored
+ *      remotely.  Any request for /metrics is answered with the current values.
+ *      The statistics are read without taking any lock that a real time thread uses,
+ *      so a scrape never delays the real time threads.  The server itself should
+ *      run at the default (non real time) priority.
+ */
+
+#ifndef METRICSSERVER_H_
+#define METRICSSERVER_H_
+
+#include "RunnableClass.h"
+
+#include <string>
+
+class MetricsServer: public RunnableClass {
+private:
+	/**
+	 * This is the TCP port that the server listens on.
+	 */
+	int myPort;
+
+	/**
+	 * This is the socket that the server listens on.
+	 */
+	int listenSocket = -1;
+
+	/**
+	 * This is the number of requests which have been answered.
+	 */
+	uint64_t requestsServed = 0;
+
+	/**
+	 * This method will answer a single request on the given connection.
+	 * @param connection This is the socket of the connection.
+	 */
+	void serveRequest(int connection);
+
+public:
+	/**
+	 * This is the constructor for the class.
+	 * @param port This is the TCP port that the server is to listen on.
+	 * @param threadName This is the name of the thread in a human readable format.
+	 */
+	MetricsServer(int port, std::string threadName);
+
+	/**
+	 * This is the destructor for the class.  It will close the socket.
+	 */
+	virtual ~MetricsServer();
+
+	/**
+	 * This is the run method.  It will accept connections and answer them until the server is stopped.
+	 */
+	void run();
+
+	/**
+	 * This method will build the metrics in the Prometheus text format.
+	 * @return The return will be the text of the metrics.
+	 */
+	static std::string buildMetrics();
+};
+
+#endif /* METRICSSERVER_H_ */
@@ -0,0 +1,435 @@
+/**
+ * @file OverloadManager.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a periodic task which sheds the low criticality tasks when
+ *      the CPU is overloaded, and restores them once there is headroom again.
+ */
+
+#include "OverloadManager.h"
+#include "Logger.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+
+/**
+ * This function will obtain the number of microseconds from one time to another.
+ * @param end This is the later time.
+ * @param start This is the earlier time.
+ * @return The return will be the number of microseconds between the times.
+ */
+static int64_t microsecondsBetween(const struct timespec &end, const struct timespec &start) {
+	return ((int64_t) (end.tv_sec - start.tv_sec) * 1000000LL) + ((end.tv_nsec - start.tv_nsec) / 1000);
+}
+
+/**
+ * This function will obtain the name of a CPU for the log, as the schedulability analysis names it.
+ * @param cpu This is the CPU, or -1 for the tasks which are not bound to a CPU.
+ * @return The return will be the name of the CPU.
+ */
+static std::string cpuName(int cpu) {
+	return (cpu < 0) ? std::string("CPU any") : "CPU " + std::to_string(cpu);
+}
+
+/**
+ * This is the constructor for the class.
+ * @param threadName This is the name of the thread in a human readable format.
+ * @param period This is the period for the task, given in microseconds.
+ */
+OverloadManager::OverloadManager(std::string threadName, uint32_t period) :
+		PeriodicTask(threadName, period), sampleCount(0), sampleGeneration(0), cpuUtilization(
+				std::max((int) sysconf(_SC_NPROCESSORS_CONF), 1) + 1, 0.0), unboundCpuCount(RunnableClass::getUnboundCpuCount()), degradeUtilization(0.9), degradeMisses(1), restoreUtilization(0.7), restoreHoldOff(10), calmPeriods(0), pendingRestores(0), mode(
+				MODE_NORMAL), transitionCount(0) {
+	previousSampleTime.tv_sec = 0;
+	previousSampleTime.tv_nsec = 0;
+	modeStartTime = previousSampleTime;
+}
+
+/**
+ * This is the destructor for the class.  If the system is degraded, the low criticality tasks are restored.
+ */
+OverloadManager::~OverloadManager() {
+	if (mode == MODE_DEGRADED) {
+		enterNormalMode("the overload manager was removed");
+	}
+}
+
+/**
+ * This method will designate a task as low criticality.  It must be called before the manager is started.
+ * @param task This is the task.
+ * @param degradedPeriod This is the period of the task in degraded mode, given in microseconds.  0 means the task is
+ * suspended in degraded mode.
+ */
+void OverloadManager::addLowCriticalityTask(PeriodicTask *task, uint32_t degradedPeriod) {
+	ManagedTask managed;
+	managed.task = task;
+	managed.degradedPeriod = degradedPeriod;
+	managed.normalPeriod = task->getTaskPeriod();
+	managed.restorePending = false;
+	managed.meanExecutionTime = 0.0;
+	managedTasks.push_back(managed);
+}
+
+/**
+ * This method will set the thresholds of the manager.  It must be called before the manager is started.
+ * @param degradeUtilization This is the utilization of a CPU, from 0 to 1, at or above which the system is degraded.
+ * @param degradeMisses This is the number of deadline misses by the high criticality tasks in a single period at or
+ * above which the system is degraded.  0 means deadline misses do not degrade the system.
+ * @param restoreUtilization This is the predicted utilization of every CPU below which the system may return to normal.
+ * @param restoreHoldOff This is the number of consecutive periods in which the system must be able to return to normal
+ * before it does.
+ */
+void OverloadManager::setThresholds(double degradeUtilization, uint32_t degradeMisses, double restoreUtilization, uint32_t restoreHoldOff) {
+	this->degradeUtilization = degradeUtilization;
+	this->degradeMisses = degradeMisses;
+	this->restoreUtilization = restoreUtilization;
+	this->restoreHoldOff = restoreHoldOff;
+}
+
+/**
+ * This method will determine if the given task is one of the low criticality tasks.
+ * @param task This is the task.
+ * @return The return will be the managed task, or NULL if the task is not a low criticality task.
+ */
+OverloadManager::ManagedTask* OverloadManager::findManagedTask(PeriodicTask *task) {
+	for (ManagedTask &managed : managedTasks) {
+		if (managed.task == task) {
+			return &managed;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * This method will find the sample of the given task from the last period.
+ * @param task This is the task.
+ * @return The return will be the sample, or NULL if the task was not sampled.
+ */
+OverloadManager::TaskSample* OverloadManager::findSample(PeriodicTask *task) {
+	for (int index = 0; index < sampleCount; index++) {
+		if (samples[index].task == task) {
+			return &samples[index];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * This method will obtain the entry of the utilization table which a CPU is counted in.  A CPU beyond the table is counted
+ * with the tasks which are not bound to a CPU.
+ * @param cpu This is the CPU, or -1 for the tasks which are not bound to a CPU.
+ * @return The return will be the index into the utilization table.
+ */
+size_t OverloadManager::cpuSlot(int cpu) {
+	return ((cpu < 0) || ((size_t) cpu + 1 >= cpuUtilization.size())) ? 0 : (size_t) cpu + 1;
+}
+
+/**
+ * This is the task method.  It measures the load and changes the mode if a threshold has been crossed.  The algorithm is
+ * as follows:
+ */
+void OverloadManager::taskMethod() {
+	struct timespec now;
+	getClock()->getTime(now);
+	int64_t window = (previousSampleTime.tv_sec == 0) ? 0 : microsecondsBetween(now, previousSampleTime);
+	if (previousSampleTime.tv_sec == 0) {
+		modeStartTime = now;
+	}
+	previousSampleTime = now;
+
+	/**
+	 * 1.0 Measure the CPU time each task used since the last period, and the deadlines the high criticality tasks missed.
+	 * A task seen for the first time, or whose statistics have been reset, is only sampled.  A task beyond the sample table
+	 * is not measured.
+	 */
+	std::fill(cpuUtilization.begin(), cpuUtilization.end(), 0.0);
+	sampleGeneration++;
+	uint32_t misses = 0;
+	for (RunnableClass *rc : RunnableClass::getRunningThreads()) {
+		PeriodicTask *task = dynamic_cast<PeriodicTask*>(rc);
+		if ((task == NULL) || (task == this)) {
+			continue;
+		}
+
+		TaskStatistics snapshot;
+		task->getStatistics(snapshot);
+		TaskSample *sample = findSample(task);
+		bool measured = (window > 0) && (sample != NULL) && (sample->epoch == snapshot.epoch);
+		if (sample == NULL) {
+			if (sampleCount >= MAXIMUM_TASKS) {
+				continue;
+			}
+			sample = &samples[sampleCount++];
+			sample->task = task;
+		}
+		int64_t cpuTime = snapshot.totalExecutionTime - sample->totalExecutionTime;
+		uint64_t activations = snapshot.activations - sample->activations;
+		uint32_t taskMisses = snapshot.deadlineMisses - sample->deadlineMisses;
+		sample->generation = sampleGeneration;
+		sample->epoch = snapshot.epoch;
+		sample->deadlineMisses = snapshot.deadlineMisses;
+		sample->activations = snapshot.activations;
+		sample->totalExecutionTime = snapshot.totalExecutionTime;
+		if (measured == false) {
+			continue;
+		}
+
+		/**
+		 * 1.1 Add the utilization of the task to its CPU.  Tasks which are not bound to a CPU are counted together, as the
+		 * schedulability analysis does, spread across the CPUs which they may execute on.
+		 */
+		size_t slot = cpuSlot(task->getBoundCpu());
+		cpuUtilization[slot] += (double) cpuTime / (double) window / ((slot == 0) ? unboundCpuCount : 1);
+
+		/**
+		 * 1.2 Keep the mean execution time of the low criticality tasks up to date, and count the misses of the others.
+		 */
+		ManagedTask *managed = findManagedTask(task);
+		if (managed != NULL) {
+			if (activations > 0) {
+				managed->meanExecutionTime = (double) cpuTime / (double) activations;
+			}
+		} else {
+			misses += taskMisses;
+		}
+	}
+
+	/**
+	 * 1.3 Forget the tasks which are no longer running, so that their entries can be reused.
+	 */
+	for (int index = 0; index < sampleCount;) {
+		if (samples[index].generation != sampleGeneration) {
+			samples[index] = samples[--sampleCount];
+		} else {
+			index++;
+		}
+	}
+	if (window <= 0) {
+		return;
+	}
+
+	/**
+	 * 2.0 Find the busiest CPU.
+	 */
+	int busiestCpu = -1;
+	double busiestUtilization = 0.0;
+	for (size_t slot = 0; slot < cpuUtilization.size(); slot++) {
+		if (cpuUtilization[slot] > busiestUtilization) {
+			busiestCpu = (int) slot - 1;
+			busiestUtilization = cpuUtilization[slot];
+		}
+	}
+
+	char reason[160];
+	if (mode == MODE_NORMAL) {
+		/**
+		 * 3.0 In normal mode, degrade the system if too many deadlines were missed or a CPU is too busy.
+		 */
+		if ((degradeMisses > 0) && (misses >= degradeMisses)) {
+			snprintf(reason, sizeof(reason), "%u deadline misses in %lld us, %s at %.0f%% utilization", misses,
+					(long long) window, cpuName(busiestCpu).c_str(), busiestUtilization * 100.0);
+			enterDegradedMode(reason);
+		} else if (busiestUtilization >= degradeUtilization) {
+			snprintf(reason, sizeof(reason), "%s at %.0f%% utilization", cpuName(busiestCpu).c_str(), busiestUtilization * 100.0);
+			enterDegradedMode(reason);
+		} else if ((pendingRestores > 0) && (misses == 0) && (busiestUtilization < restoreUtilization)) {
+			/**
+			 * 3.1 Otherwise, in a calm period, try again to restore the tasks whose normal period was refused.
+			 */
+			restorePendingTasks();
+		}
+	} else {
+		/**
+		 * 4.0 In degraded mode, predict the utilization of each CPU with the low criticality tasks restored.
+		 */
+		for (ManagedTask &managed : managedTasks) {
+			double restoredRate = 1.0 / managed.normalPeriod;
+			double degradedRate = (managed.degradedPeriod == 0) ? 0.0 : 1.0 / managed.degradedPeriod;
+			size_t slot = cpuSlot(managed.task->getBoundCpu());
+			cpuUtilization[slot] += managed.meanExecutionTime * (restoredRate - degradedRate) / ((slot == 0) ? unboundCpuCount : 1);
+		}
+		double predictedUtilization = 0.0;
+		for (size_t slot = 0; slot < cpuUtilization.size(); slot++) {
+			if (cpuUtilization[slot] > predictedUtilization) {
+				busiestCpu = (int) slot - 1;
+				predictedUtilization = cpuUtilization[slot];
+			}
+		}
+
+		/**
+		 * 4.1 Restore the system once there is headroom, and no deadlines have been missed, for long enough.
+		 */
+		if ((misses == 0) && (predictedUtilization < restoreUtilization)) {
+			calmPeriods++;
+		} else {
+			calmPeriods = 0;
+		}
+		if (calmPeriods >= restoreHoldOff) {
+			snprintf(reason, sizeof(reason), "%s predicted at %.0f%% utilization when restored", cpuName(busiestCpu).c_str(),
+					predictedUtilization * 100.0);
+			enterNormalMode(reason);
+		}
+	}
+}
+
+/**
+ * This method will obtain the number of milliseconds spent in the current mode and start the timing of the next mode.
+ * @return The return will be the number of milliseconds since the last transition.
+ */
+int64_t OverloadManager::switchModeTime() {
+	struct timespec now;
+	getClock()->getTime(now);
+	int64_t duration = microsecondsBetween(now, modeStartTime) / 1000;
+	modeStartTime = now;
+	transitionCount++;
+	return duration;
+}
+
+/**
+ * This method will move the low criticality tasks into degraded mode.
+ * @param reason This is a human readable description of why the system is degraded.
+ */
+void OverloadManager::enterDegradedMode(const std::string &reason) {
+	struct timespec start;
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	/**
+	 * Remember the period of each task, so that it can be restored, and then slow it down or suspend it.  A task which is
+	 * still waiting to be restored keeps the normal period it is waiting for.
+	 */
+	for (ManagedTask &managed : managedTasks) {
+		if (managed.restorePending == false) {
+			managed.normalPeriod = managed.task->getTaskPeriod();
+		}
+		if (managed.degradedPeriod == 0) {
+			managed.task->setSuspended(true);
+		} else if (managed.degradedPeriod > managed.normalPeriod) {
+			managed.task->setTaskPeriod(managed.degradedPeriod);
+		}
+	}
+	mode = MODE_DEGRADED;
+	calmPeriods = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	int64_t normalTime = switchModeTime();
+	Logger::log(LOG_WARNING, "%s: Entering degraded mode after %lld ms in normal mode: %s.  Shed %u tasks in %lld us.", myName.c_str(),
+			(long long) normalTime, reason.c_str(), (unsigned int) managedTasks.size(), (long long) microsecondsBetween(end, start));
+	for (ManagedTask &managed : managedTasks) {
+		if (managed.degradedPeriod == 0) {
+			Logger::log(LOG_INFO, "%s: Suspended %s.", myName.c_str(), managed.task->getName().c_str());
+		} else {
+			Logger::log(LOG_INFO, "%s: Slowed %s from a period of %u us to %u us.", myName.c_str(), managed.task->getName().c_str(),
+					managed.normalPeriod, managed.task->getTaskPeriod());
+		}
+	}
+}
+
+/**
+ * This method will restore the low criticality tasks.
+ * @param reason This is a human readable description of why the system is restored.
+ */
+void OverloadManager::enterNormalMode(const std::string &reason) {
+	struct timespec start;
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	/**
+	 * Resume the suspended tasks, and restore the period of each slowed task, unless it has been changed (for example,
+	 * through the control socket) while the system was degraded, in which case the new period is kept.
+	 */
+	for (ManagedTask &managed : managedTasks) {
+		if (managed.degradedPeriod == 0) {
+			managed.task->setSuspended(false);
+		} else if (managed.task->getTaskPeriod() == managed.degradedPeriod) {
+			managed.restorePending = true;
+		}
+	}
+	uint32_t refused = restorePendingTasks();
+	mode = MODE_NORMAL;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	int64_t degradedTime = switchModeTime();
+	Logger::log(LOG_WARNING, "%s: Returning to normal mode after %lld ms in degraded mode: %s.  Restored %u tasks in %lld us.",
+			myName.c_str(), (long long) degradedTime, reason.c_str(), (unsigned int) managedTasks.size() - refused,
+			(long long) microsecondsBetween(end, start));
+	if (refused > 0) {
+		Logger::log(LOG_WARNING, "%s: Admission control refused to restore %u tasks.  They are retried in each calm period.",
+				myName.c_str(), refused);
+	}
+}
+
+/**
+ * This method will try to restore the normal period of each task which is still waiting for it.
+ * @return The return will be the number of tasks whose normal period was refused by admission control.
+ */
+uint32_t OverloadManager::restorePendingTasks() {
+	uint32_t refused = 0;
+	for (ManagedTask &managed : managedTasks) {
+		if (managed.restorePending == false) {
+			continue;
+		}
+
+		/**
+		 * A task whose period has been changed since it was degraded keeps the new period.  Otherwise, the normal period
+		 * is only restored if admission control accepts it, which is seen in the period the task is left with.
+		 */
+		if (managed.task->getTaskPeriod() == managed.degradedPeriod) {
+			managed.task->setTaskPeriod(managed.normalPeriod);
+		}
+		if ((managed.task->getTaskPeriod() == managed.normalPeriod) || (managed.task->getTaskPeriod() != managed.degradedPeriod)) {
+			managed.restorePending = false;
+			Logger::log(LOG_INFO, "%s: Restored %s to a period of %u us.", myName.c_str(), managed.task->getName().c_str(),
+					managed.task->getTaskPeriod());
+		} else {
+			refused++;
+		}
+	}
+	pendingRestores = refused;
+	return refused;
+}
+
+/**
+ * This method will obtain the current mode of the system.
+ * @return The return will be the current mode.
+ */
+OverloadManager::Mode OverloadManager::getMode() {
+	return (Mode) mode.load();
+}
+
+/**
+ * This method will obtain the number of mode transitions.
+ * @return The return will be the number of mode transitions.
+ */
+uint32_t OverloadManager::getTransitionCount() {
+	return transitionCount;
+}
+
+/**
+ * This method will obtain the number of low criticality tasks which have not been restored to their normal period,
+ * because admission control refused it.  They are retried in each calm period of the normal mode.
+ * @return The return will be the number of tasks waiting to be restored.
+ */
+uint32_t OverloadManager::getPendingRestoreCount() {
+	return pendingRestores;
+}
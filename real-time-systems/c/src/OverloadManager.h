@@ -0,0 +1,321 @@
+/**
+ * @file OverloadManager.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a periodic task which protects the high criticality tasks
+ *      when the CPU is overloaded.  Each period, it measures the deadline misses
+ *      of the high criticality tasks and the utilization of each CPU from the
+ *      statistics of every running periodic task.  If a threshold is crossed, it
+ *      moves the system into a degraded mode, in which the designated low
+ *      criticality tasks run at a lower rate or are suspended.  Once the
+ *      utilization with the low criticality tasks restored is predicted to be
+ *      below the restore threshold, and no deadlines have been missed for a
+ *      number of periods, the tasks are restored.  Every transition is logged
+ *      with what caused it and how long it took.
+ *
+ *      The manager should run at a higher priority than the tasks it manages, so
+ *      that it still runs when they saturate the CPU.
+ */
+
+#ifndef OVERLOADMANAGER_H_
+#define OVERLOADMANAGER_H_
+
+#include "PeriodicTask.h"
+
+#include <list>
+#include <vector>
+#include <stdint.h>
+#include <time.h>
+
+class OverloadManager: public PeriodicTask {
+public:
+	/**
+	 * This is the largest number of running tasks which the manager measures.
+	 */
+	static const int MAXIMUM_TASKS = 64;
+
+	/**
+	 * This enumeration defines the modes of the system.
+	 */
+	enum Mode {
+		MODE_NORMAL, /**< Every task runs at its configured rate. */
+		MODE_DEGRADED /**< The low criticality tasks run at their degraded rate or are suspended. */
+	};
+
+private:
+	/**
+	 * This structure holds a low criticality task and how it is degraded.
+	 */
+	struct ManagedTask {
+		/**
+		 * This is the task.
+		 */
+		PeriodicTask *task;
+
+		/**
+		 * This is the period of the task in degraded mode, in microseconds.  0 means the task is suspended.
+		 */
+		uint32_t degradedPeriod;
+
+		/**
+		 * This is the period of the task when it was degraded, which is restored when the system returns to normal.
+		 */
+		uint32_t normalPeriod;
+
+		/**
+		 * This is true if the normal period is still to be restored, because admission control refused it when the system
+		 * returned to normal.
+		 */
+		bool restorePending;
+
+		/**
+		 * This is the mean CPU time of an execution of the task, in microseconds, used to predict the utilization when the
+		 * task is restored.
+		 */
+		double meanExecutionTime;
+	};
+
+	/**
+	 * This structure holds the statistics of a task at the last period of the manager.
+	 */
+	struct TaskSample {
+		/**
+		 * This is the task which was sampled.
+		 */
+		PeriodicTask *task;
+
+		/**
+		 * This is the number of the last period in which the task was running.
+		 */
+		uint32_t generation;
+
+		/**
+		 * This is the reset epoch of the statistics.
+		 */
+		uint32_t epoch;
+
+		/**
+		 * This is the number of deadline misses.
+		 */
+		uint32_t deadlineMisses;
+
+		/**
+		 * This is the number of activations.
+		 */
+		uint64_t activations;
+
+		/**
+		 * This is the total CPU time in microseconds.
+		 */
+		int64_t totalExecutionTime;
+	};
+
+	/**
+	 * These are the low criticality tasks.
+	 */
+	std::list<ManagedTask> managedTasks;
+
+	/**
+	 * These are the statistics of each running task at the last period.  They are kept in a fixed table, so that the manager
+	 * does not allocate memory as it runs.
+	 */
+	TaskSample samples[MAXIMUM_TASKS];
+
+	/**
+	 * This is the number of entries of the sample table which are in use.
+	 */
+	int sampleCount;
+
+	/**
+	 * This is the number of the current period, which marks the samples of the tasks that are still running.
+	 */
+	uint32_t sampleGeneration;
+
+	/**
+	 * This is the utilization of each CPU in the current period.  The first entry is the tasks which are not bound to a CPU,
+	 * and entry n + 1 is CPU n.  It is sized when the manager is constructed.
+	 */
+	std::vector<double> cpuUtilization;
+
+	/**
+	 * This is the time of the last period, on the task's clock.  It is 0 before the first period.
+	 */
+	struct timespec previousSampleTime;
+
+	/**
+	 * This is the number of CPUs which the tasks that are not bound to a CPU are spread across.  Their combined utilization
+	 * is divided by it, so that it can be compared with the thresholds of a single CPU.
+	 */
+	int unboundCpuCount;
+
+	/**
+	 * This is the utilization of a CPU, from 0 to 1, at or above which the system is degraded.
+	 */
+	double degradeUtilization;
+
+	/**
+	 * This is the number of deadline misses by the high criticality tasks in a single period at or above which the
+	 * system is degraded.
+	 */
+	uint32_t degradeMisses;
+
+	/**
+	 * This is the predicted utilization of every CPU, with the low criticality tasks restored, below which the system may
+	 * return to normal.
+	 */
+	double restoreUtilization;
+
+	/**
+	 * This is the number of consecutive periods in which the system must be able to return to normal before it does.
+	 */
+	uint32_t restoreHoldOff;
+
+	/**
+	 * This is the number of consecutive periods in which the system has been able to return to normal.
+	 */
+	uint32_t calmPeriods;
+
+	/**
+	 * This is the number of low criticality tasks whose normal period is still to be restored.
+	 */
+	std::atomic<uint32_t> pendingRestores;
+
+	/**
+	 * This is the current mode of the system.
+	 */
+	std::atomic<int> mode;
+
+	/**
+	 * This is the number of mode transitions.
+	 */
+	std::atomic<uint32_t> transitionCount;
+
+	/**
+	 * This is the time of the last mode transition, on the task's clock.
+	 */
+	struct timespec modeStartTime;
+
+	/**
+	 * This method will determine if the given task is one of the low criticality tasks.
+	 * @param task This is the task.
+	 * @return The return will be the managed task, or NULL if the task is not a low criticality task.
+	 */
+	ManagedTask* findManagedTask(PeriodicTask *task);
+
+	/**
+	 * This method will find the sample of the given task from the last period.
+	 * @param task This is the task.
+	 * @return The return will be the sample, or NULL if the task was not sampled.
+	 */
+	TaskSample* findSample(PeriodicTask *task);
+
+	/**
+	 * This method will obtain the entry of the utilization table which a CPU is counted in.
+	 * @param cpu This is the CPU, or -1 for the tasks which are not bound to a CPU.
+	 * @return The return will be the index into the utilization table.
+	 */
+	size_t cpuSlot(int cpu);
+
+	/**
+	 * This method will move the low criticality tasks into degraded mode.
+	 * @param reason This is a human readable description of why the system is degraded.
+	 */
+	void enterDegradedMode(const std::string &reason);
+
+	/**
+	 * This method will restore the low criticality tasks.
+	 * @param reason This is a human readable description of why the system is restored.
+	 */
+	void enterNormalMode(const std::string &reason);
+
+	/**
+	 * This method will try to restore the normal period of each task which is still waiting for it.
+	 * @return The return will be the number of tasks whose normal period was refused by admission control.
+	 */
+	uint32_t restorePendingTasks();
+
+	/**
+	 * This method will obtain the number of milliseconds spent in the current mode and start the timing of the next mode.
+	 * @return The return will be the number of milliseconds since the last transition.
+	 */
+	int64_t switchModeTime();
+
+public:
+	/**
+	 * This is the constructor for the class.
+	 * @param threadName This is the name of the thread in a human readable format.
+	 * @param period This is the period for the task, given in microseconds.  It is the interval over which the deadline
+	 * misses and the utilization are measured.  The manager must be constructed after the cores for real time tasks have
+	 * been reserved, as the CPUs available to the tasks which are not bound to a CPU are counted then.
+	 */
+	OverloadManager(std::string threadName, uint32_t period);
+
+	/**
+	 * This is the destructor for the class.  If the system is degraded, the low criticality tasks are restored.
+	 */
+	virtual ~OverloadManager();
+
+	/**
+	 * This method will designate a task as low criticality.  It must be called before the manager is started.
+	 * @param task This is the task.
+	 * @param degradedPeriod This is the period of the task in degraded mode, given in microseconds.  0 means the task is
+	 * suspended in degraded mode.
+	 */
+	void addLowCriticalityTask(PeriodicTask *task, uint32_t degradedPeriod);
+
+	/**
+	 * This method will set the thresholds of the manager.  It must be called before the manager is started.
+	 * @param degradeUtilization This is the utilization of a CPU, from 0 to 1, at or above which the system is degraded.
+	 * @param degradeMisses This is the number of deadline misses by the high criticality tasks in a single period at or
+	 * above which the system is degraded.  0 means deadline misses do not degrade the system.
+	 * @param restoreUtilization This is the predicted utilization of every CPU below which the system may return to normal.
+	 * @param restoreHoldOff This is the number of consecutive periods in which the system must be able to return to normal
+	 * before it does.
+	 */
+	void setThresholds(double degradeUtilization, uint32_t degradeMisses, double restoreUtilization, uint32_t restoreHoldOff);
+
+	/**
+	 * This is the task method.  It measures the load and changes the mode if a threshold has been crossed.
+	 */
+	virtual void taskMethod();
+
+	/**
+	 * This method will obtain the current mode of the system.
+	 * @return The return will be the current mode.
+	 */
+	Mode getMode();
+
+	/**
+	 * This method will obtain the number of mode transitions.
+	 * @return The return will be the number of mode transitions.
+	 */
+	uint32_t getTransitionCount();
+
+	/**
+	 * This method will obtain the number of low criticality tasks which have not been restored to their normal period,
+	 * because admission control refused it.  They are retried in each calm period of the normal mode.
+	 * @return The return will be the number of tasks waiting to be restored.
+	 */
+	uint32_t getPendingRestoreCount();
+};
+
+#endif /* OVERLOADMANAGER_H_ */
@@ -0,0 +1,49 @@
+/**
+ * @file ParallelJob.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This interface is a job which is split into lanes that can run in parallel,
+ *      such as the slices of a frame.  A WorkerPool runs every lane of the job on
+ *      its own thread and returns once all of them are complete.
+ */
+
+#ifndef PARALLELJOB_H_
+#define PARALLELJOB_H_
+
+class ParallelJob {
+public:
+	/**
+	 * This is the destructor for the class.
+	 */
+	virtual ~ParallelJob() {
+	}
+
+	/**
+	 * This method will carry out one lane of the job.  It is called once for every lane, each on a different thread, and
+	 * must only touch the part of the work which belongs to its lane.
+	 * @param lane This is the lane, from 0 to laneCount - 1.
+	 * @param laneCount This is the number of lanes the job is split into.
+	 */
+	virtual void runLane(int lane, int laneCount) = 0;
+};
+
+#endif /* PARALLELJOB_H_ */
@@ -26,9 +26,21 @@
  */
 
 #include "PeriodicTask.h"
+#include "SchedulabilityAnalyzer.h"
+#include "TraceBuffer.h"
+#include "AllocationCounter.h"
+#include "Logger.h"
 #include <iostream>
-#include <chrono>
 #include <iomanip>
+#include <algorithm>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+/**
+ * This is the number of activations after which a task is considered to be in a steady state, having allocated its
+ * buffers and warmed up its caches.
+ */
+#define STEADY_STATE_ACTIVATIONS (10)
 
 /**
  * This is the default constructor for the class.
@@ -37,7 +49,7 @@
  * Must be at least 100 microseconds.
  */
 PeriodicTask::PeriodicTask(std::string threadName, uint32_t period) :
-		RunnableClass(threadName) {
+		RunnableClass(threadName), taskPeriod(100000), requestedEpoch(0), releaseRequested(false), suspended(false), clock(TaskClock::getSystemClock()) {
 	this->setTaskPeriod(period);
 }
 
@@ -60,121 +72,474 @@ void PeriodicTask::setTaskPeriod(uint32_t period) {
 	 * Set the task period to the parameter passed in if it is greater than or equal to 100.
 	 */
 	if (period >= 100) {
+		/**
+		 * If the task is already running, evaluate the task set with the new period first, and keep the current period if
+		 * the change is refused.  The task never runs with a period which has not been admitted.
+		 */
+		TaskTimingModel model;
+		if (isStarted() && getTimingModel(model)) {
+			model.period = period;
+			model.deadline = period;
+			if (model.deadlineScheduled) {
+				model.worstCaseExecutionTime = std::min(model.worstCaseExecutionTime, period);
+			}
+			if (SchedulabilityAnalyzer::reevaluate(this, model) == false) {
+				return;
+			}
+		}
+
+		/**
+		 * If SCHED_DEADLINE has been requested, the kernel's period and deadline must follow the task period, and the
+		 * runtime budget may not exceed it, as in useDeadlineScheduling.  If the kernel refuses the change, the task keeps
+		 * the period which the kernel is still using.
+		 */
+		if (deadlineRequested) {
+			uint64_t runtime = std::min(deadlineRuntime, (uint64_t) period * 1000);
+			if (setDeadlineParameters(runtime, period * 1000ULL, period * 1000ULL) == false) {
+				return;
+			}
+			executionBudget = std::min(executionBudget, period);
+		}
 		taskPeriod = period;
+
+		/**
+		 * Wake the task if it is waiting, so that it waits for the new period rather than the old one.
+		 */
+		wakeup.signal();
 	}
 }
 
-
-
+/**
+ * This method will obtain the task period for this class.
+ * @return the Period for the task in microseconds.
+ */
 uint32_t PeriodicTask::getTaskPeriod()
 {
 	return taskPeriod;
 }
 
 /**
- * This method will suspend execution until the next period has been reached.  It will do this by blocking.
+ * This method will release the task immediately, rather than at the end of its current period.
  */
-void PeriodicTask::waitForNextExecution(
-		std::chrono::microseconds remainingSleepTime) {
-	/**
-	 * Sleep for the given amount of time.
-	 */
-	std::this_thread::sleep_for(remainingSleepTime);
+void PeriodicTask::releaseNow() {
+	releaseRequested = true;
+	wakeup.signal();
 }
 
 /**
- * This method will print out information about the given thread.  The info will be dependent upon the given thread.
+ * This method will suspend or resume the task.  A suspended task is not released until it is resumed.
+ * @param suspend This is true to suspend the task or false to resume it.
  */
-void PeriodicTask::printInformation() {
-	std::cout << myOSThreadID << "\t" << std::setw(18) << myName << "\t "
-			<< std::setw(5) << getPriority() << "\t "
-			<< std::setw(10) << taskPeriod << "\t "
-			<< std::setw(18) << lastExecutionTime << "\t "
-			<< std::setw(8) << worstCaseExecutionTime << "\t "
-			<< std::setw(18) << lastWallTime.count() << "\t "
-			<< std::setw(8) <<worstCaseWallTime.count() << "\n";
+void PeriodicTask::setSuspended(bool suspend) {
+	suspended = suspend;
+	wakeup.signal();
 }
 
 /**
- * This method will reset thread diagnostics back to their default values.
+ * This method will determine if the task is suspended.
+ * @return The return will be true if the task is suspended or false otherwise.
  */
-void PeriodicTask::resetThreadDiagnostics() {
-	// Reset all diagnostic variables to zero.
-	worstCaseExecutionTime = 0;
-	lastExecutionTime = 0;
-	lastWallTime = std::chrono::microseconds(0);
-	worstCaseWallTime = std::chrono::microseconds(0);
+bool PeriodicTask::isSuspended() {
+	return suspended;
 }
 
 /**
- * This is a private method that will be used by start to invoke the run method.
+ * This method will set the clock which the task uses.  It must be called before the task is started.
+ * @param newClock This is the clock.
  */
-void PeriodicTask::run() {
+void PeriodicTask::setClock(TaskClock *newClock) {
+	clock->detachTask(this);
+	clock = newClock;
+	clock->attachTask(this);
+}
+
+/**
+ * This method will obtain the clock which the task uses.
+ * @return The return will be the clock.
+ */
+TaskClock* PeriodicTask::getClock() {
+	return clock;
+}
+
+/**
+ * This method will set the execution budget for the task.
+ * @param budget This is the expected worst case execution time of the task, given in microseconds.
+ */
+void PeriodicTask::setExecutionBudget(uint32_t budget) {
+	executionBudget = budget;
+}
+
+/**
+ * This method will obtain the execution budget for the task.
+ * @return The return will be the execution budget in microseconds.
+ */
+uint32_t PeriodicTask::getExecutionBudget() {
+	return executionBudget;
+}
+
+/**
+ * This method will request that the task be scheduled with SCHED_DEADLINE rather than SCHED_FIFO.
+ * @param runtimeBudget This is the runtime budget for each period, given in microseconds.
+ */
+void PeriodicTask::useDeadlineScheduling(uint32_t runtimeBudget) {
 	/**
-	 * Set keep going to be true, to indicate that the thread is to continue running.
+	 * The runtime budget may not exceed the period.
 	 */
-	keepGoing = true;
+	if (runtimeBudget > taskPeriod) {
+		runtimeBudget = taskPeriod;
+	}
+	executionBudget = runtimeBudget;
+	setDeadlineParameters(runtimeBudget * 1000ULL, taskPeriod * 1000ULL, taskPeriod * 1000ULL);
+}
 
-	while (keepGoing == true) {
-		// Get the start time for the given iteration of the task.
-		clockid_t threadTimer;
-		struct timespec startTs;
-		struct timespec endTs;
+/**
+ * This method will obtain the number of executions whose CPU time exceeded the execution budget.
+ * @return The return will be the number of budget overruns.
+ */
+uint32_t PeriodicTask::getBudgetOverruns() {
+	TaskStatistics snapshot;
+	getStatistics(snapshot);
+	return snapshot.budgetOverruns;
+}
 
-		/**
-		 * The following gets the wall time, for determining next execution time.
-		 */
-		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+/**
+ * This method will obtain a consistent snapshot of the execution statistics of the task, as of the end of its last
+ * period.  It may be called from any thread, and never blocks the task.
+ * @param snapshot This is the structure that is to be filled in.
+ */
+void PeriodicTask::getStatistics(TaskStatistics &snapshot) {
+	publishedStatistics.read(snapshot);
+	snapshot.period = taskPeriod;
+}
 
-		/**
-		 * Obtain the cpu time at the start of this periodic task. This is for CPU time measurement.
-		 **/
-		pthread_getcpuclockid(pthread_self(), &threadTimer);
-		clock_gettime(threadTimer, &startTs);
+/**
+ * This method will obtain the distribution of the wall times of the task.
+ * @return The return will be a reference to the wall time histogram.
+ */
+LatencyHistogram& PeriodicTask::getWallTimeHistogram() {
+	return wallTimeHistogram;
+}
 
+/**
+ * This method will obtain the timing model of the given task for schedulability analysis.
+ * @param model This is the model that is to be filled in.
+ * @return The return will be true, as a periodic task always has a timing model.
+ */
+bool PeriodicTask::getTimingModel(TaskTimingModel &model) {
+	model.name = myName;
+	model.period = taskPeriod;
+	model.deadline = taskPeriod;
+	model.priority = getPriority();
+	model.cpu = getBoundCpu();
+	/**
+	 * The task is modeled as SCHED_DEADLINE unless it has fallen back to SCHED_FIFO.
+	 */
+	model.deadlineScheduled = deadlineRequested && (activePolicy.load(std::memory_order_acquire) != POLICY_FIFO);
 
-		/**Now run the task.
-		 * Call the task method.
-		 */
-		this->taskMethod();
+	/**
+	 * Use the larger of the measured worst case execution time and the configured budget.  Under SCHED_DEADLINE the kernel
+	 * enforces the budget, so the budget is used.
+	 */
+	TaskStatistics snapshot;
+	getStatistics(snapshot);
+	model.worstCaseExecutionTime = executionBudget;
+	if ((model.deadlineScheduled == false) && (snapshot.worstCaseExecutionTime > (int64_t) executionBudget)) {
+		model.worstCaseExecutionTime = (uint32_t) snapshot.worstCaseExecutionTime;
+	}
+	return true;
+}
 
+/**
+ * This method is invoked by start before the thread is created.  It applies schedulability admission control.
+ * @return true if the task may be started.  False otherwise.
+ */
+bool PeriodicTask::admitTask() {
+	return SchedulabilityAnalyzer::admit(this);
+}
+
+/**
+ * This method will suspend execution until the next period has been reached.  It will do this by blocking on the
+ * wakeup event, so that a stop, a period change, or a release request takes effect immediately.
+ * @param releaseTime This is the release time of the current period, on the task's clock.  It is advanced to the release
+ * time of the next period.
+ */
+void PeriodicTask::waitForNextExecution(struct timespec &releaseTime) {
+	struct timespec now;
+
+	for (;;) {
 		/**
-		 *Now get the end CPU time entry.
-		 **/
-		clock_gettime(threadTimer, &endTs);
-		long deltaInus = (endTs.tv_sec * 1000000 + endTs.tv_nsec / 1000) - (startTs.tv_sec * 1000000 + startTs.tv_nsec / 1000);
+		 * 1.0 Read the generation before looking at the state, so that a wakeup after the checks is not missed.
+		 */
+		uint32_t generation = wakeup.getGeneration();
 
 		/**
-		 * Determine where we are in terms of the worst case execution time.
+		 * 2.0 A stop ends the wait at once.  A release request releases the task now, and the next period starts from now.
 		 */
-		if (deltaInus > worstCaseExecutionTime) {
-			worstCaseExecutionTime = deltaInus;
+		if (keepGoing == false) {
+			return;
+		}
+		if (releaseRequested.exchange(false)) {
+			clock->getTime(releaseTime);
+			return;
 		}
-		lastExecutionTime = deltaInus;
 
 		/**
-		 * Now figure out exactly what time it is to schedule the next execution.
+		 * 3.0 Wait for the end of the period.  The period is read again each time, so a new period applies to the current wait.
 		 */
-		std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+		uint64_t period = taskPeriod.load() * 1000ULL;
+		struct timespec nextRelease = releaseTime;
+		nextRelease.tv_sec += period / 1000000000ULL;
+		nextRelease.tv_nsec += period % 1000000000ULL;
+		if (nextRelease.tv_nsec >= 1000000000L) {
+			nextRelease.tv_nsec -= 1000000000L;
+			nextRelease.tv_sec++;
+		}
+		if (clock->waitUntil(nextRelease, wakeup, generation) == false) {
+			/**
+			 * 4.0 The period has ended.  Releases are kept on the absolute schedule, so they do not drift, unless the task
+			 * has fallen more than a period behind, in which case the schedule restarts from now.
+			 */
+			clock->getTime(now);
+			int64_t late = ((int64_t) (now.tv_sec - nextRelease.tv_sec) * 1000000000LL) + (now.tv_nsec - nextRelease.tv_nsec);
+			releaseTime = (late > (int64_t) period) ? now : nextRelease;
+			return;
+		}
+	}
+}
 
-		// Now figure out the difference.
-		std::chrono::microseconds executionTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+/**
+ * This method will print out information about the given thread.  The info will be dependent upon the given thread.
+ */
+void PeriodicTask::printInformation() {
+	TaskStatistics snapshot;
+	getStatistics(snapshot);
 
-		lastWallTime = executionTime;
-		if (lastWallTime > worstCaseWallTime) {
-			worstCaseWallTime = lastWallTime;
-		}
+	std::cout << myOSThreadID.load(std::memory_order_acquire) << "\t" << std::setw(18) << myName << "\t "
+			<< std::setw(5) << getPriority() << "\t"
+			<< getSchedulingPolicyName() << "\t"
+			<< getCurrentCpu() << "\t"
+			<< getMigrationCount() << "\t "
+			<< std::setw(10) << taskPeriod << "\t "
+			<< std::setw(18) << snapshot.lastExecutionTime << "\t "
+			<< std::setw(8) << snapshot.worstCaseExecutionTime << "\t "
+			<< std::setw(18) << snapshot.lastWallTime << "\t "
+			<< std::setw(8) << snapshot.worstCaseWallTime << "\t "
+			<< std::setw(8) << snapshot.budgetOverruns << "\t "
+			<< std::setw(8) << getThrottleCount() << "\t "
+			<< std::setw(6) << snapshot.lastPageFaults << "\t "
+			<< std::setw(6) << snapshot.worstCasePageFaults << "\n";
+}
 
+/**
+ * This method will reset thread diagnostics back to their default values.  If the task is running, the reset is applied
+ * by the task at the start of its next period.
+ */
+void PeriodicTask::resetThreadDiagnostics() {
+	/**
+	 * Request the reset by starting a new epoch.  If the thread is not running, nothing can race with the reset, so apply it now.
+	 */
+	uint32_t epoch = requestedEpoch.fetch_add(1) + 1;
+	if (isStarted() == false) {
+		applyReset(epoch);
+	}
+}
+
+/**
+ * This method will reset the statistics to their default values, starting the given epoch.  It is only called by the
+ * task's own thread, or before the thread has started.
+ * @param epoch This is the epoch which is starting.
+ */
+void PeriodicTask::applyReset(uint32_t epoch) {
+	statistics = TaskStatistics();
+	statistics.epoch = epoch;
+	wallTimeHistogram.reset();
+	throttleCount = 0;
+	publishedStatistics.write(statistics);
+}
+
+/**
+ * This function will obtain the difference between two times of the same clock in microseconds.
+ * @param later This is the later time.
+ * @param earlier This is the earlier time.
+ * @return The return will be the difference in microseconds.
+ */
+static int64_t microsecondsBetween(const struct timespec &later, const struct timespec &earlier) {
+	return ((int64_t) (later.tv_sec - earlier.tv_sec) * 1000000LL) + ((later.tv_nsec - earlier.tv_nsec) / 1000);
+}
+
+/**
+ * This is a private method that will be used by start to invoke the run method.
+ */
+void PeriodicTask::run() {
+	/**
+	 * The first period starts now.  keepGoing was set by start, so a stop which arrives before the thread runs is not lost.
+	 */
+	struct timespec releaseTime;
+	clock->getTime(releaseTime);
+
+	while (keepGoing == true) {
 		/**
-		 * Figure out how long to sleep.
+		 * Execute the task for this period, unless it has been suspended.  A suspended task keeps its schedule, so that it
+		 * resumes in phase.
 		 */
-		std::chrono::microseconds remainingSleepTime =
-				std::chrono::microseconds(taskPeriod) - executionTime;
+		if (suspended == false) {
+			executeRelease(releaseTime);
+		}
 
 		/**
-		 * Sleep until the next execution should occur.
+		 * Wait until the next execution should occur.
 		 */
-		waitForNextExecution(remainingSleepTime);
+		waitForNextExecution(releaseTime);
 	}
+
+	/**
+	 * The task no longer uses its clock.
+	 */
+	clock->detachTask(this);
 }
 
+/**
+ * This method will execute the task method once, for the release at the given time, and account for the execution in
+ * the statistics: the CPU time, the wall time, the response time from the release, the release jitter, page faults,
+ * budget overruns and deadline misses.  The deadline is the end of the period.
+ * @param releaseTime This is the time of the task's clock at which the task was released.
+ * @return The return will be the CPU time of the execution in microseconds.
+ */
+long PeriodicTask::executeRelease(const struct timespec &releaseTime) {
+	// Get the start time for the given iteration of the task.
+	clockid_t threadTimer;
+	struct timespec startTs;
+	struct timespec endTs;
+	struct timespec start;
+	struct timespec end;
+
+	/**
+	 * The following gets the wall time at the start of the execution.
+	 */
+	clock->getTime(start);
+
+	/**
+	 * Obtain the cpu time at the start of this periodic task. This is for CPU time measurement.
+	 **/
+	pthread_getcpuclockid(pthread_self(), &threadTimer);
+	clock_gettime(threadTimer, &startTs);
+
+	/**
+	 * Obtain the page fault counts of this thread at the start of the period.
+	 */
+	struct rusage startUsage;
+	getrusage(RUSAGE_THREAD, &startUsage);
+
+	/**
+	 * Apply a reset of the statistics if one has been requested since the last period.
+	 */
+	uint32_t epoch = requestedEpoch.load(std::memory_order_acquire);
+	if (epoch != statistics.epoch) {
+		applyReset(epoch);
+	}
+
+	/**
+	 * Record the release and the start of the execution in the trace buffer.
+	 */
+	statistics.activations++;
+	uint32_t activation = (uint32_t) statistics.activations;
+	TraceBuffer::record(TRACE_INSTANT, STAGE_TASK_RELEASE, activation, 0);
+	TraceBuffer::record(TRACE_BEGIN, STAGE_TASK_EXECUTION, activation, 0);
+
+	/**Now run the task.
+	 * Call the task method, counting the heap allocations it makes.
+	 */
+	uint64_t allocationsBefore = AllocationCounter::getThreadAllocations();
+	this->taskMethod();
+	statistics.lastAllocations = AllocationCounter::getThreadAllocations() - allocationsBefore;
+
+	TraceBuffer::record(TRACE_END, STAGE_TASK_EXECUTION, activation, 0);
+
+	/**
+	 *Now get the end CPU time entry.
+	 **/
+	clock_gettime(threadTimer, &endTs);
+	long deltaInus = (endTs.tv_sec * 1000000 + endTs.tv_nsec / 1000) - (startTs.tv_sec * 1000000 + startTs.tv_nsec / 1000);
+
+	/**
+	 * Let the clock account for the execution.  The system clock keeps the measured CPU time, while a simulated clock
+	 * replaces it with a modeled one and serves it in simulated time.
+	 */
+	deltaInus = clock->accountExecution(this, deltaInus);
+
+	/**
+	 * Determine where we are in terms of the worst case execution time.
+	 */
+	if (deltaInus > statistics.worstCaseExecutionTime) {
+		statistics.worstCaseExecutionTime = deltaInus;
+	}
+	statistics.lastExecutionTime = deltaInus;
+	statistics.totalExecutionTime += deltaInus;
+
+	/**
+	 * Determine how many page faults (minor and major) the task took this period.
+	 */
+	struct rusage endUsage;
+	getrusage(RUSAGE_THREAD, &endUsage);
+	statistics.lastPageFaults = (endUsage.ru_minflt - startUsage.ru_minflt) + (endUsage.ru_majflt - startUsage.ru_majflt);
+	if (statistics.lastPageFaults > statistics.worstCasePageFaults) {
+		statistics.worstCasePageFaults = statistics.lastPageFaults;
+	}
+
+	/**
+	 * Involuntary context switches during the execution mean the task was preempted.  Mark them in the trace.
+	 */
+	long preemptions = endUsage.ru_nivcsw - startUsage.ru_nivcsw;
+	if (preemptions > 0) {
+		TraceBuffer::record(TRACE_INSTANT, STAGE_PREEMPTION, activation, (uint32_t) preemptions);
+	}
+
+	/**
+	 * Once the task has reached a steady state, its executions should not allocate from the heap.
+	 */
+	if ((statistics.activations > STEADY_STATE_ACTIVATIONS) && (statistics.lastAllocations > 0)) {
+		statistics.steadyStateAllocations += statistics.lastAllocations;
+		LOG_RATE_LIMITED(1, LOG_WARNING, "%s: Made %lld heap allocations in activation %llu.", myName.c_str(),
+				(long long) statistics.lastAllocations, (unsigned long long) statistics.activations);
+	}
+
+	/**
+	 * Count the execution as a budget overrun if it used more CPU time than it was budgeted.
+	 */
+	if ((executionBudget > 0) && (deltaInus > (long) executionBudget)) {
+		statistics.budgetOverruns++;
+	}
+
+	/**
+	 * Now figure out the wall time of the execution, the response time from the release, and the release jitter, which
+	 * is how late the execution started after the release.
+	 */
+	clock->getTime(end);
+	statistics.lastWallTime = microsecondsBetween(end, start);
+	if (statistics.lastWallTime > statistics.worstCaseWallTime) {
+		statistics.worstCaseWallTime = statistics.lastWallTime;
+	}
+	wallTimeHistogram.record(statistics.lastWallTime);
+
+	statistics.lastResponseTime = microsecondsBetween(end, releaseTime);
+	if (statistics.lastResponseTime > statistics.worstCaseResponseTime) {
+		statistics.worstCaseResponseTime = statistics.lastResponseTime;
+	}
+	statistics.lastReleaseJitter = microsecondsBetween(start, releaseTime);
+	if (statistics.lastReleaseJitter > statistics.worstCaseReleaseJitter) {
+		statistics.worstCaseReleaseJitter = statistics.lastReleaseJitter;
+	}
+
+	/**
+	 * The deadline is the end of the period, so an execution which did not complete within a period of its release missed it.
+	 */
+	if (statistics.lastResponseTime > (int64_t) taskPeriod.load()) {
+		statistics.deadlineMisses++;
+	}
+
+	/**
+	 * Publish the statistics of this period for the other threads.
+	 */
+	publishedStatistics.write(statistics);
+	return deltaInus;
+}
@@ -29,7 +29,12 @@
 #define PERIODICTASK_H_
 
 #include "RunnableClass.h"
+#include "LatencyHistogram.h"
+#include "TaskStatistics.h"
+#include "SeqLock.h"
+#include "TaskClock.h"
 
+#include <atomic>
 #include <chrono>
 
 class PeriodicTask: public RunnableClass {
@@ -37,29 +42,34 @@ private:
 	/**
 	 * This variable sets the period for the task.  The period defines the length of
 	 * time from one invocation until the next invocation.  The task period is given
-	 * in microseconds.  Default value is 100 ms or 100000 microseconds.
+	 * in microseconds.  Default value is 100 ms or 100000 microseconds.  It may be changed from another thread while the
+	 * task runs, and takes effect at the end of the current period.
 	 */
-	uint32_t taskPeriod = 100000;
+	std::atomic<uint32_t> taskPeriod;
 
 	/**
-	 * This variable stores the worst case execution time from a CPU time standpoint.
+	 * This variable holds the configured execution budget in microseconds.  It is the expected worst case execution time
+	 * of the task, and is used by the schedulability analysis before (and in addition to) the measured worst case execution time.
 	 */
-	long worstCaseExecutionTime = 0;
+	uint32_t executionBudget = 0;
 
 	/**
-	 * This variable holds the last execution value for the CPU, showing the time it took to execute.
+	 * These are the execution statistics of the task.  They are only ever written by the task's own thread, which publishes
+	 * a copy through the sequence lock at the end of each period for the other threads to read.
 	 */
-	long lastExecutionTime = 0;
+	TaskStatistics statistics;
+	SeqLock<TaskStatistics> publishedStatistics;
 
 	/**
-	 * This variable holds the last wall time measurement for the given periodic task.  The wall time is the time from the start to the end of the task running.
+	 * This is the reset epoch which has been requested by resetThreadDiagnostics.  The task's own thread applies the reset
+	 * at the start of its next period, so the reset never races with an update.
 	 */
-	std::chrono::microseconds lastWallTime = std::chrono::microseconds(0);
+	std::atomic<uint32_t> requestedEpoch;
 
 	/**
-	 * This variable holds the worst case wall time.  This is the worst case from start to finish of the given periodic task.
+	 * This is the distribution of the wall times of the task, used to report the percentiles.
 	 */
-	std::chrono::microseconds worstCaseWallTime = std::chrono::microseconds(0);
+	LatencyHistogram wallTimeHistogram;
 
 	/**
 	 * This is a private method that will be used by start to invoke the run method.
@@ -67,13 +77,46 @@ private:
 	void invokeRun();
 
 	/**
-	 * This method will suspend execution until the next period has been reached.  It will do this by blocking.
+	 * This variable is set by releaseNow to release the task without waiting for the end of its period.
 	 */
-	void waitForNextExecution(std::chrono::microseconds remainingSleepTime);
+	std::atomic<bool> releaseRequested;
+
+	/**
+	 * This variable is true while the task is suspended.  A suspended task is not released.
+	 */
+	std::atomic<bool> suspended;
+
+	/**
+	 * This is the clock which the task reads the time from and waits on.  By default, it is the system clock.
+	 */
+	TaskClock *clock;
+
 	/**
-	 * This method will suspend execution until the next period has been reached.  It will do this by blocking.
+	 * This method will suspend execution until the next period has been reached.  It will do this by blocking on the
+	 * wakeup event, so that a stop, a period change, or a release request takes effect immediately.
+	 * @param releaseTime This is the release time of the current period, on the task's clock.  It is advanced to the release
+	 * time of the next period.
 	 */
-	void waitForNextExecution();
+	void waitForNextExecution(struct timespec &releaseTime);
+
+protected:
+	/**
+	 * This method will execute the task method once, for the release at the given time, and account for the execution in
+	 * the statistics.  The deadline is the end of the period.  It is used by the run method of this class and of the
+	 * derived task classes, so that all tasks are measured the same way.
+	 * @param releaseTime This is the time of the task's clock at which the task was released.
+	 * @return The return will be the CPU time of the execution in microseconds.
+	 */
+	long executeRelease(const struct timespec &releaseTime);
+
+private:
+
+	/**
+	 * This method will reset the statistics to their default values, starting the given epoch.  It is only called by the
+	 * task's own thread, or before the thread has started.
+	 * @param epoch This is the epoch which is starting.
+	 */
+	void applyReset(uint32_t epoch);
 
 public:
 	/**
@@ -109,9 +152,87 @@ public:
 	virtual uint32_t getTaskPeriod() final;
 
 	/**
-	 * This is the run method for the class.
+	 * This method will release the task immediately, rather than at the end of its current period.  If the task is
+	 * executing, it is released again as soon as it completes.  The next period starts from this release.
+	 */
+	virtual void releaseNow();
+
+	/**
+	 * This method will suspend or resume the task.  A suspended task is not released until it is resumed.  It may be
+	 * called from any thread.
+	 * @param suspend This is true to suspend the task or false to resume it.
+	 */
+	virtual void setSuspended(bool suspend) final;
+
+	/**
+	 * This method will determine if the task is suspended.
+	 * @return The return will be true if the task is suspended or false otherwise.
+	 */
+	virtual bool isSuspended() final;
+
+	/**
+	 * This method will set the clock which the task uses, such as a VirtualClock to run it in simulated time.  It must be
+	 * called before the task is started.
+	 * @param newClock This is the clock.
+	 */
+	virtual void setClock(TaskClock *newClock) final;
+
+	/**
+	 * This method will obtain the clock which the task uses.
+	 * @return The return will be the clock.
 	 */
-	void run() final;
+	virtual TaskClock* getClock() final;
+
+	/**
+	 * This method will set the execution budget for the task.
+	 * @param budget This is the expected worst case execution time of the task, given in microseconds.
+	 */
+	virtual void setExecutionBudget(uint32_t budget) final;
+
+	/**
+	 * This method will obtain the execution budget for the task.
+	 * @return The return will be the execution budget in microseconds.
+	 */
+	virtual uint32_t getExecutionBudget() final;
+
+	/**
+	 * This method will request that the task be scheduled with SCHED_DEADLINE rather than SCHED_FIFO.  The runtime is the
+	 * execution budget and the deadline and period are the task period.  If the kernel refuses (for example, due to
+	 * insufficient privileges), the task falls back to SCHED_FIFO with its priority.
+	 * @param runtimeBudget This is the runtime budget for each period, given in microseconds.
+	 */
+	virtual void useDeadlineScheduling(uint32_t runtimeBudget) final;
+
+	/**
+	 * This method will obtain the number of executions whose CPU time exceeded the execution budget.
+	 * @return The return will be the number of budget overruns.
+	 */
+	virtual uint32_t getBudgetOverruns() final;
+
+	/**
+	 * This method will obtain a consistent snapshot of the execution statistics of the task, as of the end of its last
+	 * period.  It may be called from any thread, and never blocks the task.
+	 * @param snapshot This is the structure that is to be filled in.
+	 */
+	virtual void getStatistics(TaskStatistics &snapshot) final;
+
+	/**
+	 * This method will obtain the distribution of the wall times of the task.
+	 * @return The return will be a reference to the wall time histogram.
+	 */
+	virtual LatencyHistogram& getWallTimeHistogram() final;
+
+	/**
+	 * This method will obtain the timing model of the given task for schedulability analysis.
+	 * @param model This is the model that is to be filled in.
+	 * @return The return will be true, as a periodic task always has a timing model.
+	 */
+	virtual bool getTimingModel(TaskTimingModel &model);
+
+	/**
+	 * This is the run method for the class.  It releases the task once each period.
+	 */
+	virtual void run();
 
 	/**
 	 * This method will print out information about the given thread.  The info will be dependent upon the given thread.
@@ -120,9 +241,17 @@ public:
 
 	/**
 	 * This method will reset thread diagnostics back to their default values.  The wall times and CPU times will be set to 0.
+	 * If the task is running, the reset is applied by the task at the start of its next period.
 	 */
 	virtual void resetThreadDiagnostics();
 
+protected:
+	/**
+	 * This method is invoked by start before the thread is created.  It applies schedulability admission control.
+	 * @return true if the task may be started.  False otherwise.
+	 */
+	virtual bool admitTask();
+
 };
 
 #endif /* PERIODICTASK_H_ */
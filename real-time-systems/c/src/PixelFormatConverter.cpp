@@ -0,0 +1,437 @@
+/**
+ * @file PixelFormatConverter.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class converts the rows of a BGR image into the pixel formats of the
+ *      stream.
+ */
+
+#include "PixelFormatConverter.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * This method will limit a value to the range of a byte.
+ * @param value This is the value.
+ * @return The return will be the value, limited to 0 to 255.
+ */
+static inline uint8_t clampByte(int value) {
+	return (value < 0) ? 0 : ((value > 255) ? 255 : value);
+}
+
+/**
+ * These methods convert a pixel to luma and to the two chroma components.  They are the reference for the vector code.
+ * @param b This is the blue of the pixel.
+ * @param g This is the green of the pixel.
+ * @param r This is the red of the pixel.
+ * @return The return will be the component.
+ */
+static inline uint8_t luma(int b, int g, int r) {
+	return ((77 * r) + (150 * g) + (29 * b) + 128) >> 8;
+}
+static inline uint8_t chromaU(int b, int g, int r) {
+	return clampByte(((((-22) * r) - (42 * g) + (64 * b) + 64) >> 7) + 128);
+}
+static inline uint8_t chromaV(int b, int g, int r) {
+	return clampByte((((64 * r) - (54 * g) - (10 * b) + 64) >> 7) + 128);
+}
+
+#if defined(__SSE2__)
+/**
+ * This method will load 32 BGR pixels and separate them into their channels.  Interleaving the 96 bytes with
+ * themselves five times moves the byte at index i to index 32i modulo 95, which is where its channel and pixel put it.
+ * @param pixels This is the first pixel.
+ * @param channels This is filled in with the blue of the 32 pixels, then the green, then the red, two vectors each.
+ */
+static inline void loadChannels(const uint8_t *pixels, __m128i channels[6]) {
+	for (int index = 0; index < 6; index++) {
+		channels[index] = _mm_loadu_si128((const __m128i*) (pixels + (16 * index)));
+	}
+	for (int round = 0; round < 5; round++) {
+		__m128i mixed[6];
+		for (int index = 0; index < 3; index++) {
+			mixed[2 * index] = _mm_unpacklo_epi8(channels[index], channels[index + 3]);
+			mixed[(2 * index) + 1] = _mm_unpackhi_epi8(channels[index], channels[index + 3]);
+		}
+		for (int index = 0; index < 6; index++) {
+			channels[index] = mixed[index];
+		}
+	}
+}
+
+/**
+ * This method will compute the luma of 16 pixels.
+ * @param b This is the blue of the pixels.
+ * @param g This is the green of the pixels.
+ * @param r This is the red of the pixels.
+ * @return The return will be the luma of the pixels.
+ */
+static inline __m128i lumaVector(__m128i b, __m128i g, __m128i r) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i result[2];
+	for (int half = 0; half < 2; half++) {
+		__m128i b16 = (half == 0) ? _mm_unpacklo_epi8(b, zero) : _mm_unpackhi_epi8(b, zero);
+		__m128i g16 = (half == 0) ? _mm_unpacklo_epi8(g, zero) : _mm_unpackhi_epi8(g, zero);
+		__m128i r16 = (half == 0) ? _mm_unpacklo_epi8(r, zero) : _mm_unpackhi_epi8(r, zero);
+		__m128i sum = _mm_add_epi16(_mm_mullo_epi16(r16, _mm_set1_epi16(77)), _mm_mullo_epi16(g16, _mm_set1_epi16(150)));
+		sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_mullo_epi16(b16, _mm_set1_epi16(29)), _mm_set1_epi16(128)));
+		result[half] = _mm_srli_epi16(sum, 8);
+	}
+	return _mm_packus_epi16(result[0], result[1]);
+}
+
+/**
+ * This method will average each 2x2 block of a channel of 16 pixels of two rows.
+ * @param top This is the channel of the upper row.
+ * @param bottom This is the channel of the lower row.
+ * @return The return will be the 8 averages, as 16 bit lanes.
+ */
+static inline __m128i averageBlocks(__m128i top, __m128i bottom) {
+	const __m128i low = _mm_set1_epi16(0x00FF);
+	__m128i sum = _mm_add_epi16(_mm_and_si128(top, low), _mm_srli_epi16(top, 8));
+	sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_and_si128(bottom, low), _mm_srli_epi16(bottom, 8)));
+	return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+}
+
+/**
+ * This method will compute a chroma component of 8 pixels.
+ * @param b This is the blue of the pixels, as 16 bit lanes.
+ * @param g This is the green of the pixels, as 16 bit lanes.
+ * @param r This is the red of the pixels, as 16 bit lanes.
+ * @param cb This is the weight of blue.
+ * @param cg This is the weight of green.
+ * @param cr This is the weight of red.
+ * @return The return will be the component, as 16 bit lanes.
+ */
+static inline __m128i chromaVector(__m128i b, __m128i g, __m128i r, short cb, short cg, short cr) {
+	__m128i sum = _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(cb)), _mm_mullo_epi16(g, _mm_set1_epi16(cg)));
+	sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(cr)), _mm_set1_epi16(64)));
+	return _mm_add_epi16(_mm_srai_epi16(sum, 7), _mm_set1_epi16(128));
+}
+#elif defined(__ARM_NEON)
+/**
+ * This method will compute the luma of 16 pixels.
+ * @param pixels This is the blue, green and red of the pixels.
+ * @return The return will be the luma of the pixels.
+ */
+static inline uint8x16_t lumaVector(const uint8x16x3_t &pixels) {
+	uint16x8_t low = vmull_u8(vget_low_u8(pixels.val[2]), vdup_n_u8(77));
+	low = vmlal_u8(low, vget_low_u8(pixels.val[1]), vdup_n_u8(150));
+	low = vmlal_u8(low, vget_low_u8(pixels.val[0]), vdup_n_u8(29));
+	uint16x8_t high = vmull_u8(vget_high_u8(pixels.val[2]), vdup_n_u8(77));
+	high = vmlal_u8(high, vget_high_u8(pixels.val[1]), vdup_n_u8(150));
+	high = vmlal_u8(high, vget_high_u8(pixels.val[0]), vdup_n_u8(29));
+	return vcombine_u8(vrshrn_n_u16(low, 8), vrshrn_n_u16(high, 8));
+}
+#endif
+
+/**
+ * This method will convert a row to luma.
+ * @param row This is the BGR row.
+ * @param width This is the width of the row in pixels.
+ * @param output This is where the luma is written.
+ */
+static void packLumaRow(const uint8_t *row, int width, uint8_t *output) {
+	int x = 0;
+#if defined(__SSE2__)
+	for (; x + 32 <= width; x += 32) {
+		__m128i channels[6];
+		loadChannels(row + (3 * x), channels);
+		_mm_storeu_si128((__m128i*) (output + x), lumaVector(channels[0], channels[2], channels[4]));
+		_mm_storeu_si128((__m128i*) (output + x + 16), lumaVector(channels[1], channels[3], channels[5]));
+	}
+#elif defined(__ARM_NEON)
+	for (; x + 16 <= width; x += 16) {
+		vst1q_u8(output + x, lumaVector(vld3q_u8(row + (3 * x))));
+	}
+#endif
+	for (; x < width; x++) {
+		const uint8_t *pixel = row + (3 * x);
+		output[x] = luma(pixel[0], pixel[1], pixel[2]);
+	}
+}
+
+/**
+ * This method will convert two rows to luma and subsampled chroma, in one pass.  Each chroma sample is computed from
+ * the average of a 2x2 block of pixels.  The last column of an odd width row is averaged with itself.
+ * @param top This is the upper BGR row.
+ * @param bottom This is the lower BGR row, which is the upper row at the bottom of an odd height frame.
+ * @param width This is the width of the rows in pixels.
+ * @param yTop This is where the luma of the upper row is written.
+ * @param yBottom This is where the luma of the lower row is written, or NULL if there is no lower row.
+ * @param u This is where the U samples are written.
+ * @param v This is where the V samples are written.
+ */
+static void packYuv420Rows(const uint8_t *top, const uint8_t *bottom, int width, uint8_t *yTop, uint8_t *yBottom, uint8_t *u,
+		uint8_t *v) {
+	int x = 0;
+#if defined(__SSE2__)
+	for (; x + 32 <= width; x += 32) {
+		__m128i upper[6];
+		__m128i lower[6];
+		loadChannels(top + (3 * x), upper);
+		loadChannels(bottom + (3 * x), lower);
+		__m128i uHalves[2];
+		__m128i vHalves[2];
+		for (int half = 0; half < 2; half++) {
+			_mm_storeu_si128((__m128i*) (yTop + x + (16 * half)), lumaVector(upper[half], upper[2 + half], upper[4 + half]));
+			if (yBottom != NULL) {
+				_mm_storeu_si128((__m128i*) (yBottom + x + (16 * half)), lumaVector(lower[half], lower[2 + half], lower[4 + half]));
+			}
+			__m128i b = averageBlocks(upper[half], lower[half]);
+			__m128i g = averageBlocks(upper[2 + half], lower[2 + half]);
+			__m128i r = averageBlocks(upper[4 + half], lower[4 + half]);
+			uHalves[half] = chromaVector(b, g, r, 64, -42, -22);
+			vHalves[half] = chromaVector(b, g, r, -10, -54, 64);
+		}
+		_mm_storeu_si128((__m128i*) (u + (x / 2)), _mm_packus_epi16(uHalves[0], uHalves[1]));
+		_mm_storeu_si128((__m128i*) (v + (x / 2)), _mm_packus_epi16(vHalves[0], vHalves[1]));
+	}
+#elif defined(__ARM_NEON)
+	for (; x + 16 <= width; x += 16) {
+		uint8x16x3_t upper = vld3q_u8(top + (3 * x));
+		uint8x16x3_t lower = vld3q_u8(bottom + (3 * x));
+		vst1q_u8(yTop + x, lumaVector(upper));
+		if (yBottom != NULL) {
+			vst1q_u8(yBottom + x, lumaVector(lower));
+		}
+		int16x8_t b = vreinterpretq_s16_u16(vrshrq_n_u16(vpadalq_u8(vpaddlq_u8(upper.val[0]), lower.val[0]), 2));
+		int16x8_t g = vreinterpretq_s16_u16(vrshrq_n_u16(vpadalq_u8(vpaddlq_u8(upper.val[1]), lower.val[1]), 2));
+		int16x8_t r = vreinterpretq_s16_u16(vrshrq_n_u16(vpadalq_u8(vpaddlq_u8(upper.val[2]), lower.val[2]), 2));
+		int16x8_t sumU = vmlaq_n_s16(vmlaq_n_s16(vmulq_n_s16(b, 64), g, -42), r, -22);
+		int16x8_t sumV = vmlaq_n_s16(vmlaq_n_s16(vmulq_n_s16(b, -10), g, -54), r, 64);
+		vst1_u8(u + (x / 2), vqmovun_s16(vaddq_s16(vrshrq_n_s16(sumU, 7), vdupq_n_s16(128))));
+		vst1_u8(v + (x / 2), vqmovun_s16(vaddq_s16(vrshrq_n_s16(sumV, 7), vdupq_n_s16(128))));
+	}
+#endif
+	for (; x < width; x += 2) {
+		int next = (x + 1 < width) ? 3 : 0;
+		const uint8_t *a = top + (3 * x);
+		const uint8_t *c = bottom + (3 * x);
+		yTop[x] = luma(a[0], a[1], a[2]);
+		if (next != 0) {
+			yTop[x + 1] = luma(a[3], a[4], a[5]);
+		}
+		if (yBottom != NULL) {
+			yBottom[x] = luma(c[0], c[1], c[2]);
+			if (next != 0) {
+				yBottom[x + 1] = luma(c[3], c[4], c[5]);
+			}
+		}
+		int b = (a[0] + a[next] + c[0] + c[next] + 2) >> 2;
+		int g = (a[1] + a[next + 1] + c[1] + c[next + 1] + 2) >> 2;
+		int r = (a[2] + a[next + 2] + c[2] + c[next + 2] + 2) >> 2;
+		u[x / 2] = chromaU(b, g, r);
+		v[x / 2] = chromaV(b, g, r);
+	}
+}
+
+/**
+ * This method will convert a row to RGB565.
+ * @param row This is the BGR row.
+ * @param width This is the width of the row in pixels.
+ * @param output This is where the little endian RGB565 pixels are written.
+ */
+static void packRgb565Row(const uint8_t *row, int width, uint8_t *output) {
+	int x = 0;
+#if defined(__SSE2__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	const __m128i zero = _mm_setzero_si128();
+	for (; x + 32 <= width; x += 32) {
+		__m128i channels[6];
+		loadChannels(row + (3 * x), channels);
+		for (int quarter = 0; quarter < 4; quarter++) {
+			int vector = quarter / 2;
+			__m128i b = (quarter & 1) ? _mm_unpackhi_epi8(channels[vector], zero) : _mm_unpacklo_epi8(channels[vector], zero);
+			__m128i g = (quarter & 1) ? _mm_unpackhi_epi8(channels[2 + vector], zero) : _mm_unpacklo_epi8(channels[2 + vector], zero);
+			__m128i r = (quarter & 1) ? _mm_unpackhi_epi8(channels[4 + vector], zero) : _mm_unpacklo_epi8(channels[4 + vector], zero);
+			__m128i packed = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(r, _mm_set1_epi16(0xF8)), 8),
+					_mm_or_si128(_mm_slli_epi16(_mm_and_si128(g, _mm_set1_epi16(0xFC)), 3), _mm_srli_epi16(b, 3)));
+			_mm_storeu_si128((__m128i*) (output + (2 * (x + (8 * quarter)))), packed);
+		}
+	}
+#elif defined(__ARM_NEON) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	for (; x + 16 <= width; x += 16) {
+		uint8x16x3_t pixels = vld3q_u8(row + (3 * x));
+		uint8x16_t r = vandq_u8(pixels.val[2], vdupq_n_u8(0xF8));
+		uint8x16_t g = vandq_u8(pixels.val[1], vdupq_n_u8(0xFC));
+		uint8x16_t b = vshrq_n_u8(pixels.val[0], 3);
+		uint16x8_t low = vorrq_u16(vorrq_u16(vshll_n_u8(vget_low_u8(r), 8), vshll_n_u8(vget_low_u8(g), 3)), vmovl_u8(vget_low_u8(b)));
+		uint16x8_t high = vorrq_u16(vorrq_u16(vshll_n_u8(vget_high_u8(r), 8), vshll_n_u8(vget_high_u8(g), 3)), vmovl_u8(vget_high_u8(b)));
+		vst1q_u16((uint16_t*) (output + (2 * x)), low);
+		vst1q_u16((uint16_t*) (output + (2 * x) + 16), high);
+	}
+#endif
+	for (; x < width; x++) {
+		const uint8_t *pixel = row + (3 * x);
+		uint16_t packed = ((pixel[2] & 0xF8) << 8) | ((pixel[1] & 0xFC) << 3) | (pixel[0] >> 3);
+		output[2 * x] = packed & 0xFF;
+		output[(2 * x) + 1] = packed >> 8;
+	}
+}
+
+/**
+ * This method will determine if a value is one of the pixel formats.
+ * @param format This is the value.
+ * @return The return will be true if it is a StreamPixelFormat or false otherwise.
+ */
+bool PixelFormatConverter::isValid(int format) {
+	return (format >= STREAM_PIXEL_BGR24) && (format <= STREAM_PIXEL_RGB565);
+}
+
+/**
+ * This method will obtain the number of rows which the rows of a datagram must be a multiple of.
+ * @param format This is the pixel format.
+ * @return The return will be the number of rows.
+ */
+int PixelFormatConverter::getRowMultiple(StreamPixelFormat format) {
+	return (format == STREAM_PIXEL_YUV420) ? 2 : 1;
+}
+
+/**
+ * This method will obtain the size of packed rows.
+ * @param format This is the pixel format.
+ * @param width This is the width of the rows in pixels.
+ * @param rowCount This is the number of rows.
+ * @return The return will be the size in bytes.
+ */
+size_t PixelFormatConverter::getPackedSize(StreamPixelFormat format, int width, int rowCount) {
+	size_t pixels = (size_t) width * rowCount;
+	switch (format) {
+	case STREAM_PIXEL_Y8:
+		return pixels;
+	case STREAM_PIXEL_YUV420:
+		return pixels + (2 * (size_t) ((width + 1) / 2) * ((rowCount + 1) / 2));
+	case STREAM_PIXEL_RGB565:
+		return 2 * pixels;
+	default:
+		return 3 * pixels;
+	}
+}
+
+/**
+ * This method will convert rows of an image into a pixel format and pack them.
+ * @param image This is the image, an 8 bit, 3 channel BGR image.
+ * @param firstRow This is the first row to pack.
+ * @param rowCount This is the number of rows to pack.
+ * @param format This is the pixel format.
+ * @param output This is where the rows are written.  It must hold getPackedSize bytes.
+ * @return The return will be the number of bytes written.
+ */
+size_t PixelFormatConverter::packRows(const Mat &image, int firstRow, int rowCount, StreamPixelFormat format, uint8_t *output) {
+	int width = image.cols;
+	switch (format) {
+	case STREAM_PIXEL_Y8:
+		for (int row = 0; row < rowCount; row++) {
+			packLumaRow(image.ptr(firstRow + row), width, output + ((size_t) row * width));
+		}
+		break;
+
+	case STREAM_PIXEL_YUV420: {
+		/**
+		 * The chroma planes follow the luma of every row.  The last row of an odd number of rows is its own pair.
+		 */
+		size_t chromaWidth = (width + 1) / 2;
+		size_t chromaRows = (rowCount + 1) / 2;
+		uint8_t *u = output + ((size_t) rowCount * width);
+		uint8_t *v = u + (chromaWidth * chromaRows);
+		for (int row = 0; row < rowCount; row += 2) {
+			bool pair = (row + 1 < rowCount);
+			const uint8_t *top = image.ptr(firstRow + row);
+			const uint8_t *bottom = pair ? image.ptr(firstRow + row + 1) : top;
+			packYuv420Rows(top, bottom, width, output + ((size_t) row * width), pair ? output + ((size_t) (row + 1) * width) : NULL,
+					u + ((row / 2) * chromaWidth), v + ((row / 2) * chromaWidth));
+		}
+		break;
+	}
+
+	case STREAM_PIXEL_RGB565:
+		for (int row = 0; row < rowCount; row++) {
+			packRgb565Row(image.ptr(firstRow + row), width, output + (2 * (size_t) row * width));
+		}
+		break;
+
+	default:
+		for (int row = 0; row < rowCount; row++) {
+			memcpy(output + (3 * (size_t) row * width), image.ptr(firstRow + row), 3 * (size_t) width);
+		}
+		break;
+	}
+	return getPackedSize(format, width, rowCount);
+}
+
+/**
+ * This method will unpack rows in a pixel format back into BGR.
+ * @param input This is the packed rows.
+ * @param format This is the pixel format.
+ * @param width This is the width of the rows in pixels.
+ * @param rowCount This is the number of rows.
+ * @param output This is where the first BGR row is written.
+ * @param stride This is the distance between the rows of the output in bytes.
+ */
+void PixelFormatConverter::unpackRows(const uint8_t *input, StreamPixelFormat format, int width, int rowCount, uint8_t *output,
+		size_t stride) {
+	size_t chromaWidth = (width + 1) / 2;
+	const uint8_t *u = input + ((size_t) rowCount * width);
+	const uint8_t *v = u + (chromaWidth * ((rowCount + 1) / 2));
+	for (int row = 0; row < rowCount; row++) {
+		uint8_t *pixel = output + (row * stride);
+		for (int x = 0; x < width; x++, pixel += 3) {
+			size_t index = ((size_t) row * width) + x;
+			switch (format) {
+			case STREAM_PIXEL_Y8:
+				pixel[0] = pixel[1] = pixel[2] = input[index];
+				break;
+
+			case STREAM_PIXEL_YUV420: {
+				int y = input[index];
+				int cb = u[((row / 2) * chromaWidth) + (x / 2)] - 128;
+				int cr = v[((row / 2) * chromaWidth) + (x / 2)] - 128;
+				pixel[0] = clampByte(y + (((454 * cb) + 128) >> 8));
+				pixel[1] = clampByte(y - (((88 * cb) + (183 * cr) + 128) >> 8));
+				pixel[2] = clampByte(y + (((359 * cr) + 128) >> 8));
+				break;
+			}
+
+			case STREAM_PIXEL_RGB565: {
+				uint16_t packed = input[2 * index] | (input[(2 * index) + 1] << 8);
+				uint8_t r = (packed >> 11) & 0x1F;
+				uint8_t g = (packed >> 5) & 0x3F;
+				uint8_t b = packed & 0x1F;
+				pixel[0] = (b << 3) | (b >> 2);
+				pixel[1] = (g << 2) | (g >> 4);
+				pixel[2] = (r << 3) | (r >> 2);
+				break;
+			}
+
+			default:
+				memcpy(pixel, input + (3 * index), 3);
+				break;
+			}
+		}
+	}
+}
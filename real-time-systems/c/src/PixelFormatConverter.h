@@ -0,0 +1,98 @@
+/**
+ * @file PixelFormatConverter.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class converts the rows of a BGR image into the pixel formats of the
+ *      stream, which are smaller than BGR when the receiver does not need every
+ *      bit of color: 8 bit luma (Y8), planar YUV with the chroma subsampled 2x2
+ *      (YUV420), and 16 bit RGB (RGB565).  The conversion is fused with the
+ *      packing of the datagram, so each pixel is read once and written once, and
+ *      it is written with SSE2 on x86 and NEON on ARM.  The scalar code gives
+ *      exactly the same bytes.
+ *
+ *      The color conversion is the full range (JFIF) one.  Luma has 8 bits of
+ *      fraction and chroma 7, so that the arithmetic fits in 16 bit lanes.
+ */
+
+#ifndef PIXELFORMATCONVERTER_H_
+#define PIXELFORMATCONVERTER_H_
+
+#include <opencv2/opencv.hpp>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "StreamProtocol.h"
+
+using namespace cv;
+
+class PixelFormatConverter {
+public:
+	/**
+	 * This method will determine if a value is one of the pixel formats.
+	 * @param format This is the value.
+	 * @return The return will be true if it is a StreamPixelFormat or false otherwise.
+	 */
+	static bool isValid(int format);
+
+	/**
+	 * This method will obtain the number of rows which the rows of a datagram must be a multiple of.  The chroma of
+	 * YUV420 is shared by pairs of rows, so it needs an even number of rows, except at the bottom of an odd height frame.
+	 * @param format This is the pixel format.
+	 * @return The return will be the number of rows.
+	 */
+	static int getRowMultiple(StreamPixelFormat format);
+
+	/**
+	 * This method will obtain the size of packed rows.
+	 * @param format This is the pixel format.
+	 * @param width This is the width of the rows in pixels.
+	 * @param rowCount This is the number of rows.
+	 * @return The return will be the size in bytes.
+	 */
+	static size_t getPackedSize(StreamPixelFormat format, int width, int rowCount);
+
+	/**
+	 * This method will convert rows of an image into a pixel format and pack them.  Y8 and RGB565 rows follow each other.
+	 * YUV420 rows are packed as planes: the luma of every row, then the U and then the V of every pair of rows.  RGB565
+	 * pixels are little endian, with red in the top 5 bits.
+	 * @param image This is the image, an 8 bit, 3 channel BGR image.
+	 * @param firstRow This is the first row to pack.
+	 * @param rowCount This is the number of rows to pack.
+	 * @param format This is the pixel format.
+	 * @param output This is where the rows are written.  It must hold getPackedSize bytes.
+	 * @return The return will be the number of bytes written.
+	 */
+	static size_t packRows(const Mat &image, int firstRow, int rowCount, StreamPixelFormat format, uint8_t *output);
+
+	/**
+	 * This method will unpack rows in a pixel format back into BGR.  It is meant for receivers, and is not vectorized.
+	 * @param input This is the packed rows.
+	 * @param format This is the pixel format.
+	 * @param width This is the width of the rows in pixels.
+	 * @param rowCount This is the number of rows.
+	 * @param output This is where the first BGR row is written.
+	 * @param stride This is the distance between the rows of the output in bytes.
+	 */
+	static void unpackRows(const uint8_t *input, StreamPixelFormat format, int width, int rowCount, uint8_t *output, size_t stride);
+};
+
+#endif /* PIXELFORMATCONVERTER_H_ */
@@ -0,0 +1,157 @@
+/**
+ * @file RealTimeInit.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class provides the real time startup mode.
+ */
+
+#include "RealTimeInit.h"
+#include <sys/mman.h>
+#include <malloc.h>
+#include <alloca.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+/*
+ * These variables hold the state of the real time startup mode.
+ */
+bool RealTimeInit::memoryLocked = false;
+size_t RealTimeInit::stackPrefaultSize = 0;
+
+/**
+ * This method will set up the real time startup mode.
+ * @param stackPrefault This is the number of bytes of stack to prefault in each thread.
+ * @param heapPrefault This is the number of bytes of heap to prefault.  It should cover the frame buffers.
+ * @return The return will be true if the memory could be locked or false otherwise.
+ */
+bool RealTimeInit::initialize(size_t stackPrefault, size_t heapPrefault) {
+	/**
+	 * 1.0 Lock the memory.  The heap must be configured before it is prefaulted, or the prefaulted memory would be returned when it is freed.
+	 */
+	bool locked = lockMemory();
+
+	/**
+	 * 2.0 Prefault the heap and the stack of the calling thread.
+	 */
+	prefaultHeap(heapPrefault);
+	prefaultStack(stackPrefault);
+
+	/**
+	 * 3.0 Every runnable class started from now on will prefault the same amount of stack.
+	 */
+	setStackPrefaultSize(stackPrefault);
+	return locked;
+}
+
+/**
+ * This method will lock all current and future pages of the process into memory, and configure the heap so that freed
+ * memory is kept in the process rather than being returned to the operating system.
+ * @return The return will be true if the memory could be locked or false otherwise.
+ */
+bool RealTimeInit::lockMemory() {
+	/**
+	 * 1.0 Never trim the heap and never satisfy allocations with a separate mmap, so freed blocks stay mapped and locked.
+	 */
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+
+	/**
+	 * 2.0 Lock the current and all future pages.
+	 */
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+		printf("Failed to lock memory (%s).  Page faults may occur in the real time threads.\n", strerror(errno));
+		return false;
+	}
+	memoryLocked = true;
+	return true;
+}
+
+/**
+ * This method will touch the given number of bytes of heap so that the pages are mapped (and locked) before they are needed.
+ * @param size This is the number of bytes to prefault.
+ */
+void RealTimeInit::prefaultHeap(size_t size) {
+	long pageSize = sysconf(_SC_PAGESIZE);
+
+	if (size == 0) {
+		return;
+	}
+
+	/**
+	 * Allocate the memory, write to one byte in each page, and free it.  As the heap is never trimmed, the pages remain in the process for later allocations.
+	 */
+	volatile unsigned char *buffer = (volatile unsigned char *) malloc(size);
+	if (buffer != NULL) {
+		for (size_t offset = 0; offset < size; offset += pageSize) {
+			buffer[offset] = 0;
+		}
+		free((void *) buffer);
+	}
+}
+
+/**
+ * This method will touch the given number of bytes of the calling thread's stack so that the pages are mapped (and locked)
+ * before they are needed.
+ * @param size This is the number of bytes to prefault.
+ */
+void RealTimeInit::prefaultStack(size_t size) {
+	long pageSize = sysconf(_SC_PAGESIZE);
+
+	if (size == 0) {
+		return;
+	}
+
+	/**
+	 * Allocate the memory on the stack and write to one byte in each page.  The pages stay mapped when this method returns.
+	 */
+	volatile unsigned char *stack = (volatile unsigned char *) alloca(size);
+	for (size_t offset = 0; offset < size; offset += pageSize) {
+		stack[offset] = 0;
+	}
+}
+
+/**
+ * This method will set the number of bytes of stack which each runnable class prefaults when its thread starts.
+ * @param size This is the number of bytes to prefault.
+ */
+void RealTimeInit::setStackPrefaultSize(size_t size) {
+	stackPrefaultSize = size;
+}
+
+/**
+ * This method will obtain the number of bytes of stack which each runnable class prefaults when its thread starts.
+ * @return The return will be the number of bytes to prefault.
+ */
+size_t RealTimeInit::getStackPrefaultSize() {
+	return stackPrefaultSize;
+}
+
+/**
+ * This method will determine if the memory of the process has been locked.
+ * @return The return will be true if the memory is locked or false otherwise.
+ */
+bool RealTimeInit::isMemoryLocked() {
+	return memoryLocked;
+}
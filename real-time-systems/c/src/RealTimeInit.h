@@ -0,0 +1,96 @@
+/**
+ * @file RealTimeInit.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class provides the real time startup mode.  It locks the memory of the
+ *      process so that it can not be paged out, keeps freed heap memory within the
+ *      process, and prefaults the heap and thread stacks so that the real time
+ *      threads do not take page faults once they are running.
+ */
+
+#ifndef REALTIMEINIT_H_
+#define REALTIMEINIT_H_
+
+#include <stddef.h>
+
+class RealTimeInit {
+private:
+	/**
+	 * This variable will determine whether or not the memory of the process has been locked.
+	 */
+	static bool memoryLocked;
+
+	/**
+	 * This is the number of bytes of stack which each runnable class prefaults when its thread starts.  0 means the stack is not prefaulted.
+	 */
+	static size_t stackPrefaultSize;
+
+public:
+	/**
+	 * This method will set up the real time startup mode.  It locks memory, prefaults the heap, and sets the amount of stack
+	 * that each runnable class will prefault.  It should be called by main before any threads are started.
+	 * @param stackPrefault This is the number of bytes of stack to prefault in each thread.
+	 * @param heapPrefault This is the number of bytes of heap to prefault.  It should cover the frame buffers.
+	 * @return The return will be true if the memory could be locked or false otherwise.
+	 */
+	static bool initialize(size_t stackPrefault, size_t heapPrefault);
+
+	/**
+	 * This method will lock all current and future pages of the process into memory, and configure the heap so that freed
+	 * memory is kept in the process rather than being returned to the operating system.
+	 * @return The return will be true if the memory could be locked or false otherwise.
+	 */
+	static bool lockMemory();
+
+	/**
+	 * This method will touch the given number of bytes of heap so that the pages are mapped (and locked) before they are needed.
+	 * @param size This is the number of bytes to prefault.
+	 */
+	static void prefaultHeap(size_t size);
+
+	/**
+	 * This method will touch the given number of bytes of the calling thread's stack so that the pages are mapped (and locked)
+	 * before they are needed.
+	 * @param size This is the number of bytes to prefault.
+	 */
+	static void prefaultStack(size_t size);
+
+	/**
+	 * This method will set the number of bytes of stack which each runnable class prefaults when its thread starts.
+	 * @param size This is the number of bytes to prefault.
+	 */
+	static void setStackPrefaultSize(size_t size);
+
+	/**
+	 * This method will obtain the number of bytes of stack which each runnable class prefaults when its thread starts.
+	 * @return The return will be the number of bytes to prefault.
+	 */
+	static size_t getStackPrefaultSize();
+
+	/**
+	 * This method will determine if the memory of the process has been locked.
+	 * @return The return will be true if the memory is locked or false otherwise.
+	 */
+	static bool isMemoryLocked();
+};
+
+#endif /* REALTIMEINIT_H_ */
@@ -0,0 +1,249 @@
+/**
+ * @file RealTimeMutex.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a priority inheritance (or priority ceiling) mutex for
+ *      resources which are shared between real time tasks.
+ */
+
+#include "RealTimeMutex.h"
+#include <iostream>
+#include <iomanip>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * This is a file scoped variable which holds a list of all of the locks.
+ */
+std::list<RealTimeMutex*> RealTimeMutex::allLocks;
+
+/**
+ * This is the constructor for the class.
+ * @param name This is the human readable name of the lock, which is shown in the diagnostics.
+ * @param protocol This is the protocol which is used to prevent priority inversion.
+ * @param ceiling This is the ceiling priority, which is only used by the priority ceiling protocol.
+ */
+RealTimeMutex::RealTimeMutex(std::string name, Protocol protocol, int ceiling) :
+		acquisitions(0), contentions(0), totalWaitTime(0), worstCaseWaitTime(0), totalHoldTime(0), worstCaseHoldTime(0) {
+	pthread_mutexattr_t attributes;
+	int result;
+
+	myName = name;
+	myProtocol = protocol;
+
+	/**
+	 * 1.0 Set up the attributes for the requested protocol.
+	 */
+	pthread_mutexattr_init(&attributes);
+	if (protocol == PROTOCOL_CEILING) {
+		pthread_mutexattr_setprotocol(&attributes, PTHREAD_PRIO_PROTECT);
+		pthread_mutexattr_setprioceiling(&attributes, ceiling);
+	} else {
+		pthread_mutexattr_setprotocol(&attributes, PTHREAD_PRIO_INHERIT);
+	}
+
+	/**
+	 * 2.0 Initialize the mutex.  If the protocol is not supported, fall back to a plain mutex so the program still works.
+	 */
+	result = pthread_mutex_init(&mutex, &attributes);
+	if (result != 0) {
+		printf("%s: Unable to create a priority protocol mutex (%s).  Using a plain mutex.\n", myName.c_str(), strerror(result));
+		pthread_mutex_init(&mutex, NULL);
+	}
+	pthread_mutexattr_destroy(&attributes);
+
+	/**
+	 * 3.0 Add the lock to the list of locks so that it shows up in the diagnostics.
+	 */
+	allLocks.push_back(this);
+}
+
+/**
+ * This is the destructor for the class.
+ */
+RealTimeMutex::~RealTimeMutex() {
+	allLocks.remove(this);
+	pthread_mutex_destroy(&mutex);
+}
+
+/**
+ * This method will obtain the current monotonic time in nanoseconds.
+ * @return The return will be the current time in nanoseconds.
+ */
+uint64_t RealTimeMutex::now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+/**
+ * This method will raise the given maximum to the given value if the value is larger.
+ * @param maximum This is the maximum which is to be updated.
+ * @param value This is the new value.
+ */
+void RealTimeMutex::updateMaximum(std::atomic<uint64_t> &maximum, uint64_t value) {
+	uint64_t current = maximum.load(std::memory_order_relaxed);
+	while ((value > current) && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+	}
+}
+
+/**
+ * This method will lock the mutex, blocking until it is available.
+ */
+void RealTimeMutex::lock() {
+	/**
+	 * 1.0 Try to take the lock without blocking.  If that fails, the lock is contended, so time how long we wait for it.
+	 */
+	if (pthread_mutex_trylock(&mutex) != 0) {
+		uint64_t waitStart = now();
+		contentions.fetch_add(1, std::memory_order_relaxed);
+		pthread_mutex_lock(&mutex);
+		uint64_t waited = now() - waitStart;
+		totalWaitTime.fetch_add(waited, std::memory_order_relaxed);
+		updateMaximum(worstCaseWaitTime, waited);
+	}
+
+	/**
+	 * 2.0 Record when the lock was acquired so the hold time can be measured.
+	 */
+	acquisitions.fetch_add(1, std::memory_order_relaxed);
+	acquiredAt = now();
+}
+
+/**
+ * This method will try to lock the mutex without blocking.
+ * @return The return will be true if the lock was acquired or false otherwise.
+ */
+bool RealTimeMutex::try_lock() {
+	if (pthread_mutex_trylock(&mutex) != 0) {
+		return false;
+	}
+	acquisitions.fetch_add(1, std::memory_order_relaxed);
+	acquiredAt = now();
+	return true;
+}
+
+/**
+ * This method will unlock the mutex.
+ */
+void RealTimeMutex::unlock() {
+	/**
+	 * Measure the hold time while the lock is still held, and then release it.
+	 */
+	uint64_t held = now() - acquiredAt;
+	totalHoldTime.fetch_add(held, std::memory_order_relaxed);
+	updateMaximum(worstCaseHoldTime, held);
+	pthread_mutex_unlock(&mutex);
+}
+
+/**
+ * This method will obtain the name of the lock.
+ * @return The return will be the human readable name of the lock.
+ */
+std::string RealTimeMutex::getName() {
+	return myName;
+}
+
+/**
+ * This method will print out information about the given lock.
+ */
+void RealTimeMutex::printInformation() {
+	uint64_t count = getAcquisitions();
+	uint64_t contended = getContentions();
+
+	std::cout << std::setw(18) << myName << "\t"
+			<< ((myProtocol == PROTOCOL_CEILING) ? "CEIL" : "INHERIT") << "\t "
+			<< std::setw(10) << count << "\t "
+			<< std::setw(10) << contended << "\t "
+			<< std::setw(12) << ((contended > 0) ? (getTotalWaitTime() / contended / 1000) : 0) << "\t "
+			<< std::setw(12) << (getWorstCaseWaitTime() / 1000) << "\t "
+			<< std::setw(12) << ((count > 0) ? (getTotalHoldTime() / count / 1000) : 0) << "\t "
+			<< std::setw(12) << (getWorstCaseHoldTime() / 1000) << "\n";
+}
+
+/**
+ * This method will reset the lock diagnostics back to their default values.
+ */
+void RealTimeMutex::resetDiagnostics() {
+	acquisitions = 0;
+	contentions = 0;
+	totalWaitTime = 0;
+	worstCaseWaitTime = 0;
+	totalHoldTime = 0;
+	worstCaseHoldTime = 0;
+}
+
+/**
+ * This method will print out to the console the diagnostics for all of the locks.
+ */
+void RealTimeMutex::printLocks() {
+	std::cout << "Lock Diagnostic Information:\n";
+	std::cout << "Lock              \tProtocol\tAcquisitions\tContentions\tAvg Wait(us)\tMax Wait(us)\tAvg Hold(us)\tMax Hold(us)\n";
+	for (RealTimeMutex *lock : allLocks) {
+		lock->printInformation();
+	}
+}
+
+/**
+ * This method will reset the diagnostics of all of the locks.
+ */
+void RealTimeMutex::resetAllLockInformation() {
+	for (RealTimeMutex *lock : allLocks) {
+		lock->resetDiagnostics();
+	}
+}
+
+/**
+ * This method will obtain the list of all of the real time mutexes.
+ * @return The return will be a reference to the list of locks.
+ */
+const std::list<RealTimeMutex*>& RealTimeMutex::getAllLocks() {
+	return allLocks;
+}
+
+/**
+ * These methods obtain the statistics of the lock.  Times are given in nanoseconds.
+ */
+uint64_t RealTimeMutex::getAcquisitions() {
+	return acquisitions.load(std::memory_order_relaxed);
+}
+
+uint64_t RealTimeMutex::getContentions() {
+	return contentions.load(std::memory_order_relaxed);
+}
+
+uint64_t RealTimeMutex::getTotalWaitTime() {
+	return totalWaitTime.load(std::memory_order_relaxed);
+}
+
+uint64_t RealTimeMutex::getWorstCaseWaitTime() {
+	return worstCaseWaitTime.load(std::memory_order_relaxed);
+}
+
+uint64_t RealTimeMutex::getTotalHoldTime() {
+	return totalHoldTime.load(std::memory_order_relaxed);
+}
+
+uint64_t RealTimeMutex::getWorstCaseHoldTime() {
+	return worstCaseHoldTime.load(std::memory_order_relaxed);
+}
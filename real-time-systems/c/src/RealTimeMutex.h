@@ -0,0 +1,174 @@
+/**
+ * @file RealTimeMutex.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a mutex for resources which are shared between real time
+ *      tasks.  It uses the priority inheritance protocol (or, optionally, the
+ *      priority ceiling protocol) so that a low priority task holding the lock
+ *      can not cause priority inversion.  It also keeps track of how long the lock
+ *      is held, how long tasks wait for it, and how often it is contended.  It
+ *      provides lock, unlock, and try_lock, so it can be used with std::lock_guard.
+ */
+
+#ifndef REALTIMEMUTEX_H_
+#define REALTIMEMUTEX_H_
+
+#include <pthread.h>
+#include <string>
+#include <list>
+#include <atomic>
+#include <stdint.h>
+
+class RealTimeMutex {
+public:
+	/**
+	 * This enumeration defines the protocol which is used to prevent priority inversion.
+	 */
+	enum Protocol {
+		PROTOCOL_INHERIT, /**< The holder inherits the priority of the highest priority waiter (PTHREAD_PRIO_INHERIT). */
+		PROTOCOL_CEILING /**< The holder runs at the ceiling priority of the lock (PTHREAD_PRIO_PROTECT). */
+	};
+
+private:
+	/**
+	 * This is a list of all of the real time mutexes which have been instantiated.
+	 */
+	static std::list<RealTimeMutex*> allLocks;
+
+	/**
+	 * This is the underlying pthread mutex.
+	 */
+	pthread_mutex_t mutex;
+
+	/**
+	 * This is the human readable name of the lock.
+	 */
+	std::string myName;
+
+	/**
+	 * This is the protocol which the lock uses.
+	 */
+	Protocol myProtocol;
+
+	/**
+	 * This is the time, in nanoseconds, at which the current holder acquired the lock.  It is only accessed by the holder.
+	 */
+	uint64_t acquiredAt = 0;
+
+	/**
+	 * These are the statistics of the lock.  Times are given in nanoseconds.
+	 */
+	std::atomic<uint64_t> acquisitions;
+	std::atomic<uint64_t> contentions;
+	std::atomic<uint64_t> totalWaitTime;
+	std::atomic<uint64_t> worstCaseWaitTime;
+	std::atomic<uint64_t> totalHoldTime;
+	std::atomic<uint64_t> worstCaseHoldTime;
+
+	/**
+	 * This method will obtain the current monotonic time in nanoseconds.
+	 * @return The return will be the current time in nanoseconds.
+	 */
+	static uint64_t now();
+
+	/**
+	 * This method will raise the given maximum to the given value if the value is larger.
+	 * @param maximum This is the maximum which is to be updated.
+	 * @param value This is the new value.
+	 */
+	static void updateMaximum(std::atomic<uint64_t> &maximum, uint64_t value);
+
+public:
+	/**
+	 * This is the constructor for the class.
+	 * @param name This is the human readable name of the lock, which is shown in the diagnostics.
+	 * @param protocol This is the protocol which is used to prevent priority inversion.
+	 * @param ceiling This is the ceiling priority, which is only used by the priority ceiling protocol.  It must be at least
+	 * the priority of the highest priority task which uses the lock.
+	 */
+	RealTimeMutex(std::string name, Protocol protocol = PROTOCOL_INHERIT, int ceiling = 0);
+
+	/**
+	 * This is the destructor for the class.
+	 */
+	virtual ~RealTimeMutex();
+
+	/**
+	 * This method will lock the mutex, blocking until it is available.
+	 */
+	void lock();
+
+	/**
+	 * This method will try to lock the mutex without blocking.
+	 * @return The return will be true if the lock was acquired or false otherwise.
+	 */
+	bool try_lock();
+
+	/**
+	 * This method will unlock the mutex.
+	 */
+	void unlock();
+
+	/**
+	 * This method will obtain the name of the lock.
+	 * @return The return will be the human readable name of the lock.
+	 */
+	std::string getName();
+
+	/**
+	 * This method will print out information about the given lock.
+	 */
+	void printInformation();
+
+	/**
+	 * This method will reset the lock diagnostics back to their default values.
+	 */
+	void resetDiagnostics();
+
+	/**
+	 * This method will print out to the console the diagnostics for all of the locks.
+	 */
+	static void printLocks();
+
+	/**
+	 * This method will reset the diagnostics of all of the locks.
+	 */
+	static void resetAllLockInformation();
+
+	/**
+	 * This method will obtain the list of all of the real time mutexes.
+	 * @return The return will be a reference to the list of locks.
+	 */
+	static const std::list<RealTimeMutex*>& getAllLocks();
+
+	/**
+	 * These methods obtain the statistics of the lock.  Times are given in nanoseconds.
+	 */
+	uint64_t getAcquisitions();
+	uint64_t getContentions();
+	uint64_t getTotalWaitTime();
+	uint64_t getWorstCaseWaitTime();
+	uint64_t getTotalHoldTime();
+	uint64_t getWorstCaseHoldTime();
+};
+
+#endif /* REALTIMEMUTEX_H_ */
@@ -28,25 +28,102 @@
  */
 
 #include "RunnableClass.h"
-#include <thread>
+#include "RealTimeInit.h"
+#include "RealTimeMutex.h"
+#include "TraceBuffer.h"
+#include "Logger.h"
 #include <string>
 #include <iostream>
 #include <iomanip>
 #include <sys/types.h>
 #include <unistd.h>
 #include <sys/syscall.h>
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
+#include <errno.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+#ifndef SCHED_FLAG_DL_OVERRUN
+#define SCHED_FLAG_DL_OVERRUN 0x04
+#endif
 
 /*
  * This is a file scopes variable which holds a list of the threads that are running.
  */
 std::list<RunnableClass*> RunnableClass::runningThreads;
 
+/*
+ * These variables define the cores which are reserved for real time tasks.
+ */
+bool RunnableClass::coreReservationEnabled = false;
+cpu_set_t RunnableClass::reservedCpus;
+
+/*
+ * This is the stack size used by runnable classes which have not set their own.
+ */
+size_t RunnableClass::defaultStackSize = 0;
+
+/*
+ * This structure mirrors the kernel's struct sched_attr, which is used by the sched_setattr system call.  It is declared here, as older C libraries do not provide it.
+ */
+struct DeadlineAttributes {
+	uint32_t size;
+	uint32_t schedPolicy;
+	uint64_t schedFlags;
+	int32_t schedNice;
+	uint32_t schedPriority;
+	uint64_t schedRuntime;
+	uint64_t schedDeadline;
+	uint64_t schedPeriod;
+};
+
+/*
+ * This is the throttle counter of the runnable class executing on the current thread.  It is used by the SIGXCPU handler.
+ */
+static thread_local std::atomic<uint32_t> *currentThrottleCounter = NULL;
+
+/*
+ * This is the signal handler for SIGXCPU, which the kernel sends to a SCHED_DEADLINE thread that overruns its runtime.
+ */
+static void deadlineOverrunHandler(int signal) {
+	if (currentThrottleCounter != NULL) {
+		currentThrottleCounter->fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+/*
+ * This function installs the SIGXCPU handler once for the process.
+ */
+static void installDeadlineOverrunHandler() {
+	static std::once_flag installed;
+	std::call_once(installed, []() {
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = deadlineOverrunHandler;
+		action.sa_flags = SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGXCPU, &action, NULL);
+	});
+}
+
 /**
  * This is the default constructor for the class.
  * @param threadName This is the name of the thread in a human readable format.
  */
-RunnableClass::RunnableClass(std::string threadName) {
+RunnableClass::RunnableClass(std::string threadName) :
+		myOSThreadID(0), keepGoing(true), stopRequestTime(0), stopLatency(-1), runCompleted(false), runStarted(false),
+		activePolicy(POLICY_DEFAULT), throttleCount(0) {
 	priority = 1;
+	CPU_ZERO(&cpuAffinity);
 
 	// Set the name of the thread accordingly.
 	myName = threadName;
@@ -63,17 +140,26 @@ void RunnableClass::printThreads() {
 			<< "===============================================================================================\nThread Diagnostic Information:\n";
 	// Print the header out
 	std::cout
-			<< "Thread\tTask              \tPrio.\tperiod(us)\tLast Execution(us)\tWCET(us)\tLast Wall Time(us)\tWCWT(us)\n";
+			<< "Thread\tTask              \tPrio.\tPolicy\tCPU\tMigr.\tperiod(us)\tLast Execution(us)\tWCET(us)\tLast Wall Time(us)\tWCWT(us)\tOverruns\tThrottled\tFaults\tWC Faults\n";
 	for (std::list<RunnableClass*>::iterator it = runningThreads.begin();
 			it != runningThreads.end(); it++) {
 		RunnableClass *rc = *it;
 		rc->printInformation();
 	}
+	RealTimeMutex::printLocks();
 	std::cout
 			<< "===============================================================================================\n";
 
 }
 
+/**
+ * This method will obtain the list of all of the runnable classes which have been instantiated.
+ * @return The return will be a reference to the list of runnable classes.
+ */
+const std::list<RunnableClass*>& RunnableClass::getRunningThreads() {
+	return runningThreads;
+}
+
 /**
  * This method will reset the thread information which is dynamic in nature and changes as the robot runs.
  * This predominantly impacts threads which are not part of the Runnable class.
@@ -84,6 +170,7 @@ void RunnableClass::resetAllThreadInformation() {
 		RunnableClass *rc = *it;
 		rc->resetThreadDiagnostics();
 	}
+	RealTimeMutex::resetAllLockInformation();
 }
 
 /**
@@ -98,8 +185,9 @@ void RunnableClass::resetThreadDiagnostics() {
  */
 void RunnableClass::printInformation() {
 
-	std::cout << myOSThreadID << "\t" << std::setw(18) << myName << "\t "
-			<< std::setw(5) << getPriority() << "\n ";
+	std::cout << myOSThreadID.load(std::memory_order_acquire) << "\t" << std::setw(18) << myName << "\t "
+			<< std::setw(5) << getPriority() << "\t" << getSchedulingPolicyName() << "\t"
+			<< getCurrentCpu() << "\t" << getMigrationCount() << "\n";
 }
 
 /*
@@ -107,22 +195,78 @@ void RunnableClass::printInformation() {
  */
 RunnableClass::~RunnableClass() {
 	/**
-	 * If the thread is not NULL, delete it.
+	 * If the thread was created and never joined, detach it so that its resources are released when it ends.
 	 */
-	if (myThread != NULL) {
-		delete myThread;
+	if (threadCreated) {
+		pthread_detach(myThread);
 	}
+
+	// Remove the thread from the list so that diagnostics do not reference a deleted object.
+	runningThreads.remove(this);
 }
 
 /**
  * This private method initializes the runnable class.  It is actually the method invoked when the thread starts.
  */
 void RunnableClass::invokeRunMethod() {
-	// Setup the operating thread to be a real time thread.
-	struct sched_param p;
+	runStarted.store(true, std::memory_order_release);
+	runCompleted.store(false, std::memory_order_release);
 
-	runStarted = true;
-	runCompleted = false;
+	// Obtain the thread id by making a system call.
+	myOSThreadID.store(syscall(SYS_gettid), std::memory_order_release);
+	currentThrottleCounter = &throttleCount;
+
+	// Create the trace buffer for this thread now, rather than on its first traced event.
+	TraceBuffer::registerThread(myName);
+
+	// Setup the operating thread to be a real time thread, preferring SCHED_DEADLINE if it has been requested.
+	if (deadlineRequested) {
+		if (applyDeadlineScheduling(0) == false) {
+			Logger::log(LOG_WARNING, "%s: SCHED_DEADLINE refused by the kernel (%s).  Falling back to SCHED_FIFO priority %d.",
+					myName.c_str(), strerror(errno), priority);
+			applyFifoScheduling();
+		}
+	} else {
+		applyFifoScheduling();
+	}
+
+	// Real time threads without an explicit affinity are placed onto the reserved cores.
+	if ((affinityRequested == false) && coreReservationEnabled && (activePolicy.load(std::memory_order_acquire) != POLICY_DEFAULT)) {
+		cpuAffinity = reservedCpus;
+		affinityRequested = true;
+	}
+	if (affinityRequested) {
+		applyCpuAffinity(0);
+	}
+
+	// In the real time startup mode, touch the stack now so that the run method does not take page faults on it later.
+	size_t prefault = RealTimeInit::getStackPrefaultSize();
+	size_t actualStackSize = (stackSize > 0) ? stackSize : defaultStackSize;
+	if ((actualStackSize > 0) && (prefault + 65536 > actualStackSize)) {
+		prefault = (actualStackSize > 65536) ? (actualStackSize - 65536) : 0;
+	}
+	RealTimeInit::prefaultStack(prefault);
+
+	// Now invoke the run method,
+	this->run();
+
+	// When run returns, indicate that the run is completed, and report how long it took to stop.
+	uint64_t requested = stopRequestTime.load();
+	if (requested != 0) {
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		stopLatency = (int64_t) ((((uint64_t) now.tv_sec * 1000000000ULL) + now.tv_nsec - requested) / 1000);
+		Logger::log(LOG_INFO, "%s: Stopped %lld us after the stop request.", myName.c_str(), (long long) stopLatency.load());
+	}
+	runCompleted.store(true, std::memory_order_release);
+	runStarted.store(false, std::memory_order_release);
+}
+
+/**
+ * This method will apply the SCHED_FIFO policy with the configured priority to the calling thread.
+ */
+void RunnableClass::applyFifoScheduling() {
+	struct sched_param p;
 
 	if (priority > 0) {
 
@@ -133,19 +277,96 @@ void RunnableClass::invokeRunMethod() {
 		}
 
 		if (sched_setscheduler(0, SCHED_FIFO, &p) != 0) {
-			printf("Failed to set the scheduler\n");
+			Logger::log(LOG_ERROR, "%s: Failed to set the scheduler (%s).", myName.c_str(), strerror(errno));
+		} else {
+			activePolicy.store(POLICY_FIFO, std::memory_order_release);
 		}
 	}
+}
 
-	// Obtain the thread id by making a system call.
-	myOSThreadID = syscall(SYS_gettid);
+/**
+ * This method will apply the SCHED_DEADLINE parameters to the given thread.
+ * @param tid This is the operating system thread id, or 0 for the calling thread.
+ * @return The return will be true if the kernel accepted the parameters or false otherwise.
+ */
+bool RunnableClass::applyDeadlineScheduling(pid_t tid) {
+	DeadlineAttributes attr;
 
-	// Now invoke the run method,
-	this->run();
+	/**
+	 * 1.0 Fill in the attributes, asking the kernel to signal runtime overruns with SIGXCPU.
+	 */
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.schedPolicy = SCHED_DEADLINE;
+	attr.schedFlags = SCHED_FLAG_DL_OVERRUN;
+	attr.schedRuntime = deadlineRuntime;
+	attr.schedDeadline = deadlineDeadline;
+	attr.schedPeriod = deadlinePeriod;
+	installDeadlineOverrunHandler();
+
+	/**
+	 * 2.0 Make the system call.  Kernels older than 4.16 do not know the overrun flag, so retry without it if the flags are rejected.
+	 */
+	int result = syscall(SYS_sched_setattr, tid, &attr, 0);
+	if ((result != 0) && (errno == EINVAL)) {
+		attr.schedFlags = 0;
+		result = syscall(SYS_sched_setattr, tid, &attr, 0);
+	}
+
+	if (result == 0) {
+		activePolicy.store(POLICY_DEADLINE, std::memory_order_release);
+	}
+	return (result == 0);
+}
+
+/**
+ * This method will apply the CPU affinity to the thread.
+ * @param tid This is the operating system thread id, or 0 for the calling thread.
+ */
+void RunnableClass::applyCpuAffinity(pid_t tid) {
+	/**
+	 * The kernel only admits SCHED_DEADLINE threads which may run on every CPU of their root domain, so the affinity can not be narrowed for them.
+	 */
+	if (activePolicy.load(std::memory_order_acquire) == POLICY_DEADLINE) {
+		Logger::log(LOG_WARNING, "%s: CPU affinity is not applied to a SCHED_DEADLINE thread.", myName.c_str());
+		return;
+	}
+	if (sched_setaffinity(tid, sizeof(cpuAffinity), &cpuAffinity) != 0) {
+		Logger::log(LOG_ERROR, "%s: Failed to set the CPU affinity (%s).", myName.c_str(), strerror(errno));
+	}
+}
+
+/**
+ * This method will request that the thread be scheduled using SCHED_DEADLINE.  If the thread is already running, the
+ * parameters are applied immediately.  If the kernel refuses, the thread falls back to SCHED_FIFO.
+ * @param runtime This is the runtime budget in nanoseconds.
+ * @param deadline This is the relative deadline in nanoseconds.
+ * @param period This is the period in nanoseconds.
+ */
+bool RunnableClass::setDeadlineParameters(uint64_t runtime, uint64_t deadline, uint64_t period) {
+	uint64_t previousRuntime = deadlineRuntime;
+	uint64_t previousDeadline = deadlineDeadline;
+	uint64_t previousPeriod = deadlinePeriod;
+	deadlineRequested = true;
+	deadlineRuntime = runtime;
+	deadlineDeadline = deadline;
+	deadlinePeriod = period;
 
-	// When run returns, indicate that the run is completed.
-	runCompleted = true;
-	runStarted = false;
+	/**
+	 * If the thread is already executing under SCHED_DEADLINE, change its parameters now.  If the kernel refuses, the
+	 * parameters which it is still executing under are kept, so that they always match the kernel's.
+	 */
+	pid_t tid = myOSThreadID.load(std::memory_order_acquire);
+	if ((activePolicy.load(std::memory_order_acquire) == POLICY_DEADLINE) && (tid != 0)) {
+		if (applyDeadlineScheduling(tid) == false) {
+			Logger::log(LOG_ERROR, "%s: Unable to change the SCHED_DEADLINE parameters (%s).", myName.c_str(), strerror(errno));
+			deadlineRuntime = previousRuntime;
+			deadlineDeadline = previousDeadline;
+			deadlinePeriod = previousPeriod;
+			return false;
+		}
+	}
+	return true;
 }
 
 /**
@@ -153,9 +374,56 @@ void RunnableClass::invokeRunMethod() {
  * This method will cause the task to start with the default priority.
  */
 void RunnableClass::start() {
+	/**
+	 * Give the derived class a chance to refuse to start.
+	 */
+	if (admitTask() == false) {
+		return;
+	}
 	keepGoing = true;
+	stopRequestTime = 0;
+	stopLatency = -1;
+	runStarted.store(true, std::memory_order_release);
 	startChildRunnables();
-	myThread = new std::thread(&RunnableClass::invokeRunMethod, this);
+
+	/**
+	 * Create the thread with the configured stack size.
+	 */
+	pthread_attr_t attributes;
+	size_t actualStackSize = (stackSize > 0) ? stackSize : defaultStackSize;
+	pthread_attr_init(&attributes);
+	if ((actualStackSize > 0) && (pthread_attr_setstacksize(&attributes, actualStackSize) != 0)) {
+		Logger::log(LOG_WARNING, "%s: Invalid stack size %lu.  Using the default stack size.", myName.c_str(), (unsigned long) actualStackSize);
+	}
+	int result = pthread_create(&myThread, &attributes, &RunnableClass::threadEntry, this);
+	pthread_attr_destroy(&attributes);
+	if (result != 0) {
+		Logger::log(LOG_ERROR, "%s: Failed to create the thread (%s).", myName.c_str(), strerror(result));
+		runStarted.store(false, std::memory_order_release);
+		return;
+	}
+	threadCreated = true;
+}
+
+/**
+ * This is the entry point of the thread.  It invokes the run method of the given runnable class.
+ * @param runnable This is the runnable class whose thread is starting.
+ * @return The return will always be NULL.
+ */
+void* RunnableClass::threadEntry(void *runnable) {
+	((RunnableClass *) runnable)->invokeRunMethod();
+	return NULL;
+}
+
+/**
+ * This method is invoked by start before the thread is created.  It gives derived classes the chance to refuse to start.
+ * @return true if the task may be started.  False otherwise.
+ */
+bool RunnableClass::admitTask() {
+	/**
+	 * By default, every runnable class is admitted.
+	 */
+	return true;
 }
 
 /**
@@ -184,7 +452,7 @@ void RunnableClass::startChildRunnables() {
  * @return true if the task has been started.  False otherwise.
  */
 bool RunnableClass::isStarted() {
-	return runStarted;
+	return runStarted.load(std::memory_order_acquire);
 }
 
 /**
@@ -193,8 +461,23 @@ bool RunnableClass::isStarted() {
 void RunnableClass::stop() {
 	/**
 	 * Stop the thread by changing the value of keepGoing.  If there is a child class that has a RUnnable object inside of it, then stop must be called on that object.
+	 * The time of the request is recorded so that the time to stop can be measured, and the thread is woken up if it is waiting.
 	 */
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	uint64_t expected = 0;
+	stopRequestTime.compare_exchange_strong(expected, ((uint64_t) now.tv_sec * 1000000000ULL) + now.tv_nsec);
 	keepGoing = false;
+	wakeup.signal();
+}
+
+/**
+ * This method will obtain the time the thread took to stop.
+ * @return The return will be the time, in microseconds, from the stop request until the run method returned, or -1 if
+ * the thread has not stopped.
+ */
+int64_t RunnableClass::getStopLatency() {
+	return stopLatency.load();
 }
 
 /**
@@ -202,7 +485,7 @@ void RunnableClass::stop() {
  * @return The return will be true if the thread is shutdown or false otherwise.
  */
 bool RunnableClass::isShutdown() {
-	return runCompleted;
+	return runCompleted.load(std::memory_order_acquire);
 }
 
 /**
@@ -211,21 +494,38 @@ bool RunnableClass::isShutdown() {
  * to wait for the child method to shutdown.
  */
 void RunnableClass::waitForShutdown() {
-	if (myThread != NULL) {
+	if (threadCreated) {
 		/**
 		 * Join the thread and wait for shutdown.
 		 */
-		myThread->join();
+		pthread_join(myThread, NULL);
+		threadCreated = false;
 	}
 }
 
 /**
- * This method will set the priority for the given task.
+ * This method will set the priority for the given task.  If the thread is already running under SCHED_FIFO (or the
+ * default policy), the new priority is applied to it immediately.
  * @param priority This is the priority for the task.  It must be between 0 and 99, with 99 being the highest priority.
  */
 void RunnableClass::setPriority(int priority) {
 	if (priority >= 0 && priority <= 100) {
 		this->priority = priority;
+
+		/**
+		 * A SCHED_DEADLINE thread has no priority, so only the stored value changes for it.
+		 */
+		pid_t tid = myOSThreadID.load(std::memory_order_acquire);
+		if ((tid != 0) && runStarted.load(std::memory_order_acquire) && (activePolicy.load(std::memory_order_acquire) != POLICY_DEADLINE)) {
+			struct sched_param p;
+			p.__sched_priority = (priority > sched_get_priority_max(SCHED_FIFO)) ? sched_get_priority_max(SCHED_FIFO) : priority;
+			int policy = (priority > 0) ? SCHED_FIFO : SCHED_OTHER;
+			if (sched_setscheduler(tid, policy, &p) != 0) {
+				Logger::log(LOG_ERROR, "%s: Failed to change the priority to %d (%s).", myName.c_str(), priority, strerror(errno));
+			} else {
+				activePolicy.store((priority > 0) ? POLICY_FIFO : POLICY_DEFAULT, std::memory_order_release);
+			}
+		}
 	}
 }
 
@@ -236,3 +536,255 @@ void RunnableClass::setPriority(int priority) {
 int RunnableClass::getPriority() {
 	return this->priority;
 }
+
+/**
+ * This method will obtain the name of this runnable class.
+ * @return The return will be the human readable name of the thread.
+ */
+std::string RunnableClass::getName() {
+	return myName;
+}
+
+/**
+ * This method will obtain the timing model of the given task for schedulability analysis.
+ * @param model This is the model that is to be filled in.
+ * @return The return will be false, as a plain runnable class has no periodic timing behavior.
+ */
+bool RunnableClass::getTimingModel(TaskTimingModel &model) {
+	return false;
+}
+
+/**
+ * This method will obtain the scheduling policy which the thread is executing under.
+ * @return The return will be the active scheduling policy.
+ */
+RunnableClass::SchedulingPolicy RunnableClass::getSchedulingPolicy() {
+	return activePolicy.load(std::memory_order_acquire);
+}
+
+/**
+ * This method will obtain a human readable name for the scheduling policy which the thread is executing under.
+ * @return The return will be "OTHER", "FIFO", or "DL".
+ */
+const char* RunnableClass::getSchedulingPolicyName() {
+	switch (activePolicy.load(std::memory_order_acquire)) {
+	case POLICY_FIFO:
+		return "FIFO";
+	case POLICY_DEADLINE:
+		return "DL";
+	default:
+		return "OTHER";
+	}
+}
+
+/**
+ * This method will obtain the number of times the kernel throttled this thread for overrunning its SCHED_DEADLINE runtime.
+ * @return The return will be the number of throttle events.
+ */
+uint32_t RunnableClass::getThrottleCount() {
+	return throttleCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will reserve a set of cores for real time tasks.
+ * @param count This is the number of cores to reserve if the kernel has not isolated any cores.
+ * @return The return will be true if cores were reserved or false otherwise.
+ */
+bool RunnableClass::reserveIsolatedCores(int count) {
+	cpu_set_t housekeepingCpus;
+	int cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+	char isolated[256] = "";
+
+	CPU_ZERO(&reservedCpus);
+
+	/**
+	 * 1.0 Read the list of isolated cores (for example "2-3" or "1,3") from sysfs and parse it.
+	 */
+	FILE *file = fopen("/sys/devices/system/cpu/isolated", "r");
+	if (file != NULL) {
+		if (fgets(isolated, sizeof(isolated), file) == NULL) {
+			isolated[0] = 0;
+		}
+		fclose(file);
+	}
+	char *token = strtok(isolated, ",\n");
+	while (token != NULL) {
+		int first, last;
+		int fields = sscanf(token, "%d-%d", &first, &last);
+		if (fields == 1) {
+			last = first;
+		}
+		for (int cpu = first; (fields >= 1) && (cpu <= last); cpu++) {
+			CPU_SET(cpu, &reservedCpus);
+		}
+		token = strtok(NULL, ",\n");
+	}
+
+	/**
+	 * 2.0 If the kernel has not isolated any cores, reserve the highest numbered cores, always leaving at least one core for everything else.
+	 */
+	if (CPU_COUNT(&reservedCpus) == 0) {
+		for (int cpu = cpuCount - 1; (cpu > 0) && (cpu >= cpuCount - count); cpu--) {
+			CPU_SET(cpu, &reservedCpus);
+		}
+	}
+	if (CPU_COUNT(&reservedCpus) == 0) {
+		printf("No cores could be reserved for real time tasks.\n");
+		return false;
+	}
+
+	/**
+	 * 3.0 Move the calling thread onto the remaining cores.  Threads it creates inherit this affinity.
+	 */
+	CPU_ZERO(&housekeepingCpus);
+	for (int cpu = 0; cpu < cpuCount; cpu++) {
+		if (!CPU_ISSET(cpu, &reservedCpus)) {
+			CPU_SET(cpu, &housekeepingCpus);
+		}
+	}
+	if (sched_setaffinity(0, sizeof(housekeepingCpus), &housekeepingCpus) != 0) {
+		printf("Failed to move the main thread off of the reserved cores (%s).\n", strerror(errno));
+	}
+	coreReservationEnabled = true;
+	return true;
+}
+
+/**
+ * This method will obtain the number of CPUs which the threads that are not bound to a single CPU are spread across.
+ * @return The return will be the number of CPUs, which is at least 1.
+ */
+int RunnableClass::getUnboundCpuCount() {
+	cpu_set_t cpus;
+
+	/**
+	 * The affinity of the process is that of the main thread, which has been moved off of the reserved cores if they are in use.
+	 */
+	if (sched_getaffinity(getpid(), sizeof(cpus), &cpus) != 0) {
+		return std::max((int) sysconf(_SC_NPROCESSORS_ONLN), 1);
+	}
+	if (coreReservationEnabled) {
+		CPU_OR(&cpus, &cpus, &reservedCpus);
+	}
+	return std::max(CPU_COUNT(&cpus), 1);
+}
+
+/**
+ * This method will set the CPUs which this thread is allowed to execute on.
+ * @param cpus This is the list of CPU numbers.  An empty list removes the affinity.
+ */
+void RunnableClass::setCpuAffinity(const std::vector<int> &cpus) {
+	CPU_ZERO(&cpuAffinity);
+	for (int cpu : cpus) {
+		CPU_SET(cpu, &cpuAffinity);
+	}
+	affinityRequested = (cpus.size() > 0);
+
+	/**
+	 * If the thread is already executing, apply the change now.  Removing the affinity allows every online CPU.
+	 */
+	pid_t tid = myOSThreadID.load(std::memory_order_acquire);
+	if (tid != 0) {
+		if (affinityRequested == false) {
+			for (int cpu = 0; cpu < sysconf(_SC_NPROCESSORS_ONLN); cpu++) {
+				CPU_SET(cpu, &cpuAffinity);
+			}
+		}
+		applyCpuAffinity(tid);
+	}
+}
+
+/**
+ * This method will obtain the CPU which this thread is bound to.
+ * @return The return will be the CPU number if the thread is bound to exactly one CPU, or -1 otherwise.
+ */
+int RunnableClass::getBoundCpu() {
+	if (affinityRequested && (CPU_COUNT(&cpuAffinity) == 1)) {
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &cpuAffinity)) {
+				return cpu;
+			}
+		}
+	}
+	return -1;
+}
+
+/**
+ * This method will obtain the CPU which this thread last executed on, as read from /proc/self/task/<tid>/stat.
+ * @return The return will be the CPU number or -1 if it can not be determined.
+ */
+int RunnableClass::getCurrentCpu() {
+	char path[64];
+	char line[1024];
+	int cpu = -1;
+
+	pid_t tid = myOSThreadID.load(std::memory_order_acquire);
+	if (tid == 0) {
+		return -1;
+	}
+	snprintf(path, sizeof(path), "/proc/self/task/%d/stat", (int) tid);
+	FILE *file = fopen(path, "r");
+	if (file != NULL) {
+		if (fgets(line, sizeof(line), file) != NULL) {
+			/**
+			 * The thread name (field 2) may contain spaces, so start counting after its closing parenthesis.  The processor is field 39.
+			 */
+			char *field = strrchr(line, ')');
+			int fieldNumber = 2;
+			while ((field != NULL) && (fieldNumber < 39)) {
+				field = strchr(field + 1, ' ');
+				fieldNumber++;
+			}
+			if (field != NULL) {
+				cpu = atoi(field + 1);
+			}
+		}
+		fclose(file);
+	}
+	return cpu;
+}
+
+/**
+ * This method will obtain the number of times this thread has migrated between CPUs, as read from /proc/self/task/<tid>/sched.
+ * @return The return will be the migration count or -1 if it can not be determined.
+ */
+long RunnableClass::getMigrationCount() {
+	char path[64];
+	char line[256];
+	long migrations = -1;
+
+	pid_t tid = myOSThreadID.load(std::memory_order_acquire);
+	if (tid == 0) {
+		return -1;
+	}
+	snprintf(path, sizeof(path), "/proc/self/task/%d/sched", (int) tid);
+	FILE *file = fopen(path, "r");
+	if (file != NULL) {
+		while (fgets(line, sizeof(line), file) != NULL) {
+			if (strncmp(line, "se.nr_migrations", 16) == 0) {
+				char *value = strchr(line, ':');
+				if (value != NULL) {
+					migrations = atol(value + 1);
+				}
+				break;
+			}
+		}
+		fclose(file);
+	}
+	return migrations;
+}
+
+/**
+ * This method will set the stack size of the thread.  It must be called before the thread is started.
+ * @param size This is the stack size in bytes.  0 means the default stack size is used.
+ */
+void RunnableClass::setStackSize(size_t size) {
+	stackSize = size;
+}
+
+/**
+ * This method will set the stack size used by runnable classes which have not set their own.
+ * @param size This is the stack size in bytes.  0 means the system default is used.
+ */
+void RunnableClass::setDefaultStackSize(size_t size) {
+	defaultStackSize = size;
+}
@@ -30,15 +30,31 @@
 #ifndef RUNNABLECLASS_H_
 #define RUNNABLECLASS_H_
 
-#include <thread>
+#include <pthread.h>
 #include <string>
 #include <list>
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+#include <sched.h>
 #include <sys/types.h>
+#include "TaskTimingModel.h"
+#include "WakeupEvent.h"
 
 /**
  * This is the runnable class, which mimics the runnable interface from Java.  It is a virtual class which should not directly be instantiated.
  */
 class RunnableClass {
+public:
+	/**
+	 * This enumeration defines the scheduling policies which a runnable class can be executing under.
+	 */
+	enum SchedulingPolicy {
+		POLICY_DEFAULT, /**< The default (SCHED_OTHER) time sharing policy. */
+		POLICY_FIFO, /**< The real time SCHED_FIFO policy with a fixed priority. */
+		POLICY_DEADLINE /**< The SCHED_DEADLINE (earliest deadline first) policy with a runtime, deadline, and period. */
+	};
+
 protected:
 	/**
 	 * This is a list of all of the running threads which have been started by this set of libraries.
@@ -46,14 +62,30 @@ protected:
 	static std::list<RunnableClass*> runningThreads;
 
 	/**
-	 * This is the instance of the thread that is to be executed by this class.  AT instantiation it is NULL.  It will be instantiated when the start method of the class is invoked.
+	 * This is the handle of the thread that is to be executed by this class.  It will be created when the start method of the class is invoked.
+	 */
+	pthread_t myThread;
+
+	/**
+	 * This variable will determine whether or not the thread has been created and not yet joined.
 	 */
-	std::thread *myThread = NULL;
+	bool threadCreated = false;
 
 	/**
-	 * This is the thread id (tid) for this task.
+	 * This is the size of the stack of the thread in bytes.  0 means the default size is used.
 	 */
-	pid_t myOSThreadID = 0;
+	size_t stackSize = 0;
+
+	/**
+	 * This is the stack size used by runnable classes which have not set their own.  0 means the system default is used.
+	 */
+	static size_t defaultStackSize;
+
+	/**
+	 * This is the thread id (tid) for this task.  It is set by the thread itself and read by other threads, so it is
+	 * published with release ordering and read with acquire ordering.
+	 */
+	std::atomic<pid_t> myOSThreadID;
 
 	/**
 	 * This is the name of the thread.  It is shown as a string so that it can easily be viewed in human-readable format.
@@ -61,14 +93,31 @@ protected:
 	std::string myName;
 
 	/**
-	 * This variable will determine whether or not the given thread is to continue executing.
+	 * This variable will determine whether or not the given thread is to continue executing.  It is set by start and
+	 * cleared by stop, from other threads.
+	 */
+	std::atomic<bool> keepGoing;
+
+	/**
+	 * This event is signaled whenever the thread should stop waiting and look at its state again, such as when it is stopped.
+	 */
+	WakeupEvent wakeup;
+
+	/**
+	 * This is the CLOCK_MONOTONIC time, in nanoseconds, at which the thread was asked to stop.  It is 0 if it has not been asked.
+	 */
+	std::atomic<uint64_t> stopRequestTime;
+
+	/**
+	 * This is the time, in microseconds, from the stop request until the run method returned.  It is -1 until the thread has stopped.
 	 */
-	bool keepGoing = true;
+	std::atomic<int64_t> stopLatency;
 
 	/**
 	 * This variable will determine if the current Runnable class has completed execution and the run method has returned.
+	 * It is set by the thread and read by the threads waiting for it, with release and acquire ordering.
 	 */
-	bool runCompleted = false;
+	std::atomic<bool> runCompleted;
 
 	/**
 	 * This is the priority of the given thread.  A value of -1 indicates no change in the priority and to use the default setup.
@@ -77,9 +126,71 @@ protected:
 	int priority = -1;
 
 	/**
-	 * This variable will determine whether or not the current task has been started or not.
+	 * This variable will determine whether or not the current task has been started or not.  It is written by both the
+	 * starting thread and the thread itself, with release and acquire ordering.
+	 */
+	std::atomic<bool> runStarted;
+
+	/**
+	 * This variable will determine whether or not SCHED_DEADLINE scheduling has been requested for this thread.
+	 */
+	bool deadlineRequested = false;
+
+	/**
+	 * These are the SCHED_DEADLINE runtime, deadline, and period, all given in nanoseconds.
 	 */
-	bool runStarted = false;
+	uint64_t deadlineRuntime = 0;
+	uint64_t deadlineDeadline = 0;
+	uint64_t deadlinePeriod = 0;
+
+	/**
+	 * This is the scheduling policy which the thread is actually executing under.  It is changed by the thread and by
+	 * the threads which reconfigure it, and read by the monitoring threads, with release and acquire ordering.
+	 */
+	std::atomic<SchedulingPolicy> activePolicy;
+
+	/**
+	 * This is a count of the number of times the kernel has signaled that the thread overran its SCHED_DEADLINE runtime and was throttled.
+	 */
+	std::atomic<uint32_t> throttleCount;
+
+	/**
+	 * This variable will determine whether or not a CPU affinity has been requested for this thread.
+	 */
+	bool affinityRequested = false;
+
+	/**
+	 * This is the set of CPUs which the thread is allowed to execute on, if an affinity has been requested.
+	 */
+	cpu_set_t cpuAffinity;
+
+	/**
+	 * This variable will determine whether or not the cores reserved for real time tasks are in use.
+	 */
+	static bool coreReservationEnabled;
+
+	/**
+	 * This is the set of CPUs which are reserved for real time tasks.
+	 */
+	static cpu_set_t reservedCpus;
+
+	/**
+	 * This method will request that the thread be scheduled using SCHED_DEADLINE.  If the thread is already running, the
+	 * parameters are applied immediately.  If the kernel refuses, the thread falls back to SCHED_FIFO.
+	 * @param runtime This is the runtime budget in nanoseconds.
+	 * @param deadline This is the relative deadline in nanoseconds.
+	 * @param period This is the period in nanoseconds.
+	 * @return The return will be true if the parameters were applied, or will be when the thread starts, or false if the
+	 * kernel refused to change the parameters of the running thread, which are then kept as they were.
+	 */
+	virtual bool setDeadlineParameters(uint64_t runtime, uint64_t deadline, uint64_t period) final;
+
+	/**
+	 * This method is invoked by start before the thread is created.  It gives derived classes the chance to refuse to start,
+	 * for example when admitting the task would make the task set unschedulable.
+	 * @return true if the task may be started.  False otherwise.
+	 */
+	virtual bool admitTask();
 
 private:
 	/**
@@ -87,12 +198,62 @@ private:
 	 */
 	virtual void invokeRunMethod() final;
 
+	/**
+	 * This is the entry point of the thread.  It invokes the run method of the given runnable class.
+	 * @param runnable This is the runnable class whose thread is starting.
+	 * @return The return will always be NULL.
+	 */
+	static void* threadEntry(void *runnable);
+
+	/**
+	 * This method will apply the SCHED_DEADLINE parameters to the given thread.
+	 * @param tid This is the operating system thread id, or 0 for the calling thread.
+	 * @return The return will be true if the kernel accepted the parameters or false otherwise.
+	 */
+	bool applyDeadlineScheduling(pid_t tid);
+
+	/**
+	 * This method will apply the SCHED_FIFO policy with the configured priority to the calling thread.
+	 */
+	void applyFifoScheduling();
+
+	/**
+	 * This method will apply the CPU affinity to the thread.
+	 * @param tid This is the operating system thread id, or 0 for the calling thread.
+	 */
+	void applyCpuAffinity(pid_t tid);
+
 public:
 	/**
 	 * This method will print out to the console each of the running threads and their thread ID's.
 	 */
 	static void printThreads();
 
+	/**
+	 * This method will obtain the list of all of the runnable classes which have been instantiated.  The list is not
+	 * synchronized, so it may only be walked while no runnable class is being created or deleted.
+	 * @return The return will be a reference to the list of runnable classes.
+	 */
+	static const std::list<RunnableClass*>& getRunningThreads();
+
+	/**
+	 * This method will reserve a set of cores for real time tasks.  If the kernel was booted with isolated cores (isolcpus),
+	 * those cores are reserved.  Otherwise, the highest numbered cores are reserved.  The calling thread, and any thread it
+	 * creates after this call, is moved off of the reserved cores, and real time runnable classes without an explicit
+	 * affinity are placed onto the reserved cores when they start.  This should be called by main before any threads are started.
+	 * @param count This is the number of cores to reserve if the kernel has not isolated any cores.
+	 * @return The return will be true if cores were reserved or false otherwise.
+	 */
+	static bool reserveIsolatedCores(int count);
+
+	/**
+	 * This method will obtain the number of CPUs which the threads that are not bound to a single CPU are spread across.
+	 * These are the CPUs the process may execute on, together with the reserved cores, onto which real time threads without
+	 * an explicit affinity are placed.
+	 * @return The return will be the number of CPUs, which is at least 1.
+	 */
+	static int getUnboundCpuCount();
+
 	/**
 	 * This method will reset the thread information which is dynamic in nature and changes as the robot runs.
 	 * This predominantly impacts threads which are not part of the Runnable class.
@@ -135,6 +296,7 @@ public:
 
 	/**
 	 * This method will set the priority for the given task, using the real time FIFO scheduler as well as setting the priority.
+	 * If the thread is already running, the new priority is applied to it immediately.
 	 * @param priority This is the priority for the task.  It must be between 0 and 99, with 99 being the highest priority.
 	 */
 	virtual void setPriority(int priority) final;
@@ -145,6 +307,74 @@ public:
 	 */
 	virtual int getPriority() final;
 
+	/**
+	 * This method will obtain the scheduling policy which the thread is executing under.
+	 * @return The return will be the active scheduling policy.
+	 */
+	virtual SchedulingPolicy getSchedulingPolicy() final;
+
+	/**
+	 * This method will obtain a human readable name for the scheduling policy which the thread is executing under.
+	 * @return The return will be "OTHER", "FIFO", or "DL".
+	 */
+	virtual const char* getSchedulingPolicyName() final;
+
+	/**
+	 * This method will obtain the number of times the kernel throttled this thread for overrunning its SCHED_DEADLINE runtime.
+	 * @return The return will be the number of throttle events.
+	 */
+	virtual uint32_t getThrottleCount() final;
+
+	/**
+	 * This method will set the CPUs which this thread is allowed to execute on.  If the thread is running, the change takes
+	 * effect immediately.  Otherwise, it is applied when the thread starts.
+	 * @param cpus This is the list of CPU numbers.  An empty list removes the affinity.
+	 */
+	virtual void setCpuAffinity(const std::vector<int> &cpus) final;
+
+	/**
+	 * This method will obtain the CPU which this thread is bound to.
+	 * @return The return will be the CPU number if the thread is bound to exactly one CPU, or -1 otherwise.
+	 */
+	virtual int getBoundCpu() final;
+
+	/**
+	 * This method will obtain the CPU which this thread last executed on, as read from /proc/self/task/<tid>/stat.
+	 * @return The return will be the CPU number or -1 if it can not be determined.
+	 */
+	virtual int getCurrentCpu() final;
+
+	/**
+	 * This method will obtain the number of times this thread has migrated between CPUs, as read from /proc/self/task/<tid>/sched.
+	 * @return The return will be the migration count or -1 if it can not be determined.
+	 */
+	virtual long getMigrationCount() final;
+
+	/**
+	 * This method will set the stack size of the thread.  It must be called before the thread is started.
+	 * @param size This is the stack size in bytes.  0 means the default stack size is used.
+	 */
+	virtual void setStackSize(size_t size) final;
+
+	/**
+	 * This method will set the stack size used by runnable classes which have not set their own.
+	 * @param size This is the stack size in bytes.  0 means the system default is used.
+	 */
+	static void setDefaultStackSize(size_t size);
+
+	/**
+	 * This method will obtain the name of this runnable class.
+	 * @return The return will be the human readable name of the thread.
+	 */
+	virtual std::string getName() final;
+
+	/**
+	 * This method will obtain the timing model of the given task for schedulability analysis.
+	 * @param model This is the model that is to be filled in.
+	 * @return The return will be true if the task has a timing model (i.e. it is periodic) or false otherwise.
+	 */
+	virtual bool getTimingModel(TaskTimingModel &model);
+
 	/**
 	 * This is the virtual run method.  It will execute the given code that is to be executed by this class.
 	 */
@@ -164,10 +394,17 @@ public:
 	virtual bool isStarted() final;
 
 	/**
-	 * This method will stop the execution of the given class.
+	 * This method will stop the execution of the given class.  A thread which is waiting is woken up so that it stops immediately.
 	 */
 	virtual void stop() ;
 
+	/**
+	 * This method will obtain the time the thread took to stop.
+	 * @return The return will be the time, in microseconds, from the stop request until the run method returned, or -1 if
+	 * the thread has not stopped.
+	 */
+	virtual int64_t getStopLatency() final;
+
 	/**
 	 * This method will block waiting for the given thread to terminate before continuing.  This should be overridden if any child class
 	 * has it's own runnable objects encapsulated within it.
@@ -0,0 +1,423 @@
+/**
+ * @file SchedulabilityAnalyzer.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class performs an online rate monotonic (fixed priority) schedulability
+ *      analysis of the running task set.
+ */
+
+#include "SchedulabilityAnalyzer.h"
+#include "Logger.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <map>
+#include <cmath>
+#include <sched.h>
+#include <stdio.h>
+
+/*
+ * This is the policy applied when tasks are started or changed.
+ */
+SchedulabilityAnalyzer::AdmissionPolicy SchedulabilityAnalyzer::admissionPolicy = SchedulabilityAnalyzer::ADMISSION_WARN;
+
+/**
+ * This method will analyze a given task set.
+ * @param tasks This is the set of task timing models that is to be analyzed.
+ * @param results This is the vector which will be filled with one entry per CPU.
+ * @return The return will be true if the entire task set is schedulable or false otherwise.
+ */
+bool SchedulabilityAnalyzer::analyze(const std::vector<TaskTimingModel> &tasks, std::vector<CpuAnalysis> &results) {
+	bool schedulable = true;
+	std::map<int, CpuAnalysis> cpus;
+
+	/**
+	 * 1.0 Sort the tasks into groups by the CPU which they are bound to.  Tasks that are not bound are analyzed together, as
+	 * spread across the CPUs which they may execute on.
+	 */
+	for (const TaskTimingModel &model : tasks) {
+		CpuAnalysis &cpuResult = cpus[model.cpu];
+		cpuResult.cpu = model.cpu;
+		cpuResult.cpuCount = 1;
+		TaskAnalysis taskResult;
+		taskResult.model = model;
+		taskResult.worstCaseResponseTime = 0;
+		taskResult.schedulable = true;
+		cpuResult.tasks.push_back(taskResult);
+	}
+
+	/**
+	 * 2.0 Analyze each CPU independently.  If the tasks which are not bound may only execute on one CPU, they are analyzed
+	 * as a single CPU.
+	 */
+	results.clear();
+	for (auto &entry : cpus) {
+		if (entry.first < 0) {
+			entry.second.cpuCount = RunnableClass::getUnboundCpuCount();
+		}
+		if (entry.second.cpuCount > 1) {
+			analyzeGlobal(entry.second);
+		} else {
+			analyzeCpu(entry.second);
+		}
+		schedulable = schedulable && entry.second.schedulable;
+		results.push_back(entry.second);
+	}
+	return schedulable;
+}
+
+/**
+ * This method will obtain the priority of a task as seen by the analysis.  SCHED_DEADLINE tasks are above every SCHED_FIFO
+ * priority, and non real time tasks are below every SCHED_FIFO priority.
+ * @param model This is the timing model of the task.
+ * @return The return will be the effective priority of the task.
+ */
+int SchedulabilityAnalyzer::effectivePriority(const TaskTimingModel &model) {
+	if (model.deadlineScheduled) {
+		return sched_get_priority_max(SCHED_FIFO) + 1;
+	}
+	return std::max(model.priority, 0);
+}
+
+/**
+ * This method will analyze the tasks which share a single CPU using response time analysis.
+ * @param cpuResult This is the result for the CPU.  Its task list must be filled in before the call.
+ */
+void SchedulabilityAnalyzer::analyzeCpu(CpuAnalysis &cpuResult) {
+	std::vector<TaskAnalysis> &tasks = cpuResult.tasks;
+	double deadlineUtilization = 0.0;
+
+	/**
+	 * 1.0 Order the tasks from highest to lowest effective priority.
+	 */
+	std::stable_sort(tasks.begin(), tasks.end(), [](const TaskAnalysis &a, const TaskAnalysis &b) {
+		return effectivePriority(a.model) > effectivePriority(b.model);
+	});
+
+	/**
+	 * 2.0 Determine the utilization and the Liu and Layland bound, n(2^(1/n) - 1).
+	 */
+	cpuResult.utilization = 0.0;
+	for (const TaskAnalysis &task : tasks) {
+		if (task.model.period > 0) {
+			double taskUtilization = (double) task.model.worstCaseExecutionTime / (double) task.model.period;
+			cpuResult.utilization += taskUtilization;
+			if (task.model.deadlineScheduled) {
+				deadlineUtilization += taskUtilization;
+			}
+		}
+	}
+	double n = (double) tasks.size();
+	cpuResult.utilizationBound = (tasks.size() > 0) ? n * (std::pow(2.0, 1.0 / n) - 1.0) : 1.0;
+	cpuResult.schedulable = true;
+
+	/**
+	 * 3.0 For each task, iterate R = C + sum(ceil(R / Tj) * Cj) over all tasks j of equal or higher priority until it converges or exceeds the deadline.
+	 * Tasks of equal priority run FIFO with respect to each other, so they are conservatively treated as interfering.
+	 */
+	for (size_t i = 0; i < tasks.size(); i++) {
+		TaskAnalysis &task = tasks[i];
+		uint64_t deadline = (task.model.deadline > 0) ? task.model.deadline : task.model.period;
+		uint64_t response = task.model.worstCaseExecutionTime;
+		uint64_t previous = 0;
+
+		/**
+		 * 3.1 SCHED_DEADLINE tasks are scheduled earliest deadline first amongst themselves.  With implicit deadlines,
+		 * every one meets its deadline as long as their combined utilization does not exceed 1.
+		 */
+		if (task.model.deadlineScheduled) {
+			task.schedulable = (deadlineUtilization <= 1.0);
+			task.worstCaseResponseTime = deadline;
+			cpuResult.schedulable = cpuResult.schedulable && task.schedulable;
+			continue;
+		}
+
+		while ((response != previous) && (response <= deadline)) {
+			previous = response;
+			response = task.model.worstCaseExecutionTime;
+			for (size_t j = 0; j < tasks.size(); j++) {
+				const TaskTimingModel &other = tasks[j].model;
+				if ((j != i) && (effectivePriority(other) >= effectivePriority(task.model)) && (other.period > 0)) {
+					response += ((previous + other.period - 1) / other.period) * other.worstCaseExecutionTime;
+				}
+			}
+		}
+
+		task.worstCaseResponseTime = response;
+		task.schedulable = (response <= deadline);
+		cpuResult.schedulable = cpuResult.schedulable && task.schedulable;
+	}
+}
+
+/**
+ * This method will analyze the tasks which are spread across several CPUs using response time analysis for global fixed
+ * priority scheduling.
+ * @param cpuResult This is the result for the CPUs.  Its task list and CPU count must be filled in before the call.
+ */
+void SchedulabilityAnalyzer::analyzeGlobal(CpuAnalysis &cpuResult) {
+	std::vector<TaskAnalysis> &tasks = cpuResult.tasks;
+	uint64_t m = (uint64_t) cpuResult.cpuCount;
+	double deadlineUtilization = 0.0;
+	double largestDeadlineUtilization = 0.0;
+
+	/**
+	 * 1.0 Order the tasks from highest to lowest effective priority.
+	 */
+	std::stable_sort(tasks.begin(), tasks.end(), [](const TaskAnalysis &a, const TaskAnalysis &b) {
+		return effectivePriority(a.model) > effectivePriority(b.model);
+	});
+
+	/**
+	 * 2.0 Determine the utilization, which can not exceed the number of CPUs.
+	 */
+	cpuResult.utilization = 0.0;
+	for (const TaskAnalysis &task : tasks) {
+		if (task.model.period > 0) {
+			double taskUtilization = (double) task.model.worstCaseExecutionTime / (double) task.model.period;
+			cpuResult.utilization += taskUtilization;
+			if (task.model.deadlineScheduled) {
+				deadlineUtilization += taskUtilization;
+				largestDeadlineUtilization = std::max(largestDeadlineUtilization, taskUtilization);
+			}
+		}
+	}
+	cpuResult.utilizationBound = (double) m;
+	cpuResult.schedulable = true;
+
+	/**
+	 * 3.0 For each task, iterate R = C + floor(sum(min(Wj(R), R - C + 1)) / m) over all tasks j of equal or higher
+	 * priority, where Wj(L) = Nj * Cj + min(Cj, L + Rj - Cj - Nj * Tj) and Nj = floor((L + Rj - Cj) / Tj) bounds the work
+	 * of task j, including the job carried in from before the window, in a window of length L.  A task whose response
+	 * time is not yet known, or which misses its deadline, is bounded by its deadline.
+	 */
+	for (size_t i = 0; i < tasks.size(); i++) {
+		TaskAnalysis &task = tasks[i];
+		uint64_t deadline = (task.model.deadline > 0) ? task.model.deadline : task.model.period;
+		uint64_t execution = task.model.worstCaseExecutionTime;
+		uint64_t response = execution;
+		uint64_t previous = 0;
+
+		/**
+		 * 3.1 SCHED_DEADLINE tasks are scheduled by global earliest deadline first amongst themselves.  With implicit
+		 * deadlines, every one meets its deadline if U <= m - (m - 1) * Umax.
+		 */
+		if (task.model.deadlineScheduled) {
+			task.schedulable = (deadlineUtilization <= (double) m - ((double) (m - 1) * largestDeadlineUtilization));
+			task.worstCaseResponseTime = deadline;
+			cpuResult.schedulable = cpuResult.schedulable && task.schedulable;
+			continue;
+		}
+
+		while ((response != previous) && (response <= deadline)) {
+			previous = response;
+			uint64_t interference = 0;
+			for (size_t j = 0; j < tasks.size(); j++) {
+				const TaskAnalysis &other = tasks[j];
+				uint64_t period = other.model.period;
+				uint64_t otherExecution = other.model.worstCaseExecutionTime;
+				if ((j == i) || (effectivePriority(other.model) < effectivePriority(task.model)) || (period == 0)) {
+					continue;
+				}
+				uint64_t otherDeadline = (other.model.deadline > 0) ? other.model.deadline : period;
+				uint64_t otherResponse = ((j < i) && other.schedulable) ? other.worstCaseResponseTime : otherDeadline;
+				uint64_t window = previous + std::max(otherResponse, otherExecution) - otherExecution;
+				uint64_t jobs = window / period;
+				uint64_t work = (jobs * otherExecution) + std::min(otherExecution, window - (jobs * period));
+				interference += std::min(work, previous - execution + 1);
+			}
+			response = execution + (interference / m);
+		}
+
+		task.worstCaseResponseTime = response;
+		task.schedulable = (response <= deadline);
+		cpuResult.schedulable = cpuResult.schedulable && task.schedulable;
+	}
+}
+
+/**
+ * This method will collect the timing models of all of the running tasks.
+ * @param tasks This is the vector that the models are to be appended to.
+ * @param exclude This is a task which is not to be collected, as the caller will add its model.  It may be NULL.
+ */
+void SchedulabilityAnalyzer::collectRunningTasks(std::vector<TaskTimingModel> &tasks, RunnableClass *exclude) {
+	for (RunnableClass *rc : RunnableClass::getRunningThreads()) {
+		TaskTimingModel model;
+		if ((rc != exclude) && (rc->isStarted()) && (rc->getTimingModel(model))) {
+			tasks.push_back(model);
+		}
+	}
+}
+
+/**
+ * This method will analyze the set of tasks which are currently running.
+ * @param results This is the vector which will be filled with one entry per CPU.
+ * @return The return will be true if the running task set is schedulable or false otherwise.
+ */
+bool SchedulabilityAnalyzer::analyzeRunningTasks(std::vector<CpuAnalysis> &results) {
+	std::vector<TaskTimingModel> tasks;
+	collectRunningTasks(tasks, NULL);
+	return analyze(tasks, results);
+}
+
+/**
+ * This method will check a task set with a candidate task added, applying the admission policy.
+ * @param candidate This is the task that is to be checked.  Its current model is left out of the running task set.
+ * @param candidateModel This is the timing model of the candidate which is to be checked.
+ * @param action This is a human readable description of what is being done to the candidate.
+ * @return The return will be true if the candidate is accepted or false otherwise.
+ */
+bool SchedulabilityAnalyzer::checkWithCandidate(RunnableClass *candidate, const TaskTimingModel &candidateModel, const char *action) {
+	std::vector<TaskTimingModel> tasks;
+	std::vector<CpuAnalysis> results;
+
+	/**
+	 * 1.0 If admission control is disabled, accept the candidate.
+	 */
+	if (admissionPolicy == ADMISSION_DISABLED) {
+		return true;
+	}
+
+	/**
+	 * 2.0 Analyze the running tasks plus the candidate.
+	 */
+	collectRunningTasks(tasks, candidate);
+	tasks.push_back(candidateModel);
+	if (analyze(tasks, results)) {
+		return true;
+	}
+
+	/**
+	 * 3.0 The task set is not schedulable.  Log the tasks which would miss their deadlines and apply the policy.  This may
+	 * be called from a real time thread, so the full analysis is left to printAnalysis.
+	 */
+	bool accepted = (admissionPolicy != ADMISSION_REFUSE);
+	Logger::log(LOG_WARNING, "Schedulability warning: %s task %s makes the task set unschedulable.%s", action,
+			candidateModel.name.c_str(), accepted ? "" : "  The request is refused.");
+	for (const CpuAnalysis &cpuResult : results) {
+		char cpuName[16];
+		if (cpuResult.cpu < 0) {
+			snprintf(cpuName, sizeof(cpuName), "CPU any");
+		} else {
+			snprintf(cpuName, sizeof(cpuName), "CPU %d", cpuResult.cpu);
+		}
+		for (const TaskAnalysis &task : cpuResult.tasks) {
+			if (task.schedulable == false) {
+				Logger::log(LOG_WARNING, "Schedulability warning: %s on %s (utilization %.3f) responds in %llu us, beyond its deadline of %u us.",
+						task.model.name.c_str(), cpuName, cpuResult.utilization, (unsigned long long) task.worstCaseResponseTime,
+						(task.model.deadline > 0) ? task.model.deadline : task.model.period);
+			}
+		}
+	}
+	return accepted;
+}
+
+/**
+ * This method will determine if the given task may be started, applying the admission policy.
+ * @param candidate This is the task which is about to be started.
+ * @return The return will be true if the task may start or false if it is refused.
+ */
+bool SchedulabilityAnalyzer::admit(RunnableClass *candidate) {
+	TaskTimingModel candidateModel;
+
+	/**
+	 * A task without a timing model is always accepted.
+	 */
+	if (candidate->getTimingModel(candidateModel) == false) {
+		return true;
+	}
+	return checkWithCandidate(candidate, candidateModel, "Starting");
+}
+
+/**
+ * This method will evaluate the running task set with a task's parameters changed, applying the admission policy.
+ * @param changedTask This is the task whose parameters are to be changed.
+ * @param changedModel This is the timing model of the task with the changed parameters.
+ * @return The return will be true if the change may be made or false if it is to be refused.
+ */
+bool SchedulabilityAnalyzer::reevaluate(RunnableClass *changedTask, const TaskTimingModel &changedModel) {
+	return checkWithCandidate(changedTask, changedModel, "Changing");
+}
+
+/**
+ * This method will print out to the console the analysis of the running task set.
+ */
+void SchedulabilityAnalyzer::printAnalysis() {
+	std::vector<CpuAnalysis> results;
+	analyzeRunningTasks(results);
+	printAnalysis(results);
+}
+
+/**
+ * This method will print out to the console the given analysis results.
+ * @param results These are the results that are to be printed.
+ */
+void SchedulabilityAnalyzer::printAnalysis(const std::vector<CpuAnalysis> &results) {
+	std::ios_base::fmtflags originalFlags = std::cout.flags();
+	std::streamsize originalPrecision = std::cout.precision();
+
+	std::cout
+			<< "===============================================================================================\nSchedulability Analysis:\n";
+	for (const CpuAnalysis &cpuResult : results) {
+		if (cpuResult.cpu < 0) {
+			std::cout << "CPU any";
+		} else {
+			std::cout << "CPU " << cpuResult.cpu;
+		}
+		std::cout << "\tUtilization: " << std::fixed << std::setprecision(3) << cpuResult.utilization;
+		if (cpuResult.cpuCount > 1) {
+			std::cout << "\tGlobal on " << cpuResult.cpuCount << " CPUs";
+		} else {
+			std::cout << "\tRM bound: " << cpuResult.utilizationBound;
+		}
+		std::cout << "\t" << (cpuResult.schedulable ? "SCHEDULABLE" : "NOT SCHEDULABLE") << "\n";
+		std::cout << "Task              \tPrio.\tPolicy\tperiod(us)\tWCET(us)\tWCRT(us)\tOK\n";
+		for (const TaskAnalysis &task : cpuResult.tasks) {
+			std::cout << std::setw(18) << task.model.name << "\t "
+					<< std::setw(5) << task.model.priority << "\t"
+					<< (task.model.deadlineScheduled ? "DL" : "FP") << "\t "
+					<< std::setw(10) << task.model.period << "\t "
+					<< std::setw(8) << task.model.worstCaseExecutionTime << "\t "
+					<< std::setw(8) << task.worstCaseResponseTime << "\t"
+					<< (task.schedulable ? "yes" : "NO") << "\n";
+		}
+	}
+	std::cout
+			<< "===============================================================================================\n";
+	std::cout.flags(originalFlags);
+	std::cout.precision(originalPrecision);
+}
+
+/**
+ * This method will set the admission policy which is used when tasks are started or changed.
+ * @param policy This is the new admission policy.
+ */
+void SchedulabilityAnalyzer::setAdmissionPolicy(AdmissionPolicy policy) {
+	admissionPolicy = policy;
+}
+
+/**
+ * This method will obtain the admission policy.
+ * @return The return will be the current admission policy.
+ */
+SchedulabilityAnalyzer::AdmissionPolicy SchedulabilityAnalyzer::getAdmissionPolicy() {
+	return admissionPolicy;
+}
@@ -0,0 +1,209 @@
+/**
+ * @file SchedulabilityAnalyzer.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class performs an online rate monotonic (fixed priority) schedulability
+ *      analysis of the running task set.  For each CPU it computes the utilization
+ *      and uses response time analysis to predict the worst case response time of
+ *      every task.  It also provides admission control, so that a task which would
+ *      make the task set unschedulable can be refused or warned about.  Tasks
+ *      scheduled with SCHED_DEADLINE are checked with the EDF utilization bound and
+ *      treated as the highest priority interference for the fixed priority tasks.
+ *      The tasks which are not bound to a CPU are spread across several CPUs, so
+ *      they are analyzed with the response time analysis for global fixed priority
+ *      scheduling of Bertogna and Cirinei, and the global EDF bound of Goossens,
+ *      Funk and Baruah.
+ */
+
+#ifndef SCHEDULABILITYANALYZER_H_
+#define SCHEDULABILITYANALYZER_H_
+
+#include "RunnableClass.h"
+#include "TaskTimingModel.h"
+
+#include <vector>
+
+class SchedulabilityAnalyzer {
+public:
+	/**
+	 * This enumeration defines what happens when a task is started or retuned and the result is unschedulable.
+	 */
+	enum AdmissionPolicy {
+		ADMISSION_DISABLED, /**< No analysis is done when tasks are started. */
+		ADMISSION_WARN, /**< The tasks which would miss their deadlines are logged as a warning but the task is still started. */
+		ADMISSION_REFUSE /**< The task is refused and does not start. */
+	};
+
+	/**
+	 * This structure holds the analysis result for a single task.
+	 */
+	struct TaskAnalysis {
+		/**
+		 * This is the timing model that was analyzed.
+		 */
+		TaskTimingModel model;
+
+		/**
+		 * This is the predicted worst case response time in microseconds.  If the iteration exceeded the deadline, it is the value at which the iteration was stopped.
+		 */
+		uint64_t worstCaseResponseTime;
+
+		/**
+		 * This is true if the predicted worst case response time is within the deadline.
+		 */
+		bool schedulable;
+	};
+
+	/**
+	 * This structure holds the analysis result for all tasks which share a CPU.
+	 */
+	struct CpuAnalysis {
+		/**
+		 * This is the CPU that was analyzed.  A value of -1 represents the tasks which are not bound to a CPU.
+		 */
+		int cpu;
+
+		/**
+		 * This is the number of CPUs which the tasks are spread across.  It is 1 for a single CPU.
+		 */
+		int cpuCount;
+
+		/**
+		 * This is the total utilization of the tasks on the CPU.
+		 */
+		double utilization;
+
+		/**
+		 * This is the Liu and Layland utilization bound for the number of tasks on the CPU.  For tasks spread across several
+		 * CPUs, it is the number of CPUs, which the utilization can never exceed.
+		 */
+		double utilizationBound;
+
+		/**
+		 * This is true if every task on the CPU is schedulable.
+		 */
+		bool schedulable;
+
+		/**
+		 * These are the results for each task on the CPU, ordered from highest to lowest priority.
+		 */
+		std::vector<TaskAnalysis> tasks;
+	};
+
+	/**
+	 * This method will analyze a given task set.
+	 * @param tasks This is the set of task timing models that is to be analyzed.
+	 * @param results This is the vector which will be filled with one entry per CPU.
+	 * @return The return will be true if the entire task set is schedulable or false otherwise.
+	 */
+	static bool analyze(const std::vector<TaskTimingModel> &tasks, std::vector<CpuAnalysis> &results);
+
+	/**
+	 * This method will analyze the set of tasks which are currently running.
+	 * @param results This is the vector which will be filled with one entry per CPU.
+	 * @return The return will be true if the running task set is schedulable or false otherwise.
+	 */
+	static bool analyzeRunningTasks(std::vector<CpuAnalysis> &results);
+
+	/**
+	 * This method will determine if the given task may be started, applying the admission policy.
+	 * @param candidate This is the task which is about to be started.
+	 * @return The return will be true if the task may start or false if it is refused.
+	 */
+	static bool admit(RunnableClass *candidate);
+
+	/**
+	 * This method will evaluate the running task set with a task's parameters changed, applying the admission policy.  The
+	 * change is checked before it is made, so the task keeps its parameters if the change is refused.
+	 * @param changedTask This is the task whose parameters are to be changed.
+	 * @param changedModel This is the timing model of the task with the changed parameters.
+	 * @return The return will be true if the change may be made or false if it is to be refused.
+	 */
+	static bool reevaluate(RunnableClass *changedTask, const TaskTimingModel &changedModel);
+
+	/**
+	 * This method will print out to the console the analysis of the running task set.
+	 */
+	static void printAnalysis();
+
+	/**
+	 * This method will print out to the console the given analysis results.
+	 * @param results These are the results that are to be printed.
+	 */
+	static void printAnalysis(const std::vector<CpuAnalysis> &results);
+
+	/**
+	 * This method will set the admission policy which is used when tasks are started or changed.
+	 * @param policy This is the new admission policy.
+	 */
+	static void setAdmissionPolicy(AdmissionPolicy policy);
+
+	/**
+	 * This method will obtain the admission policy.
+	 * @return The return will be the current admission policy.
+	 */
+	static AdmissionPolicy getAdmissionPolicy();
+
+private:
+	/**
+	 * This is the policy applied when tasks are started or changed.  By default, a warning is logged.
+	 */
+	static AdmissionPolicy admissionPolicy;
+
+	/**
+	 * This method will collect the timing models of all of the running tasks.
+	 * @param tasks This is the vector that the models are to be appended to.
+	 * @param exclude This is a task which is not to be collected, as the caller will add its model.  It may be NULL.
+	 */
+	static void collectRunningTasks(std::vector<TaskTimingModel> &tasks, RunnableClass *exclude);
+
+	/**
+	 * This method will obtain the priority of a task as seen by the analysis.
+	 * @param model This is the timing model of the task.
+	 * @return The return will be the effective priority of the task.
+	 */
+	static int effectivePriority(const TaskTimingModel &model);
+
+	/**
+	 * This method will analyze the tasks which share a single CPU using response time analysis.
+	 * @param cpuResult This is the result for the CPU.  Its task list must be filled in before the call.
+	 */
+	static void analyzeCpu(CpuAnalysis &cpuResult);
+
+	/**
+	 * This method will analyze the tasks which are spread across several CPUs using response time analysis for global
+	 * fixed priority scheduling.
+	 * @param cpuResult This is the result for the CPUs.  Its task list and CPU count must be filled in before the call.
+	 */
+	static void analyzeGlobal(CpuAnalysis &cpuResult);
+
+	/**
+	 * This method will check a task set with a candidate task added, applying the admission policy.
+	 * @param candidate This is the task that is to be checked.  Its current model is left out of the running task set.
+	 * @param candidateModel This is the timing model of the candidate which is to be checked.
+	 * @param action This is a human readable description of what is being done to the candidate.
+	 * @return The return will be true if the candidate is accepted or false otherwise.
+	 */
+	static bool checkWithCandidate(RunnableClass *candidate, const TaskTimingModel &candidateModel, const char *action);
+};
+
+#endif /* SCHEDULABILITYANALYZER_H_ */
@@ -0,0 +1,87 @@
+/**
+ * @file SeqLock.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a sequence lock, which publishes a value from a single writer
+ *      to any number of readers.  The writer never waits.  A reader copies the value
+ *      and retries if the writer changed it during the copy, so the reader always
+ *      obtains a consistent (tear free) copy without blocking the writer.  The value
+ *      must be trivially copyable and should be small.
+ */
+
+#ifndef SEQLOCK_H_
+#define SEQLOCK_H_
+
+#include <atomic>
+#include <string.h>
+#include <stdint.h>
+
+template<typename T>
+class SeqLock {
+private:
+	/**
+	 * This is the sequence number.  It is odd while a write is in progress.
+	 */
+	std::atomic<uint32_t> sequence;
+
+	/**
+	 * This is the published value.
+	 */
+	T value;
+
+public:
+	/**
+	 * This is the constructor for the class.  The value starts out default constructed.
+	 */
+	SeqLock() :
+			sequence(0), value() {
+	}
+
+	/**
+	 * This method will publish a new value.  It may only be called by one thread at a time.
+	 * @param newValue This is the value that is to be published.
+	 */
+	void write(const T &newValue) {
+		uint32_t current = sequence.load(std::memory_order_relaxed);
+		sequence.store(current + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		memcpy((void *) &value, (const void *) &newValue, sizeof(T));
+		sequence.store(current + 2, std::memory_order_release);
+	}
+
+	/**
+	 * This method will obtain a consistent copy of the published value.  It never blocks the writer.
+	 * @param copy This is the value which is filled in.
+	 */
+	void read(T &copy) const {
+		uint32_t before;
+		uint32_t after;
+		do {
+			before = sequence.load(std::memory_order_acquire);
+			memcpy((void *) &copy, (const void *) &value, sizeof(T));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = sequence.load(std::memory_order_relaxed);
+		} while ((before & 1) || (before != after));
+	}
+};
+
+#endif /* SEQLOCK_H_ */
@@ -0,0 +1,182 @@
+/**
+ * @file SporadicTask.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a sporadic task, which is released by events rather than by a
+ *      timer, and which enforces a minimum inter-arrival time and a budget.
+ */
+
+#include "SporadicTask.h"
+#include <time.h>
+
+/**
+ * This function will obtain the current time of a clock in nanoseconds.
+ * @param clock This is the clock.
+ * @return The return will be the current time in nanoseconds.
+ */
+static uint64_t clockNow(TaskClock *clock) {
+	struct timespec ts;
+	clock->getTime(ts);
+	return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+/**
+ * This function will convert a time in nanoseconds into a timespec.
+ * @param time This is the time in nanoseconds.
+ * @return The return will be the time as a timespec.
+ */
+static struct timespec toTimespec(uint64_t time) {
+	struct timespec ts;
+	ts.tv_sec = time / 1000000000ULL;
+	ts.tv_nsec = time % 1000000000ULL;
+	return ts;
+}
+
+/**
+ * This is the constructor for the class.
+ * @param threadName This is the name of the thread in a human readable format.
+ * @param minimumInterArrivalTime This is the shortest time between releases, given in microseconds.
+ * @param budget This is the execution budget for each release, given in microseconds.
+ */
+SporadicTask::SporadicTask(std::string threadName, uint32_t minimumInterArrivalTime, uint32_t budget) :
+		PeriodicTask(threadName, minimumInterArrivalTime), pendingArrival(0), eventCount(0), combinedEvents(0), deferredReleases(0) {
+	setExecutionBudget(budget);
+}
+
+/**
+ * This is the destructor for the class.
+ */
+SporadicTask::~SporadicTask() {
+	/**
+	 * Nothing to be done in the destructor.
+	 */
+}
+
+/**
+ * This method will signal an event, releasing the task as soon as the minimum inter-arrival time and the budget allow.
+ * It may be called from any thread, including a real time thread, and never blocks.
+ */
+void SporadicTask::release() {
+	uint64_t expected = 0;
+	eventCount.fetch_add(1, std::memory_order_relaxed);
+
+	/**
+	 * Only the first event of a release records its arrival time.  Later events are combined with the pending release.
+	 */
+	if (pendingArrival.compare_exchange_strong(expected, clockNow(getClock()))) {
+		wakeup.signal();
+	} else {
+		combinedEvents.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+/**
+ * This method will release the task, as release does.
+ */
+void SporadicTask::releaseNow() {
+	release();
+}
+
+/**
+ * This method will wait until the given time, or until the task is stopped.
+ * @param deadline This is the time of the task's clock to wait until.
+ */
+void SporadicTask::waitUntil(const struct timespec &deadline) {
+	for (;;) {
+		uint32_t generation = wakeup.getGeneration();
+		if ((keepGoing == false) || (getClock()->waitUntil(deadline, wakeup, generation) == false)) {
+			return;
+		}
+	}
+}
+
+/**
+ * This is the run method for the class.  It waits for events and releases the task for them.
+ */
+void SporadicTask::run() {
+	uint64_t earliestRelease = 0;
+
+	while (keepGoing == true) {
+		/**
+		 * 1.0 Wait for an event.  The generation is read before the check, so an event after the check is not missed.  While
+		 * the task is suspended, events are held until it is resumed.
+		 */
+		uint32_t generation = wakeup.getGeneration();
+		uint64_t arrival = pendingArrival.load();
+		if ((arrival == 0) || isSuspended()) {
+			struct timespec forever = toTimespec(clockNow(getClock()) + 3600000000000ULL);
+			getClock()->waitUntil(forever, wakeup, generation);
+			continue;
+		}
+
+		/**
+		 * 2.0 Hold the release back until the minimum inter-arrival time (and any budget overrun) has passed since the last release.
+		 */
+		uint64_t releaseTime = arrival;
+		if (earliestRelease > arrival) {
+			deferredReleases.fetch_add(1, std::memory_order_relaxed);
+			waitUntil(toTimespec(earliestRelease));
+			if (keepGoing == false) {
+				break;
+			}
+			releaseTime = earliestRelease;
+		}
+
+		/**
+		 * 3.0 Take the pending events and execute the task for them.  Events which arrive from now on make a new release.
+		 */
+		pendingArrival.store(0);
+		long executionTime = executeRelease(toTimespec(releaseTime));
+
+		/**
+		 * 4.0 Work out when the next release may happen.  A release which used more than its budget holds the task off for
+		 * one minimum inter-arrival time per budget used, which replenishes the budget it overdrew.
+		 */
+		uint64_t interArrival = getTaskPeriod() * 1000ULL;
+		uint64_t budget = getExecutionBudget();
+		uint64_t budgetsUsed = 1;
+		if ((budget > 0) && ((uint64_t) executionTime > budget)) {
+			budgetsUsed = ((uint64_t) executionTime + budget - 1) / budget;
+		}
+		earliestRelease = releaseTime + (interArrival * budgetsUsed);
+	}
+
+	/**
+	 * The task no longer uses its clock.
+	 */
+	getClock()->detachTask(this);
+}
+
+/**
+ * These methods obtain the event statistics of the task.
+ */
+uint64_t SporadicTask::getEventCount() {
+	return eventCount.load(std::memory_order_relaxed);
+}
+
+uint64_t SporadicTask::getCombinedEvents() {
+	return combinedEvents.load(std::memory_order_relaxed);
+}
+
+uint64_t SporadicTask::getDeferredReleases() {
+	return deferredReleases.load(std::memory_order_relaxed);
+}
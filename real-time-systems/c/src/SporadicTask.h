@@ -0,0 +1,119 @@
+/**
+ * @file SporadicTask.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a sporadic task, which is released by events rather than by a
+ *      timer.  Events may arrive from any thread at any time, but the task is never
+ *      released more often than its minimum inter-arrival time, and it behaves as a
+ *      sporadic server: if a release uses more CPU time than the execution budget,
+ *      the following release is held back by one minimum inter-arrival time for
+ *      each budget used.  Over any interval, the task therefore uses no more than
+ *      its budget per minimum inter-arrival time, which is exactly what the
+ *      schedulability analysis assumes of it, so event driven work can not starve
+ *      the periodic tasks.  The enforcement is applied between releases, so for a
+ *      hard guarantee within a release, use SCHED_DEADLINE as well.
+ *
+ *      Events which arrive while a release is pending are combined with it, so
+ *      the task method should handle all of the work which is waiting.  The
+ *      minimum inter-arrival time is the task period, and the statistics are the
+ *      same as those of a periodic task, with the response time measured from the
+ *      release, which is the first event or, if it was held back, the time at
+ *      which the release became eligible.
+ */
+
+#ifndef SPORADICTASK_H_
+#define SPORADICTASK_H_
+
+#include "PeriodicTask.h"
+
+#include <atomic>
+#include <stdint.h>
+
+class SporadicTask: public PeriodicTask {
+private:
+	/**
+	 * This is the time of the task's clock, in nanoseconds, at which the first event of the pending release arrived.  It is 0
+	 * if no release is pending.
+	 */
+	std::atomic<uint64_t> pendingArrival;
+
+	/**
+	 * This is the number of events which have arrived.
+	 */
+	std::atomic<uint64_t> eventCount;
+
+	/**
+	 * This is the number of events which were combined with a release which was already pending.
+	 */
+	std::atomic<uint64_t> combinedEvents;
+
+	/**
+	 * This is the number of releases which were held back to enforce the minimum inter-arrival time or the budget.
+	 */
+	std::atomic<uint64_t> deferredReleases;
+
+	/**
+	 * This method will wait until the given time, or until the task is stopped.
+	 * @param deadline This is the time of the task's clock to wait until.
+	 */
+	void waitUntil(const struct timespec &deadline);
+
+public:
+	/**
+	 * This is the constructor for the class.
+	 * @param threadName This is the name of the thread in a human readable format.
+	 * @param minimumInterArrivalTime This is the shortest time between releases, given in microseconds.  It is used as
+	 * the period (and the deadline) of the task.
+	 * @param budget This is the execution budget for each release, given in microseconds.
+	 */
+	SporadicTask(std::string threadName, uint32_t minimumInterArrivalTime, uint32_t budget);
+
+	/**
+	 * This is the destructor for the class.
+	 */
+	virtual ~SporadicTask();
+
+	/**
+	 * This method will signal an event, releasing the task as soon as the minimum inter-arrival time and the budget allow.
+	 * It may be called from any thread, including a real time thread, and never blocks.
+	 */
+	void release();
+
+	/**
+	 * This method will release the task, as release does.
+	 */
+	virtual void releaseNow();
+
+	/**
+	 * This is the run method for the class.  It waits for events and releases the task for them.
+	 */
+	virtual void run();
+
+	/**
+	 * These methods obtain the event statistics of the task.
+	 */
+	uint64_t getEventCount();
+	uint64_t getCombinedEvents();
+	uint64_t getDeferredReleases();
+};
+
+#endif /* SPORADICTASK_H_ */
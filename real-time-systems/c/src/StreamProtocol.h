@@ -0,0 +1,553 @@
+/**
+ * @file StreamProtocol.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This file defines the datagrams of the compressed image stream.  A JPEG
+ *      datagram starts with a StreamSliceHeader, and is followed by the payload,
+ *      which is a horizontal slice of a frame that can be decoded on its own.  A
+ *      lost datagram therefore only loses its rows of the frame.  A tile datagram
+ *      starts with a StreamTileHeader, and is followed by the tiles of the frame
+ *      which have changed since they were last sent.  A lossless datagram starts
+ *      with a StreamRowHeader, and is followed by rows of the frame compressed by
+ *      the LosslessRowCodec.  A pixel row datagram also starts with a
+ *      StreamRowHeader, and is followed by rows of the frame converted to a
+ *      smaller pixel format.  When forward error correction is on, each of these
+ *      datagrams is wrapped in a StreamFecHeader, and every group of them is
+ *      followed by parity datagrams from which lost ones can be rebuilt.  When
+ *      retransmission is on, each datagram is first wrapped in a
+ *      StreamSequenceHeader, which numbers it within its frame, so that the
+ *      receiver can ask for the lost ones again.  When several resolutions of
+ *      the frames are sent on one socket, each datagram, with any of these
+ *      headers, is finally wrapped in a StreamSimulcastHeader, which names the
+ *      stream it belongs to.  The receiver answers on the same socket with
+ *      StreamFeedback messages, StreamNack messages for lost datagrams, and
+ *      periodic StreamReceiverReport messages.  All integers in the headers are
+ *      in network byte order.
+ */
+
+#ifndef STREAMPROTOCOL_H_
+#define STREAMPROTOCOL_H_
+
+#include <stdint.h>
+
+/**
+ * This is the magic number which starts every datagram of the compressed stream ("RTSS").  It can not be mistaken for
+ * the first word of a raw datagram, which is the number of lines in it.
+ */
+#define STREAM_MAGIC 0x52545353
+
+/**
+ * This is the version of the stream protocol.
+ */
+#define STREAM_VERSION 1
+
+/**
+ * This is the largest UDP datagram which can be sent over IPv4.
+ */
+#define STREAM_MAX_DATAGRAM_SIZE 65507
+
+/**
+ * This enumeration defines the kinds of payload.
+ */
+enum StreamPayloadType {
+	STREAM_PAYLOAD_JPEG = 1, /**< The slice is a baseline JPEG holding rowCount rows of the frame, starting at firstRow. */
+	STREAM_PAYLOAD_TILES = 2, /**< The datagram holds tileCount tiles, each a StreamTile followed by its raw BGR rows. */
+	STREAM_PAYLOAD_LOSSLESS_ROWS = 3, /**< The datagram holds rowCount rows, starting at firstRow, compressed without loss. */
+	STREAM_PAYLOAD_PIXEL_ROWS = 4 /**< The datagram holds rowCount rows, starting at firstRow, in the pixelFormat of the header. */
+};
+
+/**
+ * This enumeration defines the pixel formats which rows can be sent in.
+ */
+enum StreamPixelFormat {
+	STREAM_PIXEL_BGR24 = 0, /**< 3 bytes per pixel: blue, green and red. */
+	STREAM_PIXEL_Y8 = 1, /**< 1 byte per pixel: the luma only. */
+	STREAM_PIXEL_YUV420 = 2, /**< The luma plane of the rows, then the U and V planes, each sampled once per 2x2 pixels. */
+	STREAM_PIXEL_RGB565 = 3 /**< 2 bytes per pixel, little endian: 5 bits of red, 6 of green and 5 of blue. */
+};
+
+/**
+ * This is the flag of a StreamTileHeader which marks a keyframe, in which every tile of the frame is sent.
+ */
+#define STREAM_FLAG_KEYFRAME 0x0001
+
+/**
+ * This structure is the header of a datagram of the compressed stream.  It is 32 bytes.
+ */
+struct StreamSliceHeader {
+	/**
+	 * This is the magic number, STREAM_MAGIC.
+	 */
+	uint32_t magic;
+
+	/**
+	 * This is the version of the protocol, STREAM_VERSION.
+	 */
+	uint8_t version;
+
+	/**
+	 * This is the kind of payload (a StreamPayloadType).
+	 */
+	uint8_t payloadType;
+
+	/**
+	 * This is the index of the slice within the frame, and the number of slices in the frame.
+	 */
+	uint16_t sliceIndex;
+	uint16_t sliceCount;
+
+	/**
+	 * These are the first row of the frame which the slice holds, and the number of rows it holds.
+	 */
+	uint16_t firstRow;
+	uint16_t rowCount;
+
+	/**
+	 * These are the width and the height of the whole frame in pixels.
+	 */
+	uint16_t frameWidth;
+	uint16_t frameHeight;
+
+	/**
+	 * This is the quality which the slice was encoded at.  It may be below the quality of the stream if the slice had
+	 * to be reduced to fit the datagram.
+	 */
+	uint16_t quality;
+
+	/**
+	 * This is the count of the frame, which is the same for all of its slices.
+	 */
+	uint32_t frameId;
+
+	/**
+	 * This is the time, in milliseconds, at which the transmission of the frame started.
+	 */
+	uint32_t timestamp;
+
+	/**
+	 * This is the size of the payload which follows the header in bytes.
+	 */
+	uint32_t payloadSize;
+} __attribute__((packed));
+
+/**
+ * This structure is the header of a datagram of tiles.  It is 32 bytes.  A frame in which no tile has changed is still
+ * sent, as a single datagram without tiles.
+ */
+struct StreamTileHeader {
+	/**
+	 * This is the magic number, STREAM_MAGIC.
+	 */
+	uint32_t magic;
+
+	/**
+	 * This is the version of the protocol, STREAM_VERSION.
+	 */
+	uint8_t version;
+
+	/**
+	 * This is the kind of payload, STREAM_PAYLOAD_TILES.
+	 */
+	uint8_t payloadType;
+
+	/**
+	 * These are the flags of the frame, such as STREAM_FLAG_KEYFRAME.
+	 */
+	uint16_t flags;
+
+	/**
+	 * This is the index of the datagram within the frame, and the number of datagrams in the frame.
+	 */
+	uint16_t datagramIndex;
+	uint16_t datagramCount;
+
+	/**
+	 * This is the width and height of a tile in pixels.  The tiles on the right and bottom edges may be smaller.
+	 */
+	uint16_t tileSize;
+
+	/**
+	 * This is the number of tiles in the datagram.
+	 */
+	uint16_t tileCount;
+
+	/**
+	 * These are the width and the height of the whole frame in pixels.
+	 */
+	uint16_t frameWidth;
+	uint16_t frameHeight;
+
+	/**
+	 * This is the count of the frame, which is the same for all of its datagrams.
+	 */
+	uint32_t frameId;
+
+	/**
+	 * This is the time, in milliseconds, at which the transmission of the frame started.
+	 */
+	uint32_t timestamp;
+
+	/**
+	 * This is the count of the last keyframe.  A receiver which did not get all of that keyframe can not rebuild the
+	 * frame, and should ask for a new keyframe.
+	 */
+	uint32_t keyframeId;
+} __attribute__((packed));
+
+/**
+ * This structure is the header of a datagram of rows, either losslessly compressed or in a smaller pixel format.  It is
+ * 32 bytes.  The rows of one datagram only depend on each other, so every datagram can be decoded on its own.
+ */
+struct StreamRowHeader {
+	/**
+	 * This is the magic number, STREAM_MAGIC.
+	 */
+	uint32_t magic;
+
+	/**
+	 * This is the version of the protocol, STREAM_VERSION.
+	 */
+	uint8_t version;
+
+	/**
+	 * This is the kind of payload, STREAM_PAYLOAD_LOSSLESS_ROWS or STREAM_PAYLOAD_PIXEL_ROWS.
+	 */
+	uint8_t payloadType;
+
+	/**
+	 * This is the pixel format of the rows (a StreamPixelFormat).  Lossless rows are always STREAM_PIXEL_BGR24.
+	 */
+	uint8_t pixelFormat;
+
+	/**
+	 * This is reserved, and is 0.
+	 */
+	uint8_t reserved;
+
+	/**
+	 * These are the first row of the frame which the datagram holds, and the number of rows it holds.
+	 */
+	uint16_t firstRow;
+	uint16_t rowCount;
+
+	/**
+	 * These are the width and the height of the whole frame in pixels.
+	 */
+	uint16_t frameWidth;
+	uint16_t frameHeight;
+
+	/**
+	 * This is the count of the frame, which is the same for all of its datagrams.
+	 */
+	uint32_t frameId;
+
+	/**
+	 * This is the time, in milliseconds, at which the transmission of the frame started.
+	 */
+	uint32_t timestamp;
+
+	/**
+	 * This is the size of the rows which follow the header in bytes.
+	 */
+	uint32_t payloadSize;
+
+	/**
+	 * This is the size of the rows before they were compressed in bytes.  It is payloadSize for uncompressed rows.
+	 */
+	uint32_t rawSize;
+} __attribute__((packed));
+
+/**
+ * This structure precedes the rows of each tile in a datagram of tiles.  It is 4 bytes.
+ */
+struct StreamTile {
+	/**
+	 * These are the column and the row of the tile, counted in tiles from the top left of the frame.
+	 */
+	uint16_t column;
+	uint16_t row;
+} __attribute__((packed));
+
+/**
+ * This is the magic number which starts every datagram of a stream protected by forward error correction ("RTSE").
+ */
+#define STREAM_FEC_MAGIC 0x52545345
+
+/**
+ * This structure precedes every datagram of a stream protected by forward error correction.  It is 12 bytes.  A data
+ * datagram is followed by the datagram it protects, as it would have been sent without protection.  A parity datagram
+ * is followed by a parity block.  The parity is computed over protected blocks, each of which is the length of a data
+ * datagram (2 bytes) followed by the datagram, padded with zeros to the longest block of the group.  A lost data datagram
+ * is rebuilt, with its length, from any dataCount of the group's data and parity blocks.  Groups never span frames.
+ */
+struct StreamFecHeader {
+	/**
+	 * This is the magic number, STREAM_FEC_MAGIC.
+	 */
+	uint32_t magic;
+
+	/**
+	 * This is the version of the protocol, STREAM_VERSION.
+	 */
+	uint8_t version;
+
+	/**
+	 * This is the index of the datagram within its group.  The data datagrams come first, and are followed by the
+	 * parity datagrams, from index dataCount on.
+	 */
+	uint8_t index;
+
+	/**
+	 * This is the number of data datagrams in the group.  In a data datagram, it is the most the group can hold, as the
+	 * group may be closed early at the end of a frame.  In a parity datagram, it is the number which the group holds.
+	 */
+	uint8_t dataCount;
+
+	/**
+	 * This is the number of parity datagrams in the group.
+	 */
+	uint8_t parityCount;
+
+	/**
+	 * This is the count of the group, which increases by one for each group of the stream.
+	 */
+	uint32_t groupId;
+} __attribute__((packed));
+
+/**
+ * This is the most which forward error correction adds to a datagram.  A parity datagram is this much longer than the
+ * longest datagram of its group, so a datagram can only be protected if it is at most STREAM_MAX_DATAGRAM_SIZE minus
+ * this many bytes long.
+ */
+#define STREAM_FEC_OVERHEAD (sizeof(StreamFecHeader) + 2)
+
+/**
+ * This is the magic number which starts every datagram of a stream which can be retransmitted ("RTSQ").
+ */
+#define STREAM_SEQUENCE_MAGIC 0x52545351
+
+/**
+ * This is the flag of a StreamSequenceHeader which marks a datagram that is sent again because the receiver lost it.
+ */
+#define STREAM_FLAG_RETRANSMITTED 0x01
+
+/**
+ * This structure precedes every datagram of a stream which can be retransmitted.  It is 16 bytes, and is followed by the
+ * datagram as it would have been sent without retransmission.  When forward error correction is also on, it is this
+ * datagram which is protected, and retransmitted datagrams are sent without a StreamFecHeader.
+ */
+struct StreamSequenceHeader {
+	/**
+	 * This is the magic number, STREAM_SEQUENCE_MAGIC.
+	 */
+	uint32_t magic;
+
+	/**
+	 * This is the version of the protocol, STREAM_VERSION.
+	 */
+	uint8_t version;
+
+	/**
+	 * These are the flags of the datagram, such as STREAM_FLAG_RETRANSMITTED.
+	 */
+	uint8_t flags;
+
+	/**
+	 * This is the index of the datagram within its frame, counting from 0.
+	 */
+	uint16_t datagramIndex;
+
+	/**
+	 * This is the count of the frame which the datagram belongs to.
+	 */
+	uint32_t frameId;
+
+	/**
+	 * This is the number of datagrams in the frame before this one, so that the receiver can tell when the last
+	 * datagrams of that frame were lost.  It is 0 if the frame before was not sent with sequence headers.
+	 */
+	uint16_t previousDatagramCount;
+
+	/**
+	 * This is reserved, and is 0.
+	 */
+	uint16_t reserved;
+} __attribute__((packed));
+
+/**
+ * This is the magic number which starts every datagram of a simulcast ("RTSC").
+ */
+#define STREAM_SIMULCAST_MAGIC 0x52545343
+
+/**
+ * This structure precedes every datagram of a simulcast, in which each resolution of the frames is sent as its own
+ * stream on one socket.  It is 8 bytes, and is followed by the datagram as it would have been sent without simulcast,
+ * including any StreamFecHeader or StreamSequenceHeader.  A receiver keeps the datagrams of the stream it subscribes
+ * to, and drops the rest before decoding them.
+ */
+struct StreamSimulcastHeader {
+	/**
+	 * This is the magic number, STREAM_SIMULCAST_MAGIC.
+	 */
+	uint32_t magic;
+
+	/**
+	 * This is the version of the protocol, STREAM_VERSION.
+	 */
+	uint8_t version;
+
+	/**
+	 * This is the stream which the datagram belongs to.  Stream 0 is the full resolution, and each stream after it is
+	 * a smaller resolution.
+	 */
+	uint8_t streamId;
+
+	/**
+	 * This is the number of streams in the simulcast.
+	 */
+	uint8_t streamCount;
+
+	/**
+	 * This is reserved, and is 0.
+	 */
+	uint8_t reserved;
+} __attribute__((packed));
+
+/**
+ * This is the magic number which starts every feedback message from the receiver ("RTSF").
+ */
+#define STREAM_FEEDBACK_MAGIC 0x52545346
+
+/**
+ * This enumeration defines the kinds of feedback from the receiver.
+ */
+enum StreamFeedbackType {
+	STREAM_FEEDBACK_KEYFRAME = 1, /**< The receiver can not rebuild the frames, and asks for a keyframe. */
+	STREAM_FEEDBACK_NACK = 2, /**< The receiver lost datagrams of the frame, and asks for them again in a StreamNack. */
+	STREAM_FEEDBACK_REPORT = 3 /**< The receiver reports what it has received in a StreamReceiverReport. */
+};
+
+/**
+ * This structure is a feedback message, which the receiver sends back to the address the stream comes from.  It is
+ * 12 bytes.
+ */
+struct StreamFeedback {
+	/**
+	 * This is the magic number, STREAM_FEEDBACK_MAGIC.
+	 */
+	uint32_t magic;
+
+	/**
+	 * This is the version of the protocol, STREAM_VERSION.
+	 */
+	uint8_t version;
+
+	/**
+	 * This is the kind of feedback (a StreamFeedbackType).
+	 */
+	uint8_t type;
+
+	/**
+	 * This is the stream of a simulcast which the feedback is for, or 0 if the stream is not a simulcast.
+	 */
+	uint8_t streamId;
+
+	/**
+	 * This is reserved, and is 0.
+	 */
+	uint8_t reserved;
+
+	/**
+	 * This is the count of the last frame which the receiver got.
+	 */
+	uint32_t frameId;
+} __attribute__((packed));
+
+/**
+ * This is the number of datagrams which one StreamNack can ask for.
+ */
+#define STREAM_NACK_BITS 128
+
+/**
+ * This structure is a feedback message which asks for lost datagrams of a frame again.  It is 32 bytes.  Bit n of the
+ * bitmap, counting from the least significant bit of the first word, asks for datagram firstIndex + n of the frame.
+ */
+struct StreamNack {
+	/**
+	 * This is the feedback, with the type STREAM_FEEDBACK_NACK and the count of the frame which lost the datagrams.
+	 */
+	StreamFeedback feedback;
+
+	/**
+	 * This is the index of the datagram which the first bit of the bitmap refers to.
+	 */
+	uint16_t firstIndex;
+
+	/**
+	 * This is reserved, and is 0.
+	 */
+	uint16_t reserved;
+
+	/**
+	 * This is the bitmap of the datagrams which were lost.
+	 */
+	uint32_t bitmap[STREAM_NACK_BITS / 32];
+} __attribute__((packed));
+
+/**
+ * This structure is a feedback message which reports what the receiver has received since its last report.  It is 28
+ * bytes.  The receiver sends one periodically, so that the sender can fit the stream to the link.
+ */
+struct StreamReceiverReport {
+	/**
+	 * This is the feedback, with the type STREAM_FEEDBACK_REPORT and the count of the newest frame received.
+	 */
+	StreamFeedback feedback;
+
+	/**
+	 * This is the fraction of the datagrams which were lost on the link during the interval, in units of 1/65536.  It is
+	 * counted before the lost datagrams are rebuilt or retransmitted.
+	 */
+	uint16_t lossFraction;
+
+	/**
+	 * This is the length of the interval which the report covers in milliseconds.
+	 */
+	uint16_t interval;
+
+	/**
+	 * This is the interarrival jitter of the frames in microseconds, smoothed as in RFC 3550.
+	 */
+	uint32_t jitter;
+
+	/**
+	 * This is the rate at which the stream was received during the interval in kilobits per second.
+	 */
+	uint32_t receiveRate;
+
+	/**
+	 * This is the number of datagrams which were received during the interval.
+	 */
+	uint32_t datagramsReceived;
+} __attribute__((packed));
+
+#endif /* STREAMPROTOCOL_H_ */
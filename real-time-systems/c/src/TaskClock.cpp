@@ -0,0 +1,90 @@
+/**
+ * @file TaskClock.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is the clock which a periodic task uses to read the time, to
+ *      wait for its next release, and to account for its CPU time.
+ */
+
+#include "TaskClock.h"
+
+/**
+ * This is the destructor for the class.
+ */
+TaskClock::~TaskClock() {
+	/**
+	 * Nothing to be done in the destructor.
+	 */
+}
+
+/**
+ * This method is called when a task starts using the clock.  The system clock does not need to know.
+ * @param task This is the task.
+ */
+void TaskClock::attachTask(PeriodicTask *task) {
+}
+
+/**
+ * This method is called when a task stops using the clock.  The system clock does not need to know.
+ * @param task This is the task.
+ */
+void TaskClock::detachTask(PeriodicTask *task) {
+}
+
+/**
+ * This method is called at the end of each execution of a task to obtain the CPU time which the execution is accounted
+ * with.  By default, it is the time the execution actually used.
+ * @param task This is the task which executed.
+ * @param measuredTime This is the CPU time the execution actually used, in microseconds.
+ * @return The return will be the CPU time of the execution, in microseconds.
+ */
+long TaskClock::accountExecution(PeriodicTask *task, long measuredTime) {
+	return measuredTime;
+}
+
+/**
+ * This method will obtain the system clock.
+ * @return The return will be the clock which uses the real CLOCK_MONOTONIC.
+ */
+TaskClock* TaskClock::getSystemClock() {
+	static SystemClock systemClock;
+	return &systemClock;
+}
+
+/**
+ * This method will obtain the current CLOCK_MONOTONIC time.
+ * @param now This is the time which is filled in.
+ */
+void SystemClock::getTime(struct timespec &now) {
+	clock_gettime(CLOCK_MONOTONIC, &now);
+}
+
+/**
+ * This method will wait on the wakeup event until it is signaled or the deadline is reached.
+ * @param deadline This is the CLOCK_MONOTONIC time at which to stop waiting.
+ * @param wakeup This is the event which ends the wait early.
+ * @param observedGeneration This is the generation of the event which the caller read before checking its condition.
+ * @return The return will be true if the event was signaled or false if the deadline was reached.
+ */
+bool SystemClock::waitUntil(const struct timespec &deadline, WakeupEvent &wakeup, uint32_t observedGeneration) {
+	return wakeup.waitUntil(deadline, observedGeneration);
+}
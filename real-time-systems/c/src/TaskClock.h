@@ -0,0 +1,109 @@
+/**
+ * @file TaskClock.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is the clock which a periodic task uses to read the time, to
+ *      wait for its next release, and to account for the CPU time of each
+ *      execution.  The system clock, which every task uses by default, is the
+ *      real CLOCK_MONOTONIC.  Other clocks, such as the VirtualClock, let a task
+ *      set run in simulated time instead.
+ */
+
+#ifndef TASKCLOCK_H_
+#define TASKCLOCK_H_
+
+#include "WakeupEvent.h"
+
+#include <stdint.h>
+#include <time.h>
+
+class PeriodicTask;
+
+class TaskClock {
+public:
+	/**
+	 * This is the destructor for the class.
+	 */
+	virtual ~TaskClock();
+
+	/**
+	 * This method will obtain the current time of the clock.
+	 * @param now This is the time which is filled in.  It is comparable with CLOCK_MONOTONIC times of the same clock.
+	 */
+	virtual void getTime(struct timespec &now) = 0;
+
+	/**
+	 * This method will wait until the wakeup event is signaled or the clock reaches the deadline.
+	 * @param deadline This is the time of the clock at which to stop waiting.
+	 * @param wakeup This is the event which ends the wait early.
+	 * @param observedGeneration This is the generation of the event which the caller read before checking its condition.
+	 * @return The return will be true if the event was signaled or false if the deadline was reached.
+	 */
+	virtual bool waitUntil(const struct timespec &deadline, WakeupEvent &wakeup, uint32_t observedGeneration) = 0;
+
+	/**
+	 * This method is called when a task starts using the clock.
+	 * @param task This is the task.
+	 */
+	virtual void attachTask(PeriodicTask *task);
+
+	/**
+	 * This method is called when a task stops using the clock, either because it has ended or it is using another clock.
+	 * @param task This is the task.
+	 */
+	virtual void detachTask(PeriodicTask *task);
+
+	/**
+	 * This method is called at the end of each execution of a task to obtain the CPU time which the execution is
+	 * accounted with.
+	 * @param task This is the task which executed.
+	 * @param measuredTime This is the CPU time the execution actually used, in microseconds.
+	 * @return The return will be the CPU time of the execution, in microseconds.
+	 */
+	virtual long accountExecution(PeriodicTask *task, long measuredTime);
+
+	/**
+	 * This method will obtain the system clock.
+	 * @return The return will be the clock which uses the real CLOCK_MONOTONIC.
+	 */
+	static TaskClock* getSystemClock();
+};
+
+class SystemClock: public TaskClock {
+public:
+	/**
+	 * This method will obtain the current CLOCK_MONOTONIC time.
+	 * @param now This is the time which is filled in.
+	 */
+	virtual void getTime(struct timespec &now);
+
+	/**
+	 * This method will wait on the wakeup event until it is signaled or the deadline is reached.
+	 * @param deadline This is the CLOCK_MONOTONIC time at which to stop waiting.
+	 * @param wakeup This is the event which ends the wait early.
+	 * @param observedGeneration This is the generation of the event which the caller read before checking its condition.
+	 * @return The return will be true if the event was signaled or false if the deadline was reached.
+	 */
+	virtual bool waitUntil(const struct timespec &deadline, WakeupEvent &wakeup, uint32_t observedGeneration);
+};
+
+#endif /* TASKCLOCK_H_ */
@@ -0,0 +1,104 @@
+/**
+ * @file TaskStatistics.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This structure is a snapshot of the execution statistics of a periodic
+ *      task.  It is filled in by PeriodicTask::getStatistics, so that the console,
+ *      the metrics exporter and other tools all see the same values.  It must remain
+ *      trivially copyable, as it is published through a SeqLock.
+ */
+
+#ifndef TASKSTATISTICS_H_
+#define TASKSTATISTICS_H_
+
+#include <stdint.h>
+
+struct TaskStatistics {
+	/**
+	 * This is the reset epoch of the statistics.  It increments every time the statistics are reset.
+	 */
+	uint32_t epoch = 0;
+
+	/**
+	 * This is the period of the task in microseconds.
+	 */
+	uint32_t period = 0;
+
+	/**
+	 * This is the number of times the task has been released.
+	 */
+	uint64_t activations = 0;
+
+	/**
+	 * These are the last and the worst case CPU times of the task method, in microseconds.
+	 */
+	int64_t lastExecutionTime = 0;
+	int64_t worstCaseExecutionTime = 0;
+
+	/**
+	 * This is the sum of the CPU times of all of the executions, in microseconds.  It is used to measure the utilization.
+	 */
+	int64_t totalExecutionTime = 0;
+
+	/**
+	 * These are the last and the worst case wall times (from the start of the execution to completion) of the task, in microseconds.
+	 */
+	int64_t lastWallTime = 0;
+	int64_t worstCaseWallTime = 0;
+
+	/**
+	 * These are the last and the worst case response times (from the release until completion) of the task, in microseconds.
+	 */
+	int64_t lastResponseTime = 0;
+	int64_t worstCaseResponseTime = 0;
+
+	/**
+	 * These are the last and the worst case release jitter (from the release until the execution started), in microseconds.
+	 */
+	int64_t lastReleaseJitter = 0;
+	int64_t worstCaseReleaseJitter = 0;
+
+	/**
+	 * This is the number of executions which did not complete within the period.
+	 */
+	uint32_t deadlineMisses = 0;
+
+	/**
+	 * This is the number of executions whose CPU time exceeded the execution budget.
+	 */
+	uint32_t budgetOverruns = 0;
+
+	/**
+	 * These are the heap allocations made by the last execution, and by all of the executions once the task reached a
+	 * steady state.  They are only counted when the allocation counting is compiled in.
+	 */
+	int64_t lastAllocations = 0;
+	uint64_t steadyStateAllocations = 0;
+
+	/**
+	 * These are the page faults taken during the last period and the worst case for a single period.
+	 */
+	int64_t lastPageFaults = 0;
+	int64_t worstCasePageFaults = 0;
+};
+
+#endif /* TASKSTATISTICS_H_ */
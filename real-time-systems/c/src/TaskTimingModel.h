@@ -0,0 +1,76 @@
+/**
+ * @file TaskTimingModel.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This file defines the timing model of a task.  The timing model is the
+ *      set of parameters (period, deadline, execution time, priority) which the
+ *      schedulability analysis uses to reason about a task.
+ */
+
+#ifndef TASKTIMINGMODEL_H_
+#define TASKTIMINGMODEL_H_
+
+#include <string>
+#include <stdint.h>
+
+/**
+ * This structure holds the timing parameters of a single task, as needed by the schedulability analysis.
+ */
+struct TaskTimingModel {
+	/**
+	 * This is the human readable name of the task.
+	 */
+	std::string name;
+
+	/**
+	 * This is the period (or minimum inter-arrival time) of the task in microseconds.
+	 */
+	uint32_t period = 0;
+
+	/**
+	 * This is the relative deadline of the task in microseconds.  For the tasks in this library it is equal to the period.
+	 */
+	uint32_t deadline = 0;
+
+	/**
+	 * This is the worst case execution time of the task in microseconds.  It is the larger of the measured WCET and the configured execution budget.
+	 */
+	uint32_t worstCaseExecutionTime = 0;
+
+	/**
+	 * This is the real time priority of the task.  Larger values are higher priority.  A value of 0 or less indicates a non real time task.
+	 */
+	int priority = 0;
+
+	/**
+	 * This is the CPU the task is bound to.  A value of -1 indicates that the task may run on any CPU.
+	 */
+	int cpu = -1;
+
+	/**
+	 * This is true if the task is scheduled by SCHED_DEADLINE.  Such tasks run ahead of every SCHED_FIFO task, and their
+	 * worst case execution time is their runtime budget, which the kernel enforces.
+	 */
+	bool deadlineScheduled = false;
+};
+
+#endif /* TASKTIMINGMODEL_H_ */
@@ -0,0 +1,298 @@
+/**
+ * @file TileDeltaEncoder.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class encodes the frames of a stream as tile deltas.
+ */
+
+#include "TileDeltaEncoder.h"
+#include "Logger.h"
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * This method will work out the largest sum of absolute differences of any 8 byte group of two rows of bytes.  Taking
+ * the largest group, rather than the whole row, keeps a change of a pixel or two from being averaged away.  It is the
+ * inner loop of the comparison, so it uses the SIMD instructions of the processor, 16 bytes at a time.
+ * @param first This is the first row.
+ * @param second This is the second row.
+ * @param length This is the length of the rows in bytes.
+ * @return The return will be the largest sum of the absolute differences of a group.
+ */
+static uint32_t largestGroupDifference(const uint8_t *first, const uint8_t *second, int length) {
+	uint32_t largest = 0;
+	int index = 0;
+#if defined(__SSE2__)
+	/**
+	 * PSADBW sums the differences of each 8 byte group into the low 16 bits of a 64 bit lane.
+	 */
+	__m128i maximum = _mm_setzero_si128();
+	for (; index + 16 <= length; index += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*) (first + index));
+		__m128i b = _mm_loadu_si128((const __m128i*) (second + index));
+		maximum = _mm_max_epi16(maximum, _mm_sad_epu8(a, b));
+	}
+	largest = std::max(_mm_cvtsi128_si32(maximum), _mm_cvtsi128_si32(_mm_srli_si128(maximum, 8)));
+#elif defined(__ARM_NEON)
+	/**
+	 * VABD and three pairwise additions sum the differences of each 8 byte group into a 32 bit lane.
+	 */
+	uint32x2_t maximum = vdup_n_u32(0);
+	for (; index + 16 <= length; index += 16) {
+		uint32x4_t quads = vpaddlq_u16(vpaddlq_u8(vabdq_u8(vld1q_u8(first + index), vld1q_u8(second + index))));
+		maximum = vmax_u32(maximum, vpadd_u32(vget_low_u32(quads), vget_high_u32(quads)));
+	}
+	largest = std::max(vget_lane_u32(maximum, 0), vget_lane_u32(maximum, 1));
+#endif
+	for (; index < length; index += 8) {
+		uint32_t sum = 0;
+		for (int byte = index; (byte < index + 8) && (byte < length); byte++) {
+			sum += abs((int) first[byte] - (int) second[byte]);
+		}
+		largest = std::max(largest, sum);
+	}
+	return largest;
+}
+
+/**
+ * This is the constructor for the class.  The reference frame is allocated here.
+ * @param maximumWidth This is the width of the widest frame which is to be encoded.
+ * @param maximumHeight This is the height of the tallest frame which is to be encoded.
+ * @param tilePixels This is the width and height of a tile in pixels, from 8 to 128.
+ * @param interval This is the number of frames from one keyframe to the next, or 0 to send keyframes only when needed.
+ * @param noiseThreshold This is the largest mean absolute difference per byte of a group of 8 bytes which is not sent.
+ */
+TileDeltaEncoder::TileDeltaEncoder(int maximumWidth, int maximumHeight, int tilePixels, uint32_t interval, int noiseThreshold) :
+		keyframeRequested(true), keyframes(0), tilesCompared(0), tilesSent(0) {
+	tileSize = std::min(std::max(tilePixels, 8), 128);
+	keyframeInterval = interval;
+	threshold = std::max(noiseThreshold, 0);
+
+	/**
+	 * The reference and the list of tiles are sized for the largest frame, so that encoding never allocates.
+	 */
+	referenceCapacity = (size_t) maximumWidth * maximumHeight * 3;
+	void *buffer = NULL;
+	if (posix_memalign(&buffer, 64, referenceCapacity) == 0) {
+		reference = (uint8_t*) buffer;
+	} else {
+		Logger::log(LOG_ERROR, "Tile Delta: Cannot allocate the reference of a %dx%d frame.", maximumWidth, maximumHeight);
+	}
+	changedTiles.resize((size_t) ((maximumWidth + tileSize - 1) / tileSize) * ((maximumHeight + tileSize - 1) / tileSize));
+}
+
+/**
+ * This is the destructor for the class.
+ */
+TileDeltaEncoder::~TileDeltaEncoder() {
+	free(reference);
+}
+
+/**
+ * This method will find the tiles of a frame which have changed since they were last sent, and take them as sent.
+ * @param frame This is the frame, an 8 bit, 3 channel BGR image.  It must not change until its datagrams are built.
+ * @param id This is the count of the frame.
+ * @param time This is the time at which the transmission of the frame started, in milliseconds.
+ * @param datagramSize This is the largest datagram which may be built.
+ * @return The return will be the number of datagrams which the frame needs, or 0 if it can not be encoded.
+ */
+int TileDeltaEncoder::encode(const Mat &frame, uint32_t id, uint32_t time, size_t datagramSize) {
+	/**
+	 * 1.0 The frame must fit the reference and the 16 bit sizes of the header, and a datagram must hold a whole tile.
+	 */
+	tilesPerDatagram = 0;
+	if (datagramSize > sizeof(StreamTileHeader)) {
+		tilesPerDatagram = (int) ((datagramSize - sizeof(StreamTileHeader)) / (sizeof(StreamTile) + (tileSize * tileSize * 3)));
+	}
+	if ((reference == NULL) || (frame.channels() != 3) || (frame.rows <= 0) || (frame.cols <= 0) || (frame.rows > 65535)
+			|| (frame.cols > 65535) || ((size_t) frame.rows * frame.cols * 3 > referenceCapacity) || (tilesPerDatagram < 1)) {
+		return 0;
+	}
+	image = &frame;
+	frameId = id;
+	timestamp = time;
+
+	/**
+	 * 2.0 Decide whether this is a keyframe: one was requested, the size of the frame changed, or the interval is up.
+	 */
+	keyframe = keyframeRequested.exchange(false);
+	if ((frame.cols != referenceWidth) || (frame.rows != referenceHeight)) {
+		referenceWidth = frame.cols;
+		referenceHeight = frame.rows;
+		keyframe = true;
+	}
+	if ((keyframeInterval > 0) && (framesSinceKeyframe + 1 >= keyframeInterval)) {
+		keyframe = true;
+	}
+	if (keyframe) {
+		keyframeId = id;
+		framesSinceKeyframe = 0;
+		keyframes.fetch_add(1, std::memory_order_relaxed);
+	} else {
+		framesSinceKeyframe++;
+	}
+
+	/**
+	 * 3.0 Compare every tile with the reference.  The tiles which are sent are copied into the reference, as that is
+	 * what the receiver will hold.
+	 */
+	tileColumns = (frame.cols + tileSize - 1) / tileSize;
+	int tileRows = (frame.rows + tileSize - 1) / tileSize;
+	if ((size_t) (tileColumns * tileRows) > changedTiles.size()) {
+		changedTiles.resize(tileColumns * tileRows);
+	}
+	changedTileCount = 0;
+	for (int row = 0; row < tileRows; row++) {
+		for (int column = 0; column < tileColumns; column++) {
+			if (keyframe || tileChanged(column, row)) {
+				updateReference(column, row);
+				changedTiles[changedTileCount++] = (row * tileColumns) + column;
+			}
+		}
+	}
+	tilesCompared.fetch_add(tileColumns * tileRows, std::memory_order_relaxed);
+	tilesSent.fetch_add(changedTileCount, std::memory_order_relaxed);
+
+	/**
+	 * 4.0 A frame without changes is still sent as one empty datagram, so the receiver knows it was not lost.
+	 */
+	datagramCount = std::max(1, (changedTileCount + tilesPerDatagram - 1) / tilesPerDatagram);
+	return datagramCount;
+}
+
+/**
+ * This method will determine whether or not a tile differs from the reference by more than the threshold.  Each group
+ * of 8 bytes is compared on its own, so that a small change is not averaged away by the rest of the tile.
+ * @param column This is the column of the tile.
+ * @param row This is the row of the tile.
+ * @return The return will be true if the tile has changed.
+ */
+bool TileDeltaEncoder::tileChanged(int column, int row) {
+	int x = column * tileSize;
+	int width = std::min(tileSize, image->cols - x);
+	int height = std::min(tileSize, image->rows - (row * tileSize));
+	uint32_t groupThreshold = (uint32_t) (threshold * 8);
+	for (int y = row * tileSize; y < (row * tileSize) + height; y++) {
+		const uint8_t *current = image->ptr(y) + (x * 3);
+		const uint8_t *previous = reference + ((((size_t) y * referenceWidth) + x) * 3);
+		if (largestGroupDifference(current, previous, width * 3) > groupThreshold) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * This method will copy a tile of the current frame into the reference.
+ * @param column This is the column of the tile.
+ * @param row This is the row of the tile.
+ */
+void TileDeltaEncoder::updateReference(int column, int row) {
+	int x = column * tileSize;
+	int width = std::min(tileSize, image->cols - x);
+	int height = std::min(tileSize, image->rows - (row * tileSize));
+	for (int y = row * tileSize; y < (row * tileSize) + height; y++) {
+		memcpy(reference + ((((size_t) y * referenceWidth) + x) * 3), image->ptr(y) + (x * 3), width * 3);
+	}
+}
+
+/**
+ * This method will build one datagram of the current frame.
+ * @param datagram This is the index of the datagram.
+ * @param buffer This is the buffer the datagram is built in.  It must hold datagramSize bytes.
+ * @return The return will be the length of the datagram.
+ */
+size_t TileDeltaEncoder::buildDatagram(int datagram, uint8_t *buffer) {
+	int first = datagram * tilesPerDatagram;
+	int last = std::min(first + tilesPerDatagram, changedTileCount);
+
+	/**
+	 * 1.0 Fill in the header.
+	 */
+	StreamTileHeader *header = (StreamTileHeader*) buffer;
+	header->magic = htonl(STREAM_MAGIC);
+	header->version = STREAM_VERSION;
+	header->payloadType = STREAM_PAYLOAD_TILES;
+	header->flags = htons(keyframe ? STREAM_FLAG_KEYFRAME : 0);
+	header->datagramIndex = htons(datagram);
+	header->datagramCount = htons(datagramCount);
+	header->tileSize = htons(tileSize);
+	header->tileCount = htons((last > first) ? (last - first) : 0);
+	header->frameWidth = htons(image->cols);
+	header->frameHeight = htons(image->rows);
+	header->frameId = htonl(frameId);
+	header->timestamp = htonl(timestamp);
+	header->keyframeId = htonl(keyframeId);
+
+	/**
+	 * 2.0 Append each tile: its position, and then its rows straight from the frame.
+	 */
+	uint8_t *next = buffer + sizeof(StreamTileHeader);
+	for (int index = first; index < last; index++) {
+		int column = changedTiles[index] % tileColumns;
+		int row = changedTiles[index] / tileColumns;
+		StreamTile *tile = (StreamTile*) next;
+		tile->column = htons(column);
+		tile->row = htons(row);
+		next += sizeof(StreamTile);
+
+		int x = column * tileSize;
+		int width = std::min(tileSize, image->cols - x);
+		int height = std::min(tileSize, image->rows - (row * tileSize));
+		for (int y = row * tileSize; y < (row * tileSize) + height; y++) {
+			memcpy(next, image->ptr(y) + (x * 3), width * 3);
+			next += width * 3;
+		}
+	}
+	return next - buffer;
+}
+
+/**
+ * This method will ask for the next frame to be a keyframe.  It may be called from any thread.
+ */
+void TileDeltaEncoder::requestKeyframe() {
+	keyframeRequested.store(true);
+}
+
+/**
+ * These methods obtain the statistics of the encoder.
+ */
+uint64_t TileDeltaEncoder::getKeyframes() {
+	return keyframes.load(std::memory_order_relaxed);
+}
+
+uint64_t TileDeltaEncoder::getTilesCompared() {
+	return tilesCompared.load(std::memory_order_relaxed);
+}
+
+uint64_t TileDeltaEncoder::getTilesSent() {
+	return tilesSent.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,183 @@
+/**
+ * @file TileDeltaEncoder.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class encodes the frames of a stream as tile deltas.  The frame is
+ *      divided into square tiles, and each tile is compared with the version of
+ *      it which was last sent, using SIMD sums of absolute differences (SSE2 on
+ *      x86, NEON on ARM) over groups of 8 bytes.  Only the tiles which have changed are sent, raw, so
+ *      the bandwidth follows the motion in the scene rather than its resolution.
+ *
+ *      The encoder keeps its own copy of what the receiver holds, updated only
+ *      for the tiles which are sent, so small changes below the threshold can
+ *      never accumulate into drift.  Every tile is sent in a keyframe, which goes
+ *      out on a fixed interval, when the size of the frame changes, and when the
+ *      receiver asks for one after losing a datagram.
+ */
+
+#ifndef TILEDELTAENCODER_H_
+#define TILEDELTAENCODER_H_
+
+#include "StreamProtocol.h"
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+using namespace cv;
+
+class TileDeltaEncoder {
+private:
+	/**
+	 * This is the width and height of a tile in pixels.
+	 */
+	int tileSize;
+
+	/**
+	 * This is the number of frames from one keyframe to the next.  0 means keyframes are only sent when needed.
+	 */
+	uint32_t keyframeInterval;
+
+	/**
+	 * This is the largest mean absolute difference, per byte, of any group of 8 bytes of a tile which is still treated
+	 * as unchanged.  It keeps sensor noise from being sent as motion.
+	 */
+	int threshold;
+
+	/**
+	 * This is the copy of the frame as the receiver holds it, and the largest frame it can hold in bytes.
+	 */
+	uint8_t *reference = NULL;
+	size_t referenceCapacity;
+
+	/**
+	 * These are the width and height of the reference frame.  They are 0 until the first keyframe.
+	 */
+	int referenceWidth = 0;
+	int referenceHeight = 0;
+
+	/**
+	 * These are the tiles of the current frame which are to be sent, as a row major tile index.
+	 */
+	std::vector<uint32_t> changedTiles;
+	int changedTileCount = 0;
+
+	/**
+	 * These describe the current frame: its count, its start time, whether it is a keyframe, and the number of tiles
+	 * per row of the frame.
+	 */
+	const Mat *image = NULL;
+	uint32_t frameId = 0;
+	uint32_t timestamp = 0;
+	bool keyframe = false;
+	int tileColumns = 0;
+
+	/**
+	 * These are the number of tiles which fit in one datagram, and the number of datagrams in the current frame.
+	 */
+	int tilesPerDatagram = 0;
+	int datagramCount = 0;
+
+	/**
+	 * This is the count of the last keyframe, and the number of frames since it.
+	 */
+	uint32_t keyframeId = 0;
+	uint32_t framesSinceKeyframe = 0;
+
+	/**
+	 * This variable will determine whether or not a keyframe has been requested.  It may be set from any thread.
+	 */
+	std::atomic<bool> keyframeRequested;
+
+	/**
+	 * These are the statistics of the encoder.  They may be read by any thread.
+	 */
+	std::atomic<uint64_t> keyframes;
+	std::atomic<uint64_t> tilesCompared;
+	std::atomic<uint64_t> tilesSent;
+
+	/**
+	 * This method will determine whether or not a tile differs from the reference by more than the threshold.
+	 * @param column This is the column of the tile.
+	 * @param row This is the row of the tile.
+	 * @return The return will be true if the tile has changed.
+	 */
+	bool tileChanged(int column, int row);
+
+	/**
+	 * This method will copy a tile of the current frame into the reference.
+	 * @param column This is the column of the tile.
+	 * @param row This is the row of the tile.
+	 */
+	void updateReference(int column, int row);
+
+public:
+	/**
+	 * This is the constructor for the class.  The reference frame is allocated here.
+	 * @param maximumWidth This is the width of the widest frame which is to be encoded.
+	 * @param maximumHeight This is the height of the tallest frame which is to be encoded.
+	 * @param tilePixels This is the width and height of a tile in pixels, from 8 to 128.
+	 * @param interval This is the number of frames from one keyframe to the next, or 0 to send keyframes only when needed.
+	 * @param noiseThreshold This is the largest mean absolute difference per byte of a group of 8 bytes which is not sent.
+	 */
+	TileDeltaEncoder(int maximumWidth, int maximumHeight, int tilePixels, uint32_t interval, int noiseThreshold);
+
+	/**
+	 * This is the destructor for the class.
+	 */
+	virtual ~TileDeltaEncoder();
+
+	/**
+	 * This method will find the tiles of a frame which have changed since they were last sent, and take them as sent.
+	 * @param frame This is the frame, an 8 bit, 3 channel BGR image.  It must not change until its datagrams are built.
+	 * @param id This is the count of the frame.
+	 * @param time This is the time at which the transmission of the frame started, in milliseconds.
+	 * @param datagramSize This is the largest datagram which may be built.
+	 * @return The return will be the number of datagrams which the frame needs, or 0 if it can not be encoded.
+	 */
+	int encode(const Mat &frame, uint32_t id, uint32_t time, size_t datagramSize);
+
+	/**
+	 * This method will build one datagram of the current frame.
+	 * @param datagram This is the index of the datagram.
+	 * @param buffer This is the buffer the datagram is built in.  It must hold datagramSize bytes.
+	 * @return The return will be the length of the datagram.
+	 */
+	size_t buildDatagram(int datagram, uint8_t *buffer);
+
+	/**
+	 * This method will ask for the next frame to be a keyframe.  It may be called from any thread.
+	 */
+	void requestKeyframe();
+
+	/**
+	 * These methods obtain the statistics of the encoder: the number of keyframes, and the numbers of tiles compared
+	 * and sent.
+	 */
+	uint64_t getKeyframes();
+	uint64_t getTilesCompared();
+	uint64_t getTilesSent();
+};
+
+#endif /* TILEDELTAENCODER_H_ */
@@ -0,0 +1,145 @@
+/**
+ * @file TraceBuffer.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a lock free trace buffer for the hot path of the real time
+ *      threads.
+ */
+
+#include "TraceBuffer.h"
+#include <unistd.h>
+#include <stdlib.h>
+#include <new>
+#include <sys/syscall.h>
+
+/*
+ * These are the file scoped variables which hold the state of the tracing.
+ */
+std::atomic<bool> TraceBuffer::enabled(false);
+thread_local TraceBuffer *TraceBuffer::threadBuffer = NULL;
+std::list<TraceBuffer*> TraceBuffer::allBuffers;
+std::mutex TraceBuffer::registryMutex;
+
+/**
+ * This is the constructor for the class.
+ * @param tid This is the thread id of the owning thread.
+ * @param name This is the name of the owning thread.
+ */
+TraceBuffer::TraceBuffer(pid_t tid, std::string name) :
+		head(0), tail(0), dropped(0) {
+	threadId = tid;
+	threadName = name;
+}
+
+/**
+ * This method will create the trace buffer for the calling thread, if it does not already have one.
+ * @param name This is the name of the thread.
+ * @return The return will be the trace buffer of the calling thread, or NULL if it could not be allocated.
+ */
+TraceBuffer* TraceBuffer::registerThread(std::string name) {
+	if (threadBuffer == NULL) {
+		pid_t tid = syscall(SYS_gettid);
+		if (name.empty()) {
+			name = "Thread " + std::to_string(tid);
+		}
+
+		/**
+		 * The ring indices are on separate cache lines, so the buffer must be allocated with cache line alignment.
+		 */
+		void *memory = NULL;
+		if (posix_memalign(&memory, 64, sizeof(TraceBuffer)) != 0) {
+			return NULL;
+		}
+		threadBuffer = new (memory) TraceBuffer(tid, name);
+
+		/**
+		 * Buffers are never deleted, as the drainer may still be reading them after the thread has ended.
+		 */
+		std::lock_guard<std::mutex> guard(registryMutex);
+		allBuffers.push_back(threadBuffer);
+	}
+	return threadBuffer;
+}
+
+/**
+ * This method will turn recording on or off.
+ * @param enable This is true to record events or false to ignore them.
+ */
+void TraceBuffer::setEnabled(bool enable) {
+	enabled.store(enable, std::memory_order_relaxed);
+}
+
+/**
+ * This method will determine if events are being recorded.
+ * @return The return will be true if tracing is enabled or false otherwise.
+ */
+bool TraceBuffer::isEnabled() {
+	return enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain a copy of the list of all trace buffers.
+ * @return The return will be a list of all of the trace buffers.
+ */
+std::list<TraceBuffer*> TraceBuffer::getAllBuffers() {
+	std::lock_guard<std::mutex> guard(registryMutex);
+	return allBuffers;
+}
+
+/**
+ * This method will remove the oldest event from the ring.  It may only be called by the drainer.
+ * @param event This is the event which is filled in.
+ * @return The return will be true if an event was removed or false if the ring is empty.
+ */
+bool TraceBuffer::pop(TraceEvent &event) {
+	uint32_t currentTail = tail.load(std::memory_order_relaxed);
+	if (currentTail == head.load(std::memory_order_acquire)) {
+		return false;
+	}
+	event = events[currentTail & (CAPACITY - 1)];
+	tail.store(currentTail + 1, std::memory_order_release);
+	return true;
+}
+
+/**
+ * This method will obtain the number of events dropped because the ring was full.
+ * @return The return will be the number of dropped events.
+ */
+uint64_t TraceBuffer::getDroppedCount() {
+	return dropped.load(std::memory_order_relaxed);
+}
+
+/**
+ * This method will obtain the thread id of the owning thread.
+ * @return The return will be the thread id.
+ */
+pid_t TraceBuffer::getThreadId() {
+	return threadId;
+}
+
+/**
+ * This method will obtain the name of the owning thread.
+ * @return The return will be the name of the thread.
+ */
+std::string TraceBuffer::getThreadName() {
+	return threadName;
+}
@@ -0,0 +1,259 @@
+/**
+ * @file TraceBuffer.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a lock free trace buffer for the hot path of the real time
+ *      threads.  Each thread has its own single producer / single consumer ring of
+ *      fixed size binary events with nanosecond timestamps.  Recording an event is
+ *      a clock read and a few stores, and never blocks.  The TraceDrainer task
+ *      empties the rings in the background and writes the events to a file.
+ */
+
+#ifndef TRACEBUFFER_H_
+#define TRACEBUFFER_H_
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+
+/**
+ * This enumeration defines the kinds of trace events.
+ */
+enum TraceEventType {
+	TRACE_BEGIN = 0, /**< The start of a span, such as a pipeline stage. */
+	TRACE_END = 1, /**< The end of a span. */
+	TRACE_INSTANT = 2, /**< A single point in time. */
+	TRACE_THREAD_NAME = 3 /**< The name of a thread.  Only found in the trace file, where it is followed by bytes characters of the name. */
+};
+
+/**
+ * This enumeration defines what a trace event refers to.
+ */
+enum TraceStage {
+	STAGE_GRAB = 0, /**< Taking the picture from the camera. */
+	STAGE_RESIZE = 1, /**< Resizing the picture to the transmit size. */
+	STAGE_TRANSMIT = 2, /**< Transmitting the picture. */
+	STAGE_CAPTURE = 3, /**< Capturing a frame from the camera hardware.  The frame id is the camera's frame count. */
+	STAGE_TASK_RELEASE = 4, /**< A periodic task was released.  The frame id is the activation count. */
+	STAGE_TASK_EXECUTION = 5, /**< A periodic task executing its task method.  The frame id is the activation count. */
+	STAGE_PREEMPTION = 6, /**< A periodic task was preempted during its execution.  The bytes field holds the number of preemptions. */
+	STAGE_ENCODE = 7, /**< Encoding a slice of a frame of the compressed stream.  The bytes field holds the size of the slice. */
+	STAGE_SIMULCAST_RESIZE = 8, /**< Resizing the picture to the size of a simulcast level.  It is not part of the flow of the frame. */
+	STAGE_SIMULCAST_TRANSMIT = 9 /**< Transmitting a simulcast level of the picture.  It is not part of the flow of the frame. */
+};
+
+/**
+ * This structure is a single trace event.  It is 24 bytes, and is written to the trace file as is.
+ */
+struct TraceEvent {
+	/**
+	 * This is the CLOCK_MONOTONIC time of the event in nanoseconds.
+	 */
+	uint64_t timestamp;
+
+	/**
+	 * This is the id of the frame which the event refers to.
+	 */
+	uint32_t frameId;
+
+	/**
+	 * This is the number of bytes processed, if applicable.
+	 */
+	uint32_t bytes;
+
+	/**
+	 * This is the thread id (tid) of the thread which recorded the event.
+	 */
+	uint32_t threadId;
+
+	/**
+	 * This is the type of the event (a TraceEventType).
+	 */
+	uint16_t type;
+
+	/**
+	 * This is the stage which the event refers to (a TraceStage).
+	 */
+	uint16_t stage;
+};
+
+class TraceBuffer {
+public:
+	/**
+	 * This is the number of events each thread's ring can hold.  It must be a power of two.
+	 */
+	static const uint32_t CAPACITY = 4096;
+
+private:
+	/**
+	 * This variable will determine whether or not events are being recorded.
+	 */
+	static std::atomic<bool> enabled;
+
+	/**
+	 * This is the trace buffer of the calling thread.  It is NULL until the thread records its first event or registers.
+	 */
+	static thread_local TraceBuffer *threadBuffer;
+
+	/**
+	 * This is a list of all of the trace buffers, one per thread, and the mutex that protects it.  The mutex is only taken
+	 * when a thread registers and by the drainer, never when recording.
+	 */
+	static std::list<TraceBuffer*> allBuffers;
+	static std::mutex registryMutex;
+
+	/**
+	 * This is the index at which the owning thread will write the next event.
+	 */
+	alignas(64) std::atomic<uint32_t> head;
+
+	/**
+	 * This is the index at which the drainer will read the next event.
+	 */
+	alignas(64) std::atomic<uint32_t> tail;
+
+	/**
+	 * This is a count of the events which were dropped because the ring was full.
+	 */
+	std::atomic<uint64_t> dropped;
+
+	/**
+	 * This is the ring of events.
+	 */
+	TraceEvent events[CAPACITY];
+
+	/**
+	 * This is the thread id of the owning thread.
+	 */
+	pid_t threadId;
+
+	/**
+	 * This is the name of the owning thread.
+	 */
+	std::string threadName;
+
+	/**
+	 * This is the constructor for the class.
+	 * @param tid This is the thread id of the owning thread.
+	 * @param name This is the name of the owning thread.
+	 */
+	TraceBuffer(pid_t tid, std::string name);
+
+	/**
+	 * This method will add an event to the ring, dropping it if the ring is full.
+	 * @param event This is the event that is to be added.
+	 */
+	inline void push(const TraceEvent &event) {
+		uint32_t currentHead = head.load(std::memory_order_relaxed);
+		if (currentHead - tail.load(std::memory_order_acquire) >= CAPACITY) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		events[currentHead & (CAPACITY - 1)] = event;
+		head.store(currentHead + 1, std::memory_order_release);
+	}
+
+public:
+	/**
+	 * This method will record an event on the calling thread.  If tracing is disabled, it returns immediately.
+	 * @param type This is the type of the event.
+	 * @param stage This is the stage which the event refers to.
+	 * @param frameId This is the id of the frame which the event refers to.
+	 * @param bytes This is the number of bytes processed, if applicable.
+	 */
+	static inline void record(TraceEventType type, uint16_t stage, uint32_t frameId, uint32_t bytes) {
+		if (enabled.load(std::memory_order_relaxed) == false) {
+			return;
+		}
+		TraceBuffer *buffer = threadBuffer;
+		if ((buffer == NULL) && ((buffer = registerThread("")) == NULL)) {
+			return;
+		}
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		TraceEvent event;
+		event.timestamp = ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+		event.frameId = frameId;
+		event.bytes = bytes;
+		event.threadId = buffer->threadId;
+		event.type = type;
+		event.stage = stage;
+		buffer->push(event);
+	}
+
+	/**
+	 * This method will create the trace buffer for the calling thread, if it does not already have one.  Threads should
+	 * register when they start, so that the buffer is not allocated on the hot path.
+	 * @param name This is the name of the thread.
+	 * @return The return will be the trace buffer of the calling thread, or NULL if it could not be allocated.
+	 */
+	static TraceBuffer* registerThread(std::string name);
+
+	/**
+	 * This method will turn recording on or off.  It may be called at any time from any thread.
+	 * @param enable This is true to record events or false to ignore them.
+	 */
+	static void setEnabled(bool enable);
+
+	/**
+	 * This method will determine if events are being recorded.
+	 * @return The return will be true if tracing is enabled or false otherwise.
+	 */
+	static bool isEnabled();
+
+	/**
+	 * This method will obtain a copy of the list of all trace buffers.
+	 * @return The return will be a list of all of the trace buffers.
+	 */
+	static std::list<TraceBuffer*> getAllBuffers();
+
+	/**
+	 * This method will remove the oldest event from the ring.  It may only be called by the drainer.
+	 * @param event This is the event which is filled in.
+	 * @return The return will be true if an event was removed or false if the ring is empty.
+	 */
+	bool pop(TraceEvent &event);
+
+	/**
+	 * This method will obtain the number of events dropped because the ring was full.
+	 * @return The return will be the number of dropped events.
+	 */
+	uint64_t getDroppedCount();
+
+	/**
+	 * This method will obtain the thread id of the owning thread.
+	 * @return The return will be the thread id.
+	 */
+	pid_t getThreadId();
+
+	/**
+	 * This method will obtain the name of the owning thread.
+	 * @return The return will be the name of the thread.
+	 */
+	std::string getThreadName();
+};
+
+#endif /* TRACEBUFFER_H_ */
@@ -0,0 +1,198 @@
+/**
+ * @file TraceDrainer.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a periodic task which empties the trace buffers of all of
+ *      the threads and writes the events to a file.
+ */
+
+#include "TraceDrainer.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+/*
+ * These are the names of the stages, indexed by TraceStage.
+ */
+static const char *stageNames[] = { "Grab", "Resize", "Transmit", "Capture", "Release", "Execute", "Preempted", "Encode", "Simulcast Resize",
+		"Simulcast Transmit" };
+
+/**
+ * This is the constructor for the class.  It will open the trace file.
+ * @param fileName This is the name of the file that the events are to be written to.
+ * @param threadName This is the name of the thread in a human readable format.
+ * @param period This is the period for the task, given in microseconds.
+ */
+TraceDrainer::TraceDrainer(std::string fileName, std::string threadName, uint32_t period) :
+		PeriodicTask(threadName, period) {
+	processId = getpid();
+	chromeFormat = (fileName.size() > 5) && (fileName.compare(fileName.size() - 5, 5, ".json") == 0);
+	traceFile = fopen(fileName.c_str(), "wb");
+	if (traceFile == NULL) {
+		printf("Unable to open the trace file %s (%s).\n", fileName.c_str(), strerror(errno));
+	} else if (chromeFormat) {
+		fputs("[\n", traceFile);
+	} else {
+		fwrite("RTSTRACE", 1, 8, traceFile);
+	}
+}
+
+/**
+ * This is the destructor for the class.  It will write out any remaining events and close the file.
+ */
+TraceDrainer::~TraceDrainer() {
+	taskMethod();
+	if (traceFile != NULL) {
+		if (chromeFormat) {
+			fputs("\n]\n", traceFile);
+		}
+		fclose(traceFile);
+	}
+}
+
+/**
+ * This method will write a thread name record for the given buffer, if one has not already been written.
+ * @param buffer This is the trace buffer of the thread.
+ */
+void TraceDrainer::writeThreadName(TraceBuffer *buffer) {
+	if (namedThreads.count(buffer->getThreadId()) == 0) {
+		std::string name = buffer->getThreadName();
+		namedThreads.insert(buffer->getThreadId());
+
+		if (chromeFormat) {
+			writeChromeEvent("thread_name", "", "M", 0.0, buffer->getThreadId(), 0, "\"name\":\"" + name + "\"");
+			return;
+		}
+
+		TraceEvent record;
+		memset(&record, 0, sizeof(record));
+		record.threadId = buffer->getThreadId();
+		record.type = TRACE_THREAD_NAME;
+		record.bytes = name.size();
+		fwrite(&record, sizeof(record), 1, traceFile);
+		fwrite(name.c_str(), 1, name.size(), traceFile);
+	}
+}
+
+/**
+ * This method will write the given event to the file.
+ * @param event This is the event that is to be written.
+ */
+void TraceDrainer::writeEvent(const TraceEvent &event) {
+	/**
+	 * 1.0 In the binary format, the event is written as is.
+	 */
+	if (chromeFormat == false) {
+		fwrite(&event, sizeof(event), 1, traceFile);
+		return;
+	}
+
+	/**
+	 * 2.0 Translate the event into the matching Chrome phase.  Chrome timestamps are in microseconds.
+	 */
+	const char *name = (event.stage < (sizeof(stageNames) / sizeof(stageNames[0]))) ? stageNames[event.stage] : "Unknown";
+	const char *category = ((event.stage >= STAGE_TASK_RELEASE) && (event.stage <= STAGE_PREEMPTION)) ? "task" : "pipeline";
+	const char *phase = (event.type == TRACE_BEGIN) ? "B" : ((event.type == TRACE_END) ? "E" : "i");
+	double timestamp = event.timestamp / 1000.0;
+	std::string args = "\"frame\":" + std::to_string(event.frameId) + ",\"bytes\":" + std::to_string(event.bytes);
+	writeChromeEvent(name, category, phase, timestamp, event.threadId, 0, args);
+
+	/**
+	 * 3.0 Link the stages of a frame with a flow: it starts inside the capture, steps through the resize, and ends inside the transmit.
+	 * The simulcast levels are traced with stages of their own, so that each frame has one flow which ends once.
+	 * The flow events are placed just inside the slice, so that Chrome binds them to it.
+	 */
+	if (event.frameId != 0) {
+		if ((event.stage == STAGE_CAPTURE) && (event.type == TRACE_END)) {
+			writeChromeEvent("Frame", "frame", "s", timestamp - 0.001, event.threadId, event.frameId, "");
+		} else if ((event.stage == STAGE_RESIZE) && (event.type == TRACE_BEGIN)) {
+			writeChromeEvent("Frame", "frame", "t", timestamp + 0.001, event.threadId, event.frameId, "");
+		} else if ((event.stage == STAGE_TRANSMIT) && (event.type == TRACE_BEGIN)) {
+			writeChromeEvent("Frame", "frame", "f", timestamp + 0.001, event.threadId, event.frameId, "");
+		}
+	}
+}
+
+/**
+ * This method will write one Chrome trace event object to the file.
+ * @param name This is the name of the event.
+ * @param category This is the category of the event.
+ * @param phase This is the Chrome phase of the event ("B", "E", "i", "s", "t", "f" or "M").
+ * @param timestamp This is the time of the event in microseconds.
+ * @param threadId This is the thread id of the event.
+ * @param id This is the flow id, which is only written for flow events.
+ * @param args This is the JSON text of the arguments object, without the braces.
+ */
+void TraceDrainer::writeChromeEvent(const char *name, const char *category, const char *phase, double timestamp,
+		uint32_t threadId, uint32_t id, const std::string &args) {
+	fprintf(traceFile, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u",
+			firstChromeEvent ? "" : ",\n", name, category, phase, timestamp, processId, threadId);
+	firstChromeEvent = false;
+
+	/**
+	 * Instant events are scoped to their thread, and flow events carry their id and bind to the enclosing slice.
+	 */
+	if (phase[0] == 'i') {
+		fputs(",\"s\":\"t\"", traceFile);
+	} else if ((phase[0] == 's') || (phase[0] == 't') || (phase[0] == 'f')) {
+		fprintf(traceFile, ",\"id\":%u,\"bp\":\"e\"", id);
+	}
+	if (args.empty() == false) {
+		fprintf(traceFile, ",\"args\":{%s}", args.c_str());
+	}
+	fputs("}", traceFile);
+}
+
+/**
+ * This is the task method.  It will write every event which has been recorded since the last period to the file.
+ */
+void TraceDrainer::taskMethod() {
+	TraceEvent event;
+
+	if (traceFile == NULL) {
+		return;
+	}
+
+	/**
+	 * 1.0 Empty the buffer of each thread, writing its name first if this is the first time it has been seen.
+	 */
+	for (TraceBuffer *buffer : TraceBuffer::getAllBuffers()) {
+		writeThreadName(buffer);
+		while (buffer->pop(event)) {
+			writeEvent(event);
+			eventsWritten++;
+		}
+	}
+
+	/**
+	 * 2.0 Push the events out to the file.
+	 */
+	fflush(traceFile);
+}
+
+/**
+ * This method will obtain the number of events that have been written to the file.
+ * @return The return will be the number of events written.
+ */
+uint64_t TraceDrainer::getEventsWritten() {
+	return eventsWritten;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file TraceDrainer.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a periodic task which empties the trace buffers of all of
+ *      the threads and writes the events to a file.  It is meant to run at a low
+ *      priority, so that the file I/O never delays the real time threads.
+ *
+ *      If the file name ends in ".json", the events are written in the Chrome
+ *      trace event format, which can be opened in Perfetto or chrome://tracing.
+ *      Stage and task spans become slices, releases and preemptions become instant
+ *      markers, and each camera frame id becomes a flow linking the capture, resize
+ *      and transmit of that frame.
+ *
+ *      Otherwise, the file starts with the 8 characters "RTSTRACE", followed by
+ *      TraceEvent records.  The first time a thread is seen, a TRACE_THREAD_NAME
+ *      record is written for it, followed by the characters of its name.
+ */
+
+#ifndef TRACEDRAINER_H_
+#define TRACEDRAINER_H_
+
+#include "PeriodicTask.h"
+#include "TraceBuffer.h"
+
+#include <stdio.h>
+#include <set>
+
+class TraceDrainer: public PeriodicTask {
+private:
+	/**
+	 * This is the file that the events are written to.
+	 */
+	FILE *traceFile = NULL;
+
+	/**
+	 * This is the set of threads whose names have already been written to the file.
+	 */
+	std::set<pid_t> namedThreads;
+
+	/**
+	 * This is the number of events that have been written to the file.
+	 */
+	uint64_t eventsWritten = 0;
+
+	/**
+	 * This variable will determine whether the file is written in the Chrome trace event (JSON) format or the binary format.
+	 */
+	bool chromeFormat = false;
+
+	/**
+	 * This variable will determine whether or not a JSON event has been written yet, so that events are separated by commas.
+	 */
+	bool firstChromeEvent = true;
+
+	/**
+	 * This is the process id, which Chrome uses to group the threads.
+	 */
+	int processId;
+
+	/**
+	 * This method will write a thread name record for the given buffer, if one has not already been written.
+	 * @param buffer This is the trace buffer of the thread.
+	 */
+	void writeThreadName(TraceBuffer *buffer);
+
+	/**
+	 * This method will write the given event to the file.
+	 * @param event This is the event that is to be written.
+	 */
+	void writeEvent(const TraceEvent &event);
+
+	/**
+	 * This method will write one Chrome trace event object to the file.
+	 * @param name This is the name of the event.
+	 * @param category This is the category of the event.
+	 * @param phase This is the Chrome phase of the event ("B", "E", "i", "s", "t", "f" or "M").
+	 * @param timestamp This is the time of the event in microseconds.
+	 * @param threadId This is the thread id of the event.
+	 * @param id This is the flow id, which is only written for flow events.
+	 * @param args This is the JSON text of the arguments object, without the braces.
+	 */
+	void writeChromeEvent(const char *name, const char *category, const char *phase, double timestamp, uint32_t threadId,
+			uint32_t id, const std::string &args);
+
+public:
+	/**
+	 * This is the constructor for the class.  It will open the trace file.
+	 * @param fileName This is the name of the file that the events are to be written to.
+	 * @param threadName This is the name of the thread in a human readable format.
+	 * @param period This is the period for the task, given in microseconds.
+	 */
+	TraceDrainer(std::string fileName, std::string threadName, uint32_t period);
+
+	/**
+	 * This is the destructor for the class.  It will write out any remaining events and close the file.
+	 */
+	virtual ~TraceDrainer();
+
+	/**
+	 * This is the task method.  It will write every event which has been recorded since the last period to the file.
+	 */
+	virtual void taskMethod();
+
+	/**
+	 * This method will obtain the number of events that have been written to the file.
+	 * @return The return will be the number of events written.
+	 */
+	uint64_t getEventsWritten();
+};
+
+#endif /* TRACEDRAINER_H_ */
@@ -0,0 +1,187 @@
+/**
+ * @file TransmitHistory.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class keeps the datagrams of the last frames which were sent, so
+ *      that the ones which a receiver lost can be sent again.
+ */
+
+#include "TransmitHistory.h"
+
+#include <stdlib.h>
+
+/**
+ * This is the constructor for the class.
+ * @param frameCount This is the number of frames which are kept.
+ * @param capacity This is the size of the ring of bytes which the datagrams are kept in.
+ */
+TransmitHistory::TransmitHistory(int frameCount, size_t capacity) :
+		ring(NULL), capacity(capacity), writePosition(0), frames((frameCount < 1) ? 1 : frameCount), currentFrame(-1) {
+	void *memory = NULL;
+	if (posix_memalign(&memory, 64, capacity) == 0) {
+		ring = (uint8_t*) memory;
+	} else {
+		this->capacity = 0;
+	}
+	for (Frame &frame : frames) {
+		frame.records.resize(MAXIMUM_DATAGRAMS_PER_FRAME);
+	}
+}
+
+/**
+ * This is the destructor for the class.
+ */
+TransmitHistory::~TransmitHistory() {
+	free(ring);
+}
+
+/**
+ * This method will start a new frame, forgetting the oldest one.
+ * @param frameId This is the count of the frame.
+ * @param startTime This is the CLOCK_MONOTONIC time, in nanoseconds, at which the frame was started.
+ */
+void TransmitHistory::beginFrame(uint32_t frameId, uint64_t startTime) {
+	currentFrame = (currentFrame + 1) % (int) frames.size();
+	Frame &frame = frames[currentFrame];
+	frame.used = true;
+	frame.frameId = frameId;
+	frame.startTime = startTime;
+	frame.recordCount = 0;
+}
+
+/**
+ * This method will make room for the next datagram of the current frame.  A datagram is never split across the end of
+ * the ring, so the rest of the ring is skipped if it does not fit there.
+ * @param length This is the length of the datagram in bytes.
+ * @param index This is filled in with the index of the datagram within its frame.
+ * @return The return will be where the datagram is to be copied, or NULL if it can not be kept.
+ */
+uint8_t* TransmitHistory::append(size_t length, uint16_t &index) {
+	if ((ring == NULL) || (currentFrame < 0) || (length > capacity) || (frames[currentFrame].recordCount >= MAXIMUM_DATAGRAMS_PER_FRAME)) {
+		return NULL;
+	}
+	size_t offset = writePosition % capacity;
+	if (offset + length > capacity) {
+		writePosition += capacity - offset;
+		offset = 0;
+	}
+	Frame &frame = frames[currentFrame];
+	index = frame.recordCount++;
+	frame.records[index].position = writePosition;
+	frame.records[index].length = length;
+	frame.records[index].retransmitTime = 0;
+	writePosition += length;
+	return ring + offset;
+}
+
+/**
+ * This method will find where a datagram which was sent is kept.  A datagram is no longer kept once its frame has been
+ * forgotten, or the ring has wrapped around over it.
+ * @param frameId This is the count of the frame.
+ * @param index This is the index of the datagram within its frame.
+ * @param frame This is filled in with the frame of the datagram.
+ * @return The return will be the record of the datagram, or NULL if it is no longer kept.
+ */
+TransmitHistory::Record* TransmitHistory::findRecord(uint32_t frameId, uint16_t index, Frame *&frame) {
+	for (Frame &candidate : frames) {
+		if ((candidate.used == false) || (candidate.frameId != frameId)) {
+			continue;
+		}
+		if (index >= candidate.recordCount) {
+			return NULL;
+		}
+		Record &record = candidate.records[index];
+		if (writePosition > record.position + capacity) {
+			return NULL;
+		}
+		frame = &candidate;
+		return &record;
+	}
+	return NULL;
+}
+
+/**
+ * This method will find a datagram which was sent.
+ * @param frameId This is the count of the frame.
+ * @param index This is the index of the datagram within its frame.
+ * @param length This is filled in with the length of the datagram in bytes.
+ * @param startTime This is filled in with the time at which the frame was started.
+ * @param retransmitTime This is filled in with the time at which the datagram was last sent again, or 0 if it has not been.
+ * @return The return will be the datagram, or NULL if it is no longer kept.
+ */
+uint8_t* TransmitHistory::find(uint32_t frameId, uint16_t index, size_t &length, uint64_t &startTime, uint64_t &retransmitTime) {
+	Frame *frame = NULL;
+	Record *record = findRecord(frameId, index, frame);
+	if (record == NULL) {
+		return NULL;
+	}
+	length = record->length;
+	startTime = frame->startTime;
+	retransmitTime = record->retransmitTime;
+	return ring + (record->position % capacity);
+}
+
+/**
+ * This method will record that a datagram has been sent again.
+ * @param frameId This is the count of the frame.
+ * @param index This is the index of the datagram within its frame.
+ * @param time This is the CLOCK_MONOTONIC time, in nanoseconds, at which it was sent.
+ */
+void TransmitHistory::markRetransmitted(uint32_t frameId, uint16_t index, uint64_t time) {
+	Frame *frame = NULL;
+	Record *record = findRecord(frameId, index, frame);
+	if (record != NULL) {
+		record->retransmitTime = time;
+	}
+}
+
+/**
+ * This method will obtain the time at which a frame was started.
+ * @param frameId This is the count of the frame.
+ * @param startTime This is filled in with the CLOCK_MONOTONIC time, in nanoseconds, at which the frame was started.
+ * @return The return will be true if the frame is kept, or false otherwise.
+ */
+bool TransmitHistory::getStartTime(uint32_t frameId, uint64_t &startTime) {
+	for (Frame &frame : frames) {
+		if (frame.used && (frame.frameId == frameId)) {
+			startTime = frame.startTime;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * This method will obtain the number of datagrams which have been added to the current frame.
+ * @return The return will be the number of datagrams.
+ */
+int TransmitHistory::getDatagramCount() {
+	return (currentFrame < 0) ? 0 : frames[currentFrame].recordCount;
+}
+
+/**
+ * This method will obtain the size of the ring of bytes which the datagrams are kept in.
+ * @return The return will be the size in bytes.
+ */
+size_t TransmitHistory::getCapacity() {
+	return capacity;
+}
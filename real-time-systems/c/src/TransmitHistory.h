@@ -0,0 +1,177 @@
+/**
+ * @file TransmitHistory.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class keeps the datagrams of the last frames which were sent, so
+ *      that the ones which a receiver lost can be sent again.  The datagrams
+ *      are copied into one ring of bytes, and the oldest are overwritten as new
+ *      ones are added.  Each frame keeps where its datagrams are, by their
+ *      index within the frame, and the time at which it was started.  All of
+ *      the memory is allocated when the history is constructed.  It is not
+ *      synchronized, so the transmitter only uses it under the lock of its socket.
+ */
+
+#ifndef TRANSMITHISTORY_H_
+#define TRANSMITHISTORY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class TransmitHistory {
+public:
+	/**
+	 * This is the most datagrams which are kept for one frame.
+	 */
+	static const int MAXIMUM_DATAGRAMS_PER_FRAME = 4096;
+
+private:
+	/**
+	 * This structure is where a datagram is kept, and the CLOCK_MONOTONIC time, in nanoseconds, at which it was last
+	 * sent again, which is 0 if it has not been.  The position counts every byte ever added to the ring, so that a
+	 * datagram which has been overwritten is recognized.
+	 */
+	struct Record {
+		uint64_t position;
+		size_t length;
+		uint64_t retransmitTime;
+	};
+
+	/**
+	 * This structure holds the datagrams of one frame.
+	 */
+	struct Frame {
+		/**
+		 * This is true once the frame has been started.
+		 */
+		bool used = false;
+
+		/**
+		 * These are the count of the frame and the CLOCK_MONOTONIC time, in nanoseconds, at which it was started.
+		 */
+		uint32_t frameId = 0;
+		uint64_t startTime = 0;
+
+		/**
+		 * These are the datagrams of the frame, by their index, and the number of them.
+		 */
+		std::vector<Record> records;
+		int recordCount = 0;
+	};
+
+	/**
+	 * This is the ring of bytes which the datagrams are copied into, and its size in bytes.
+	 */
+	uint8_t *ring;
+	size_t capacity;
+
+	/**
+	 * This is the position at which the next datagram is added.  It only ever increases.
+	 */
+	uint64_t writePosition;
+
+	/**
+	 * These are the frames which are kept, and the index of the frame which datagrams are added to, or -1 if no frame
+	 * has been started.
+	 */
+	std::vector<Frame> frames;
+	int currentFrame;
+
+	/**
+	 * This method will find where a datagram which was sent is kept.
+	 * @param frameId This is the count of the frame.
+	 * @param index This is the index of the datagram within its frame.
+	 * @param frame This is filled in with the frame of the datagram.
+	 * @return The return will be the record of the datagram, or NULL if it is no longer kept.
+	 */
+	Record* findRecord(uint32_t frameId, uint16_t index, Frame *&frame);
+
+public:
+	/**
+	 * This is the constructor for the class.
+	 * @param frameCount This is the number of frames which are kept.
+	 * @param capacity This is the size of the ring of bytes which the datagrams are kept in.
+	 */
+	TransmitHistory(int frameCount, size_t capacity);
+
+	/**
+	 * This is the destructor for the class.
+	 */
+	virtual ~TransmitHistory();
+
+	/**
+	 * This method will start a new frame, forgetting the oldest one.
+	 * @param frameId This is the count of the frame.
+	 * @param startTime This is the CLOCK_MONOTONIC time, in nanoseconds, at which the frame was started.
+	 */
+	void beginFrame(uint32_t frameId, uint64_t startTime);
+
+	/**
+	 * This method will make room for the next datagram of the current frame.  The caller copies the datagram into it.
+	 * @param length This is the length of the datagram in bytes.
+	 * @param index This is filled in with the index of the datagram within its frame.
+	 * @return The return will be where the datagram is to be copied, or NULL if no frame has been started, the frame
+	 * already has MAXIMUM_DATAGRAMS_PER_FRAME datagrams, or the datagram does not fit the ring.
+	 */
+	uint8_t* append(size_t length, uint16_t &index);
+
+	/**
+	 * This method will find a datagram which was sent.
+	 * @param frameId This is the count of the frame.
+	 * @param index This is the index of the datagram within its frame.
+	 * @param length This is filled in with the length of the datagram in bytes.
+	 * @param startTime This is filled in with the time at which the frame was started.
+	 * @param retransmitTime This is filled in with the time at which the datagram was last sent again, or 0 if it has not been.
+	 * @return The return will be the datagram, or NULL if it is no longer kept.
+	 */
+	uint8_t* find(uint32_t frameId, uint16_t index, size_t &length, uint64_t &startTime, uint64_t &retransmitTime);
+
+	/**
+	 * This method will record that a datagram has been sent again.
+	 * @param frameId This is the count of the frame.
+	 * @param index This is the index of the datagram within its frame.
+	 * @param time This is the CLOCK_MONOTONIC time, in nanoseconds, at which it was sent.
+	 */
+	void markRetransmitted(uint32_t frameId, uint16_t index, uint64_t time);
+
+	/**
+	 * This method will obtain the time at which a frame was started.
+	 * @param frameId This is the count of the frame.
+	 * @param startTime This is filled in with the CLOCK_MONOTONIC time, in nanoseconds, at which the frame was started.
+	 * @return The return will be true if the frame is kept, or false otherwise.
+	 */
+	bool getStartTime(uint32_t frameId, uint64_t &startTime);
+
+	/**
+	 * This method will obtain the number of datagrams which have been added to the current frame.
+	 * @return The return will be the number of datagrams.
+	 */
+	int getDatagramCount();
+
+	/**
+	 * This method will obtain the size of the ring of bytes which the datagrams are kept in.
+	 * @return The return will be the size in bytes.
+	 */
+	size_t getCapacity();
+};
+
+#endif /* TRANSMITHISTORY_H_ */
@@ -0,0 +1,315 @@
+/**
+ * @file VirtualClock.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a simulated clock, which lets a whole task set run in virtual
+ *      time, many times faster than real time and repeatably.
+ */
+
+#include "VirtualClock.h"
+#include "PeriodicTask.h"
+
+#include <chrono>
+#include <vector>
+
+/**
+ * This function will convert a time into nanoseconds.
+ * @param time This is the time.
+ * @return The return will be the time in nanoseconds.
+ */
+static uint64_t toNanoseconds(const struct timespec &time) {
+	return ((uint64_t) time.tv_sec * 1000000000ULL) + time.tv_nsec;
+}
+
+/**
+ * This is the constructor for the class.  The clock starts paused, one second after its epoch.
+ */
+VirtualClock::VirtualClock() :
+		currentTime(1000000000ULL), stopTime(1000000000ULL), paused(true), attachedTasks(0), blockedTasks(0), demandSequence(0) {
+}
+
+/**
+ * This is the destructor for the class.
+ */
+VirtualClock::~VirtualClock() {
+	/**
+	 * Nothing to be done in the destructor.
+	 */
+}
+
+/**
+ * This method will obtain the current virtual time.
+ * @param now This is the time which is filled in.
+ */
+void VirtualClock::getTime(struct timespec &now) {
+	uint64_t time = currentTime.load();
+	now.tv_sec = time / 1000000000ULL;
+	now.tv_nsec = time % 1000000000ULL;
+}
+
+/**
+ * This method will move time forward to the next event, as long as every attached task is blocked, and release the tasks
+ * whose wait or execution has ended.  The mutex must be held.  The algorithm is as follows:
+ */
+void VirtualClock::advance() {
+	while ((paused == false) && (attachedTasks > 0) && (blockedTasks == attachedTasks)) {
+		bool releasedAny = false;
+
+		/**
+		 * 1.0 A task whose wakeup event has been signaled runs before time moves on.
+		 */
+		for (Sleeper *sleeper : sleepers) {
+			if ((sleeper->released == false) && (sleeper->wakeup->getGeneration() != sleeper->observedGeneration)) {
+				sleeper->released = true;
+				blockedTasks--;
+				releasedAny = true;
+			}
+		}
+		if (releasedAny) {
+			stateChanged.notify_all();
+			return;
+		}
+
+		/**
+		 * 2.0 Find the execution each simulated processor is serving, which is the highest priority execution on it, first
+		 * in first out among equal priorities.
+		 */
+		std::vector<Demand*> running;
+		for (Demand *demand : demands) {
+			if (demand->released) {
+				continue;
+			}
+			bool placed = false;
+			for (Demand *&current : running) {
+				if (current->cpu == demand->cpu) {
+					if ((demand->priority > current->priority)
+							|| ((demand->priority == current->priority) && (demand->sequence < current->sequence))) {
+						current = demand;
+					}
+					placed = true;
+				}
+			}
+			if (placed == false) {
+				running.push_back(demand);
+			}
+		}
+
+		/**
+		 * 3.0 The next event is the earliest end of a wait or of a running execution, but time never passes the stop time.
+		 */
+		uint64_t now = currentTime.load();
+		uint64_t next = stopTime;
+		for (Sleeper *sleeper : sleepers) {
+			if ((sleeper->released == false) && (sleeper->deadline < next)) {
+				next = sleeper->deadline;
+			}
+		}
+		for (Demand *demand : running) {
+			if (now + demand->remaining < next) {
+				next = now + demand->remaining;
+			}
+		}
+		if (next < now) {
+			next = now;
+		}
+
+		/**
+		 * 4.0 Move time forward, serving the running executions, and release the tasks which are done.
+		 */
+		for (Demand *demand : running) {
+			demand->remaining -= (next - now);
+		}
+		currentTime = next;
+		for (Sleeper *sleeper : sleepers) {
+			if ((sleeper->released == false) && (sleeper->deadline <= next)) {
+				sleeper->released = true;
+				blockedTasks--;
+				releasedAny = true;
+			}
+		}
+		for (Demand *demand : demands) {
+			if ((demand->released == false) && (demand->remaining == 0)) {
+				demand->released = true;
+				blockedTasks--;
+				releasedAny = true;
+			}
+		}
+		if (next >= stopTime) {
+			paused = true;
+		}
+		if (releasedAny || paused) {
+			stateChanged.notify_all();
+			return;
+		}
+	}
+}
+
+/**
+ * This method will wait until the wakeup event is signaled or the virtual time reaches the deadline.
+ * @param deadline This is the virtual time at which to stop waiting.
+ * @param wakeup This is the event which ends the wait early.
+ * @param observedGeneration This is the generation of the event which the caller read before checking its condition.
+ * @return The return will be true if the event was signaled or false if the deadline was reached.
+ */
+bool VirtualClock::waitUntil(const struct timespec &deadline, WakeupEvent &wakeup, uint32_t observedGeneration) {
+	std::unique_lock<std::mutex> lock(clockMutex);
+	Sleeper sleeper;
+	sleeper.deadline = toNanoseconds(deadline);
+	sleeper.wakeup = &wakeup;
+	sleeper.observedGeneration = observedGeneration;
+	sleeper.released = false;
+
+	if (wakeup.getGeneration() != observedGeneration) {
+		return true;
+	}
+	if (sleeper.deadline <= currentTime) {
+		return false;
+	}
+
+	/**
+	 * Block, and let time move on if this was the last task running.  A signal from a thread outside of the simulation
+	 * does not notify the clock, so the wakeup event is also checked now and then.
+	 */
+	sleepers.push_back(&sleeper);
+	blockedTasks++;
+	advance();
+	while (sleeper.released == false) {
+		stateChanged.wait_for(lock, std::chrono::milliseconds(10));
+		if ((sleeper.released == false) && (wakeup.getGeneration() != observedGeneration)) {
+			sleeper.released = true;
+			blockedTasks--;
+		}
+	}
+	sleepers.remove(&sleeper);
+	return currentTime < sleeper.deadline;
+}
+
+/**
+ * This method will serve an execution on the simulated scheduler, returning once it has received its CPU time.
+ * @param cpu This is the CPU the task is bound to, or -1 if it is not bound.
+ * @param priority This is the priority of the task.
+ * @param executionTime This is the CPU time of the execution in nanoseconds.
+ */
+void VirtualClock::execute(int cpu, int priority, uint64_t executionTime) {
+	std::unique_lock<std::mutex> lock(clockMutex);
+	if (executionTime == 0) {
+		return;
+	}
+
+	Demand demand;
+	demand.cpu = cpu;
+	demand.priority = priority;
+	demand.sequence = demandSequence++;
+	demand.remaining = executionTime;
+	demand.released = false;
+
+	demands.push_back(&demand);
+	blockedTasks++;
+	advance();
+	while (demand.released == false) {
+		stateChanged.wait(lock);
+	}
+	demands.remove(&demand);
+}
+
+/**
+ * This method is called when a task starts using the clock.  The clock will not move until the task blocks in it.
+ * @param task This is the task.
+ */
+void VirtualClock::attachTask(PeriodicTask *task) {
+	std::lock_guard<std::mutex> guard(clockMutex);
+	attachedTasks++;
+}
+
+/**
+ * This method is called when a task stops using the clock.
+ * @param task This is the task.
+ */
+void VirtualClock::detachTask(PeriodicTask *task) {
+	std::lock_guard<std::mutex> guard(clockMutex);
+	attachedTasks--;
+	advance();
+	stateChanged.notify_all();
+}
+
+/**
+ * This method will simulate the CPU time of an execution, and return once the simulated scheduler has served it.
+ * @param task This is the task which executed.
+ * @param measuredTime This is the CPU time the execution actually used, in microseconds.
+ * @return The return will be the simulated CPU time of the execution, in microseconds.
+ */
+long VirtualClock::accountExecution(PeriodicTask *task, long measuredTime) {
+	long executionTime = measuredTime;
+	std::map<PeriodicTask*, ExecutionTimeModel*>::iterator model = models.find(task);
+	if (model != models.end()) {
+		executionTime = model->second->nextExecutionTime();
+	}
+	execute(task->getBoundCpu(), task->getPriority(), executionTime * 1000ULL);
+	return executionTime;
+}
+
+/**
+ * This method will set the execution time model of a task.  It must be called before the clock is run.
+ * @param task This is the task.
+ * @param model This is the model of the execution time of the task.
+ */
+void VirtualClock::setExecutionTimeModel(PeriodicTask *task, ExecutionTimeModel *model) {
+	std::lock_guard<std::mutex> guard(clockMutex);
+	models[task] = model;
+}
+
+/**
+ * This method will run the clock for the given amount of virtual time, and return once it has passed.
+ * @param duration This is the virtual time to run for, in microseconds.
+ */
+void VirtualClock::runFor(uint64_t duration) {
+	std::unique_lock<std::mutex> lock(clockMutex);
+	stopTime = currentTime + (duration * 1000ULL);
+
+	/**
+	 * With no tasks, there is nothing to wait for.
+	 */
+	if (attachedTasks == 0) {
+		currentTime = stopTime;
+		return;
+	}
+	paused = false;
+	advance();
+	while (paused == false) {
+		stateChanged.wait(lock);
+	}
+}
+
+/**
+ * This method will run the clock, after the tasks have been stopped, until every attached task has ended.
+ */
+void VirtualClock::runUntilStopped() {
+	std::unique_lock<std::mutex> lock(clockMutex);
+	stopTime = UINT64_MAX;
+	paused = false;
+	advance();
+	while (attachedTasks > 0) {
+		stateChanged.wait_for(lock, std::chrono::milliseconds(10));
+		advance();
+	}
+	paused = true;
+}
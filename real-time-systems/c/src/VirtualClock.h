@@ -0,0 +1,232 @@
+/**
+ * @file VirtualClock.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a simulated clock, which lets a whole task set run in virtual
+ *      time, many times faster than real time and repeatably.  Time only moves
+ *      when every attached task is blocked in the clock, either waiting for its
+ *      next release or executing, and then it jumps straight to the next event.
+ *
+ *      The task methods still run, but in zero virtual time.  The CPU time of each
+ *      execution is drawn from the task's ExecutionTimeModel (or, without one, is
+ *      the time it actually used), and is then served by a simulated fixed priority
+ *      preemptive scheduler, with one processor for each CPU that the tasks are
+ *      bound to and one for the unbound tasks, as in the schedulability analysis.
+ *      So the statistics of the tasks show the response times, jitter, overruns
+ *      and deadline misses the task set would have.
+ *
+ *      A task is attached by PeriodicTask::setClock, and the clock does not move
+ *      until every attached task has started, so the clock should be paused (as it
+ *      is when constructed) while the tasks are started, then run with runFor.
+ *      Trace events and the real time threads' other statistics still use real time.
+ */
+
+#ifndef VIRTUALCLOCK_H_
+#define VIRTUALCLOCK_H_
+
+#include "TaskClock.h"
+#include "ExecutionTimeModel.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+
+class VirtualClock: public TaskClock {
+private:
+	/**
+	 * This structure is a task which is waiting for a time or a wakeup event.
+	 */
+	struct Sleeper {
+		/**
+		 * This is the virtual time, in nanoseconds, at which the wait ends.
+		 */
+		uint64_t deadline;
+
+		/**
+		 * This is the wakeup event which ends the wait early, and the generation of it that was observed.
+		 */
+		WakeupEvent *wakeup;
+		uint32_t observedGeneration;
+
+		/**
+		 * This is set when the wait has ended.
+		 */
+		bool released;
+	};
+
+	/**
+	 * This structure is an execution which is being served by the simulated scheduler.
+	 */
+	struct Demand {
+		/**
+		 * This is the CPU the task is bound to, or -1 if it is not bound.
+		 */
+		int cpu;
+
+		/**
+		 * This is the priority of the task.
+		 */
+		int priority;
+
+		/**
+		 * This is the order in which the executions arrived, so that equal priorities are served first in first out.
+		 */
+		uint64_t sequence;
+
+		/**
+		 * This is the CPU time, in nanoseconds, which the execution still needs.
+		 */
+		uint64_t remaining;
+
+		/**
+		 * This is set when the execution has completed.
+		 */
+		bool released;
+	};
+
+	/**
+	 * This mutex protects the state of the clock, and the condition variable is notified whenever it changes.
+	 */
+	std::mutex clockMutex;
+	std::condition_variable stateChanged;
+
+	/**
+	 * This is the virtual time in nanoseconds.
+	 */
+	std::atomic<uint64_t> currentTime;
+
+	/**
+	 * This is the virtual time at which the clock pauses.
+	 */
+	uint64_t stopTime;
+
+	/**
+	 * This is true while the clock is paused.
+	 */
+	bool paused;
+
+	/**
+	 * This is the number of attached tasks, and the number of them which are blocked in the clock.
+	 */
+	uint32_t attachedTasks;
+	uint32_t blockedTasks;
+
+	/**
+	 * This is the sequence number of the next execution.
+	 */
+	uint64_t demandSequence;
+
+	/**
+	 * These are the waiting tasks and the executions being served.
+	 */
+	std::list<Sleeper*> sleepers;
+	std::list<Demand*> demands;
+
+	/**
+	 * These are the execution time models of the tasks.
+	 */
+	std::map<PeriodicTask*, ExecutionTimeModel*> models;
+
+	/**
+	 * This method will move time forward to the next event, as long as every attached task is blocked, and release the
+	 * tasks whose wait or execution has ended.  The mutex must be held.
+	 */
+	void advance();
+
+	/**
+	 * This method will serve an execution on the simulated scheduler, returning once it has received its CPU time.
+	 * @param cpu This is the CPU the task is bound to, or -1 if it is not bound.
+	 * @param priority This is the priority of the task.
+	 * @param executionTime This is the CPU time of the execution in nanoseconds.
+	 */
+	void execute(int cpu, int priority, uint64_t executionTime);
+
+public:
+	/**
+	 * This is the constructor for the class.  The clock starts paused, one second after its epoch.
+	 */
+	VirtualClock();
+
+	/**
+	 * This is the destructor for the class.
+	 */
+	virtual ~VirtualClock();
+
+	/**
+	 * This method will obtain the current virtual time.
+	 * @param now This is the time which is filled in.
+	 */
+	virtual void getTime(struct timespec &now);
+
+	/**
+	 * This method will wait until the wakeup event is signaled or the virtual time reaches the deadline.  It may only be
+	 * called by attached tasks.
+	 * @param deadline This is the virtual time at which to stop waiting.
+	 * @param wakeup This is the event which ends the wait early.
+	 * @param observedGeneration This is the generation of the event which the caller read before checking its condition.
+	 * @return The return will be true if the event was signaled or false if the deadline was reached.
+	 */
+	virtual bool waitUntil(const struct timespec &deadline, WakeupEvent &wakeup, uint32_t observedGeneration);
+
+	/**
+	 * This method is called when a task starts using the clock.  The clock will not move until the task blocks in it.
+	 * @param task This is the task.
+	 */
+	virtual void attachTask(PeriodicTask *task);
+
+	/**
+	 * This method is called when a task stops using the clock.
+	 * @param task This is the task.
+	 */
+	virtual void detachTask(PeriodicTask *task);
+
+	/**
+	 * This method will simulate the CPU time of an execution, and return once the simulated scheduler has served it.
+	 * @param task This is the task which executed.
+	 * @param measuredTime This is the CPU time the execution actually used, in microseconds.  It is only used if the task
+	 * has no execution time model.
+	 * @return The return will be the simulated CPU time of the execution, in microseconds.
+	 */
+	virtual long accountExecution(PeriodicTask *task, long measuredTime);
+
+	/**
+	 * This method will set the execution time model of a task.  It must be called before the clock is run.
+	 * @param task This is the task.
+	 * @param model This is the model of the execution time of the task.
+	 */
+	void setExecutionTimeModel(PeriodicTask *task, ExecutionTimeModel *model);
+
+	/**
+	 * This method will run the clock for the given amount of virtual time, and return once it has passed.
+	 * @param duration This is the virtual time to run for, in microseconds.
+	 */
+	void runFor(uint64_t duration);
+
+	/**
+	 * This method will run the clock, after the tasks have been stopped, until every attached task has ended.
+	 */
+	void runUntilStopped();
+};
+
+#endif /* VIRTUALCLOCK_H_ */
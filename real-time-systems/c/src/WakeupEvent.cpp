@@ -0,0 +1,79 @@
+/**
+ * @file WakeupEvent.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is an event which a thread can wait on until an absolute
+ *      CLOCK_MONOTONIC deadline, and which any other thread can signal.
+ */
+
+#include "WakeupEvent.h"
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "The futex word must be a plain 32 bit integer.");
+
+/**
+ * This is the constructor for the class.
+ */
+WakeupEvent::WakeupEvent() :
+		generation(0) {
+}
+
+/**
+ * This method will obtain the current generation of the event.
+ * @return The return will be the generation.
+ */
+uint32_t WakeupEvent::getGeneration() {
+	return generation.load(std::memory_order_acquire);
+}
+
+/**
+ * This method will wake up every thread which is waiting on the event.  It may be called from any thread.
+ */
+void WakeupEvent::signal() {
+	generation.fetch_add(1, std::memory_order_release);
+	syscall(SYS_futex, (uint32_t *) &generation, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+/**
+ * This method will wait until the event is signaled or the deadline is reached.
+ * @param deadline This is the absolute CLOCK_MONOTONIC time at which to stop waiting.
+ * @param observedGeneration This is the generation which the caller read before checking its condition.
+ * @return The return will be true if the event was signaled or false if the deadline was reached.
+ */
+bool WakeupEvent::waitUntil(const struct timespec &deadline, uint32_t observedGeneration) {
+	/**
+	 * FUTEX_WAIT_BITSET takes an absolute timeout on CLOCK_MONOTONIC.  The kernel only sleeps if the word still holds the
+	 * observed generation, so a signal between the caller's check and the wait is never lost.  Interrupted waits are resumed.
+	 */
+	while (generation.load(std::memory_order_acquire) == observedGeneration) {
+		long result = syscall(SYS_futex, (uint32_t *) &generation, FUTEX_WAIT_BITSET_PRIVATE, observedGeneration, &deadline,
+				NULL, FUTEX_BITSET_MATCH_ANY);
+		if ((result != 0) && (errno == ETIMEDOUT)) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file WakeupEvent.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is an event which a thread can wait on until an absolute
+ *      CLOCK_MONOTONIC deadline, and which any other thread can signal to wake it
+ *      immediately.  It is built directly on a futex, so signaling it is a single
+ *      atomic increment and, only if needed, one system call, and a waiting thread
+ *      wakes within microseconds rather than at the end of its sleep.
+ *
+ *      To wait without missing a signal, the waiter first reads the generation,
+ *      then checks its own condition, and then waits for that generation to change.
+ */
+
+#ifndef WAKEUPEVENT_H_
+#define WAKEUPEVENT_H_
+
+#include <atomic>
+#include <stdint.h>
+#include <time.h>
+
+class WakeupEvent {
+private:
+	/**
+	 * This is the generation of the event, which is the futex word.  It increments every time the event is signaled.
+	 */
+	std::atomic<uint32_t> generation;
+
+public:
+	/**
+	 * This is the constructor for the class.
+	 */
+	WakeupEvent();
+
+	/**
+	 * This method will obtain the current generation of the event.
+	 * @return The return will be the generation.
+	 */
+	uint32_t getGeneration();
+
+	/**
+	 * This method will wake up every thread which is waiting on the event.  It may be called from any thread.
+	 */
+	void signal();
+
+	/**
+	 * This method will wait until the event is signaled or the deadline is reached.
+	 * @param deadline This is the absolute CLOCK_MONOTONIC time at which to stop waiting.
+	 * @param observedGeneration This is the generation which the caller read before checking its condition.  If the event
+	 * has been signaled since then, the method returns immediately.
+	 * @return The return will be true if the event was signaled or false if the deadline was reached.
+	 */
+	bool waitUntil(const struct timespec &deadline, uint32_t observedGeneration);
+};
+
+#endif /* WAKEUPEVENT_H_ */
@@ -0,0 +1,197 @@
+/**
+ * @file WorkerPool.cpp
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a fixed set of worker threads which carry out the lanes of a
+ *      ParallelJob.
+ */
+
+#include "WorkerPool.h"
+
+/**
+ * This method will work out the CLOCK_MONOTONIC time a number of milliseconds from now.
+ * @param milliseconds This is the number of milliseconds.
+ * @return The return will be the time.
+ */
+static struct timespec timeFromNow(long milliseconds) {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	time.tv_sec += milliseconds / 1000;
+	time.tv_nsec += (milliseconds % 1000) * 1000000L;
+	if (time.tv_nsec >= 1000000000L) {
+		time.tv_nsec -= 1000000000L;
+		time.tv_sec++;
+	}
+	return time;
+}
+
+/**
+ * This is the constructor for the class.
+ * @param pool This is the pool which the worker belongs to.
+ * @param lane This is the lane which the worker carries out.
+ * @param threadName This is the name of the thread in a human readable format.
+ */
+WorkerPool::Worker::Worker(WorkerPool *pool, int lane, std::string threadName) :
+		RunnableClass(threadName) {
+	this->pool = pool;
+	this->lane = lane;
+}
+
+/**
+ * This is the run method.  It will carry out the worker's lane of each job until the worker is stopped.
+ */
+void WorkerPool::Worker::run() {
+	while (keepGoing) {
+		/**
+		 * 1.0 Read the generation before checking for a job, so that a job handed out in between is not missed.
+		 */
+		uint32_t generation = pool->jobReady.getGeneration();
+		uint64_t job = pool->jobNumber.load(std::memory_order_acquire);
+
+		if (job != lastJob) {
+			/**
+			 * 2.0 Carry out this worker's lane of the new job.  The last lane to complete wakes the thread running the job.
+			 */
+			lastJob = job;
+			pool->currentJob->runLane(lane, pool->laneCount);
+			if (pool->lanesRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				pool->jobDone.signal();
+			}
+		} else {
+			/**
+			 * 3.0 Wait for the next job.  The timeout is only a safety net; a job or a stop wakes the worker at once.
+			 */
+			pool->jobReady.waitUntil(timeFromNow(1000), generation);
+		}
+	}
+}
+
+/**
+ * This method will stop the worker, waking it if it is waiting for a job.
+ */
+void WorkerPool::Worker::stop() {
+	RunnableClass::stop();
+	pool->jobReady.signal();
+}
+
+/**
+ * This is the constructor for the class.  The workers are created, but not started.
+ * @param name This is the name of the pool.  The workers are named after it.
+ * @param lanes This is the number of lanes which each job is split into.  It must be at least 1.
+ */
+WorkerPool::WorkerPool(std::string name, int lanes) :
+		jobNumber(0), lanesRemaining(0) {
+	myName = name;
+	laneCount = (lanes < 1) ? 1 : lanes;
+	for (int lane = 1; lane < laneCount; lane++) {
+		workers.push_back(new Worker(this, lane, name + " " + std::to_string(lane)));
+	}
+}
+
+/**
+ * This is the destructor for the class.  The workers must have been stopped.
+ */
+WorkerPool::~WorkerPool() {
+	for (Worker *worker : workers) {
+		delete worker;
+	}
+}
+
+/**
+ * This method will start the worker threads.
+ * @param priority This is the priority of the workers.
+ */
+void WorkerPool::start(int priority) {
+	for (Worker *worker : workers) {
+		worker->start(priority);
+	}
+}
+
+/**
+ * This method will stop the worker threads and wait for them to end.
+ */
+void WorkerPool::stop() {
+	for (Worker *worker : workers) {
+		worker->stop();
+	}
+	for (Worker *worker : workers) {
+		worker->waitForShutdown();
+	}
+}
+
+/**
+ * This method will carry out every lane of a job and return once all of them are complete.
+ * @param job This is the job.
+ */
+void WorkerPool::run(ParallelJob &job) {
+	/**
+	 * 1.0 Unless every worker is running, carry out every lane on the calling thread, so that a missing worker never
+	 * leaves the job incomplete.
+	 */
+	bool running = true;
+	for (Worker *worker : workers) {
+		running = running && worker->isStarted() && (worker->isShutdown() == false);
+	}
+	if (running == false) {
+		for (int lane = 0; lane < laneCount; lane++) {
+			job.runLane(lane, laneCount);
+		}
+		return;
+	}
+
+	/**
+	 * 2.0 Hand the job to the workers.  The job is published before its number, so a worker which sees the new number
+	 * also sees the job.
+	 */
+	currentJob = &job;
+	lanesRemaining.store((int) workers.size(), std::memory_order_relaxed);
+	jobNumber.fetch_add(1, std::memory_order_release);
+	jobReady.signal();
+
+	/**
+	 * 3.0 Carry out lane 0 here, and then wait for the workers to complete theirs.
+	 */
+	job.runLane(0, laneCount);
+	while (true) {
+		uint32_t generation = jobDone.getGeneration();
+		if (lanesRemaining.load(std::memory_order_acquire) == 0) {
+			break;
+		}
+		jobDone.waitUntil(timeFromNow(100), generation);
+	}
+}
+
+/**
+ * This method will obtain the number of lanes which each job is split into.
+ * @return The return will be the number of lanes.
+ */
+int WorkerPool::getLaneCount() {
+	return laneCount;
+}
+
+/**
+ * This method will obtain the name of the pool.
+ * @return The return will be the name of the pool.
+ */
+std::string WorkerPool::getName() {
+	return myName;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file WorkerPool.h
+ * @author  Walter Schilling (schilling@msoe.edu)
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ *
+ * This code is developed as part of the MSOE SE3910 Real Time Systems course,
+ * but can be freely used by others.
+ *
+ * SE3910 Real Time Systems is a required course for students studying the
+ * discipline of software engineering.
+ *
+ * This Software is provided under the License on an "AS IS" basis and
+ * without warranties of any kind concerning the Software, including
+ * without limitation merchantability, fitness for a particular purpose,
+ * absence of defects or errors, accuracy, and non-infringement of
+ * intellectual property rights other than copyright. This disclaimer
+ * of warranty is an essential part of the License and a condition for
+ * the grant of any rights to this Software.
+ *
+ * @section DESCRIPTION
+ *      This class is a fixed set of worker threads which carry out the lanes of a
+ *      ParallelJob.  The threads are created once, when the pool is started, and
+ *      wait on a WakeupEvent between jobs, so handing out a job is an atomic
+ *      increment and a futex wake rather than a thread creation.  The thread which
+ *      runs the job carries out lane 0 itself, so a pool of n lanes has n - 1 workers.
+ */
+
+#ifndef WORKERPOOL_H_
+#define WORKERPOOL_H_
+
+#include "RunnableClass.h"
+#include "ParallelJob.h"
+#include "WakeupEvent.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+class WorkerPool {
+private:
+	/**
+	 * This class is one worker thread of the pool, which carries out a single lane of each job.
+	 */
+	class Worker: public RunnableClass {
+	private:
+		/**
+		 * This is the pool which the worker belongs to.
+		 */
+		WorkerPool *pool;
+
+		/**
+		 * This is the lane which the worker carries out.
+		 */
+		int lane;
+
+		/**
+		 * This is the number of the last job which the worker carried out.
+		 */
+		uint64_t lastJob = 0;
+
+	public:
+		/**
+		 * This is the constructor for the class.
+		 * @param pool This is the pool which the worker belongs to.
+		 * @param lane This is the lane which the worker carries out.
+		 * @param threadName This is the name of the thread in a human readable format.
+		 */
+		Worker(WorkerPool *pool, int lane, std::string threadName);
+
+		/**
+		 * This is the run method.  It will carry out the worker's lane of each job until the worker is stopped.
+		 */
+		virtual void run();
+
+		/**
+		 * This method will stop the worker, waking it if it is waiting for a job.
+		 */
+		virtual void stop();
+	};
+
+	/**
+	 * This is the name of the pool.
+	 */
+	std::string myName;
+
+	/**
+	 * This is the number of lanes which each job is split into.
+	 */
+	int laneCount;
+
+	/**
+	 * These are the workers, which carry out lanes 1 to laneCount - 1.
+	 */
+	std::vector<Worker*> workers;
+
+	/**
+	 * This is the job which is being carried out.  It is only changed while no worker is running.
+	 */
+	ParallelJob *currentJob = NULL;
+
+	/**
+	 * This is the number of the current job.  It is incremented to hand a job to the workers.
+	 */
+	std::atomic<uint64_t> jobNumber;
+
+	/**
+	 * This is the number of worker lanes of the current job which have not yet completed.
+	 */
+	std::atomic<int> lanesRemaining;
+
+	/**
+	 * This event is signaled when a job is handed out, and when the workers are stopped.
+	 */
+	WakeupEvent jobReady;
+
+	/**
+	 * This event is signaled when the last worker lane of a job completes.
+	 */
+	WakeupEvent jobDone;
+
+public:
+	/**
+	 * This is the constructor for the class.  The workers are created, but not started.
+	 * @param name This is the name of the pool.  The workers are named after it.
+	 * @param lanes This is the number of lanes which each job is split into.  It must be at least 1.
+	 */
+	WorkerPool(std::string name, int lanes);
+
+	/**
+	 * This is the destructor for the class.  The workers must have been stopped.
+	 */
+	virtual ~WorkerPool();
+
+	/**
+	 * This method will start the worker threads.
+	 * @param priority This is the priority of the workers.  It should be the priority of the task which runs the jobs,
+	 * so that the lanes of a job are not delayed behind lower priority work.
+	 */
+	void start(int priority);
+
+	/**
+	 * This method will stop the worker threads and wait for them to end.
+	 */
+	void stop();
+
+	/**
+	 * This method will carry out every lane of a job, lane 0 on the calling thread and the others on the workers, and
+	 * return once all of them are complete.  Until the pool is started, every lane is carried out on the calling thread.
+	 * Only one thread may run jobs on a pool.
+	 * @param job This is the job.
+	 */
+	void run(ParallelJob &job);
+
+	/**
+	 * This method will obtain the number of lanes which each job is split into.
+	 * @return The return will be the number of lanes.
+	 */
+	int getLaneCount();
+
+	/**
+	 * This method will obtain the name of the pool.
+	 * @return The return will be the name of the pool.
+	 */
+	std::string getName();
+};
+
+#endif /* WORKERPOOL_H_ */
@@ -11,12 +11,38 @@ using namespace std;
 #include <chrono>
 #include <iostream>
 #include "RunnableClass.h"
+#include "SchedulabilityAnalyzer.h"
+#include "RealTimeInit.h"
+#include "TraceBuffer.h"
+#include "TraceDrainer.h"
+#include "LogDrainer.h"
+#include "MetricsServer.h"
+#include "ControlServer.h"
+#include "OverloadManager.h"
+#include "BitrateController.h"
+#include "FramePool.h"
+#include "FeedbackReceiver.h"
 #include <sys/syscall.h>
 #include <unistd.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
 
 
 using namespace std;
 
+/**
+ * This structure is a smaller resolution of the image stream, sent as a stream of the simulcast, and the encoders which
+ * it has of its own.  The encoders are NULL if the image stream does not use them.
+ */
+struct SimulcastLayer {
+	ImageTransmitter *transmitter;
+	JpegSliceEncoder *jpegEncoder;
+	TileDeltaEncoder *tileEncoder;
+	FecEncoder *fecEncoder;
+	TransmitHistory *history;
+};
+
 /**
  * This is the main program.
  */
@@ -24,12 +50,217 @@ int main(int argc, char* argv[]) {
 	// These are the image sizes for the camera (c) and the transmitted image (t), both height (h) and width (w).
 	int cw, ch, tw, th, fps, lpudp;
 
-	if (argc != 9)
+	// These are the SCHED_DEADLINE runtime budgets in microseconds for the camera and the image stream.  0 means SCHED_FIFO is used.
+	unsigned int cameraRuntime = 0, streamRuntime = 0;
+
+	// These are the CPUs the camera and the image stream are pinned to.  -1 means they are not pinned.
+	int cameraCpu = -1, streamCpu = -1;
+
+	// This is the number of cores to reserve for the real time tasks.  0 means no cores are reserved.
+	int reservedCores = 0;
+
+	// These control the real time startup mode: whether memory is locked, how much stack each thread prefaults, and the thread stack size, all in KB.
+	bool lockMemory = false;
+	unsigned int stackPrefaultKB = 256, stackSizeKB = 0;
+
+	// This determines whether the frame buffers are backed by huge pages.
+	bool hugePages = false;
+
+	// This is the file that trace events are written to.  NULL means tracing is not available.
+	char *traceFileName = NULL;
+
+	// This is the TCP port that the metrics are served on.  0 means the metrics are not served.
+	int metricsPort = 0;
+
+	// These are the CPU utilizations, in percent, at which the image stream is slowed down and restored.  0 means the overload manager is not used.
+	unsigned int degradeUtilization = 0, restoreUtilization = 0;
+
+	// This is the JPEG quality of the image stream, the number of slices encoded in parallel, and the largest datagram.
+	// A quality of 0 means the stream is sent raw, and 0 lanes means one per core.
+	int jpegQuality = 0, jpegLanes = 0, jpegDatagramSize = STREAM_MAX_DATAGRAM_SIZE;
+
+	// These are the number of frames between the keyframes of a tile delta stream, the size of the tiles, and the noise
+	// threshold.  A size of 0 means the stream is not sent as tile deltas.
+	unsigned int keyframeInterval = 0;
+	int tileSize = 0, tileThreshold = 4;
+
+	// This determines whether the image stream is compressed without loss.
+	bool lossless = false;
+
+	// This is the pixel format which the raw rows of the image stream are sent in.
+	int pixelFormat = STREAM_PIXEL_BGR24;
+
+	// These are the number of data datagrams in each group of forward error correction, and the number of parity
+	// datagrams for each group.  0 data datagrams means the image stream is not protected.
+	int fecDataCount = 0, fecParityCount = 1;
+
+	// These are the latency budget, in milliseconds, within which lost datagrams of the image stream are sent again, and
+	// the number of frames and the kilobytes of datagrams which are kept for it.  A budget of 0 means nothing is kept.
+	unsigned int retransmitBudget = 0, historyFrames = 8, historyKilobytes = 8192;
+
+	// These determine whether the image stream is fitted to the link from the receiver's reports, the highest rate it may
+	// be sent at in kilobits per second (0 for no limit), and whether its datagrams are paced at the target rate.
+	bool adaptiveBitrate = false;
+	unsigned int maximumBitrate = 0, bitratePacing = 0;
+
+	// These are the other destinations which the image stream is sent to, as host[:port], and the number of hops which
+	// the datagrams sent to a multicast group may travel.
+	std::vector<char*> extraDestinations;
+	int multicastTtl = 1;
+
+	// These are the sizes of the smaller resolutions of the image stream which are sent as a simulcast, from the largest
+	// to the smallest.  If there are none, the image stream is not a simulcast.
+	std::vector<std::pair<int, int>> simulcastSizes;
+
+	// This is the path of the control socket.
+	const char *controlPath = CONTROL_DEFAULT_PATH;
+
+	if (argc < 9)
 	{
-		printf("Usage: %s ip port cameraWidth cameraHeight TransmitWidth transmitHeight <frame per second to send> <Lines per UDP Message>", argv[0]);
+		printf("Usage: %s ip port cameraWidth cameraHeight TransmitWidth transmitHeight <frame per second to send> <Lines per UDP Message> [options]\n", argv[0]);
+		printf("Options:\n");
+		printf("  --deadline=<camera runtime us>,<stream runtime us>  Schedule the camera and stream with SCHED_DEADLINE.\n");
+		printf("  --affinity=<camera cpu>,<stream cpu>  Pin the camera and stream threads to the given CPUs.\n");
+		printf("  --isolate=<cores>  Reserve the isolated cores (or the given number of cores) for the real time threads.\n");
+		printf("  --mlock[=<stack prefault KB>]  Lock memory and prefault the heap and each thread's stack (default 256 KB).\n");
+		printf("  --stack-size=<KB>  Set the stack size of each thread.\n");
+		printf("  --hugepages  Back the frame buffers with huge pages.\n");
+		printf("  --trace=<file>  Record trace events to the given file (Chrome trace format if it ends in .json).  Tracing is turned on and off through the control socket.\n");
+		printf("  --control=<path>  Listen for control commands on the given Unix socket (default %s).\n", CONTROL_DEFAULT_PATH);
+		printf("  --metrics=<port>  Serve the task and stream statistics in the Prometheus format on the given TCP port.\n");
+		printf("  --jpeg=<quality>[,<lanes>[,<datagram bytes>]]  Send the image stream as JPEG slices which each fit one datagram, encoding the given number of slices at once (default one per core).\n");
+		printf("  --delta=<keyframe interval>[,<tile size>[,<threshold>]]  Send the image stream as the tiles (default 32 pixels) which changed by more than the threshold (default 4), with a keyframe every given number of frames (0 for only on request).\n");
+		printf("  --lossless  Send the image stream as rows compressed without loss.\n");
+		printf("  --format=bgr|y8|yuv420|rgb565  Send the raw rows of the image stream in the given pixel format (default bgr).\n");
+		printf("  --nack=<budget ms>[,<frames>[,<KB>]]  Send lost datagrams of the image stream again when the receiver asks, while their frame is younger than the budget, keeping the given number of frames (default 8) in a history of the given size (default 8192 KB).\n");
+		printf("  --fec=<data datagrams>[,<parity datagrams>]  Protect each group of the given number of datagrams of the image stream with parity datagrams (default 1), from which lost datagrams are recovered.\n");
+		printf("  --abr[=<maximum kbps>[,<pace>]]  Fit the image stream to the link from the receiver's reports, lowering the JPEG quality, the resolution and then the frame rate, and pacing its datagrams at the target rate if pace is 1.\n");
+		printf("  --destination=<host>[:<port>]  Send the image stream to the given host or multicast group as well, on the given port (default the stream's port).  May be given up to %d times.\n", ImageTransmitter::MAXIMUM_DESTINATIONS - 1);
+		printf("  --multicast-ttl=<hops>  Let the datagrams sent to a multicast group travel the given number of hops (default 1).\n");
+		printf("  --simulcast=<width>x<height>[,<width>x<height>...]  Also send each frame at the given smaller resolutions, each resized from the one before it, as streams 1, 2, ... of a simulcast on the socket of the image stream.\n");
+		printf("  --overload=<degrade %%>,<restore %%>  Halve the frame rate of the image stream when a deadline is missed or a CPU reaches the first utilization, and restore it once the second is not exceeded.\n");
 		exit(0);
 	}
 
+	// Parse the optional parameters.
+	for (int index = 9; index < argc; index++)
+	{
+		if (strncmp(argv[index], "--deadline=", 11) == 0)
+		{
+			sscanf(argv[index] + 11, "%u,%u", &cameraRuntime, &streamRuntime);
+		}
+		else if (strncmp(argv[index], "--affinity=", 11) == 0)
+		{
+			sscanf(argv[index] + 11, "%d,%d", &cameraCpu, &streamCpu);
+		}
+		else if (strncmp(argv[index], "--isolate=", 10) == 0)
+		{
+			reservedCores = atoi(argv[index] + 10);
+		}
+		else if (strncmp(argv[index], "--mlock", 7) == 0)
+		{
+			lockMemory = true;
+			sscanf(argv[index] + 7, "=%u", &stackPrefaultKB);
+		}
+		else if (strncmp(argv[index], "--stack-size=", 13) == 0)
+		{
+			stackSizeKB = atoi(argv[index] + 13);
+		}
+		else if (strcmp(argv[index], "--hugepages") == 0)
+		{
+			hugePages = true;
+		}
+		else if (strncmp(argv[index], "--trace=", 8) == 0)
+		{
+			traceFileName = argv[index] + 8;
+		}
+		else if (strncmp(argv[index], "--control=", 10) == 0)
+		{
+			controlPath = argv[index] + 10;
+		}
+		else if (strncmp(argv[index], "--metrics=", 10) == 0)
+		{
+			metricsPort = atoi(argv[index] + 10);
+		}
+		else if (strncmp(argv[index], "--jpeg=", 7) == 0)
+		{
+			sscanf(argv[index] + 7, "%d,%d,%d", &jpegQuality, &jpegLanes, &jpegDatagramSize);
+		}
+		else if (strncmp(argv[index], "--delta=", 8) == 0)
+		{
+			tileSize = 32;
+			sscanf(argv[index] + 8, "%u,%d,%d", &keyframeInterval, &tileSize, &tileThreshold);
+		}
+		else if (strcmp(argv[index], "--lossless") == 0)
+		{
+			lossless = true;
+		}
+		else if (strncmp(argv[index], "--format=", 9) == 0)
+		{
+			const char *formatNames[] = { "bgr", "y8", "yuv420", "rgb565" };
+			pixelFormat = -1;
+			for (int format = STREAM_PIXEL_BGR24; format <= STREAM_PIXEL_RGB565; format++)
+			{
+				if (strcmp(argv[index] + 9, formatNames[format]) == 0)
+				{
+					pixelFormat = format;
+				}
+			}
+			if (pixelFormat < 0)
+			{
+				printf("Unknown pixel format %s\n", argv[index] + 9);
+				pixelFormat = STREAM_PIXEL_BGR24;
+			}
+		}
+		else if (strncmp(argv[index], "--nack=", 7) == 0)
+		{
+			sscanf(argv[index] + 7, "%u,%u,%u", &retransmitBudget, &historyFrames, &historyKilobytes);
+		}
+		else if (strncmp(argv[index], "--fec=", 6) == 0)
+		{
+			sscanf(argv[index] + 6, "%d,%d", &fecDataCount, &fecParityCount);
+		}
+		else if (strncmp(argv[index], "--abr", 5) == 0)
+		{
+			adaptiveBitrate = true;
+			if (argv[index][5] == '=')
+			{
+				sscanf(argv[index] + 6, "%u,%u", &maximumBitrate, &bitratePacing);
+			}
+		}
+		else if (strncmp(argv[index], "--destination=", 14) == 0)
+		{
+			extraDestinations.push_back(argv[index] + 14);
+		}
+		else if (strncmp(argv[index], "--multicast-ttl=", 16) == 0)
+		{
+			multicastTtl = atoi(argv[index] + 16);
+		}
+		else if (strncmp(argv[index], "--simulcast=", 12) == 0)
+		{
+			const char *sizes = argv[index] + 12;
+			int width = 0, height = 0, consumed = 0;
+			while (sscanf(sizes, "%dx%d%n", &width, &height, &consumed) == 2)
+			{
+				simulcastSizes.push_back(std::make_pair(width, height));
+				sizes += consumed;
+				sizes += (*sizes == ',') ? 1 : 0;
+			}
+			if (*sizes != '\0')
+			{
+				printf("Unknown simulcast size %s\n", sizes);
+			}
+		}
+		else if (strncmp(argv[index], "--overload=", 11) == 0)
+		{
+			sscanf(argv[index] + 11, "%u,%u", &degradeUtilization, &restoreUtilization);
+		}
+		else
+		{
+			printf("Unknown option %s\n", argv[index]);
+		}
+	}
+
 	cout << "Main thread id is : " << syscall(SYS_gettid) << "\n";
 
 	// Convert the parameters into integers.
@@ -42,42 +273,340 @@ int main(int argc, char* argv[]) {
 	lpudp = atoi(argv[8]);
 
 
+	// Enter the real time startup mode.  The heap prefault covers a few frames at the camera and the transmit resolution.
+	RunnableClass::setDefaultStackSize(stackSizeKB * 1024);
+	if (lockMemory)
+	{
+		RealTimeInit::initialize(stackPrefaultKB * 1024, 4 * 3 * ((cw * ch) + (tw * th)));
+	}
+
+	// Reserve the cores for the real time threads before any other threads are created.
+	if (reservedCores > 0)
+	{
+		RunnableClass::reserveIsolatedCores(reservedCores);
+	}
+
+	// Start the log drainer at the default (non real time) priority.  From now on, the real time threads only queue their messages.
+	LogDrainer *logDrainer = new LogDrainer(stdout, "Log Drainer", 50000);
+	logDrainer->start(0);
+
+	// Start the trace drainer at the default (non real time) priority, so that writing the file never delays the real time threads.
+	TraceDrainer *drainer = NULL;
+	if (traceFileName != NULL)
+	{
+		drainer = new TraceDrainer(traceFileName, "Trace Drainer", 100000);
+		drainer->start(0);
+		TraceBuffer::setEnabled(true);
+	}
+
+	// Allocate the frame buffers once, for the larger of the camera and the transmit resolution.  The camera holds the
+	// last frame in one, the image stream holds its captured and resized frames in the next two, and each level of the
+	// simulcast holds its frame in one more.
+	FramePool *framePool = new FramePool("Frame Pool", 3 * (size_t) std::max(cw * ch, tw * th), 3 + (uint32_t) simulcastSizes.size(), hugePages);
+
 	// Instantiate a camera.
 	Camera* myCamera = new Camera(cw, ch, "Camera", 1000000/30);
+	myCamera->setFramePool(framePool);
+	if (cameraCpu >= 0)
+	{
+		myCamera->setCpuAffinity({cameraCpu});
+	}
+	if (cameraRuntime > 0)
+	{
+		myCamera->useDeadlineScheduling(cameraRuntime);
+	}
 
 	// Figure out the port to use.
 	ImageTransmitter* it = new ImageTransmitter(argv[1], port, lpudp);
+
+	// Send the image stream to the other destinations as well, each datagram being built once for all of them.
+	std::vector<int> extraPorts;
+	for (char *destination : extraDestinations)
+	{
+		int destinationPort = port;
+		char *separator = strrchr(destination, ':');
+		if (separator != NULL)
+		{
+			*separator = '\0';
+			destinationPort = atoi(separator + 1);
+		}
+		extraPorts.push_back(destinationPort);
+		if (it->addDestination(destination, destinationPort) == false)
+		{
+			printf("Too many destinations.  %s is not sent the image stream.\n", destination);
+		}
+	}
+	it->setMulticastTtl(multicastTtl);
 	myCamera->start(10);
 
+	// Protect the image stream with forward error correction, if requested.  The parity of the largest group is allocated
+	// now, and the group size may be changed through the control socket.  Each datagram then carries a header, so the
+	// JPEG slices have to be smaller.
+	FecEncoder *fecEncoder = NULL;
+	if (fecDataCount > 0)
+	{
+		fecEncoder = new FecEncoder(fecDataCount, fecParityCount);
+		it->setFecEncoder(fecEncoder);
+		jpegDatagramSize = std::min(jpegDatagramSize, (int) FecEncoder::MAXIMUM_DATAGRAM_SIZE);
+	}
+
+	// Keep the datagrams of the image stream for retransmission, if requested.  The history is allocated now, and the
+	// budget may be changed through the control socket.  Each datagram then carries a sequence header as well.
+	TransmitHistory *history = NULL;
+	if (retransmitBudget > 0)
+	{
+		history = new TransmitHistory(historyFrames, (size_t) historyKilobytes * 1024);
+		it->setTransmitHistory(history);
+		it->setRetransmitBudget(retransmitBudget);
+		size_t largestDatagram = (fecEncoder != NULL) ? FecEncoder::MAXIMUM_DATAGRAM_SIZE : STREAM_MAX_DATAGRAM_SIZE;
+		jpegDatagramSize = std::min(jpegDatagramSize, (int) (largestDatagram - sizeof(StreamSequenceHeader)));
+	}
+
+	// The datagrams of a simulcast carry a simulcast header as well.
+	if (simulcastSizes.empty() == false)
+	{
+		jpegDatagramSize = std::min(jpegDatagramSize, (int) (STREAM_MAX_DATAGRAM_SIZE - sizeof(StreamSimulcastHeader))
+				- ((fecEncoder != NULL) ? (int) STREAM_FEC_OVERHEAD : 0) - ((history != NULL) ? (int) sizeof(StreamSequenceHeader) : 0));
+	}
+
+	// Encode the image stream as JPEG slices, if requested.  The encoder allocates the datagrams of every slice now.
+	JpegSliceEncoder *jpegEncoder = NULL;
+	if (jpegQuality > 0)
+	{
+		if (jpegLanes <= 0)
+		{
+			jpegLanes = (int) sysconf(_SC_NPROCESSORS_ONLN);
+		}
+		jpegEncoder = new JpegSliceEncoder("JPEG Encoder", jpegLanes, th, jpegDatagramSize);
+		it->setJpegEncoder(jpegEncoder);
+		it->setEncoding(ENCODING_JPEG, jpegQuality);
+	}
+
+	// Send the image stream as tile deltas, if requested.  The reference frame is allocated now, for the larger of the
+	// camera and the transmit size.  If several encodings are requested, the stream starts in the last of JPEG slices,
+	// tile deltas and lossless rows, and may be switched between them through the control socket.
+	TileDeltaEncoder *tileEncoder = NULL;
+	if (tileSize > 0)
+	{
+		tileEncoder = new TileDeltaEncoder(std::max(cw, tw), std::max(ch, th), tileSize, keyframeInterval, tileThreshold);
+		it->setTileEncoder(tileEncoder);
+		it->setEncoding(ENCODING_DELTA, it->getJpegQuality());
+	}
+	if (lossless)
+	{
+		it->setEncoding(ENCODING_LOSSLESS, it->getJpegQuality());
+	}
+	it->setPixelFormat(pixelFormat);
+
 	// Start capturing and streaming.
 	ImageCapturer *is = new ImageCapturer(myCamera, it, tw, th, "Image Stream", (1000000/fps));
-	is->start();
-
-	string msg;
-	cin >> msg;
+	is->setFramePool(framePool);
 
-	while (msg.compare("QUIT")!=0)
+	// Send the smaller resolutions of the image stream as a simulcast, if requested.  Each has the settings and its own
+	// copy of the encoders of the image stream, which are allocated now.  A JPEG encoder of a small resolution has a
+	// single lane, as its slices are quick to encode.
+	std::vector<SimulcastLayer> simulcastLayers;
+	for (std::pair<int, int> &size : simulcastSizes)
 	{
-		cout << "Looping thread id is : " << syscall(SYS_gettid) << "\n";
-		if (msg.compare("P")==0)
+		SimulcastLayer layer = { new ImageTransmitter(argv[1], port, lpudp), NULL, NULL, NULL, NULL };
+		for (size_t destination = 0; destination < extraDestinations.size(); destination++)
 		{
-			RunnableClass::printThreads();
+			layer.transmitter->addDestination(extraDestinations[destination], extraPorts[destination]);
 		}
-		else if (msg.compare("R")==0)
+		layer.transmitter->setMulticastTtl(multicastTtl);
+		if (fecEncoder != NULL)
 		{
-			RunnableClass::resetAllThreadInformation();
+			layer.fecEncoder = new FecEncoder(fecDataCount, fecParityCount);
+			layer.transmitter->setFecEncoder(layer.fecEncoder);
 		}
+		if (history != NULL)
+		{
+			layer.history = new TransmitHistory(historyFrames, (size_t) historyKilobytes * 1024);
+			layer.transmitter->setTransmitHistory(layer.history);
+			layer.transmitter->setRetransmitBudget(retransmitBudget);
+		}
+		if (jpegEncoder != NULL)
+		{
+			layer.jpegEncoder = new JpegSliceEncoder("JPEG Encoder " + std::to_string(simulcastLayers.size() + 1), 1, size.second, jpegDatagramSize);
+			layer.transmitter->setJpegEncoder(layer.jpegEncoder);
+		}
+		if (tileEncoder != NULL)
+		{
+			layer.tileEncoder = new TileDeltaEncoder(size.first, size.second, tileSize, keyframeInterval, tileThreshold);
+			layer.transmitter->setTileEncoder(layer.tileEncoder);
+		}
+		layer.transmitter->setEncoding(it->getEncoding(), it->getJpegQuality());
+		layer.transmitter->setPixelFormat(pixelFormat);
+		if (is->addSimulcastLevel(layer.transmitter, size.first, size.second) == false)
+		{
+			printf("The simulcast size %dx%d is not sent.\n", size.first, size.second);
+		}
+		simulcastLayers.push_back(layer);
+	}
+	if (streamRuntime > 0)
+	{
+		is->useDeadlineScheduling(streamRuntime);
+	}
+	if (streamCpu >= 0)
+	{
+		is->setCpuAffinity({streamCpu});
+	}
+	is->start();
 
-		cin >> msg;
+	// The encoder's workers run at the priority of the image stream, which waits for them to encode each frame.
+	if (jpegEncoder != NULL)
+	{
+		jpegEncoder->start(is->getPriority());
+	}
+	for (SimulcastLayer &layer : simulcastLayers)
+	{
+		if (layer.jpegEncoder != NULL)
+		{
+			layer.jpegEncoder->start(is->getPriority());
+		}
+	}
+
+	// Act on the feedback of the receivers as soon as it arrives, if the image stream uses it, so that lost datagrams are
+	// sent again within about a round trip.  It runs at the default (non real time) priority, below the image stream.
+	FeedbackReceiver *feedback = NULL;
+	if ((history != NULL) || (tileEncoder != NULL) || adaptiveBitrate)
+	{
+		feedback = new FeedbackReceiver(it, "Feedback Receiver");
+		feedback->start(0);
+	}
+
+	// Watch for overload.  The camera is the high criticality task, and the image stream is slowed down to protect it.  The
+	// manager runs above both, so that it still runs when they saturate the CPU.
+	OverloadManager *overload = NULL;
+	if (degradeUtilization > 0)
+	{
+		overload = new OverloadManager("Overload Manager", 100000);
+		overload->setThresholds(degradeUtilization / 100.0, 1, restoreUtilization / 100.0, 10);
+		overload->addLowCriticalityTask(is, 2 * is->getTaskPeriod());
+	}
+
+	// Fit the image stream to the link, if requested, once per report of the receiver.  Both it and the overload manager
+	// change the frame rate of the image stream, so only one of them is used.
+	BitrateController *bitrate = NULL;
+	if (adaptiveBitrate && (overload != NULL))
+	{
+		printf("The adaptive bitrate can not be combined with the overload manager, and is not used.\n");
+	}
+	else if (adaptiveBitrate)
+	{
+		bitrate = new BitrateController("Bitrate Controller", 500000, is, tw, th);
+		bitrate->setLimits(maximumBitrate, 0.10, 0.02, 30000, 5);
+		bitrate->setPacing(bitratePacing != 0);
+	}
+
+	// Serve the metrics at the default (non real time) priority, so that a scrape never delays the real time threads.
+	MetricsServer *metrics = NULL;
+	if (metricsPort > 0)
+	{
+		metrics = new MetricsServer(metricsPort, "Metrics Server");
+	}
+
+	// Listen for commands on the control socket.  The tasks keep running while they are retuned.
+	ControlServer *control = new ControlServer(controlPath, "Control Server");
+	control->setTracingAvailable(drainer != NULL);
+
+	// The overload manager, the metrics server and the control server walk the list of running threads, which is not
+	// synchronized.  They are started only once every thread has been created, and every thread is stopped before any is
+	// deleted.
+	if (overload != NULL)
+	{
+		overload->start(20);
+	}
+	if (bitrate != NULL)
+	{
+		bitrate->start(0);
+	}
+	if (metrics != NULL)
+	{
+		metrics->start(0);
+	}
+	control->start(0);
+
+	// Wait for a quit command.
+	control->waitForQuit();
+
+	control->stop();
+	control->waitForShutdown();
+
+	if (metrics != NULL)
+	{
+		metrics->stop();
+		metrics->waitForShutdown();
+	}
+
+	if (overload != NULL)
+	{
+		overload->stop();
+		overload->waitForShutdown();
+	}
+
+	if (bitrate != NULL)
+	{
+		bitrate->stop();
+		bitrate->waitForShutdown();
+	}
+
+	if (feedback != NULL)
+	{
+		feedback->stop();
+		feedback->waitForShutdown();
 	}
 
 	is->stop();
 	is->waitForShutdown();
 
+	if (jpegEncoder != NULL)
+	{
+		jpegEncoder->stop();
+	}
+	for (SimulcastLayer &layer : simulcastLayers)
+	{
+		if (layer.jpegEncoder != NULL)
+		{
+			layer.jpegEncoder->stop();
+		}
+	}
+
 	myCamera->stop();
 	myCamera->waitForShutdown();
-	
+
+	if (drainer != NULL)
+	{
+		drainer->stop();
+		drainer->waitForShutdown();
+	}
+
+	logDrainer->stop();
+	logDrainer->waitForShutdown();
+
+	// Every thread has stopped, so the list of running threads may now change.  The overload manager restores the image
+	// stream when it is deleted, so it is deleted before the image stream.
+	delete control;
+	delete metrics;
+	delete overload;
+	delete bitrate;
+	delete feedback;
+	delete drainer;
+	delete logDrainer;
 	delete myCamera;
+	for (SimulcastLayer &layer : simulcastLayers)
+	{
+		delete layer.transmitter;
+		delete layer.jpegEncoder;
+		delete layer.tileEncoder;
+		delete layer.fecEncoder;
+		delete layer.history;
+	}
 	delete it;
 	delete is;
+	delete jpegEncoder;
+	delete tileEncoder;
+	delete fecEncoder;
+	delete history;
+	delete framePool;
 }
@@ -0,0 +1,178 @@
+//============================================================================
+// Name        : AllocationCheck.cpp
+// Author      : W. Schilling
+// Version     : 1.0
+// Copyright   :
+// Description : This program checks that the image stream does not allocate from the heap once it has reached a steady
+// state.  A camera which generates moving synthetic frames feeds the image stream, which resizes each frame, sends it to
+// the loopback address with the given encoding, and sends a smaller simulcast level as well.  It must be built with
+// COUNT_ALLOCATIONS defined.  Once the tasks have warmed up for a second, the allocations made by every thread, including
+// the worker pool lanes which encode the JPEG slices, are counted as well.  It exits with a status of 1 if a task or any
+// other thread allocated in its steady state.
+//     program <seconds> [raw|jpeg|delta|lossless] [port]
+//============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../../c/src/Camera.h"
+#include "../../../c/src/ImageCapturer.h"
+#include "../../../c/src/ImageTransmitter.h"
+#include "../../../c/src/JpegSliceEncoder.h"
+#include "../../../c/src/TileDeltaEncoder.h"
+#include "../../../c/src/FramePool.h"
+#include "../../../c/src/AllocationCounter.h"
+
+/**
+ * This is the number of seconds the tasks run for before the allocations of every thread are counted.
+ */
+#define WARM_UP_SECONDS (1)
+
+/**
+ * This class is a camera which generates its frames, a gradient with a bar moving across it, rather than grabbing them.
+ */
+class SyntheticCamera: public Camera {
+private:
+	/**
+	 * This is the number of frames which have been generated.
+	 */
+	uint32_t generatedFrames = 0;
+
+public:
+	/**
+	 * This is the constructor for the class.
+	 * @param width This is the width of the generated frames.
+	 * @param height This is the height of the generated frames.
+	 * @param threadName This is the name of the thread.
+	 * @param period This is the period of the camera, given in microseconds.
+	 */
+	SyntheticCamera(int width, int height, std::string threadName, uint32_t period) :
+			Camera(width, height, threadName, period, NULL) {
+	}
+
+protected:
+	/**
+	 * This method will generate the next frame in place.
+	 * @param frame This is the matrix which the frame is generated into.
+	 * @return The return will always be true.
+	 */
+	virtual bool captureFrame(Mat &frame) {
+		frame.create(getHeight(), getWidth(), CV_8UC3);
+		int bar = (generatedFrames++ * 8) % frame.cols;
+		for (int row = 0; row < frame.rows; row++) {
+			uint8_t *pixel = frame.ptr(row);
+			for (int column = 0; column < frame.cols; column++) {
+				bool onBar = (column >= bar) && (column < bar + 16);
+				*pixel++ = onBar ? 255 : (uint8_t) column;
+				*pixel++ = onBar ? 255 : (uint8_t) row;
+				*pixel++ = onBar ? 255 : (uint8_t) (row + column);
+			}
+		}
+		return true;
+	}
+};
+
+/**
+ * This function will report the steady state allocations of a task.
+ * @param task This is the task.
+ * @return The return will be the number of heap allocations the task made in its steady state.
+ */
+static uint64_t reportTask(PeriodicTask *task) {
+	TaskStatistics statistics;
+	task->getStatistics(statistics);
+	printf("%-18s %10llu activations %10llu steady state allocations\n", task->getName().c_str(),
+			(unsigned long long) statistics.activations, (unsigned long long) statistics.steadyStateAllocations);
+	return statistics.steadyStateAllocations;
+}
+
+/**
+ * This is the main program.
+ */
+int main(int argc, char* argv[]) {
+	if ((argc < 2) || (atoi(argv[1]) <= WARM_UP_SECONDS)) {
+		printf("Usage: %s <seconds> [raw|jpeg|delta|lossless] [port]\n", argv[0]);
+		printf("The tasks must run for more than %d second.\n", WARM_UP_SECONDS);
+		exit(0);
+	}
+	if (AllocationCounter::isEnabled() == false) {
+		printf("The allocations are not counted.  Build the program with -DCOUNT_ALLOCATIONS.\n");
+		exit(2);
+	}
+	const char *encoding = (argc > 2) ? argv[2] : "raw";
+	int port = (argc > 3) ? atoi(argv[3]) : 47300;
+
+	// Capture at 640x480 and stream at 320x240, with a 160x120 simulcast level, as the streamer would.
+	const int cw = 640, ch = 480, tw = 320, th = 240, sw = 160, sh = 120;
+	FramePool framePool("Frame Pool", 3 * cw * ch, 4, false);
+	SyntheticCamera camera(cw, ch, "Camera", 1000000 / 30);
+	camera.setFramePool(&framePool);
+
+	ImageTransmitter transmitter((char*) "127.0.0.1", port, 8);
+	ImageTransmitter simulcastTransmitter((char*) "127.0.0.1", port, 8);
+	JpegSliceEncoder *jpegEncoder = NULL, *simulcastJpegEncoder = NULL;
+	TileDeltaEncoder *tileEncoder = NULL, *simulcastTileEncoder = NULL;
+	int datagramSize = STREAM_MAX_DATAGRAM_SIZE - sizeof(StreamSimulcastHeader);
+	if (strcmp(encoding, "jpeg") == 0) {
+		jpegEncoder = new JpegSliceEncoder("JPEG Encoder", 2, th, datagramSize);
+		simulcastJpegEncoder = new JpegSliceEncoder("JPEG Encoder 1", 1, sh, datagramSize);
+		transmitter.setJpegEncoder(jpegEncoder);
+		simulcastTransmitter.setJpegEncoder(simulcastJpegEncoder);
+		transmitter.setEncoding(ENCODING_JPEG, 80);
+		simulcastTransmitter.setEncoding(ENCODING_JPEG, 80);
+	} else if (strcmp(encoding, "delta") == 0) {
+		tileEncoder = new TileDeltaEncoder(tw, th, 32, 30, 4);
+		simulcastTileEncoder = new TileDeltaEncoder(sw, sh, 32, 30, 4);
+		transmitter.setTileEncoder(tileEncoder);
+		simulcastTransmitter.setTileEncoder(simulcastTileEncoder);
+		transmitter.setEncoding(ENCODING_DELTA, 80);
+		simulcastTransmitter.setEncoding(ENCODING_DELTA, 80);
+	} else if (strcmp(encoding, "lossless") == 0) {
+		transmitter.setEncoding(ENCODING_LOSSLESS, 80);
+		simulcastTransmitter.setEncoding(ENCODING_LOSSLESS, 80);
+	} else if (strcmp(encoding, "raw") != 0) {
+		printf("Unknown encoding %s.  The frames are sent raw.\n", encoding);
+	}
+
+	ImageCapturer stream(&camera, &transmitter, tw, th, "Image Stream", 1000000 / 30);
+	stream.setFramePool(&framePool);
+	if (stream.addSimulcastLevel(&simulcastTransmitter, sw, sh) == false) {
+		printf("The simulcast level is not sent.\n");
+	}
+
+	// Start the tasks with the priorities the streamer uses, and let them run.
+	camera.start(10);
+	stream.start(5);
+	if (jpegEncoder != NULL) {
+		jpegEncoder->start(stream.getPriority());
+		simulcastJpegEncoder->start(stream.getPriority());
+	}
+	// Count the allocations made by every thread, not only the tasks, once the stream has warmed up.
+	sleep(WARM_UP_SECONDS);
+	uint64_t warmAllocations = AllocationCounter::getTotalAllocations();
+	sleep(atoi(argv[1]) - WARM_UP_SECONDS);
+	uint64_t processAllocations = AllocationCounter::getTotalAllocations() - warmAllocations;
+
+	stream.stop();
+	stream.waitForShutdown();
+	if (jpegEncoder != NULL) {
+		jpegEncoder->stop();
+		simulcastJpegEncoder->stop();
+	}
+	camera.stop();
+	camera.waitForShutdown();
+
+	// Report the allocations made by each task once it had reached a steady state.
+	uint64_t steadyStateAllocations = reportTask(&camera) + reportTask(&stream);
+	printf("%-18s %33llu steady state allocations\n", "All threads", (unsigned long long) processAllocations);
+	steadyStateAllocations += processAllocations;
+	printf("%s: %llu %s datagrams sent by %s.\n", (steadyStateAllocations == 0) ? "PASSED" : "FAILED",
+			(unsigned long long) transmitter.getDatagramsSent(), encoding, transmitter.getName().c_str());
+
+	delete jpegEncoder;
+	delete simulcastJpegEncoder;
+	delete tileEncoder;
+	delete simulcastTileEncoder;
+	return (steadyStateAllocations > 0) ? 1 : 0;
+}
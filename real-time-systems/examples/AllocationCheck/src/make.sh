@@ -0,0 +1,9 @@
+#!/bin/sh
+SRC=../../../c/src
+g++ -std=c++14 -O2 -Wall -DCOUNT_ALLOCATIONS -o program AllocationCheck.cpp $SRC/Camera.cpp $SRC/ImageCapturer.cpp \
+	$SRC/ImageTransmitter.cpp $SRC/PixelFormatConverter.cpp $SRC/LosslessRowCodec.cpp $SRC/TileDeltaEncoder.cpp \
+	$SRC/JpegSliceEncoder.cpp $SRC/JpegCompressor.cpp $SRC/WorkerPool.cpp $SRC/FecEncoder.cpp $SRC/FecCodec.cpp \
+	$SRC/TransmitHistory.cpp $SRC/FramePool.cpp $SRC/PeriodicTask.cpp $SRC/RunnableClass.cpp $SRC/TaskClock.cpp \
+	$SRC/SchedulabilityAnalyzer.cpp $SRC/RealTimeInit.cpp $SRC/RealTimeMutex.cpp $SRC/Logger.cpp \
+	$SRC/LatencyHistogram.cpp $SRC/WakeupEvent.cpp $SRC/TraceBuffer.cpp $SRC/AllocationCounter.cpp \
+	$SRC/time_util.cpp `pkg-config --cflags --libs opencv4` -ljpeg -lpthread
@@ -0,0 +1,187 @@
+//============================================================================
+// Name        : ControlClient.cpp
+// Author      : W. Schilling
+// Version     : 1.0
+// Copyright   :
+// Description : This program sends commands to the control socket of the PiImageStreamer, so that the tasks and the stream
+// can be retuned while the streamer runs.  Commands are read from standard input, one per line:
+//     P                          Print the thread diagnostics (on the streamer's console).
+//     R                          Reset the diagnostics.
+//     S                          Print the schedulability analysis (on the streamer's console).
+//     T                          Turn tracing on or off.
+//     period <task> <us>         Set the period of a task.
+//     priority <task> <prio>     Set the priority of a task.
+//     release <task>             Release a task immediately.
+//     resolution <w> <h>         Set the transmitted resolution of every stream.
+//     lines <n>                  Set the number of lines in each datagram of every stream.
+//     pacing <us>                Set the time between the datagrams of every stream.
+//     encoding raw|jpeg|delta|lossless [<q>]  Send every stream as raw rows, JPEG slices (optionally at quality q),
+//                                tile deltas or losslessly compressed rows.
+//     keyframe                   Send the next frame of every tile delta stream as a keyframe.
+//     format bgr|y8|yuv420|rgb565  Send the raw rows of every stream in the given pixel format.
+//     fec <k> [<m>]              Protect every stream with m parity datagrams (1 by default) for each k datagrams, or
+//                                turn the error correction off if k is 0.
+//     nack <ms>                  Send lost datagrams of every stream again while their frame is younger than the given
+//                                budget, or turn retransmission off if it is 0.
+//     QUIT                       Shut the streamer down.
+// Task names which contain spaces are given with underscores, e.g. Image_Stream.
+//============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <string>
+#include <iostream>
+#include <sstream>
+
+#include "../../../c/src/ControlProtocol.h"
+
+/**
+ * This method will send a command to the streamer and print the reply.
+ * @param sock This is the socket, which is connected to the streamer.
+ * @param command This is the command.
+ * @param target This is the name of the task or stream, or an empty string.
+ * @param first This is the first argument.
+ * @param second This is the second argument.
+ */
+static void sendCommand(int sock, uint8_t command, const std::string &target, int32_t first, int32_t second) {
+	static uint16_t sequence = 0;
+	ControlMessage message;
+
+	memset(&message, 0, sizeof(message));
+	message.magic = htonl(CONTROL_MAGIC);
+	message.command = command;
+	message.sequence = htons(++sequence);
+	message.arguments[0] = htonl((uint32_t) first);
+	message.arguments[1] = htonl((uint32_t) second);
+	strncpy(message.target, target.c_str(), CONTROL_TARGET_SIZE - 1);
+
+	if (send(sock, &message, sizeof(message), 0) != sizeof(message)) {
+		perror("Unable to send the command");
+		return;
+	}
+
+	// Wait up to a second for the reply.
+	struct pollfd waiting;
+	waiting.fd = sock;
+	waiting.events = POLLIN;
+	if ((poll(&waiting, 1, 1000) <= 0) || (recv(sock, &message, sizeof(message), 0) != sizeof(message))) {
+		printf("No reply from the streamer.\n");
+		return;
+	}
+	printf("Status %d, values %d %d\n", message.status, (int32_t) ntohl(message.arguments[0]), (int32_t) ntohl(message.arguments[1]));
+}
+
+/**
+ * This method will convert a task name typed with underscores into the name of the task.
+ * @param typed This is the name as it was typed.
+ * @return The return will be the name with the underscores replaced by spaces.
+ */
+static std::string taskName(std::string typed) {
+	for (char &c : typed) {
+		if (c == '_') {
+			c = ' ';
+		}
+	}
+	return typed;
+}
+
+int main(int argc, char* argv[]) {
+	const char *serverPath = (argc > 1) ? argv[1] : CONTROL_DEFAULT_PATH;
+	struct sockaddr_un address;
+	char clientPath[64];
+
+	// Create a datagram socket, and bind it to a path of its own so that the streamer can reply.
+	int sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (sock < 0) {
+		perror("Unable to create the socket");
+		exit(-1);
+	}
+	snprintf(clientPath, sizeof(clientPath), "/tmp/ControlClient.%d", (int) getpid());
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, clientPath, sizeof(address.sun_path) - 1);
+	if (bind(sock, (struct sockaddr *) &address, sizeof(address)) != 0) {
+		perror("Unable to bind the socket");
+		exit(-1);
+	}
+
+	// Connect it to the streamer.
+	strncpy(address.sun_path, serverPath, sizeof(address.sun_path) - 1);
+	if (connect(sock, (struct sockaddr *) &address, sizeof(address)) != 0) {
+		perror("Unable to connect to the streamer");
+		unlink(clientPath);
+		exit(-1);
+	}
+
+	std::string line;
+	while (std::getline(std::cin, line)) {
+		std::istringstream words(line);
+		std::string command, target;
+		int32_t first = 0, second = 0;
+		words >> command;
+
+		if (command == "P") {
+			sendCommand(sock, CONTROL_PRINT_THREADS, "", 0, 0);
+		} else if (command == "R") {
+			sendCommand(sock, CONTROL_RESET_STATISTICS, "", 0, 0);
+		} else if (command == "S") {
+			sendCommand(sock, CONTROL_PRINT_ANALYSIS, "", 0, 0);
+		} else if (command == "T") {
+			sendCommand(sock, CONTROL_TOGGLE_TRACE, "", 0, 0);
+		} else if ((command == "period") || (command == "priority")) {
+			words >> target >> first;
+			target = taskName(target);
+			sendCommand(sock, (command == "period") ? CONTROL_SET_PERIOD : CONTROL_SET_PRIORITY, target, first, 0);
+		} else if (command == "release") {
+			words >> target;
+			target = taskName(target);
+			sendCommand(sock, CONTROL_RELEASE_NOW, target, 0, 0);
+		} else if (command == "resolution") {
+			words >> first >> second;
+			sendCommand(sock, CONTROL_SET_RESOLUTION, "", first, second);
+		} else if (command == "lines") {
+			words >> first;
+			sendCommand(sock, CONTROL_SET_LINES_PER_DATAGRAM, "", first, 0);
+		} else if (command == "pacing") {
+			words >> first;
+			sendCommand(sock, CONTROL_SET_PACING, "", first, 0);
+		} else if (command == "encoding") {
+			// The encodings are ENCODING_RAW (0), ENCODING_JPEG (1), ENCODING_DELTA (2) and ENCODING_LOSSLESS (3).  A quality
+			// of 0 keeps the current one.
+			std::string encoding;
+			words >> encoding >> second;
+			first = (encoding == "jpeg") ? 1 : ((encoding == "delta") ? 2 : ((encoding == "lossless") ? 3 : 0));
+			sendCommand(sock, CONTROL_SET_ENCODING, "", first, second);
+		} else if (command == "format") {
+			// The pixel formats are STREAM_PIXEL_BGR24 (0), STREAM_PIXEL_Y8 (1), STREAM_PIXEL_YUV420 (2) and STREAM_PIXEL_RGB565 (3).
+			std::string format;
+			words >> format;
+			first = (format == "y8") ? 1 : ((format == "yuv420") ? 2 : ((format == "rgb565") ? 3 : 0));
+			sendCommand(sock, CONTROL_SET_PIXEL_FORMAT, "", first, 0);
+		} else if (command == "fec") {
+			second = 1;
+			words >> first >> second;
+			sendCommand(sock, CONTROL_SET_FEC, "", first, second);
+		} else if (command == "nack") {
+			words >> first;
+			sendCommand(sock, CONTROL_SET_RETRANSMISSION, "", first, 0);
+		} else if (command == "keyframe") {
+			sendCommand(sock, CONTROL_REQUEST_KEYFRAME, "", 0, 0);
+		} else if (command == "QUIT") {
+			sendCommand(sock, CONTROL_QUIT, "", 0, 0);
+			break;
+		} else if (command.empty() == false) {
+			printf("Unknown command %s\n", command.c_str());
+		}
+	}
+
+	close(sock);
+	unlink(clientPath);
+	return 0;
+}
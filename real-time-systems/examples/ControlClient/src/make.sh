@@ -0,0 +1,2 @@
+#!/bin/sh
+g++ -std=c++11 -Wall -o program ControlClient.cpp
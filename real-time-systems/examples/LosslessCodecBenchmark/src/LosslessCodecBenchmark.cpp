@@ -0,0 +1,113 @@
+//============================================================================
+// Name        : LosslessCodecBenchmark.cpp
+// Author      : W. Schilling
+// Version     : 1.0
+// Copyright   :
+// Description : This program measures the lossless row codec on a picture.  The picture is compressed in groups of rows
+// which each fit in one datagram, exactly as the image transmitter sends them, then decompressed and compared with the
+// original.  The compression ratio and the encode and decode throughput are printed, along with the frame rate of 720p
+// video which the encoder could keep up with on one core.
+//     program [picture] [iterations] [datagram bytes]
+//============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "../../../c/src/LosslessRowCodec.h"
+#include "../../../c/src/StreamProtocol.h"
+
+using namespace cv;
+
+/**
+ * This structure describes one compressed group of rows.
+ */
+struct RowGroup {
+	size_t offset;
+	size_t length;
+	int firstRow;
+	int rowCount;
+};
+
+/**
+ * This function will obtain the CLOCK_MONOTONIC time in seconds.
+ * @return The return will be the time in seconds.
+ */
+static double now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+int main(int argc, char **argv) {
+	const char *path = (argc > 1) ? argv[1] : "../../../test.jpg";
+	int iterations = (argc > 2) ? atoi(argv[2]) : 20;
+	size_t datagramSize = (argc > 3) ? (size_t) atoi(argv[3]) : STREAM_MAX_DATAGRAM_SIZE;
+
+	Mat picture = imread(path, IMREAD_COLOR);
+	if (picture.empty()) {
+		printf("The picture %s could not be read.\n", path);
+		return -1;
+	}
+	if ((iterations < 1) || (datagramSize <= sizeof(StreamRowHeader))
+			|| (LosslessRowCodec::getWorstCaseRowSize(picture.cols) > datagramSize - sizeof(StreamRowHeader))) {
+		printf("A row of the %dx%d picture does not fit in a datagram of %zu bytes.\n", picture.cols, picture.rows, datagramSize);
+		return -1;
+	}
+	size_t rawSize = (size_t) picture.rows * picture.cols * 3;
+	size_t capacity = datagramSize - sizeof(StreamRowHeader);
+
+	// Every group may be as large as a datagram, so the output is sized for a group per row.
+	std::vector<uint8_t> compressed(capacity * picture.rows);
+	std::vector<uint8_t> decoded(rawSize);
+	std::vector<RowGroup> groups;
+	LosslessRowCodec codec;
+	double encodeTime = 0.0;
+	double decodeTime = 0.0;
+	size_t compressedSize = 0;
+
+	for (int iteration = 0; iteration < iterations; iteration++) {
+		// Compress the picture, one datagram's worth of rows at a time.
+		groups.clear();
+		compressedSize = 0;
+		double start = now();
+		for (int row = 0; row < picture.rows;) {
+			RowGroup group;
+			group.offset = compressedSize;
+			group.firstRow = row;
+			group.rowCount = codec.encodeRows(picture, row, &compressed[compressedSize], capacity, group.length);
+			groups.push_back(group);
+			compressedSize += group.length;
+			row += group.rowCount;
+		}
+		double middle = now();
+
+		// Decompress every group, each on its own, as the receiver does.
+		for (const RowGroup &group : groups) {
+			if (!LosslessRowCodec::decodeRows(&compressed[group.offset], group.length, picture.cols, group.rowCount,
+					&decoded[(size_t) group.firstRow * picture.cols * 3], picture.cols * 3)) {
+				printf("The rows starting at %d could not be decoded.\n", group.firstRow);
+				return -1;
+			}
+		}
+		double end = now();
+		encodeTime += middle - start;
+		decodeTime += end - middle;
+	}
+
+	// The picture is continuous as it was just read, so it can be compared as one block.
+	bool exact = (memcmp(decoded.data(), picture.data, rawSize) == 0);
+	double encodeRate = (rawSize * (double) iterations) / encodeTime;
+	double decodeRate = (rawSize * (double) iterations) / decodeTime;
+	printf("Picture:     %s (%dx%d)\n", path, picture.cols, picture.rows);
+	printf("Exact:       %s\n", exact ? "yes" : "NO");
+	printf("Datagrams:   %zu of at most %zu bytes\n", groups.size(), datagramSize);
+	printf("Ratio:       %.3f (%zu to %zu bytes)\n", (double) rawSize / compressedSize, rawSize, compressedSize);
+	printf("Encode:      %.1f MB/s (%.1f frames/s at 1280x720)\n", encodeRate / 1e6, encodeRate / (1280 * 720 * 3));
+	printf("Decode:      %.1f MB/s (%.1f frames/s at 1280x720)\n", decodeRate / 1e6, decodeRate / (1280 * 720 * 3));
+	return exact ? 0 : -1;
+}
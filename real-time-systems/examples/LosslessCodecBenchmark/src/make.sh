@@ -0,0 +1,3 @@
+#!/bin/sh
+SRC=../../../c/src
+g++ -std=c++14 -O2 -Wall -o program LosslessCodecBenchmark.cpp $SRC/LosslessRowCodec.cpp `pkg-config --cflags --libs opencv4`
@@ -0,0 +1,164 @@
+//============================================================================
+// Name        : RetransmitCheck.cpp
+// Author      : W. Schilling
+// Version     : 1.0
+// Copyright   :
+// Description : This program checks that a datagram which a receiver asks for again is sent before the next frame.  An
+// image stream with retransmission on sends one frame to a receiving socket on the loopback address.  The receiver then
+// asks for one of its datagrams again with a NACK, and waits, for no longer than a frame period, for it to come back.
+// No other frame is streamed meanwhile, so the datagram can only be sent by the feedback receiver.  The receiver then
+// asks for the datagram twice more, straight away, which must not be answered, as it was sent again less than a round
+// trip before.  It exits with a status of 1 if the datagram did not come back in time, or came back again.
+//     program [port] [frame period ms]
+//============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "../../../c/src/ImageTransmitter.h"
+#include "../../../c/src/TransmitHistory.h"
+#include "../../../c/src/FeedbackReceiver.h"
+
+/**
+ * This is the index of the datagram which the receiver asks for again.
+ */
+#define LOST_INDEX (5)
+
+/**
+ * This function will obtain the CLOCK_MONOTONIC time.
+ * @return The return will be the time in microseconds.
+ */
+static uint64_t getMicroseconds() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t) now.tv_sec * 1000000ULL) + (now.tv_nsec / 1000);
+}
+
+/**
+ * This function will receive the next datagram of the stream which carries a sequence header.
+ * @param sock This is the receiving socket.
+ * @param timeout This is the longest time to wait in milliseconds.
+ * @param header This is filled in with the sequence header of the datagram.
+ * @param sender This is filled in with the address the datagram came from.
+ * @return The return will be true if a datagram was received, or false if the wait timed out.
+ */
+static bool receiveDatagram(int sock, int timeout, StreamSequenceHeader &header, struct sockaddr_in &sender) {
+	static uint8_t datagram[65536];
+	struct pollfd waiting;
+	waiting.fd = sock;
+	waiting.events = POLLIN;
+	while (poll(&waiting, 1, timeout) > 0) {
+		socklen_t senderLength = sizeof(sender);
+		ssize_t length = recvfrom(sock, datagram, sizeof(datagram), 0, (struct sockaddr*) &sender, &senderLength);
+		if ((length >= (ssize_t) sizeof(header)) && (ntohl(*(uint32_t*) datagram) == STREAM_SEQUENCE_MAGIC)) {
+			memcpy(&header, datagram, sizeof(header));
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * This function will ask the sender for a datagram of a frame again.
+ * @param sock This is the receiving socket.
+ * @param sender This is the address of the sender.
+ * @param frameId This is the count of the frame.
+ * @param index This is the index of the datagram.
+ */
+static void sendNack(int sock, const struct sockaddr_in &sender, uint32_t frameId, int index) {
+	StreamNack nack;
+	memset(&nack, 0, sizeof(nack));
+	nack.feedback.magic = htonl(STREAM_FEEDBACK_MAGIC);
+	nack.feedback.version = STREAM_VERSION;
+	nack.feedback.type = STREAM_FEEDBACK_NACK;
+	nack.feedback.frameId = htonl(frameId);
+	nack.firstIndex = htons(0);
+	nack.bitmap[index / 32] = htonl(1u << (index % 32));
+	sendto(sock, &nack, sizeof(nack), 0, (struct sockaddr*) &sender, sizeof(sender));
+}
+
+/**
+ * This is the main program.
+ */
+int main(int argc, char* argv[]) {
+	int port = (argc > 1) ? atoi(argv[1]) : 47400;
+	int framePeriod = (argc > 2) ? atoi(argv[2]) : 33;
+
+	// Receive the stream on the loopback address.
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(port);
+	if ((sock < 0) || (bind(sock, (struct sockaddr*) &address, sizeof(address)) != 0)) {
+		printf("Cannot receive on port %d.\n", port);
+		exit(2);
+	}
+
+	// Send a small frame of raw rows, one per datagram, keeping them for retransmission.
+	TransmitHistory history(8, 1024 * 1024);
+	ImageTransmitter transmitter((char*) "127.0.0.1", port, 1);
+	transmitter.setTransmitHistory(&history);
+	transmitter.setRetransmitBudget(10 * framePeriod);
+	FeedbackReceiver feedback(&transmitter, "Feedback Receiver");
+	feedback.start(0);
+
+	Mat frame(48, 64, CV_8UC3);
+	for (int row = 0; row < frame.rows; row++) {
+		memset(frame.ptr(row), row, frame.cols * 3);
+	}
+	transmitter.streamImage(&frame);
+
+	// Receive the frame, then ask for one of its datagrams again.
+	StreamSequenceHeader header;
+	struct sockaddr_in sender;
+	int received = 0;
+	uint32_t frameId = 0;
+	while (receiveDatagram(sock, framePeriod, header, sender)) {
+		frameId = ntohl(header.frameId);
+		received++;
+	}
+	uint64_t nackTime = getMicroseconds();
+	sendNack(sock, sender, frameId, LOST_INDEX);
+
+	// Wait, for no longer than a frame period, for the datagram to be sent again.
+	bool retransmitted = false;
+	uint64_t deadline = nackTime + (framePeriod * 1000);
+	uint64_t now = nackTime;
+	while ((retransmitted == false) && (now < deadline)) {
+		if (receiveDatagram(sock, (int) ((deadline - now + 999) / 1000), header, sender)) {
+			retransmitted = (header.flags & STREAM_FLAG_RETRANSMITTED) && (ntohl(header.frameId) == frameId)
+					&& (ntohs(header.datagramIndex) == LOST_INDEX);
+		}
+		now = getMicroseconds();
+	}
+
+	uint64_t latency = now - nackTime;
+
+	// Ask for the datagram twice more, as a receiver which did not see it yet might.  Neither is to be answered.
+	sendNack(sock, sender, frameId, LOST_INDEX);
+	sendNack(sock, sender, frameId, LOST_INDEX);
+	int duplicates = 0;
+	while (receiveDatagram(sock, framePeriod, header, sender)) {
+		duplicates++;
+	}
+
+	feedback.stop();
+	feedback.waitForShutdown();
+
+	bool passed = retransmitted && (duplicates == 0) && (transmitter.getRetransmissionsSuppressed() == 2);
+	printf("%s: %d datagrams of frame %u received, datagram %d sent again %s (%llu us after the NACK), "
+			"%d duplicates sent and %llu suppressed.\n", passed ? "PASSED" : "FAILED", received, frameId, LOST_INDEX,
+			retransmitted ? "before the next frame" : "too late", (unsigned long long) latency, duplicates,
+			(unsigned long long) transmitter.getRetransmissionsSuppressed());
+	close(sock);
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,559 @@
+//============================================================================
+// Name        : StreamReceiver.cpp
+// Author      : W. Schilling
+// Version     : 1.0
+// Copyright   :
+// Description : This program receives the image stream and rebuilds its frames.  Every datagram is first passed
+// through the forward error correction decoder, which hands back the datagrams it protects and rebuilds the lost ones
+// from the parity datagrams.  If the datagrams carry sequence headers, the ones which are still missing when the next
+// frame starts are asked for again with a NACK.  The raw rows, JPEG slices, tile deltas, lossless rows and pixel rows
+// are all decoded into a BGR frame.  Datagrams can be dropped on purpose, to see how much of the loss the error
+// correction and the retransmission recover.  Once a second, the frames, datagrams, recovered datagrams, lost
+// datagrams, datagrams asked for again, retransmitted datagrams and skipped datagrams are printed.  Twice a second, a
+// report of the loss, the jitter and the receive rate is sent back to the sender.  When the program is stopped, the
+// last frame is written to the output picture, if one is given other than -.  If a multicast group is given other
+// than -, the group is joined, and several receivers on the same machine may share the port.  If the stream is a
+// simulcast, only the datagrams of the given stream (default 0, the full resolution) are kept, and the rest are
+// skipped.
+//     program port [drop percent] [output picture] [multicast group] [stream id]
+//============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "../../../c/src/StreamProtocol.h"
+#include "../../../c/src/FecDecoder.h"
+#include "../../../c/src/LosslessRowCodec.h"
+#include "../../../c/src/PixelFormatConverter.h"
+
+using namespace cv;
+
+/**
+ * This is set when the program is asked to stop.
+ */
+static volatile sig_atomic_t stopRequested = 0;
+
+/**
+ * This is the frame which is being rebuilt, and the count of the frame which was last written into it.
+ */
+static Mat frame;
+static uint32_t currentFrameId = 0;
+
+/**
+ * These are the statistics of the stream.
+ */
+static uint64_t framesReceived = 0;
+static uint64_t datagramsReceived = 0;
+static uint64_t datagramsDropped = 0;
+static uint64_t datagramsMalformed = 0;
+static uint64_t datagramsNacked = 0;
+static uint64_t datagramsRetransmitted = 0;
+static uint64_t datagramsSkipped = 0;
+
+/**
+ * This is the stream of a simulcast which the receiver subscribes to.  The feedback is sent for it.
+ */
+static uint8_t subscribedStream = 0;
+
+/**
+ * This is the socket, and the address which the stream comes from, which the NACKs are sent back to.
+ */
+static int sock = -1;
+static struct sockaddr_in senderAddress;
+
+/**
+ * These are the newest frame which carried sequence headers, the datagrams of it which have arrived, and the highest
+ * index of them.
+ */
+static bool sequenceStarted = false;
+static uint32_t sequenceFrameId = 0;
+static std::vector<bool> sequenceSeen(65536, false);
+static int highestIndex = -1;
+
+/**
+ * These are the measurements for the next report: the datagrams of the closed frames which were expected and which
+ * arrived without being rebuilt or retransmitted, the datagrams which arrived directly in the frame being received, and
+ * the bytes received.
+ */
+static uint64_t reportExpected = 0;
+static uint64_t reportArrived = 0;
+static uint64_t frameArrived = 0;
+static uint64_t reportBytes = 0;
+
+/**
+ * These are the interarrival jitter of the frames in microseconds, and the arrival time, in microseconds, and the
+ * timestamp, in milliseconds, of the last frame.
+ */
+static double jitter = 0.0;
+static double lastArrival = 0.0;
+static uint32_t lastTimestamp = 0;
+
+/**
+ * This function will ask the program to stop.
+ * @param signalNumber This is the signal which was caught.
+ */
+static void handleSignal(int signalNumber) {
+	stopRequested = 1;
+}
+
+/**
+ * This function will obtain the CLOCK_MONOTONIC time in seconds.
+ * @return The return will be the time in seconds.
+ */
+static double now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+/**
+ * This function will make sure the frame has the given size, and count a new frame when a newer frame arrives.  The
+ * jitter is updated from the arrival of each new frame, as in RFC 3550.
+ * @param width This is the width of the frame in pixels.
+ * @param height This is the height of the frame in pixels.
+ * @param frameId This is the count of the frame which the datagram belongs to.
+ * @param timestamp This is the time, in milliseconds, at which the transmission of the frame started.
+ * @return The return will be true if the datagram can be written into the frame, or false if its size is not sensible.
+ */
+static bool startFrame(int width, int height, uint32_t frameId, uint32_t timestamp) {
+	if ((width <= 0) || (height <= 0) || (width > 8192) || (height > 8192)) {
+		return false;
+	}
+	if ((frame.cols != width) || (frame.rows != height)) {
+		frame = Mat::zeros(height, width, CV_8UC3);
+	}
+	if ((framesReceived == 0) || ((int32_t) (frameId - currentFrameId) > 0)) {
+		double arrival = now() * 1e6;
+		if (framesReceived > 0) {
+			double difference = (arrival - lastArrival) - ((int32_t) (timestamp - lastTimestamp) * 1000.0);
+			jitter += (fabs(difference) - jitter) / 16.0;
+		}
+		lastArrival = arrival;
+		lastTimestamp = timestamp;
+		currentFrameId = frameId;
+		framesReceived++;
+	}
+	return true;
+}
+
+/**
+ * This function will decode a datagram of raw rows.  It starts with the number of lines, and each line is 6 integers
+ * (start time, timestamp, image count, rows, columns and row index) followed by the BGR pixels of the row.
+ * @param datagram This is the datagram.
+ * @param length This is the length of the datagram in bytes.
+ * @return The return will be true if the datagram was decoded.
+ */
+static bool decodeRaw(const uint8_t *datagram, size_t length) {
+	if (length < 28) {
+		return false;
+	}
+	uint32_t lines = ntohl(((const uint32_t*) datagram)[0]);
+	uint32_t rows = ntohl(((const uint32_t*) datagram)[4]);
+	uint32_t cols = ntohl(((const uint32_t*) datagram)[5]);
+	if ((lines == 0) || (startFrame(cols, rows, ntohl(((const uint32_t*) datagram)[3]), ntohl(((const uint32_t*) datagram)[1])) == false)) {
+		return false;
+	}
+
+	/**
+	 * The lines are laid out 6 + (cols * 3 / 4) words apart.  The last line of an image may be followed by stale lines,
+	 * which are recognized by their row index.
+	 */
+	size_t stride = 4 * (6 + (cols * 3 / 4));
+	uint32_t firstRow = ntohl(((const uint32_t*) datagram)[6]);
+	for (uint32_t line = 0; line < lines; line++) {
+		const uint8_t *start = datagram + 4 + (line * stride);
+		if (start + 24 + (cols * 3) > datagram + length) {
+			break;
+		}
+		uint32_t rowIndex = ntohl(((const uint32_t*) start)[5]);
+		if ((rowIndex != firstRow + line) || (rowIndex >= rows)) {
+			break;
+		}
+		memcpy(frame.ptr(rowIndex), start + 24, cols * 3);
+	}
+	return true;
+}
+
+/**
+ * This function will decode a JPEG slice into its rows of the frame.
+ * @param datagram This is the datagram.
+ * @param length This is the length of the datagram in bytes.
+ * @return The return will be true if the datagram was decoded.
+ */
+static bool decodeSlice(const uint8_t *datagram, size_t length) {
+	const StreamSliceHeader *header = (const StreamSliceHeader*) datagram;
+	size_t payloadSize = ntohl(header->payloadSize);
+	int firstRow = ntohs(header->firstRow);
+	int rowCount = ntohs(header->rowCount);
+	if ((length < sizeof(StreamSliceHeader) + payloadSize)
+			|| (startFrame(ntohs(header->frameWidth), ntohs(header->frameHeight), ntohl(header->frameId), ntohl(header->timestamp)) == false)) {
+		return false;
+	}
+	Mat slice = imdecode(Mat(1, payloadSize, CV_8UC1, (void*) (datagram + sizeof(StreamSliceHeader))), IMREAD_COLOR);
+	if ((slice.empty()) || (slice.cols != frame.cols) || (firstRow + std::min(rowCount, slice.rows) > frame.rows)) {
+		return false;
+	}
+	slice.rowRange(0, std::min(rowCount, slice.rows)).copyTo(frame.rowRange(firstRow, firstRow + std::min(rowCount, slice.rows)));
+	return true;
+}
+
+/**
+ * This function will decode a datagram of tiles into the frame.
+ * @param datagram This is the datagram.
+ * @param length This is the length of the datagram in bytes.
+ * @return The return will be true if the datagram was decoded.
+ */
+static bool decodeTiles(const uint8_t *datagram, size_t length) {
+	const StreamTileHeader *header = (const StreamTileHeader*) datagram;
+	int tileSize = ntohs(header->tileSize);
+	int tileCount = ntohs(header->tileCount);
+	if ((length < sizeof(StreamTileHeader)) || (tileSize <= 0)
+			|| (startFrame(ntohs(header->frameWidth), ntohs(header->frameHeight), ntohl(header->frameId), ntohl(header->timestamp)) == false)) {
+		return false;
+	}
+	const uint8_t *position = datagram + sizeof(StreamTileHeader);
+	const uint8_t *end = datagram + length;
+	for (int index = 0; index < tileCount; index++) {
+		if (position + sizeof(StreamTile) > end) {
+			return false;
+		}
+		const StreamTile *tile = (const StreamTile*) position;
+		int x = ntohs(tile->column) * tileSize;
+		int y = ntohs(tile->row) * tileSize;
+		if ((x >= frame.cols) || (y >= frame.rows)) {
+			return false;
+		}
+		int width = std::min(tileSize, frame.cols - x);
+		int height = std::min(tileSize, frame.rows - y);
+		position += sizeof(StreamTile);
+		if (position + (width * height * 3) > end) {
+			return false;
+		}
+		for (int row = 0; row < height; row++) {
+			memcpy(frame.ptr(y + row) + (x * 3), position, width * 3);
+			position += width * 3;
+		}
+	}
+	return true;
+}
+
+/**
+ * This function will decode a datagram of lossless or pixel rows into the frame.
+ * @param datagram This is the datagram.
+ * @param length This is the length of the datagram in bytes.
+ * @return The return will be true if the datagram was decoded.
+ */
+static bool decodeRows(const uint8_t *datagram, size_t length) {
+	const StreamRowHeader *header = (const StreamRowHeader*) datagram;
+	size_t payloadSize = ntohl(header->payloadSize);
+	int firstRow = ntohs(header->firstRow);
+	int rowCount = ntohs(header->rowCount);
+	if ((length < sizeof(StreamRowHeader) + payloadSize)
+			|| (startFrame(ntohs(header->frameWidth), ntohs(header->frameHeight), ntohl(header->frameId), ntohl(header->timestamp)) == false)
+			|| (firstRow + rowCount > frame.rows)) {
+		return false;
+	}
+	const uint8_t *payload = datagram + sizeof(StreamRowHeader);
+	if (header->payloadType == STREAM_PAYLOAD_LOSSLESS_ROWS) {
+		return LosslessRowCodec::decodeRows(payload, payloadSize, frame.cols, rowCount, frame.ptr(firstRow), frame.step);
+	}
+	StreamPixelFormat format = (StreamPixelFormat) header->pixelFormat;
+	if ((PixelFormatConverter::isValid(format) == false)
+			|| (payloadSize < PixelFormatConverter::getPackedSize(format, frame.cols, rowCount))) {
+		return false;
+	}
+	PixelFormatConverter::unpackRows(payload, format, frame.cols, rowCount, frame.ptr(firstRow), frame.step);
+	return true;
+}
+
+/**
+ * This function will ask for the datagrams of the newest frame which have not arrived, up to the given count.
+ * @param datagramCount This is the number of datagrams in the frame.
+ */
+static void sendNacks(int datagramCount) {
+	for (int firstIndex = 0; firstIndex < datagramCount; firstIndex += STREAM_NACK_BITS) {
+		StreamNack nack;
+		memset(&nack, 0, sizeof(nack));
+		bool missing = false;
+		for (int bit = 0; (bit < STREAM_NACK_BITS) && (firstIndex + bit < datagramCount); bit++) {
+			if (sequenceSeen[firstIndex + bit] == false) {
+				nack.bitmap[bit / 32] |= (1u << (bit % 32));
+				datagramsNacked++;
+				missing = true;
+			}
+		}
+		if (missing) {
+			for (int word = 0; word < STREAM_NACK_BITS / 32; word++) {
+				nack.bitmap[word] = htonl(nack.bitmap[word]);
+			}
+			nack.feedback.magic = htonl(STREAM_FEEDBACK_MAGIC);
+			nack.feedback.version = STREAM_VERSION;
+			nack.feedback.type = STREAM_FEEDBACK_NACK;
+			nack.feedback.streamId = subscribedStream;
+			nack.feedback.frameId = htonl(sequenceFrameId);
+			nack.firstIndex = htons(firstIndex);
+			sendto(sock, &nack, sizeof(nack), 0, (struct sockaddr*) &senderAddress, sizeof(senderAddress));
+		}
+	}
+}
+
+/**
+ * This function will send a receiver report to the sender, and start the measurements for the next one.
+ * @param interval This is the time, in seconds, since the last report.
+ * @param lossFraction This is the fraction of the datagrams lost on the link during the interval.
+ */
+static void sendReport(double interval, double lossFraction) {
+	StreamReceiverReport report;
+	memset(&report, 0, sizeof(report));
+	report.feedback.magic = htonl(STREAM_FEEDBACK_MAGIC);
+	report.feedback.version = STREAM_VERSION;
+	report.feedback.type = STREAM_FEEDBACK_REPORT;
+	report.feedback.streamId = subscribedStream;
+	report.feedback.frameId = htonl(currentFrameId);
+	report.lossFraction = htons((uint16_t) std::min(65535.0, lossFraction * 65536.0));
+	report.interval = htons((uint16_t) std::min(65535.0, interval * 1000.0));
+	report.jitter = htonl((uint32_t) jitter);
+	report.receiveRate = htonl((uint32_t) (reportBytes * 8 / 1000.0 / interval));
+	report.datagramsReceived = htonl((uint32_t) datagramsReceived);
+	sendto(sock, &report, sizeof(report), 0, (struct sockaddr*) &senderAddress, sizeof(senderAddress));
+	reportExpected = 0;
+	reportArrived = 0;
+	reportBytes = 0;
+}
+
+/**
+ * This function will take the simulcast header off a datagram, if it has one.
+ * @param datagram This is the datagram.  It is moved past the simulcast header.
+ * @param length This is the length of the datagram in bytes.  It is reduced by the simulcast header.
+ * @return The return will be true if the datagram belongs to the stream which the receiver subscribes to, or is not
+ * part of a simulcast, or false if it is to be skipped.
+ */
+static bool takeSimulcast(const uint8_t *&datagram, size_t &length) {
+	if ((length < sizeof(StreamSimulcastHeader)) || (ntohl(*(const uint32_t*) datagram) != STREAM_SIMULCAST_MAGIC)) {
+		return true;
+	}
+	const StreamSimulcastHeader *header = (const StreamSimulcastHeader*) datagram;
+	datagram += sizeof(StreamSimulcastHeader);
+	length -= sizeof(StreamSimulcastHeader);
+	return header->streamId == subscribedStream;
+}
+
+/**
+ * This function will take the sequence header off a datagram, if it has one.  When the first datagram of a newer frame
+ * arrives, the datagrams of the frame before which are still missing are asked for again.
+ * @param datagram This is the datagram.  It is moved past the sequence header.
+ * @param length This is the length of the datagram in bytes.  It is reduced by the sequence header.
+ * @param rebuilt This is true if the datagram was rebuilt by the forward error correction.
+ */
+static void takeSequence(const uint8_t *&datagram, size_t &length, bool rebuilt) {
+	if ((length < sizeof(StreamSequenceHeader)) || (ntohl(*(const uint32_t*) datagram) != STREAM_SEQUENCE_MAGIC)) {
+		return;
+	}
+	const StreamSequenceHeader *header = (const StreamSequenceHeader*) datagram;
+	uint32_t frameId = ntohl(header->frameId);
+	int index = ntohs(header->datagramIndex);
+	datagram += sizeof(StreamSequenceHeader);
+	length -= sizeof(StreamSequenceHeader);
+	if (header->flags & STREAM_FLAG_RETRANSMITTED) {
+		datagramsRetransmitted++;
+	}
+
+	/**
+	 * A newer frame closes the frame before.  The count of its datagrams is only known if it was the frame just before.
+	 */
+	if ((sequenceStarted == false) || ((int32_t) (frameId - sequenceFrameId) > 0)) {
+		if (sequenceStarted) {
+			int datagramCount = (frameId == sequenceFrameId + 1) ? ntohs(header->previousDatagramCount) : (highestIndex + 1);
+			sendNacks(datagramCount);
+			reportExpected += std::max((uint64_t) datagramCount, frameArrived);
+			reportArrived += frameArrived;
+		}
+		frameArrived = 0;
+		sequenceStarted = true;
+		sequenceFrameId = frameId;
+		std::fill(sequenceSeen.begin(), sequenceSeen.end(), false);
+		highestIndex = -1;
+	}
+	if (frameId == sequenceFrameId) {
+		if ((rebuilt == false) && ((header->flags & STREAM_FLAG_RETRANSMITTED) == 0) && (sequenceSeen[index] == false)) {
+			frameArrived++;
+		}
+		sequenceSeen[index] = true;
+		highestIndex = std::max(highestIndex, index);
+	}
+}
+
+/**
+ * This function will decode a datagram of the stream, as it was sent without forward error correction.
+ * @param datagram This is the datagram.
+ * @param length This is the length of the datagram in bytes.
+ * @param rebuilt This is true if the datagram was rebuilt by the forward error correction.
+ */
+static void decodeDatagram(const uint8_t *datagram, size_t length, bool rebuilt) {
+	bool decoded = false;
+	takeSequence(datagram, length, rebuilt);
+	if ((length >= sizeof(StreamSliceHeader)) && (ntohl(*(const uint32_t*) datagram) == STREAM_MAGIC)) {
+		switch (datagram[5]) {
+		case STREAM_PAYLOAD_JPEG:
+			decoded = decodeSlice(datagram, length);
+			break;
+		case STREAM_PAYLOAD_TILES:
+			decoded = decodeTiles(datagram, length);
+			break;
+		case STREAM_PAYLOAD_LOSSLESS_ROWS:
+		case STREAM_PAYLOAD_PIXEL_ROWS:
+			decoded = decodeRows(datagram, length);
+			break;
+		}
+	} else {
+		decoded = decodeRaw(datagram, length);
+	}
+	if (decoded == false) {
+		datagramsMalformed++;
+	}
+}
+
+/**
+ * This is the main program.
+ * @param argc This is the number of arguments.
+ * @param argv These are the arguments: the port, the percentage of datagrams to drop, the output picture, which is
+ * not written if it is -, the multicast group, which is not joined if it is -, and the stream id.
+ * @return The return will be 0 if the program ends normally.
+ */
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		printf("Usage: %s port [drop percent] [output picture] [multicast group] [stream id]\n", argv[0]);
+		return 0;
+	}
+	int port = atoi(argv[1]);
+	double dropPercent = (argc > 2) ? atof(argv[2]) : 0.0;
+	const char *outputPicture = ((argc > 3) && (strcmp(argv[3], "-") != 0)) ? argv[3] : NULL;
+	const char *multicastGroup = ((argc > 4) && (strcmp(argv[4], "-") != 0)) ? argv[4] : NULL;
+	subscribedStream = (argc > 5) ? atoi(argv[5]) : 0;
+
+	/**
+	 * 1.0 Bind the socket, with a receive buffer large enough for a burst of datagrams, and time out once a second so
+	 * that the statistics are printed while the stream is idle.
+	 */
+	sock = socket(AF_INET, SOCK_DGRAM, 0);
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+	int reuse = 1;
+	if (multicastGroup != NULL) {
+		setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	}
+	if ((sock < 0) || (bind(sock, (struct sockaddr*) &address, sizeof(address)) < 0)) {
+		perror("bind");
+		return -1;
+	}
+	if (multicastGroup != NULL) {
+		struct ip_mreq membership;
+		memset(&membership, 0, sizeof(membership));
+		membership.imr_interface.s_addr = htonl(INADDR_ANY);
+		if ((inet_aton(multicastGroup, &membership.imr_multiaddr) == 0)
+				|| (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0)) {
+			perror("join");
+			return -1;
+		}
+	}
+	int bufferSize = 8 * 1024 * 1024;
+	setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+	struct timeval timeout = { 1, 0 };
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	signal(SIGINT, handleSignal);
+	signal(SIGTERM, handleSignal);
+
+	/**
+	 * 2.0 Receive datagrams until the program is stopped.  Each one is passed through the decoder, and then so are the
+	 * datagrams it rebuilds.
+	 */
+	FecDecoder decoder(16);
+	std::vector<uint8_t> buffer(STREAM_MAX_DATAGRAM_SIZE);
+	std::vector<uint8_t> recovered;
+	double nextReport = now() + 1.0;
+	double lastFeedback = now();
+	uint64_t lastReceived = 0;
+	uint64_t lastMissing = 0;
+	srand(time(NULL));
+	while (stopRequested == 0) {
+		socklen_t senderLength = sizeof(senderAddress);
+		ssize_t received = recvfrom(sock, buffer.data(), buffer.size(), 0, (struct sockaddr*) &senderAddress, &senderLength);
+		const uint8_t *simulcastDatagram = buffer.data();
+		size_t length = (received > 0) ? received : 0;
+		if ((length > 0) && (takeSimulcast(simulcastDatagram, length) == false)) {
+			datagramsSkipped++;
+		} else if (length > 0) {
+			datagramsReceived++;
+			reportBytes += length;
+			if ((dropPercent > 0) && ((rand() % 10000) < (dropPercent * 100))) {
+				datagramsDropped++;
+			} else {
+				size_t innerLength = 0;
+				const uint8_t *datagram = decoder.receive(simulcastDatagram, length, innerLength);
+				if (datagram != NULL) {
+					decodeDatagram(datagram, innerLength, false);
+				}
+				while (decoder.takeRecovered(recovered)) {
+					decodeDatagram(recovered.data(), recovered.size(), true);
+				}
+			}
+		}
+
+		/**
+		 * 2.1 Print the statistics once a second.
+		 */
+		if (now() >= nextReport) {
+			printf("Frames %llu  datagrams %llu  dropped %llu  recovered %llu  lost %llu  nacked %llu  retransmitted %llu  malformed %llu  skipped %llu\n",
+					(unsigned long long) framesReceived, (unsigned long long) datagramsReceived,
+					(unsigned long long) datagramsDropped, (unsigned long long) decoder.getRecoveredCount(),
+					(unsigned long long) decoder.getLostCount(), (unsigned long long) datagramsNacked,
+					(unsigned long long) datagramsRetransmitted, (unsigned long long) datagramsMalformed,
+					(unsigned long long) datagramsSkipped);
+			fflush(stdout);
+			nextReport += 1.0;
+		}
+
+		/**
+		 * 2.2 Send a receiver report twice a second, once the sender is known.  The loss is measured from the sequence
+		 * headers, or if there are none, from the datagrams the decoder had to rebuild or could not.
+		 */
+		double interval = now() - lastFeedback;
+		if ((interval >= 0.5) && (datagramsReceived > 0)) {
+			uint64_t missing = decoder.getRecoveredCount() + decoder.getLostCount();
+			double lossFraction = 0.0;
+			if (reportExpected > 0) {
+				lossFraction = (double) (reportExpected - reportArrived) / reportExpected;
+			} else if (datagramsReceived + missing > lastReceived + lastMissing) {
+				lossFraction = (double) (missing - lastMissing) / (datagramsReceived + missing - lastReceived - lastMissing);
+			}
+			sendReport(interval, lossFraction);
+			lastFeedback += interval;
+			lastReceived = datagramsReceived;
+			lastMissing = missing;
+		}
+	}
+
+	/**
+	 * 3.0 Write out the last frame, if asked to.
+	 */
+	if ((outputPicture != NULL) && (frame.empty() == false)) {
+		imwrite(outputPicture, frame);
+	}
+	close(sock);
+	return 0;
+}
@@ -0,0 +1,3 @@
+#!/bin/sh
+SRC=../../../c/src
+g++ -std=c++14 -O2 -Wall -o program StreamReceiver.cpp $SRC/FecDecoder.cpp $SRC/FecCodec.cpp $SRC/LosslessRowCodec.cpp $SRC/PixelFormatConverter.cpp `pkg-config --cflags --libs opencv4`
@@ -0,0 +1,254 @@
+//============================================================================
+// Name        : TaskSimulation.cpp
+// Author      : W. Schilling
+// Version     : 1.0
+// Copyright   :
+// Description : This program runs a model of the PiImageStreamer task set (the camera and the image stream) in virtual
+// time, so that the periods can be tuned and the timing checked without the camera, and many times faster than real
+// time.  The execution times are drawn from seeded distributions, so every run with the same parameters gives the same
+// statistics.  It then runs a sporadic task, released by bursts of events, and checks that its releases are held to the
+// minimum inter-arrival time and held back further after a budget overrun.
+//     program <simulated seconds> <camera period us> <stream period us> <stream mean us> <stream deviation us> [seed]
+//============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../../../c/src/PeriodicTask.h"
+#include "../../../c/src/SporadicTask.h"
+#include "../../../c/src/VirtualClock.h"
+#include "../../../c/src/ExecutionTimeModel.h"
+#include "../../../c/src/SchedulabilityAnalyzer.h"
+
+/**
+ * This class is a task whose work is entirely modeled by the clock.
+ */
+class ModeledTask: public PeriodicTask {
+public:
+	/**
+	 * This is the constructor for the class.
+	 * @param threadName This is the name of the task.
+	 * @param period This is the period of the task, given in microseconds.
+	 */
+	ModeledTask(std::string threadName, uint32_t period) :
+			PeriodicTask(threadName, period) {
+	}
+
+	/**
+	 * This is the task method.  The execution time is simulated by the clock, so there is nothing to do.
+	 */
+	virtual void taskMethod() {
+	}
+};
+
+/**
+ * This class is a sporadic task whose work is modeled by the clock.  It records when each release starts to execute, and
+ * how long the release before it executed, so that the spacing of the releases can be checked.
+ */
+class ModeledSporadicTask: public SporadicTask {
+public:
+	/**
+	 * This is the largest number of releases which are recorded.
+	 */
+	static const int MAXIMUM_RELEASES = 4096;
+
+	/**
+	 * This is the time, in microseconds of the clock, at which each release started to execute.
+	 */
+	uint64_t releaseStart[MAXIMUM_RELEASES];
+
+	/**
+	 * This is the execution time, in microseconds, of the release before each release.
+	 */
+	int64_t previousExecutionTime[MAXIMUM_RELEASES];
+
+	/**
+	 * This is the number of releases which have been recorded.
+	 */
+	int releases = 0;
+
+	/**
+	 * This is the constructor for the class.
+	 * @param threadName This is the name of the task.
+	 * @param minimumInterArrivalTime This is the shortest time between releases, given in microseconds.
+	 * @param budget This is the execution budget for each release, given in microseconds.
+	 */
+	ModeledSporadicTask(std::string threadName, uint32_t minimumInterArrivalTime, uint32_t budget) :
+			SporadicTask(threadName, minimumInterArrivalTime, budget) {
+	}
+
+	/**
+	 * This is the task method.  The execution time is simulated by the clock, so it only records the release.
+	 */
+	virtual void taskMethod() {
+		if (releases < MAXIMUM_RELEASES) {
+			struct timespec now;
+			TaskStatistics statistics;
+			getClock()->getTime(now);
+			getStatistics(statistics);
+			releaseStart[releases] = (now.tv_sec * 1000000ULL) + (now.tv_nsec / 1000);
+			previousExecutionTime[releases] = statistics.lastExecutionTime;
+			releases++;
+		}
+	}
+};
+
+/**
+ * This class is a periodic task which signals an event to a sporadic task in some of its periods, so that the events
+ * arrive in bursts separated by quiet spells.
+ */
+class EventSource: public PeriodicTask {
+private:
+	/**
+	 * This is the task which the events are signaled to.
+	 */
+	SporadicTask *target;
+
+	/**
+	 * These are the number of periods in which an event is signaled, followed by the number in which none is.
+	 */
+	uint32_t burstPeriods;
+	uint32_t quietPeriods;
+
+	/**
+	 * This is the number of periods which have passed.
+	 */
+	uint32_t periods = 0;
+
+public:
+	/**
+	 * This is the constructor for the class.
+	 * @param threadName This is the name of the task.
+	 * @param period This is the period of the task, which is the time between the events of a burst, given in microseconds.
+	 * @param target This is the task which the events are signaled to.
+	 * @param burstPeriods This is the number of periods in which an event is signaled.
+	 * @param quietPeriods This is the number of periods after a burst in which no event is signaled.
+	 */
+	EventSource(std::string threadName, uint32_t period, SporadicTask *target, uint32_t burstPeriods, uint32_t quietPeriods) :
+			PeriodicTask(threadName, period), target(target), burstPeriods(burstPeriods), quietPeriods(quietPeriods) {
+	}
+
+	/**
+	 * This is the task method.  It signals an event if the source is in a burst.
+	 */
+	virtual void taskMethod() {
+		if ((periods++ % (burstPeriods + quietPeriods)) < burstPeriods) {
+			target->release();
+		}
+	}
+};
+
+/**
+ * This function will run a sporadic task, which events arrive at five times faster than its minimum inter-arrival time
+ * during a burst, and check the spacing of its releases.  A release which overruns its budget holds the next one back by
+ * one minimum inter-arrival time for each budget it used.
+ * @param duration This is the virtual time to run for, in microseconds.
+ * @param seed This is the seed of the execution time distribution.
+ */
+static void simulateSporadicTask(uint64_t duration, uint32_t seed) {
+	const uint32_t interArrivalTime = 10000, budget = 2000;
+	VirtualClock clock;
+	ModeledSporadicTask handler("Event Handler", interArrivalTime, budget);
+	EventSource source("Event Source", interArrivalTime / 5, &handler, 20, 30);
+	ExecutionTimeModel handlerModel(ExecutionTimeModel::DISTRIBUTION_NORMAL, 1500, 200, seed + 2);
+	ExecutionTimeModel sourceModel(ExecutionTimeModel::DISTRIBUTION_CONSTANT, 50, 0, seed + 3);
+	handlerModel.setOverrun(0.05, 4000);
+
+	handler.setClock(&clock);
+	source.setClock(&clock);
+	clock.setExecutionTimeModel(&handler, &handlerModel);
+	clock.setExecutionTimeModel(&source, &sourceModel);
+
+	// The handler runs above the source, so that each release starts to execute as soon as it is allowed to.
+	handler.start(15);
+	source.start(12);
+	clock.runFor(duration);
+	handler.stop();
+	source.stop();
+	clock.runUntilStopped();
+	handler.waitForShutdown();
+	source.waitForShutdown();
+
+	// Check that no two releases were closer than the minimum inter-arrival time, scaled by the budgets used by the first.
+	uint64_t shortestGap = UINT64_MAX;
+	int overruns = 0, violations = 0, example = -1;
+	for (int release = 1; release < handler.releases; release++) {
+		uint64_t gap = handler.releaseStart[release] - handler.releaseStart[release - 1];
+		int64_t executionTime = handler.previousExecutionTime[release];
+		uint64_t budgetsUsed = (executionTime > (int64_t) budget) ? (executionTime + budget - 1) / budget : 1;
+		if (budgetsUsed > 1) {
+			overruns++;
+			example = (example < 0) ? release : example;
+		}
+		if (gap < interArrivalTime * budgetsUsed) {
+			violations++;
+		}
+		shortestGap = (gap < shortestGap) ? gap : shortestGap;
+	}
+
+	printf("Sporadic task: minimum inter-arrival time %u us, budget %u us.\n", interArrivalTime, budget);
+	printf("  %llu events, %llu combined with a pending release, %llu releases held back.\n",
+			(unsigned long long) handler.getEventCount(), (unsigned long long) handler.getCombinedEvents(),
+			(unsigned long long) handler.getDeferredReleases());
+	printf("  %d releases, the closest %llu us apart.  %d overran the budget.\n", handler.releases,
+			(unsigned long long) shortestGap, overruns);
+	if (example > 0) {
+		printf("  For example, the release at %.3f s executed for %lld us, and the next was held back until %.3f s.\n",
+				handler.releaseStart[example - 1] / 1e6, (long long) handler.previousExecutionTime[example],
+				handler.releaseStart[example] / 1e6);
+	}
+	printf("  %s: %d releases came too early.\n", (violations == 0) ? "PASSED" : "FAILED", violations);
+}
+
+/**
+ * This is the main program.
+ */
+int main(int argc, char* argv[]) {
+	if (argc < 6) {
+		printf("Usage: %s <simulated seconds> <camera period us> <stream period us> <stream mean us> <stream deviation us> [seed]\n", argv[0]);
+		exit(0);
+	}
+	uint64_t duration = atoll(argv[1]) * 1000000ULL;
+	uint32_t seed = (argc > 6) ? atoi(argv[6]) : 1;
+
+	// Model the camera, which grabs a frame with a nearly constant cost, and the image stream, which resizes and sends it.
+	// The stream occasionally overruns, as it does when the network stalls.
+	VirtualClock clock;
+	ModeledTask camera("Camera", atoi(argv[2]));
+	ModeledTask stream("Image Stream", atoi(argv[3]));
+	ExecutionTimeModel cameraModel(ExecutionTimeModel::DISTRIBUTION_NORMAL, 4000, 300, seed);
+	ExecutionTimeModel streamModel(ExecutionTimeModel::DISTRIBUTION_NORMAL, atoi(argv[4]), atoi(argv[5]), seed + 1);
+	streamModel.setOverrun(0.01, 3 * atoi(argv[4]));
+
+	camera.setClock(&clock);
+	stream.setClock(&clock);
+	clock.setExecutionTimeModel(&camera, &cameraModel);
+	clock.setExecutionTimeModel(&stream, &streamModel);
+
+	// Start the tasks with the priorities the streamer uses.  The clock is paused until runFor is called, so both tasks
+	// start at the same virtual time.
+	camera.start(10);
+	stream.start(5);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	clock.runFor(duration);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	RunnableClass::printThreads();
+	SchedulabilityAnalyzer::printAnalysis();
+
+	camera.stop();
+	stream.stop();
+	clock.runUntilStopped();
+	camera.waitForShutdown();
+	stream.waitForShutdown();
+
+	double elapsed = (end.tv_sec - start.tv_sec) + ((end.tv_nsec - start.tv_nsec) / 1e9);
+	printf("Simulated %.1f s in %.3f s (%.0f times real time).\n", duration / 1e6, elapsed, (duration / 1e6) / elapsed);
+
+	// Run the sporadic task for the same time, on a clock of its own.
+	simulateSporadicTask(duration, seed);
+	return 0;
+}
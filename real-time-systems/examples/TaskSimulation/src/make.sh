@@ -0,0 +1,6 @@
+#!/bin/sh
+SRC=../../../c/src
+g++ -std=c++14 -Wall -o program TaskSimulation.cpp $SRC/PeriodicTask.cpp $SRC/SporadicTask.cpp $SRC/RunnableClass.cpp $SRC/TaskClock.cpp \
+	$SRC/VirtualClock.cpp $SRC/ExecutionTimeModel.cpp $SRC/SchedulabilityAnalyzer.cpp $SRC/RealTimeInit.cpp \
+	$SRC/RealTimeMutex.cpp $SRC/Logger.cpp $SRC/LatencyHistogram.cpp $SRC/WakeupEvent.cpp $SRC/TraceBuffer.cpp \
+	$SRC/AllocationCounter.cpp -lpthread